@@ -11,33 +11,47 @@
 #include "ui_display.h"
 
 #include "lvgl.h"
+#if LV_USE_TILE_ANIM
+#include "lv_tile_anim.h"
+#endif
 
 /***********************************************************
 ************************macro define************************
 ***********************************************************/
-
+#if LV_USE_TILE_ANIM
+// the eyes are converted into tile animations at build time
+#define UI_EYES_IMG_T               lv_tile_anim_dsc_t
+#define UI_EYES_IMG_DECLARE(name)   extern const lv_tile_anim_dsc_t name
+#define __ui_eyes_create(parent)    lv_tile_anim_create(parent)
+#define __ui_eyes_set_src(obj, img) lv_tile_anim_set_src(obj, img)
+#else
+#define UI_EYES_IMG_T               lv_img_dsc_t
+#define UI_EYES_IMG_DECLARE(name)   LV_IMG_DECLARE(name)
+#define __ui_eyes_create(parent)    lv_gif_create(parent)
+#define __ui_eyes_set_src(obj, img) lv_gif_set_src(obj, img)
+#endif
 
 /***********************************************************
 ***********************typedef define***********************
 ***********************************************************/
 typedef struct {
     char *name;
-    const lv_img_dsc_t *img;
+    const UI_EYES_IMG_T *img;
 } UI_EYES_EMOJI_T;
 
 /***********************************************************
 ***********************variable define**********************
 ***********************************************************/
-LV_IMG_DECLARE(Nature128);
-LV_IMG_DECLARE(Touch128);
-LV_IMG_DECLARE(Angry128);
-LV_IMG_DECLARE(Fearful128);
-LV_IMG_DECLARE(Surprise128);
-LV_IMG_DECLARE(Sad128);
-LV_IMG_DECLARE(Think128);
-LV_IMG_DECLARE(Happy128);
-LV_IMG_DECLARE(Confused128);
-LV_IMG_DECLARE(Disappointed128);
+UI_EYES_IMG_DECLARE(Nature128);
+UI_EYES_IMG_DECLARE(Touch128);
+UI_EYES_IMG_DECLARE(Angry128);
+UI_EYES_IMG_DECLARE(Fearful128);
+UI_EYES_IMG_DECLARE(Surprise128);
+UI_EYES_IMG_DECLARE(Sad128);
+UI_EYES_IMG_DECLARE(Think128);
+UI_EYES_IMG_DECLARE(Happy128);
+UI_EYES_IMG_DECLARE(Confused128);
+UI_EYES_IMG_DECLARE(Disappointed128);
 
 static const UI_EYES_EMOJI_T cEYES_EMOJI_LIST[] = {
     {EMOJI_NEUTRAL,      &Nature128},
@@ -57,13 +71,13 @@ static lv_obj_t *sg_eyes_gif;
 /***********************************************************
 ***********************function define**********************
 ***********************************************************/
-static lv_img_dsc_t *__ui_eyes_get_img(char *name)
+static const UI_EYES_IMG_T *__ui_eyes_get_img(char *name)
 {
     int i = 0;
 
     for (i = 0; i < CNTSOF(cEYES_EMOJI_LIST); i++) {
         if (0 == strcasecmp(cEYES_EMOJI_LIST[i].name, name)) {
-            return (lv_img_dsc_t *)cEYES_EMOJI_LIST[i].img;
+            return cEYES_EMOJI_LIST[i].img;
         }
     }
 
@@ -72,16 +86,16 @@ static lv_img_dsc_t *__ui_eyes_get_img(char *name)
 
 int ui_init(UI_FONT_T *ui_font)
 {
-    lv_img_dsc_t *img = NULL;
+    const UI_EYES_IMG_T *img = NULL;
 
-    sg_eyes_gif = lv_gif_create(lv_scr_act());
+    sg_eyes_gif = __ui_eyes_create(lv_scr_act());
     img = __ui_eyes_get_img(EMOJI_NEUTRAL);
     if(NULL == img) {
         PR_ERR("invalid emotion: %s", EMOJI_NEUTRAL);
         return OPRT_INVALID_PARM;
     }
 
-    lv_gif_set_src(sg_eyes_gif, img);
+    __ui_eyes_set_src(sg_eyes_gif, img);
     lv_obj_align(sg_eyes_gif, LV_ALIGN_CENTER, 0, 0);
 
     return OPRT_OK;
@@ -89,7 +103,7 @@ int ui_init(UI_FONT_T *ui_font)
 
 void ui_set_emotion(const char *emotion)
 {
-    lv_img_dsc_t *img = NULL;
+    const UI_EYES_IMG_T *img = NULL;
     
     img = __ui_eyes_get_img((char *)emotion);
     if(NULL == img) {
@@ -97,7 +111,7 @@ void ui_set_emotion(const char *emotion)
         return;
     }
 
-    lv_gif_set_src(sg_eyes_gif, img);
+    __ui_eyes_set_src(sg_eyes_gif, img);
 
     return;
 }
@@ -0,0 +1,310 @@
+/**
+ * @file example_display_convert_bench.c
+ * @brief Benchmark of the pixel format conversion of the display layer.
+ *
+ * This example converts RGB565 frames of several panel sizes into the frame
+ * buffer formats of monochrome, I2 and byte swapped RGB565 panels. Each case
+ * runs the per pixel conversion the LVGL port used before, then the row
+ * kernels of tdl_display_convert.h, and reports the time of a frame for both.
+ * The monochrome and swapped frames of both are compared, the I2 kernel
+ * dithers the grey levels so its frame differs on purpose.
+ *
+ * Key operations demonstrated in this file:
+ * - Conversion of whole frames with tdl_disp_convert_mono_row,
+ *   tdl_disp_convert_i2_row and tdl_disp_convert_swap_row.
+ * - Timing of each conversion in microseconds per frame.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include "tuya_cloud_types.h"
+#include "tal_api.h"
+#include "tkl_output.h"
+#include "tdl_display_convert.h"
+
+/***********************************************************
+************************macro define************************
+***********************************************************/
+#define BENCH_PIXEL_TOTAL (32 * 1024 * 1024) // pixels converted per case and method
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+typedef enum {
+    BENCH_FMT_MONO = 0,
+    BENCH_FMT_I2,
+    BENCH_FMT_SWAP,
+} BENCH_FMT_E;
+
+typedef struct {
+    BENCH_FMT_E fmt;
+    uint16_t width;
+    uint16_t height;
+} BENCH_CASE_T;
+
+typedef void (*BENCH_CONVERT_CB)(const uint16_t *src, uint16_t *work, uint8_t *dst, uint16_t width,
+                                 uint16_t height);
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+static const BENCH_CASE_T sg_cases[] = {
+    {BENCH_FMT_MONO, 128, 64},  {BENCH_FMT_MONO, 200, 200}, {BENCH_FMT_MONO, 400, 300},
+    {BENCH_FMT_I2, 200, 200},   {BENCH_FMT_I2, 400, 300},   {BENCH_FMT_SWAP, 240, 240},
+    {BENCH_FMT_SWAP, 320, 240}, {BENCH_FMT_SWAP, 480, 320},
+};
+
+static const char *sg_fmt_name[] = {"mono", "i2", "swap"};
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+
+/* the per pixel conversion of the LVGL port before the row kernels */
+static void __ref_mono_write_point(uint32_t x, uint32_t y, bool enable, uint8_t *frame, uint16_t width,
+                                   uint16_t height)
+{
+    if (NULL == frame || x >= width || y >= height) {
+        PR_ERR("Point (%d, %d) out of bounds", x, y);
+        return;
+    }
+
+    uint32_t write_byte_index = y * (width / 8) + x / 8;
+    uint8_t write_bit = x % 8;
+
+    if (enable) {
+        frame[write_byte_index] |= (1 << write_bit);
+    } else {
+        frame[write_byte_index] &= ~(1 << write_bit);
+    }
+}
+
+static void __ref_i2_write_point(uint32_t x, uint32_t y, uint8_t color, uint8_t *frame, uint16_t width,
+                                 uint16_t height)
+{
+    if (NULL == frame || x >= width || y >= height) {
+        PR_ERR("Point (%d, %d) out of bounds", x, y);
+        return;
+    }
+
+    uint32_t write_byte_index = y * (width / 4) + x / 4;
+    uint8_t write_bit = (x % 4) * 2;
+    uint8_t cleared = frame[write_byte_index] & (~(0x03 << write_bit));
+
+    frame[write_byte_index] = cleared | ((color & 0x03) << write_bit);
+}
+
+static void __ref_mono(const uint16_t *src, uint16_t *work, uint8_t *dst, uint16_t width, uint16_t height)
+{
+    uint32_t x = 0, y = 0, offset = 0;
+
+    for (y = 0; y < height; y++) {
+        for (x = 0; x < width; x++) {
+            __ref_mono_write_point(x, y, (src[offset++] > 0x8FFF) ? false : true, dst, width, height);
+        }
+    }
+}
+
+static void __ref_i2(const uint16_t *src, uint16_t *work, uint8_t *dst, uint16_t width, uint16_t height)
+{
+    uint32_t x = 0, y = 0, offset = 0;
+    uint16_t px = 0;
+    uint8_t grey2 = 0;
+
+    for (y = 0; y < height; y++) {
+        for (x = 0; x < width; x++) {
+            px = src[offset++];
+            grey2 = ~(((px >> 11) + ((px >> 5) & 0x3F) * 2 + (px & 0x1F)) >> 2);
+            __ref_i2_write_point(x, y, grey2, dst, width, height);
+        }
+    }
+}
+
+/* a swap pass over the rendered pixels, then a copy of each row */
+static void __ref_swap(const uint16_t *src, uint16_t *work, uint8_t *dst, uint16_t width, uint16_t height)
+{
+    uint32_t i = 0, y = 0;
+
+    memcpy(work, src, width * height * sizeof(uint16_t));
+    for (i = 0; i < (uint32_t)width * height; i++) {
+        work[i] = (work[i] << 8) | (work[i] >> 8);
+    }
+    for (y = 0; y < height; y++) {
+        memcpy(dst + y * width * sizeof(uint16_t), work + y * width, width * sizeof(uint16_t));
+    }
+}
+
+static void __kernel_mono(const uint16_t *src, uint16_t *work, uint8_t *dst, uint16_t width, uint16_t height)
+{
+    uint32_t y = 0;
+
+    for (y = 0; y < height; y++) {
+        tdl_disp_convert_mono_row(src + y * width, dst + y * TDL_DISP_MONO_STRIDE(width), 0, width);
+    }
+}
+
+static void __kernel_i2(const uint16_t *src, uint16_t *work, uint8_t *dst, uint16_t width, uint16_t height)
+{
+    uint32_t y = 0;
+
+    for (y = 0; y < height; y++) {
+        tdl_disp_convert_i2_row(src + y * width, dst + y * TDL_DISP_I2_STRIDE(width), 0, y, width);
+    }
+}
+
+/* the reference swaps a copy, the kernel reads the rendered pixels as they are */
+static void __kernel_swap(const uint16_t *src, uint16_t *work, uint8_t *dst, uint16_t width, uint16_t height)
+{
+    uint32_t y = 0;
+
+    for (y = 0; y < height; y++) {
+        tdl_disp_convert_swap_row(src + y * width, (uint16_t *)(dst + y * width * sizeof(uint16_t)), width);
+    }
+}
+
+static void __bench_image(uint16_t *src, uint16_t width, uint16_t height)
+{
+    uint32_t x = 0, y = 0, seed = 0x2545F491;
+
+    /* gradients with some noise, so that the thresholds are crossed everywhere */
+    for (y = 0; y < height; y++) {
+        for (x = 0; x < width; x++) {
+            seed = seed * 1103515245 + 12345;
+            src[y * width + x] = (uint16_t)((((x * 31 / width) ^ (seed >> 28)) << 11) |
+                                            (((y * 63 / height) ^ (seed >> 26)) << 5) | ((x + y) & 0x1F));
+        }
+    }
+}
+
+static SYS_TIME_T __bench_run(BENCH_CONVERT_CB convert, const uint16_t *src, uint16_t *work, uint8_t *dst,
+                              uint16_t width, uint16_t height, uint32_t frames)
+{
+    uint32_t i = 0;
+    SYS_TIME_T start = tal_system_get_millisecond(), cost_ms = 0;
+
+    for (i = 0; i < frames; i++) {
+        convert(src, work, dst, width, height);
+    }
+    cost_ms = tal_system_get_millisecond() - start;
+
+    return cost_ms ? cost_ms : 1;
+}
+
+static OPERATE_RET __bench_case(const BENCH_CASE_T *bench)
+{
+    OPERATE_RET rt = OPRT_OK;
+    static const BENCH_CONVERT_CB ref_cb[] = {__ref_mono, __ref_i2, __ref_swap};
+    static const BENCH_CONVERT_CB kernel_cb[] = {__kernel_mono, __kernel_i2, __kernel_swap};
+    uint32_t pixels = (uint32_t)bench->width * bench->height;
+    uint32_t frames = BENCH_PIXEL_TOTAL / pixels;
+    uint32_t dst_len = pixels * sizeof(uint16_t);
+    uint16_t *src = tal_malloc(pixels * sizeof(uint16_t));
+    uint16_t *work = tal_malloc(pixels * sizeof(uint16_t));
+    uint8_t *ref_dst = tal_malloc(dst_len);
+    uint8_t *kernel_dst = tal_malloc(dst_len);
+    SYS_TIME_T ref_ms = 0, kernel_ms = 0;
+
+    if (NULL == src || NULL == work || NULL == ref_dst || NULL == kernel_dst) {
+        rt = OPRT_MALLOC_FAILED;
+        goto __EXIT;
+    }
+
+    __bench_image(src, bench->width, bench->height);
+    memset(ref_dst, 0, dst_len);
+    memset(kernel_dst, 0, dst_len);
+
+    ref_ms = __bench_run(ref_cb[bench->fmt], src, work, ref_dst, bench->width, bench->height, frames);
+    kernel_ms = __bench_run(kernel_cb[bench->fmt], src, work, kernel_dst, bench->width, bench->height, frames);
+
+    if (BENCH_FMT_I2 != bench->fmt && memcmp(ref_dst, kernel_dst, dst_len)) {
+        PR_ERR("%s %dx%d: the row kernel differs from the per pixel conversion", sg_fmt_name[bench->fmt],
+               bench->width, bench->height);
+        rt = OPRT_COM_ERROR;
+        goto __EXIT;
+    }
+
+    PR_NOTICE("%-4s %3dx%3d | per pixel %6llu us/frame | row kernel %6llu us/frame | x%llu.%02llu",
+              sg_fmt_name[bench->fmt], bench->width, bench->height, (uint64_t)ref_ms * 1000 / frames,
+              (uint64_t)kernel_ms * 1000 / frames, (uint64_t)ref_ms / kernel_ms,
+              (uint64_t)ref_ms * 100 / kernel_ms % 100);
+
+__EXIT:
+    tal_free(src);
+    tal_free(work);
+    tal_free(ref_dst);
+    tal_free(kernel_dst);
+    return rt;
+}
+
+/**
+ * @brief user_main
+ *
+ * @return none
+ */
+void user_main(void)
+{
+    OPERATE_RET rt = OPRT_OK;
+    uint32_t idx = 0;
+
+    tal_log_init(TAL_LOG_LEVEL_NOTICE, 1024, (TAL_LOG_OUTPUT_CB)tkl_log_output);
+
+    PR_NOTICE("Application information:");
+    PR_NOTICE("Project name:        %s", PROJECT_NAME);
+    PR_NOTICE("App version:         %s", PROJECT_VERSION);
+    PR_NOTICE("Compile time:        %s", __DATE__);
+    PR_NOTICE("TuyaOpen version:    %s", OPEN_VERSION);
+    PR_NOTICE("TuyaOpen commit-id:  %s", OPEN_COMMIT);
+    PR_NOTICE("Platform chip:       %s", PLATFORM_CHIP);
+    PR_NOTICE("Platform board:      %s", PLATFORM_BOARD);
+    PR_NOTICE("Platform commit-id:  %s", PLATFORM_COMMIT);
+
+    for (idx = 0; idx < CNTSOF(sg_cases); idx++) {
+        TUYA_CALL_ERR_GOTO(__bench_case(&sg_cases[idx]), __EXIT);
+    }
+    PR_NOTICE("display convert bench done");
+
+__EXIT:
+    if (OPRT_OK != rt) {
+        PR_ERR("display convert bench failed, rt:%d", rt);
+    }
+    return;
+}
+
+/**
+ * @brief main
+ *
+ * @param argc
+ * @param argv
+ * @return void
+ */
+#if OPERATING_SYSTEM == SYSTEM_LINUX
+void main(int argc, char *argv[])
+{
+    user_main();
+}
+#else
+
+/* Tuya thread handle */
+static THREAD_HANDLE ty_app_thread = NULL;
+
+/**
+ * @brief  task thread
+ *
+ * @param[in] arg:Parameters when creating a task
+ * @return none
+ */
+static void tuya_app_thread(void *arg)
+{
+    user_main();
+
+    tal_thread_delete(ty_app_thread);
+    ty_app_thread = NULL;
+}
+
+void tuya_app_main(void)
+{
+    THREAD_CFG_T thrd_param = {4096, 4, "tuya_app_main"};
+    tal_thread_create_and_start(&ty_app_thread, NULL, NULL, tuya_app_thread, NULL, &thrd_param);
+}
+#endif
@@ -0,0 +1,306 @@
+/**
+ * @file example_display_flush_bench.c
+ * @brief Benchmark of the dirty rect flush of the display layer.
+ *
+ * This example registers a simulated 320x480 RGB565 SPI panel with the display
+ * layer. The panel keeps its own GRAM and writes the pixel data it receives in
+ * the window set before, like a controller does. Each scenario changes some
+ * regions of the frame buffer every frame and flushes them with
+ * tdl_disp_dev_flush_rects, then the bytes sent on the bus give the bus time
+ * and the frame rate the bus allows, next to those of a whole frame flush.
+ *
+ * Key operations demonstrated in this file:
+ * - Registration of a display device with a flush_rects interface.
+ * - Flushing the dirty rects of a frame with tdl_disp_dev_flush_rects.
+ * - Reading the flush counters with tdl_disp_dev_get_flush_stat.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include "tuya_cloud_types.h"
+#include "tal_api.h"
+#include "tkl_output.h"
+#include "tdl_display_manage.h"
+#include "tdl_display_driver.h"
+
+/***********************************************************
+************************macro define************************
+***********************************************************/
+#define BENCH_DISP_NAME   "bench_panel"
+#define BENCH_WIDTH       320
+#define BENCH_HEIGHT      480
+#define BENCH_PIXEL_BYTES 2
+#define BENCH_FRAME_NUM   200
+#define BENCH_SPI_HZ      40000000 // one bit per clock
+#define BENCH_WINDOW_LEN  11       // CASET, RASET and RAMWR with their parameters
+#define BENCH_STAGE_LEN   (8 * 1024)
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+typedef struct {
+    uint8_t *gram;
+    TDL_DISP_RECT_T window;
+    uint32_t pos;        // pixels written in the window
+    uint64_t bus_bytes;  // commands and pixels
+    uint8_t stage[BENCH_STAGE_LEN];
+} BENCH_PANEL_T;
+
+typedef struct {
+    const char *name;
+    uint8_t rect_num;
+    TDL_DISP_RECT_T rects[4];
+} BENCH_SCENE_T;
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+static BENCH_PANEL_T sg_panel;
+
+static const BENCH_SCENE_T sg_scenes[] = {
+    {"cursor", 1, {{100, 200, 101, 219}}},
+    {"label", 1, {{40, 60, 199, 83}}},
+    {"widgets", 2, {{10, 10, 69, 69}, {250, 400, 309, 469}}},
+    {"overlap", 3, {{20, 300, 119, 339}, {60, 320, 159, 359}, {20, 340, 159, 359}}},
+    {"scroll", 4, {{0, 100, 319, 149}, {0, 150, 319, 199}, {0, 200, 319, 249}, {0, 250, 319, 299}}},
+    {"redraw", 2, {{0, 0, 319, 239}, {0, 240, 319, 479}}},
+};
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+
+static void __panel_window_set(const TDL_DISP_RECT_T *rect)
+{
+    sg_panel.window = *rect;
+    sg_panel.pos = 0;
+    sg_panel.bus_bytes += BENCH_WINDOW_LEN;
+}
+
+/* write the data in the window, row after row, as the controller does */
+static OPERATE_RET __panel_data_write(void *arg, uint8_t *data, uint32_t len)
+{
+    uint32_t width = sg_panel.window.x2 - sg_panel.window.x1 + 1;
+    uint32_t pixels = len / BENCH_PIXEL_BYTES, i = 0, x = 0, y = 0;
+
+    for (i = 0; i < pixels; i++, sg_panel.pos++) {
+        x = sg_panel.window.x1 + sg_panel.pos % width;
+        y = sg_panel.window.y1 + sg_panel.pos / width;
+        if (y > sg_panel.window.y2) {
+            return OPRT_EXCEED_UPPER_LIMIT;
+        }
+        memcpy(sg_panel.gram + (y * BENCH_WIDTH + x) * BENCH_PIXEL_BYTES, data + i * BENCH_PIXEL_BYTES,
+               BENCH_PIXEL_BYTES);
+    }
+    sg_panel.bus_bytes += len;
+
+    return OPRT_OK;
+}
+
+static OPERATE_RET __panel_open(TDD_DISP_DEV_HANDLE_T device)
+{
+    return OPRT_OK;
+}
+
+static OPERATE_RET __panel_flush(TDD_DISP_DEV_HANDLE_T device, TDL_DISP_FRAME_BUFF_T *frame_buff)
+{
+    TDL_DISP_RECT_T full = {0, 0, frame_buff->width - 1, frame_buff->height - 1};
+
+    __panel_window_set(&full);
+    return __panel_data_write(NULL, frame_buff->frame, frame_buff->len);
+}
+
+static OPERATE_RET __panel_flush_rects(TDD_DISP_DEV_HANDLE_T device, TDL_DISP_FRAME_BUFF_T *frame_buff,
+                                       const TDL_DISP_RECT_T *rects, uint8_t rect_num)
+{
+    OPERATE_RET rt = OPRT_OK;
+    uint8_t i = 0;
+
+    for (i = 0; i < rect_num; i++) {
+        __panel_window_set(&rects[i]);
+        TUYA_CALL_ERR_RETURN(
+            tdl_disp_rect_send(frame_buff, &rects[i], sg_panel.stage, BENCH_STAGE_LEN, __panel_data_write, NULL));
+    }
+
+    return rt;
+}
+
+static OPERATE_RET __panel_close(TDD_DISP_DEV_HANDLE_T device)
+{
+    return OPRT_OK;
+}
+
+static OPERATE_RET __bench_panel_register(void)
+{
+    TDD_DISP_DEV_INFO_T info;
+    TDD_DISP_INTFS_T intfs = {
+        .open = __panel_open,
+        .flush = __panel_flush,
+        .close = __panel_close,
+        .flush_rects = __panel_flush_rects,
+    };
+
+    sg_panel.gram = tal_malloc(BENCH_WIDTH * BENCH_HEIGHT * BENCH_PIXEL_BYTES);
+    if (NULL == sg_panel.gram) {
+        return OPRT_MALLOC_FAILED;
+    }
+
+    memset(&info, 0, sizeof(info));
+    info.type = TUYA_DISPLAY_SPI;
+    info.width = BENCH_WIDTH;
+    info.height = BENCH_HEIGHT;
+    info.fmt = TUYA_PIXEL_FMT_RGB565;
+    info.rotation = TUYA_DISPLAY_ROTATION_0;
+    info.bl.type = TUYA_DISP_BL_TP_NONE;
+    info.power.pin = TUYA_GPIO_NUM_MAX;
+    info.rect_x_align = 2; // like the controllers that write pixel pairs
+    info.rect_y_align = 1;
+
+    return tdl_disp_device_register(BENCH_DISP_NAME, (TDD_DISP_DEV_HANDLE_T)&sg_panel, &intfs, &info);
+}
+
+static void __bench_rect_fill(TDL_DISP_FRAME_BUFF_T *fb, const TDL_DISP_RECT_T *rect, uint16_t color)
+{
+    uint16_t x = 0, y = 0;
+    uint16_t *pixels = (uint16_t *)fb->frame;
+
+    for (y = rect->y1; y <= rect->y2; y++) {
+        for (x = rect->x1; x <= rect->x2; x++) {
+            pixels[y * fb->width + x] = color + x;
+        }
+    }
+}
+
+static void __bench_report(const char *name, uint64_t bus_bytes, uint32_t frames, uint32_t rects, SYS_TIME_T cost_ms)
+{
+    uint64_t frame_bytes = bus_bytes / frames;
+    uint64_t bus_us = frame_bytes * 8 * 1000000 / BENCH_SPI_HZ;
+
+    bus_us = bus_us ? bus_us : 1;
+    PR_NOTICE("%-8s rects/frame:%2u | %7llu B/frame | bus %6llu us/frame | %5llu fps | cpu %4llu us/frame", name,
+              rects / frames, frame_bytes, bus_us, 1000000 / bus_us, (uint64_t)cost_ms * 1000 / frames);
+}
+
+static OPERATE_RET __bench_scene(TDL_DISP_HANDLE_T disp_hdl, TDL_DISP_FRAME_BUFF_T *fb, const BENCH_SCENE_T *scene)
+{
+    OPERATE_RET rt = OPRT_OK;
+    TDL_DISP_FLUSH_STAT_T start, end;
+    uint64_t bus_bytes = 0;
+    uint32_t frame = 0;
+    uint8_t i = 0;
+    SYS_TIME_T start_ms = 0, cost_ms = 0;
+
+    TUYA_CALL_ERR_RETURN(tdl_disp_dev_get_flush_stat(disp_hdl, &start));
+    bus_bytes = sg_panel.bus_bytes;
+    start_ms = tal_system_get_millisecond();
+    for (frame = 0; frame < BENCH_FRAME_NUM; frame++) {
+        for (i = 0; i < scene->rect_num; i++) {
+            __bench_rect_fill(fb, &scene->rects[i], frame * 97 + i);
+        }
+        TUYA_CALL_ERR_RETURN(tdl_disp_dev_flush_rects(disp_hdl, fb, scene->rects, scene->rect_num));
+    }
+    cost_ms = tal_system_get_millisecond() - start_ms;
+    TUYA_CALL_ERR_RETURN(tdl_disp_dev_get_flush_stat(disp_hdl, &end));
+
+    if (memcmp(sg_panel.gram, fb->frame, fb->len)) {
+        PR_ERR("%s: the panel differs from the frame buffer", scene->name);
+        return OPRT_COM_ERROR;
+    }
+    __bench_report(scene->name, sg_panel.bus_bytes - bus_bytes, end.frames - start.frames, end.rects - start.rects,
+                   cost_ms);
+
+    return rt;
+}
+
+/**
+ * @brief user_main
+ *
+ * @return none
+ */
+void user_main(void)
+{
+    OPERATE_RET rt = OPRT_OK;
+    TDL_DISP_HANDLE_T disp_hdl = NULL;
+    TDL_DISP_FRAME_BUFF_T *fb = NULL;
+    uint32_t idx = 0;
+
+    tal_log_init(TAL_LOG_LEVEL_NOTICE, 1024, (TAL_LOG_OUTPUT_CB)tkl_log_output);
+
+    PR_NOTICE("Application information:");
+    PR_NOTICE("Project name:        %s", PROJECT_NAME);
+    PR_NOTICE("App version:         %s", PROJECT_VERSION);
+    PR_NOTICE("Compile time:        %s", __DATE__);
+    PR_NOTICE("TuyaOpen version:    %s", OPEN_VERSION);
+    PR_NOTICE("TuyaOpen commit-id:  %s", OPEN_COMMIT);
+    PR_NOTICE("Platform chip:       %s", PLATFORM_CHIP);
+    PR_NOTICE("Platform board:      %s", PLATFORM_BOARD);
+    PR_NOTICE("Platform commit-id:  %s", PLATFORM_COMMIT);
+
+    TUYA_CALL_ERR_GOTO(__bench_panel_register(), __EXIT);
+    disp_hdl = tdl_disp_find_dev(BENCH_DISP_NAME);
+    TUYA_CALL_ERR_GOTO(tdl_disp_dev_open(disp_hdl), __EXIT);
+
+    fb = tdl_disp_create_frame_buff(DISP_FB_TP_SRAM, BENCH_WIDTH * BENCH_HEIGHT * BENCH_PIXEL_BYTES);
+    if (NULL == fb) {
+        rt = OPRT_MALLOC_FAILED;
+        goto __EXIT;
+    }
+    fb->fmt = TUYA_PIXEL_FMT_RGB565;
+    fb->width = BENCH_WIDTH;
+    fb->height = BENCH_HEIGHT;
+
+    /* the panel starts with the content of the frame buffer */
+    TUYA_CALL_ERR_GOTO(tdl_disp_dev_flush(disp_hdl, fb), __EXIT);
+    __bench_report("full", sg_panel.bus_bytes, 1, 0, 0);
+
+    for (idx = 0; idx < CNTSOF(sg_scenes); idx++) {
+        TUYA_CALL_ERR_GOTO(__bench_scene(disp_hdl, fb, &sg_scenes[idx]), __EXIT);
+    }
+    PR_NOTICE("display flush bench done");
+
+__EXIT:
+    if (OPRT_OK != rt) {
+        PR_ERR("display flush bench failed, rt:%d", rt);
+    }
+    tdl_disp_free_frame_buff(fb);
+    return;
+}
+
+/**
+ * @brief main
+ *
+ * @param argc
+ * @param argv
+ * @return void
+ */
+#if OPERATING_SYSTEM == SYSTEM_LINUX
+void main(int argc, char *argv[])
+{
+    user_main();
+}
+#else
+
+/* Tuya thread handle */
+static THREAD_HANDLE ty_app_thread = NULL;
+
+/**
+ * @brief  task thread
+ *
+ * @param[in] arg:Parameters when creating a task
+ * @return none
+ */
+static void tuya_app_thread(void *arg)
+{
+    user_main();
+
+    tal_thread_delete(ty_app_thread);
+    ty_app_thread = NULL;
+}
+
+void tuya_app_main(void)
+{
+    THREAD_CFG_T thrd_param = {4096, 4, "tuya_app_main"};
+    tal_thread_create_and_start(&ty_app_thread, NULL, NULL, tuya_app_thread, NULL, &thrd_param);
+}
+#endif
@@ -0,0 +1,212 @@
+/**
+ * @file example_lvgl_render_bench.c
+ * @brief Benchmark of the LVGL software rendering.
+ *
+ * This example runs the scenes of lv_demo_benchmark on a display without a
+ * panel, its flush returns at once, so that only the rendering is timed. The
+ * LVGL tick is driven by the example: each loop moves it one refresh period
+ * ahead and runs the timer handler, so every scene renders the same frames on
+ * any board and the loop never sleeps. The time of each scene is divided by
+ * the frames rendered in it.
+ *
+ * Build it once with LVGL_USE_OS disabled and once per LVGL_DRAW_UNIT_CNT to
+ * compare the single threaded rendering with the parallel draw units.
+ *
+ * Key operations demonstrated in this file:
+ * - Creation of an LVGL display with a dummy flush.
+ * - Rendering of the lv_demo_benchmark scenes in simulated time.
+ * - Timing of each scene in microseconds per rendered frame.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include "tuya_cloud_types.h"
+#include "tal_api.h"
+#include "tkl_output.h"
+
+#include "lvgl.h"
+#include "demos/lv_demos.h"
+
+/***********************************************************
+************************macro define************************
+***********************************************************/
+#define BENCH_WIDTH     480
+#define BENCH_HEIGHT    320
+#define BENCH_BUF_PARTS 10 // the draw buffer is this part of the display, as in the LVGL port
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+typedef struct {
+    const char *name;
+    uint32_t time_ms;
+} BENCH_SCENE_T;
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+/* the scene schedule of lv_demo_benchmark.c */
+static const BENCH_SCENE_T sg_scenes[] = {
+    {"Empty screen", 3000},
+    {"Moving wallpaper", 3000},
+    {"Single rectangle", 3000},
+    {"Multiple rectangles", 3000},
+    {"Multiple RGB images", 3000},
+    {"Multiple ARGB images", 3000},
+    {"Rotated ARGB images", 3000},
+    {"Multiple labels", 3000},
+    {"Screen sized text", 5000},
+    {"Multiple arcs", 3000},
+    {"Containers", 3000},
+    {"Containers with overlay", 3000},
+    {"Containers with opa", 3000},
+    {"Containers with opa_layer", 3000},
+    {"Containers with scrolling", 5000},
+    {"Widgets demo", 20000},
+};
+
+static uint32_t sg_tick = 0;
+static uint32_t sg_frames = 0;
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+static uint32_t __bench_tick_cb(void)
+{
+    return sg_tick;
+}
+
+static void __bench_flush_cb(lv_display_t *disp, const lv_area_t *area, uint8_t *px_map)
+{
+    lv_display_flush_ready(disp);
+}
+
+static void __bench_render_ready_cb(lv_event_t *e)
+{
+    sg_frames++;
+}
+
+static OPERATE_RET __bench_scene(const BENCH_SCENE_T *scene, uint64_t *total_ms, uint32_t *total_frames)
+{
+    uint32_t end = sg_tick + scene->time_ms;
+    SYS_TIME_T start = tal_system_get_millisecond(), cost_ms = 0;
+
+    sg_frames = 0;
+    while (sg_tick < end) {
+        sg_tick += LV_DEF_REFR_PERIOD;
+        lv_timer_handler();
+    }
+    cost_ms = tal_system_get_millisecond() - start;
+
+    if (0 == sg_frames) {
+        PR_ERR("%s: no frame rendered", scene->name);
+        return OPRT_COM_ERROR;
+    }
+
+    PR_NOTICE("%-26s | %4u frames | %6llu us/frame", scene->name, sg_frames, (uint64_t)cost_ms * 1000 / sg_frames);
+
+    *total_ms += cost_ms;
+    *total_frames += sg_frames;
+
+    return OPRT_OK;
+}
+
+/**
+ * @brief user_main
+ *
+ * @return none
+ */
+void user_main(void)
+{
+    OPERATE_RET rt = OPRT_OK;
+    uint32_t idx = 0, total_frames = 0;
+    uint32_t buf_len = BENCH_WIDTH * BENCH_HEIGHT / BENCH_BUF_PARTS * (LV_COLOR_DEPTH / 8);
+    uint64_t total_ms = 0;
+    uint8_t *buf = NULL;
+    lv_display_t *disp = NULL;
+
+    tal_log_init(TAL_LOG_LEVEL_NOTICE, 1024, (TAL_LOG_OUTPUT_CB)tkl_log_output);
+
+    PR_NOTICE("Application information:");
+    PR_NOTICE("Project name:        %s", PROJECT_NAME);
+    PR_NOTICE("App version:         %s", PROJECT_VERSION);
+    PR_NOTICE("Compile time:        %s", __DATE__);
+    PR_NOTICE("TuyaOpen version:    %s", OPEN_VERSION);
+    PR_NOTICE("TuyaOpen commit-id:  %s", OPEN_COMMIT);
+    PR_NOTICE("Platform chip:       %s", PLATFORM_CHIP);
+    PR_NOTICE("Platform board:      %s", PLATFORM_BOARD);
+    PR_NOTICE("Platform commit-id:  %s", PLATFORM_COMMIT);
+
+    buf = tal_malloc(buf_len);
+    if (NULL == buf) {
+        rt = OPRT_MALLOC_FAILED;
+        goto __EXIT;
+    }
+
+    lv_init();
+    lv_tick_set_cb(__bench_tick_cb);
+
+    disp = lv_display_create(BENCH_WIDTH, BENCH_HEIGHT);
+    lv_display_set_flush_cb(disp, __bench_flush_cb);
+    lv_display_set_buffers(disp, buf, NULL, buf_len, LV_DISPLAY_RENDER_MODE_PARTIAL);
+    lv_display_add_event_cb(disp, __bench_render_ready_cb, LV_EVENT_RENDER_READY, NULL);
+
+    PR_NOTICE("render %dx%d with %d draw unit(s)", BENCH_WIDTH, BENCH_HEIGHT, LV_DRAW_SW_DRAW_UNIT_CNT);
+
+    lv_demo_benchmark();
+    for (idx = 0; idx < CNTSOF(sg_scenes); idx++) {
+        TUYA_CALL_ERR_GOTO(__bench_scene(&sg_scenes[idx], &total_ms, &total_frames), __EXIT);
+    }
+
+    PR_NOTICE("%-26s | %4u frames | %6llu us/frame", "All scenes", total_frames, total_ms * 1000 / total_frames);
+    PR_NOTICE("lvgl render bench done");
+
+__EXIT:
+    if (OPRT_OK != rt) {
+        PR_ERR("lvgl render bench failed, rt:%d", rt);
+    }
+    if (disp) {
+        lv_display_delete(disp);
+    }
+    tal_free(buf);
+    return;
+}
+
+/**
+ * @brief main
+ *
+ * @param argc
+ * @param argv
+ * @return void
+ */
+#if OPERATING_SYSTEM == SYSTEM_LINUX
+void main(int argc, char *argv[])
+{
+    user_main();
+}
+#else
+
+/* Tuya thread handle */
+static THREAD_HANDLE ty_app_thread = NULL;
+
+/**
+ * @brief  task thread
+ *
+ * @param[in] arg:Parameters when creating a task
+ * @return none
+ */
+static void tuya_app_thread(void *arg)
+{
+    user_main();
+
+    tal_thread_delete(ty_app_thread);
+    ty_app_thread = NULL;
+}
+
+void tuya_app_main(void)
+{
+    THREAD_CFG_T thrd_param = {8192, 4, "tuya_app_main"};
+    tal_thread_create_and_start(&ty_app_thread, NULL, NULL, tuya_app_thread, NULL, &thrd_param);
+}
+#endif
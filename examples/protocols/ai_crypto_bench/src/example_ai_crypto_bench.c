@@ -0,0 +1,206 @@
+/**
+ * @file example_ai_crypto_bench.c
+ * @brief Benchmark of the AI protocol crypto engine.
+ *
+ * This example measures the per packet cost of the persistent AI protocol crypto
+ * engine for every security level: ChaCha20 (SL2), AES-256-CBC (SL3) and
+ * AES-256-GCM (SL4). Each round encrypts and signs a packet the way the send path
+ * does, then verifies and decrypts it the way the read path does.
+ *
+ * Key operations demonstrated in this file:
+ * - Initialization of a tx and a rx crypto engine per security level.
+ * - In place encryption, signing, verification and decryption of packets.
+ * - Reporting of us per packet and bytes per second for each packet size.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include "tuya_cloud_types.h"
+#include "tal_api.h"
+#include "tkl_output.h"
+#include "uni_random.h"
+#include "tuya_ai_crypto.h"
+
+/***********************************************************
+************************macro define************************
+***********************************************************/
+#define BENCH_MAX_DATA_LEN 4096
+#define BENCH_TOTAL_BYTES  (4 * 1024 * 1024)
+#define BENCH_MIN_ROUNDS   200
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+static const uint32_t sg_bench_size[] = {64, 256, 1024, BENCH_MAX_DATA_LEN};
+static const AI_PACKET_SL sg_bench_sl[] = {AI_PACKET_SL2, AI_PACKET_SL3, AI_PACKET_SL4};
+
+static uint8_t sg_crypt_key[AI_KEY_LEN];
+static uint8_t sg_sign_key[AI_KEY_LEN];
+static uint8_t sg_packet[BENCH_MAX_DATA_LEN + AI_IV_LEN + AI_GCM_TAG_LEN];
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+
+static OPERATE_RET __bench_sign(AI_CRYPTO_T *crypto, uint8_t *data, uint32_t len, uint8_t *signature)
+{
+    OPERATE_RET rt = OPRT_OK;
+    uint32_t tail = (len > 32) ? 32 : len;
+
+    TUYA_CALL_ERR_RETURN(tuya_ai_crypto_sign_starts(crypto));
+    TUYA_CALL_ERR_RETURN(tuya_ai_crypto_sign_update(crypto, data, tail));
+    TUYA_CALL_ERR_RETURN(tuya_ai_crypto_sign_update(crypto, data + len - tail, tail));
+    TUYA_CALL_ERR_RETURN(tuya_ai_crypto_sign_finish(crypto, signature));
+    return rt;
+}
+
+static OPERATE_RET __bench_run(AI_CRYPTO_T *tx, AI_CRYPTO_T *rx, uint32_t size)
+{
+    OPERATE_RET rt = OPRT_OK;
+    uint8_t tx_iv[AI_IV_LEN], rx_iv[AI_IV_LEN];
+    uint8_t tx_sign[AI_SIGN_LEN], rx_sign[AI_SIGN_LEN];
+    uint32_t rounds = BENCH_TOTAL_BYTES / size;
+    uint32_t idx = 0, en_len = 0, de_len = 0;
+    SYS_TIME_T tx_ms = 0, rx_ms = 0, start = 0;
+
+    if (rounds < BENCH_MIN_ROUNDS) {
+        rounds = BENCH_MIN_ROUNDS;
+    }
+
+    for (idx = 0; idx < rounds; idx++) {
+        uni_random_bytes(tx_iv, AI_IV_LEN);
+        memcpy(rx_iv, tx_iv, AI_IV_LEN);
+        memset(sg_packet, (uint8_t)idx, size);
+
+        start = tal_system_get_millisecond();
+        TUYA_CALL_ERR_RETURN(tuya_ai_crypto_encrypt(tx, tx_iv, sg_packet, size, &en_len));
+        TUYA_CALL_ERR_RETURN(__bench_sign(tx, sg_packet, en_len, tx_sign));
+        tx_ms += tal_system_get_millisecond() - start;
+
+        start = tal_system_get_millisecond();
+        TUYA_CALL_ERR_RETURN(__bench_sign(rx, sg_packet, en_len, rx_sign));
+        if (memcmp(tx_sign, rx_sign, AI_SIGN_LEN)) {
+            PR_ERR("sign mismatch, sl:%d, size:%d", tx->sl, size);
+            return OPRT_COM_ERROR;
+        }
+        rt = tuya_ai_crypto_decrypt(rx, rx_iv, sg_packet, en_len, sg_packet, &de_len);
+        rx_ms += tal_system_get_millisecond() - start;
+
+        /* SL2 keeps the padding out of the keystream, so only SL3/4 round trip the length */
+        if (tx->sl == AI_PACKET_SL2) {
+            rt = OPRT_OK;
+            continue;
+        }
+        if (OPRT_OK != rt) {
+            return rt;
+        }
+        if (de_len != size) {
+            PR_ERR("decrypt len mismatch, sl:%d, %d != %d", tx->sl, de_len, size);
+            return OPRT_COM_ERROR;
+        }
+    }
+
+    tx_ms = tx_ms ? tx_ms : 1;
+    rx_ms = rx_ms ? rx_ms : 1;
+    PR_NOTICE("sl:%d size:%5d rounds:%6d | tx %6llu us/pkt %10llu B/s | rx %6llu us/pkt %10llu B/s", tx->sl, size,
+              rounds, (uint64_t)tx_ms * 1000 / rounds, (uint64_t)size * rounds * 1000 / tx_ms,
+              (uint64_t)rx_ms * 1000 / rounds, (uint64_t)size * rounds * 1000 / rx_ms);
+    return rt;
+}
+
+static void __bench_sl(AI_PACKET_SL sl)
+{
+    OPERATE_RET rt = OPRT_OK;
+    AI_CRYPTO_T tx, rx;
+    uint32_t idx = 0;
+
+    memset(&tx, 0, sizeof(tx));
+    memset(&rx, 0, sizeof(rx));
+    TUYA_CALL_ERR_GOTO(tuya_ai_crypto_init(&tx, sl, TRUE, sg_crypt_key, sg_sign_key), __EXIT);
+    TUYA_CALL_ERR_GOTO(tuya_ai_crypto_init(&rx, sl, FALSE, sg_crypt_key, sg_sign_key), __EXIT);
+
+    for (idx = 0; idx < CNTSOF(sg_bench_size); idx++) {
+        TUYA_CALL_ERR_GOTO(__bench_run(&tx, &rx, sg_bench_size[idx]), __EXIT);
+    }
+
+__EXIT:
+    if (OPRT_OK != rt) {
+        PR_ERR("bench sl:%d failed, rt:%d", sl, rt);
+    }
+    tuya_ai_crypto_deinit(&tx);
+    tuya_ai_crypto_deinit(&rx);
+}
+
+/**
+ * @brief user_main
+ *
+ * @return none
+ */
+void user_main(void)
+{
+    uint32_t idx = 0;
+
+    /* basic init */
+    tal_log_init(TAL_LOG_LEVEL_DEBUG, 1024, (TAL_LOG_OUTPUT_CB)tkl_log_output);
+
+    PR_NOTICE("Application information:");
+    PR_NOTICE("Project name:        %s", PROJECT_NAME);
+    PR_NOTICE("App version:         %s", PROJECT_VERSION);
+    PR_NOTICE("Compile time:        %s", __DATE__);
+    PR_NOTICE("TuyaOpen version:    %s", OPEN_VERSION);
+    PR_NOTICE("TuyaOpen commit-id:  %s", OPEN_COMMIT);
+    PR_NOTICE("Platform chip:       %s", PLATFORM_CHIP);
+    PR_NOTICE("Platform board:      %s", PLATFORM_BOARD);
+    PR_NOTICE("Platform commit-id:  %s", PLATFORM_COMMIT);
+
+    uni_random_bytes(sg_crypt_key, sizeof(sg_crypt_key));
+    uni_random_bytes(sg_sign_key, sizeof(sg_sign_key));
+
+    for (idx = 0; idx < CNTSOF(sg_bench_sl); idx++) {
+        __bench_sl(sg_bench_sl[idx]);
+    }
+    PR_NOTICE("ai crypto bench done");
+}
+
+/**
+ * @brief main
+ *
+ * @param argc
+ * @param argv
+ * @return void
+ */
+#if OPERATING_SYSTEM == SYSTEM_LINUX
+void main(int argc, char *argv[])
+{
+    user_main();
+}
+#else
+
+/* Tuya thread handle */
+static THREAD_HANDLE ty_app_thread = NULL;
+
+/**
+ * @brief  task thread
+ *
+ * @param[in] arg:Parameters when creating a task
+ * @return none
+ */
+static void tuya_app_thread(void *arg)
+{
+    user_main();
+
+    tal_thread_delete(ty_app_thread);
+    ty_app_thread = NULL;
+}
+
+void tuya_app_main(void)
+{
+    THREAD_CFG_T thrd_param = {4096, 4, "tuya_app_main"};
+    tal_thread_create_and_start(&ty_app_thread, NULL, NULL, tuya_app_thread, NULL, &thrd_param);
+}
+#endif
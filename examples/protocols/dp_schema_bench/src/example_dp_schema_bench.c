@@ -0,0 +1,308 @@
+/**
+ * @file example_dp_schema_bench.c
+ * @brief Benchmark of the DP schema lookups.
+ *
+ * This example creates DP schemas of 8, 64 and 255 DPs and measures the paths
+ * that look DPs up in them: the node lookup by id, the report path that checks
+ * and serializes every DP, and the receive path that parses a command carrying
+ * every DP.
+ *
+ * Key operations demonstrated in this file:
+ * - Creation of a DP schema from its JSON description.
+ * - Reporting with dp_rept_valid_check and dp_rept_json_output.
+ * - Parsing of a received command with dp_data_recv_parse.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include "tuya_cloud_types.h"
+#include "tal_api.h"
+#include "tkl_output.h"
+#include "dp_schema.h"
+
+/***********************************************************
+************************macro define************************
+***********************************************************/
+#define BENCH_DEVID        "bench_dp_schema_devid"
+#define BENCH_FIND_TOTAL   2000000 // node lookups per schema
+#define BENCH_DP_TOTAL     200000  // dps reported or received per schema
+#define BENCH_SCHEMA_ITEM  128     // json bytes of one dp description
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+static const uint16_t sg_bench_dp_num[] = {8, 64, DP_NODE_NUM_MAX};
+
+static uint32_t sg_recv_cnt = 0;
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+
+/* dp i + 1 is a bool for odd i and a value in [0, 1000] otherwise */
+static char *__bench_schema_json(uint16_t dp_num)
+{
+    uint16_t i = 0;
+    int offset = 0;
+    char *json = tal_malloc(dp_num * BENCH_SCHEMA_ITEM + 2);
+
+    if (NULL == json) {
+        return NULL;
+    }
+
+    json[offset++] = '[';
+    for (i = 0; i < dp_num; i++) {
+        if (i & 1) {
+            offset += sprintf(json + offset, "{\"id\":%d,\"mode\":\"rw\",\"type\":\"obj\",\"property\":{\"type\":\"bool\"}},",
+                              i + 1);
+        } else {
+            offset += sprintf(json + offset,
+                              "{\"id\":%d,\"mode\":\"rw\",\"type\":\"obj\",\"property\":{\"type\":\"value\",\"min\":0,"
+                              "\"max\":1000,\"scale\":0}},",
+                              i + 1);
+        }
+    }
+    json[offset - 1] = ']';
+    json[offset] = 0;
+
+    return json;
+}
+
+static void __bench_dps_fill(dp_obj_t *dps, uint16_t dp_num, uint32_t round)
+{
+    uint16_t i = 0;
+
+    for (i = 0; i < dp_num; i++) {
+        dps[i].id = i + 1;
+        if (i & 1) {
+            dps[i].type = PROP_BOOL;
+            dps[i].value.dp_bool = (round + i) & 1;
+        } else {
+            dps[i].type = PROP_VALUE;
+            dps[i].value.dp_value = (round + i) % 1001;
+        }
+        dps[i].time_stamp = 0;
+    }
+}
+
+static void __bench_recv_cb(dp_type_t type, void *dp_data, void *user_data)
+{
+    sg_recv_cnt += ((dp_obj_recv_t *)dp_data)->dpscnt;
+}
+
+static OPERATE_RET __bench_find(dp_schema_t *schema, uint16_t dp_num)
+{
+    uint32_t rounds = BENCH_FIND_TOTAL / dp_num;
+    uint32_t idx = 0, found = 0;
+    uint16_t id = 0;
+    SYS_TIME_T start = tal_system_get_millisecond(), cost_ms = 0;
+
+    for (idx = 0; idx < rounds; idx++) {
+        for (id = 1; id <= dp_num; id++) {
+            found += (NULL != dp_node_find(schema, id));
+        }
+    }
+    cost_ms = tal_system_get_millisecond() - start;
+    cost_ms = cost_ms ? cost_ms : 1;
+
+    if (found != rounds * dp_num) {
+        PR_ERR("find mismatch %d != %d", found, rounds * dp_num);
+        return OPRT_COM_ERROR;
+    }
+    PR_NOTICE("dps:%3d find    ops:%8d | total %6llu ms | %6llu ns/op", dp_num, found, (uint64_t)cost_ms,
+              (uint64_t)cost_ms * 1000000 / found);
+    return OPRT_OK;
+}
+
+static OPERATE_RET __bench_rept(dp_schema_t *schema, uint16_t dp_num)
+{
+    OPERATE_RET rt = OPRT_OK;
+    uint32_t rounds = BENCH_DP_TOTAL / dp_num;
+    uint32_t idx = 0;
+    dp_obj_t *dps = tal_malloc(dp_num * sizeof(dp_obj_t));
+    dp_rept_valid_t *dpvalid = tal_malloc(sizeof(dp_rept_valid_t) + dp_num);
+    dp_rept_in_t dpin;
+    dp_rept_out_t dpout;
+    SYS_TIME_T start = 0, cost_ms = 0;
+
+    if (NULL == dps || NULL == dpvalid) {
+        rt = OPRT_MALLOC_FAILED;
+        goto __EXIT;
+    }
+
+    start = tal_system_get_millisecond();
+    for (idx = 0; idx < rounds; idx++) {
+        __bench_dps_fill(dps, dp_num, idx);
+        memset(&dpin, 0, sizeof(dpin));
+        dpin.rept_type = T_OBJ_REPT;
+        dpin.flags = DP_REPT_NO_FILTER_FLAG;
+        dpin.dpscnt = dp_num;
+        dpin.dps = dps;
+        memset(dpvalid, 0, sizeof(dp_rept_valid_t) + dp_num);
+        memset(&dpout, 0, sizeof(dpout));
+        TUYA_CALL_ERR_GOTO(dp_rept_valid_check(schema, &dpin, dpvalid), __EXIT);
+        TUYA_CALL_ERR_GOTO(dp_rept_json_output(schema, &dpin, dpvalid, &dpout), __EXIT);
+        tal_free(dpout.dpsjson);
+    }
+    cost_ms = tal_system_get_millisecond() - start;
+    cost_ms = cost_ms ? cost_ms : 1;
+
+    PR_NOTICE("dps:%3d report  rounds:%5d | total %6llu ms | %6llu us/report", dp_num, rounds, (uint64_t)cost_ms,
+              (uint64_t)cost_ms * 1000 / rounds);
+
+__EXIT:
+    tal_free(dps);
+    tal_free(dpvalid);
+    return rt;
+}
+
+static OPERATE_RET __bench_recv(uint16_t dp_num)
+{
+    OPERATE_RET rt = OPRT_OK;
+    uint32_t rounds = BENCH_DP_TOTAL / dp_num;
+    uint32_t idx = 0;
+    uint16_t i = 0;
+    char id[8];
+    cJSON *root = cJSON_CreateObject();
+    cJSON *dps_js = cJSON_CreateObject();
+    dp_recv_msg_t msg;
+    SYS_TIME_T start = 0, cost_ms = 0;
+
+    if (NULL == root || NULL == dps_js) {
+        cJSON_Delete(root);
+        cJSON_Delete(dps_js);
+        return OPRT_MALLOC_FAILED;
+    }
+    cJSON_AddItemToObject(root, "dps", dps_js);
+    for (i = 0; i < dp_num; i++) {
+        snprintf(id, sizeof(id), "%d", i + 1);
+        if (i & 1) {
+            cJSON_AddBoolToObject(dps_js, id, TRUE);
+        } else {
+            cJSON_AddNumberToObject(dps_js, id, i);
+        }
+    }
+
+    memset(&msg, 0, sizeof(msg));
+    msg.devid = BENCH_DEVID;
+    msg.cmd = DP_CMD_MQ;
+    msg.dt_tp = DTT_SCT_UNC;
+    msg.data_js = root;
+
+    sg_recv_cnt = 0;
+    start = tal_system_get_millisecond();
+    for (idx = 0; idx < rounds; idx++) {
+        TUYA_CALL_ERR_GOTO(dp_data_recv_parse(&msg, __bench_recv_cb), __EXIT);
+    }
+    cost_ms = tal_system_get_millisecond() - start;
+    cost_ms = cost_ms ? cost_ms : 1;
+
+    if (sg_recv_cnt != rounds * dp_num) {
+        PR_ERR("recv mismatch %d != %d", sg_recv_cnt, rounds * dp_num);
+        rt = OPRT_COM_ERROR;
+        goto __EXIT;
+    }
+    PR_NOTICE("dps:%3d receive rounds:%5d | total %6llu ms | %6llu us/command", dp_num, rounds, (uint64_t)cost_ms,
+              (uint64_t)cost_ms * 1000 / rounds);
+
+__EXIT:
+    cJSON_Delete(root);
+    return rt;
+}
+
+static void __bench_schema(uint16_t dp_num)
+{
+    OPERATE_RET rt = OPRT_OK;
+    dp_schema_t *schema = NULL;
+    char *json = __bench_schema_json(dp_num);
+
+    if (NULL == json) {
+        PR_ERR("schema json malloc failed");
+        return;
+    }
+
+    TUYA_CALL_ERR_GOTO(dp_schema_create(BENCH_DEVID, json, &schema), __EXIT);
+    TUYA_CALL_ERR_GOTO(__bench_find(schema, dp_num), __EXIT);
+    TUYA_CALL_ERR_GOTO(__bench_rept(schema, dp_num), __EXIT);
+    TUYA_CALL_ERR_GOTO(__bench_recv(dp_num), __EXIT);
+
+__EXIT:
+    if (OPRT_OK != rt) {
+        PR_ERR("bench dps:%d failed, rt:%d", dp_num, rt);
+    }
+    if (schema) {
+        dp_schema_delete(BENCH_DEVID);
+    }
+    tal_free(json);
+}
+
+/**
+ * @brief user_main
+ *
+ * @return none
+ */
+void user_main(void)
+{
+    uint32_t idx = 0;
+
+    /* the report and receive paths log every dp at debug level */
+    tal_log_init(TAL_LOG_LEVEL_NOTICE, 1024, (TAL_LOG_OUTPUT_CB)tkl_log_output);
+
+    PR_NOTICE("Application information:");
+    PR_NOTICE("Project name:        %s", PROJECT_NAME);
+    PR_NOTICE("App version:         %s", PROJECT_VERSION);
+    PR_NOTICE("Compile time:        %s", __DATE__);
+    PR_NOTICE("TuyaOpen version:    %s", OPEN_VERSION);
+    PR_NOTICE("TuyaOpen commit-id:  %s", OPEN_COMMIT);
+    PR_NOTICE("Platform chip:       %s", PLATFORM_CHIP);
+    PR_NOTICE("Platform board:      %s", PLATFORM_BOARD);
+    PR_NOTICE("Platform commit-id:  %s", PLATFORM_COMMIT);
+
+    for (idx = 0; idx < CNTSOF(sg_bench_dp_num); idx++) {
+        __bench_schema(sg_bench_dp_num[idx]);
+    }
+    PR_NOTICE("dp schema bench done");
+}
+
+/**
+ * @brief main
+ *
+ * @param argc
+ * @param argv
+ * @return void
+ */
+#if OPERATING_SYSTEM == SYSTEM_LINUX
+void main(int argc, char *argv[])
+{
+    user_main();
+}
+#else
+
+/* Tuya thread handle */
+static THREAD_HANDLE ty_app_thread = NULL;
+
+/**
+ * @brief  task thread
+ *
+ * @param[in] arg:Parameters when creating a task
+ * @return none
+ */
+static void tuya_app_thread(void *arg)
+{
+    user_main();
+
+    tal_thread_delete(ty_app_thread);
+    ty_app_thread = NULL;
+}
+
+void tuya_app_main(void)
+{
+    THREAD_CFG_T thrd_param = {4096, 4, "tuya_app_main"};
+    tal_thread_create_and_start(&ty_app_thread, NULL, NULL, tuya_app_thread, NULL, &thrd_param);
+}
+#endif
@@ -0,0 +1,194 @@
+/**
+ * @file example_http_download_bench.c
+ * @brief Benchmark of the parallel range download.
+ *
+ * This example downloads the same file with http_file_download using 1, 2 and
+ * 4 workers and reports the throughput of each run. The data is hashed with
+ * SHA-256 as it is delivered, the digests of the runs must be equal since the
+ * blocks fetched by the workers reach the handler in file order.
+ *
+ * Serve a file from the host with a server that answers range requests, for
+ * example `python3 -m RangeHTTPServer 8000`, and set BENCH_URL to it.
+ *
+ * Key operations demonstrated in this file:
+ * - Download of a file with http_file_download and the workers option.
+ * - Hashing of the data in the DL_EVENT_ON_DATA handler.
+ * - Check that every piece of data arrives at the expected offset.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include "tuya_cloud_types.h"
+#include "tal_api.h"
+#include "tkl_output.h"
+#include "http_download.h"
+
+/***********************************************************
+************************macro define************************
+***********************************************************/
+#define BENCH_URL        "http://127.0.0.1:8000/bench.bin"
+#define BENCH_RANGE_LEN  4096  // bytes handed to the handler at once, like the ota
+#define BENCH_BLOCK_SIZE 65536 // bytes of one range request of a worker
+#define BENCH_TIMEOUT_MS 5000
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+typedef struct {
+    TKL_HASH_HANDLE sha256;
+    size_t file_size;
+    size_t received;
+    BOOL_T in_order;
+    BOOL_T finished;
+    uint8_t digest[32];
+} BENCH_RUN_T;
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+static const uint8_t sg_bench_workers[] = {1, 2, 4};
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+
+static void __bench_event_cb(http_download_event_id_t id, http_download_event_t *event)
+{
+    BENCH_RUN_T *run = (BENCH_RUN_T *)event->user_data;
+
+    switch (id) {
+    case DL_EVENT_START:
+        tal_sha256_create_init(&run->sha256);
+        tal_sha256_starts_ret(run->sha256, 0);
+        break;
+
+    case DL_EVENT_ON_FILESIZE:
+        run->file_size = event->file_size;
+        break;
+
+    case DL_EVENT_ON_DATA:
+        if (event->offset != run->received) {
+            run->in_order = FALSE;
+        }
+        tal_sha256_update_ret(run->sha256, event->data, event->data_len);
+        run->received += event->data_len;
+        event->remain_len = 0;
+        break;
+
+    case DL_EVENT_FINISH:
+        tal_sha256_finish_ret(run->sha256, run->digest);
+        tal_sha256_free(run->sha256);
+        run->finished = TRUE;
+        break;
+
+    case DL_EVENT_FAULT:
+        tal_sha256_free(run->sha256);
+        break;
+
+    default:
+        break;
+    }
+}
+
+static void __bench_download(uint8_t workers)
+{
+    BENCH_RUN_T run;
+    http_download_config_t cfg;
+    SYS_TIME_T start = 0, cost_ms = 0;
+    char digest[17];
+    uint32_t i = 0;
+
+    memset(&run, 0, sizeof(run));
+    run.in_order = TRUE;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.url = BENCH_URL;
+    cfg.timeout_ms = BENCH_TIMEOUT_MS;
+    cfg.range_length = BENCH_RANGE_LEN;
+    cfg.block_size = BENCH_BLOCK_SIZE;
+    cfg.workers = workers;
+    cfg.user_data = &run;
+    cfg.event_handler = __bench_event_cb;
+
+    start = tal_system_get_millisecond();
+    http_file_download(&cfg);
+    cost_ms = tal_system_get_millisecond() - start;
+    cost_ms = cost_ms ? cost_ms : 1;
+
+    if (!run.finished || !run.in_order || run.received != run.file_size) {
+        PR_ERR("workers:%d failed, %d of %d bytes, in order:%d", workers, run.received, run.file_size, run.in_order);
+        return;
+    }
+    for (i = 0; i < 8; i++) {
+        snprintf(digest + i * 2, 3, "%02x", run.digest[i]);
+    }
+    PR_NOTICE("workers:%d | %9d B | %6llu ms | %7llu KB/s | sha256 %s...", workers, run.file_size, (uint64_t)cost_ms,
+              (uint64_t)run.file_size * 1000 / 1024 / cost_ms, digest);
+}
+
+/**
+ * @brief user_main
+ *
+ * @return none
+ */
+void user_main(void)
+{
+    uint32_t idx = 0;
+
+    /* the download logs every piece of data at debug level */
+    tal_log_init(TAL_LOG_LEVEL_NOTICE, 1024, (TAL_LOG_OUTPUT_CB)tkl_log_output);
+
+    PR_NOTICE("Application information:");
+    PR_NOTICE("Project name:        %s", PROJECT_NAME);
+    PR_NOTICE("App version:         %s", PROJECT_VERSION);
+    PR_NOTICE("Compile time:        %s", __DATE__);
+    PR_NOTICE("TuyaOpen version:    %s", OPEN_VERSION);
+    PR_NOTICE("TuyaOpen commit-id:  %s", OPEN_COMMIT);
+    PR_NOTICE("Platform chip:       %s", PLATFORM_CHIP);
+    PR_NOTICE("Platform board:      %s", PLATFORM_BOARD);
+    PR_NOTICE("Platform commit-id:  %s", PLATFORM_COMMIT);
+
+    PR_NOTICE("download %s", BENCH_URL);
+    for (idx = 0; idx < CNTSOF(sg_bench_workers); idx++) {
+        __bench_download(sg_bench_workers[idx]);
+    }
+    PR_NOTICE("http download bench done");
+}
+
+/**
+ * @brief main
+ *
+ * @param argc
+ * @param argv
+ * @return void
+ */
+#if OPERATING_SYSTEM == SYSTEM_LINUX
+void main(int argc, char *argv[])
+{
+    user_main();
+}
+#else
+
+/* Tuya thread handle */
+static THREAD_HANDLE ty_app_thread = NULL;
+
+/**
+ * @brief  task thread
+ *
+ * @param[in] arg:Parameters when creating a task
+ * @return none
+ */
+static void tuya_app_thread(void *arg)
+{
+    user_main();
+
+    tal_thread_delete(ty_app_thread);
+    ty_app_thread = NULL;
+}
+
+void tuya_app_main(void)
+{
+    THREAD_CFG_T thrd_param = {4096, 4, "tuya_app_main"};
+    tal_thread_create_and_start(&ty_app_thread, NULL, NULL, tuya_app_thread, NULL, &thrd_param);
+}
+#endif
@@ -0,0 +1,224 @@
+/**
+ * @file example_os_event_bench.c
+ * @brief Benchmark of the event publish path.
+ *
+ * This example measures the publish throughput of the event module. A number of
+ * filler events are registered first so the name lookup works on a realistic
+ * event table, then one event with several subscribers is published by name and
+ * by id. At last several threads publish the same event whose subscriber blocks
+ * for a while, to show that publishers of the same event are not serialized.
+ *
+ * Key operations demonstrated in this file:
+ * - Interning of event names with tal_event_id_get.
+ * - Timing of tal_event_publish and tal_event_publish_by_id.
+ * - Concurrent publishing of one event from several threads.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include "tuya_cloud_types.h"
+
+#include "tal_api.h"
+#include "tkl_output.h"
+
+/***********************************************************
+************************macro define************************
+***********************************************************/
+#define BENCH_FILLER_EVENT_NUM 64
+#define BENCH_SUBSCRIBER_NUM   4
+#define BENCH_PUBLISH_NUM      200000
+
+#define BENCH_EVENT_FAST "bench.fast"
+#define BENCH_EVENT_SLOW "bench.slow"
+
+#define BENCH_SLOW_THREAD_NUM  4
+#define BENCH_SLOW_PUBLISH_NUM 20
+#define BENCH_SLOW_CB_MS       10
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+static volatile uint32_t sg_fast_cnt = 0;
+static SEM_HANDLE sg_slow_done = NULL;
+static EVENT_ID_T sg_slow_id = EVENT_ID_INVALID;
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+
+static int __bench_fast_cb(void *data)
+{
+    sg_fast_cnt++;
+    return OPRT_OK;
+}
+
+static int __bench_slow_cb(void *data)
+{
+    tal_system_sleep(BENCH_SLOW_CB_MS);
+    return OPRT_OK;
+}
+
+static void __bench_report(const char *op, uint32_t num, SYS_TIME_T cost_ms)
+{
+    cost_ms = cost_ms ? cost_ms : 1;
+    PR_NOTICE("%-12s publish:%d | total %6llu ms | %6llu ns/publish | %8llu publish/s", op, num, (uint64_t)cost_ms,
+              (uint64_t)cost_ms * 1000000 / num, (uint64_t)num * 1000 / cost_ms);
+}
+
+static OPERATE_RET __bench_fast(void)
+{
+    OPERATE_RET rt = OPRT_OK;
+    char name[EVENT_NAME_MAX_LEN + 1];
+    char desc[EVENT_DESC_MAX_LEN + 1];
+    EVENT_ID_T id = EVENT_ID_INVALID;
+    SYS_TIME_T start = 0;
+    uint32_t idx = 0;
+
+    for (idx = 0; idx < BENCH_FILLER_EVENT_NUM; idx++) {
+        snprintf(name, sizeof(name), "bench.filler%d", idx);
+        TUYA_CALL_ERR_RETURN(tal_event_id_get(name, &id));
+    }
+
+    for (idx = 0; idx < BENCH_SUBSCRIBER_NUM; idx++) {
+        snprintf(desc, sizeof(desc), "bench%d", idx);
+        TUYA_CALL_ERR_RETURN(tal_event_subscribe(BENCH_EVENT_FAST, desc, __bench_fast_cb, SUBSCRIBE_TYPE_NORMAL));
+    }
+    TUYA_CALL_ERR_RETURN(tal_event_id_get(BENCH_EVENT_FAST, &id));
+
+    sg_fast_cnt = 0;
+    start = tal_system_get_millisecond();
+    for (idx = 0; idx < BENCH_PUBLISH_NUM; idx++) {
+        tal_event_publish(BENCH_EVENT_FAST, NULL);
+    }
+    __bench_report("by name", BENCH_PUBLISH_NUM, tal_system_get_millisecond() - start);
+
+    start = tal_system_get_millisecond();
+    for (idx = 0; idx < BENCH_PUBLISH_NUM; idx++) {
+        tal_event_publish_by_id(id, NULL);
+    }
+    __bench_report("by id", BENCH_PUBLISH_NUM, tal_system_get_millisecond() - start);
+
+    if (sg_fast_cnt != 2 * BENCH_PUBLISH_NUM * BENCH_SUBSCRIBER_NUM) {
+        PR_ERR("subscriber called %d times, expect %d", sg_fast_cnt, 2 * BENCH_PUBLISH_NUM * BENCH_SUBSCRIBER_NUM);
+        return OPRT_COM_ERROR;
+    }
+
+    return rt;
+}
+
+static void __bench_slow_thread(void *arg)
+{
+    THREAD_HANDLE *thread = (THREAD_HANDLE *)arg;
+    uint32_t idx = 0;
+
+    for (idx = 0; idx < BENCH_SLOW_PUBLISH_NUM; idx++) {
+        tal_event_publish_by_id(sg_slow_id, NULL);
+    }
+
+    tal_semaphore_post(sg_slow_done);
+    tal_thread_delete(*thread);
+}
+
+static OPERATE_RET __bench_slow(void)
+{
+    OPERATE_RET rt = OPRT_OK;
+    static THREAD_HANDLE thread[BENCH_SLOW_THREAD_NUM];
+    THREAD_CFG_T thread_cfg = {.stackDepth = 4096, .priority = THREAD_PRIO_2, .thrdname = "event_bench"};
+    SYS_TIME_T start = 0;
+    uint32_t idx = 0;
+
+    TUYA_CALL_ERR_RETURN(tal_semaphore_create_init(&sg_slow_done, 0, BENCH_SLOW_THREAD_NUM));
+    TUYA_CALL_ERR_RETURN(tal_event_subscribe(BENCH_EVENT_SLOW, "bench", __bench_slow_cb, SUBSCRIBE_TYPE_NORMAL));
+    TUYA_CALL_ERR_RETURN(tal_event_id_get(BENCH_EVENT_SLOW, &sg_slow_id));
+
+    start = tal_system_get_millisecond();
+    for (idx = 0; idx < BENCH_SLOW_THREAD_NUM; idx++) {
+        TUYA_CALL_ERR_RETURN(
+            tal_thread_create_and_start(&thread[idx], NULL, NULL, __bench_slow_thread, &thread[idx], &thread_cfg));
+    }
+    for (idx = 0; idx < BENCH_SLOW_THREAD_NUM; idx++) {
+        tal_semaphore_wait_forever(sg_slow_done);
+    }
+
+    /* serialized publishers need threads * publish * cb ms, parallel ones need publish * cb ms */
+    __bench_report("slow cb", BENCH_SLOW_THREAD_NUM * BENCH_SLOW_PUBLISH_NUM, tal_system_get_millisecond() - start);
+    PR_NOTICE("slow cb      serialized %d ms, parallel %d ms",
+              BENCH_SLOW_THREAD_NUM * BENCH_SLOW_PUBLISH_NUM * BENCH_SLOW_CB_MS,
+              BENCH_SLOW_PUBLISH_NUM * BENCH_SLOW_CB_MS);
+
+    return rt;
+}
+
+/**
+ * @brief user_main
+ *
+ * @return none
+ */
+void user_main(void)
+{
+    OPERATE_RET rt = OPRT_OK;
+
+    /* basic init */
+    tal_log_init(TAL_LOG_LEVEL_DEBUG, 1024, (TAL_LOG_OUTPUT_CB)tkl_log_output);
+
+    PR_NOTICE("Application information:");
+    PR_NOTICE("Project name:        %s", PROJECT_NAME);
+    PR_NOTICE("App version:         %s", PROJECT_VERSION);
+    PR_NOTICE("Compile time:        %s", __DATE__);
+    PR_NOTICE("TuyaOpen version:    %s", OPEN_VERSION);
+    PR_NOTICE("TuyaOpen commit-id:  %s", OPEN_COMMIT);
+    PR_NOTICE("Platform chip:       %s", PLATFORM_CHIP);
+    PR_NOTICE("Platform board:      %s", PLATFORM_BOARD);
+    PR_NOTICE("Platform commit-id:  %s", PLATFORM_COMMIT);
+
+    TUYA_CALL_ERR_GOTO(tal_event_init(), __EXIT);
+    TUYA_CALL_ERR_GOTO(__bench_fast(), __EXIT);
+    TUYA_CALL_ERR_GOTO(__bench_slow(), __EXIT);
+    PR_NOTICE("event bench done");
+
+__EXIT:
+    return;
+}
+
+/**
+ * @brief main
+ *
+ * @param argc
+ * @param argv
+ * @return void
+ */
+#if OPERATING_SYSTEM == SYSTEM_LINUX
+void main(int argc, char *argv[])
+{
+    user_main();
+}
+#else
+
+/* Tuya thread handle */
+static THREAD_HANDLE ty_app_thread = NULL;
+
+/**
+ * @brief  task thread
+ *
+ * @param[in] arg:Parameters when creating a task
+ * @return none
+ */
+static void tuya_app_thread(void *arg)
+{
+    user_main();
+
+    tal_thread_delete(ty_app_thread);
+    ty_app_thread = NULL;
+}
+
+void tuya_app_main(void)
+{
+    THREAD_CFG_T thrd_param = {4096, 4, "tuya_app_main"};
+    tal_thread_create_and_start(&ty_app_thread, NULL, NULL, tuya_app_thread, NULL, &thrd_param);
+}
+#endif
@@ -0,0 +1,203 @@
+/**
+ * @file example_kv_bench.c
+ * @brief Benchmark of the KV storage backends.
+ *
+ * This example runs the same key-value workload on the backend selected by
+ * KV_BACKEND in Kconfig and reports the throughput and the flash traffic of
+ * each phase. On the Ubuntu board the flash is a file, so the result compares
+ * the number of flash operations of the backends rather than a real chip.
+ *
+ * Key operations demonstrated in this file:
+ * - Creation, update, read and deletion of a set of small keys.
+ * - Timing of each phase in operations per second.
+ * - Reporting of the bytes programmed and erased with tal_kv_flash_stat.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include "tuya_cloud_types.h"
+#include "tal_api.h"
+#include "tkl_output.h"
+
+/***********************************************************
+************************macro define************************
+***********************************************************/
+#define BENCH_KEY_NUM    32
+#define BENCH_VALUE_LEN  64
+#define BENCH_UPDATE_NUM 2000
+#define BENCH_READ_NUM   2000
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+typedef struct {
+    SYS_TIME_T start_ms;
+    uint32_t write_bytes;
+    uint32_t erase_bytes;
+} BENCH_MARK_T;
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+static uint8_t sg_value[BENCH_VALUE_LEN];
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+
+static void __bench_key(char *key, uint32_t idx)
+{
+    snprintf(key, 16, "bench.%02d", (int)idx);
+}
+
+static void __bench_value(uint32_t seed)
+{
+    uint32_t i = 0;
+
+    for (i = 0; i < BENCH_VALUE_LEN; i++) {
+        sg_value[i] = (uint8_t)(seed + i * 31);
+    }
+}
+
+static void __bench_begin(BENCH_MARK_T *mark)
+{
+    tal_kv_flash_stat(&mark->write_bytes, &mark->erase_bytes);
+    mark->start_ms = tal_system_get_millisecond();
+}
+
+static void __bench_report(const char *op, uint32_t ops, BENCH_MARK_T *mark)
+{
+    SYS_TIME_T cost_ms = tal_system_get_millisecond() - mark->start_ms;
+    uint32_t write_bytes = 0, erase_bytes = 0;
+
+    tal_kv_flash_stat(&write_bytes, &erase_bytes);
+    cost_ms = cost_ms ? cost_ms : 1;
+    PR_NOTICE("%-7s ops:%5d | %6llu ms | %7llu ops/s | write %8u B | erase %8u B", op, ops, (uint64_t)cost_ms,
+              (uint64_t)ops * 1000 / cost_ms, write_bytes - mark->write_bytes, erase_bytes - mark->erase_bytes);
+}
+
+static OPERATE_RET __bench_run(void)
+{
+    OPERATE_RET rt = OPRT_OK;
+    BENCH_MARK_T mark;
+    uint32_t idx = 0;
+    uint8_t *value = NULL;
+    size_t length = 0;
+    char key[16];
+
+    __bench_begin(&mark);
+    for (idx = 0; idx < BENCH_KEY_NUM; idx++) {
+        __bench_key(key, idx);
+        __bench_value(idx);
+        TUYA_CALL_ERR_RETURN(tal_kv_set(key, sg_value, BENCH_VALUE_LEN));
+    }
+    __bench_report("create", BENCH_KEY_NUM, &mark);
+
+    /* small values rewritten over and over, like dp states */
+    __bench_begin(&mark);
+    for (idx = 0; idx < BENCH_UPDATE_NUM; idx++) {
+        __bench_key(key, tal_system_get_random(BENCH_KEY_NUM));
+        __bench_value(BENCH_KEY_NUM + idx);
+        TUYA_CALL_ERR_RETURN(tal_kv_set(key, sg_value, BENCH_VALUE_LEN));
+    }
+    __bench_report("update", BENCH_UPDATE_NUM, &mark);
+
+    __bench_begin(&mark);
+    for (idx = 0; idx < BENCH_READ_NUM; idx++) {
+        __bench_key(key, tal_system_get_random(BENCH_KEY_NUM));
+        TUYA_CALL_ERR_RETURN(tal_kv_get(key, &value, &length));
+        tal_kv_free(value);
+    }
+    __bench_report("read", BENCH_READ_NUM, &mark);
+
+    __bench_begin(&mark);
+    for (idx = 0; idx < BENCH_KEY_NUM; idx++) {
+        __bench_key(key, idx);
+        TUYA_CALL_ERR_RETURN(tal_kv_del(key));
+    }
+    __bench_report("delete", BENCH_KEY_NUM, &mark);
+
+    return rt;
+}
+
+/**
+ * @brief user_main
+ *
+ * @return none
+ */
+void user_main(void)
+{
+    OPERATE_RET rt = OPRT_OK;
+
+    /* basic init */
+    tal_log_init(TAL_LOG_LEVEL_DEBUG, 1024, (TAL_LOG_OUTPUT_CB)tkl_log_output);
+
+    PR_NOTICE("Application information:");
+    PR_NOTICE("Project name:        %s", PROJECT_NAME);
+    PR_NOTICE("App version:         %s", PROJECT_VERSION);
+    PR_NOTICE("Compile time:        %s", __DATE__);
+    PR_NOTICE("TuyaOpen version:    %s", OPEN_VERSION);
+    PR_NOTICE("TuyaOpen commit-id:  %s", OPEN_COMMIT);
+    PR_NOTICE("Platform chip:       %s", PLATFORM_CHIP);
+    PR_NOTICE("Platform board:      %s", PLATFORM_BOARD);
+    PR_NOTICE("Platform commit-id:  %s", PLATFORM_COMMIT);
+
+    /* the log backend reclaims in the system work queue */
+    TUYA_CALL_ERR_GOTO(tal_sw_timer_init(), __EXIT);
+    TUYA_CALL_ERR_GOTO(tal_workq_init(), __EXIT);
+    TUYA_CALL_ERR_GOTO(tal_kv_init(&(tal_kv_cfg_t){
+                           .seed = "vmlkasdh93dlvlcy",
+                           .key = "dflfuap134ddlduq",
+                       }),
+                       __EXIT);
+
+#if defined(KV_BACKEND_LOG) && (KV_BACKEND_LOG == 1)
+    PR_NOTICE("kv backend: log");
+#else
+    PR_NOTICE("kv backend: littlefs");
+#endif
+    TUYA_CALL_ERR_GOTO(__bench_run(), __EXIT);
+    PR_NOTICE("kv bench done");
+
+__EXIT:
+    return;
+}
+
+/**
+ * @brief main
+ *
+ * @param argc
+ * @param argv
+ * @return void
+ */
+#if OPERATING_SYSTEM == SYSTEM_LINUX
+void main(int argc, char *argv[])
+{
+    user_main();
+}
+#else
+
+/* Tuya thread handle */
+static THREAD_HANDLE ty_app_thread = NULL;
+
+/**
+ * @brief  task thread
+ *
+ * @param[in] arg:Parameters when creating a task
+ * @return none
+ */
+static void tuya_app_thread(void *arg)
+{
+    user_main();
+
+    tal_thread_delete(ty_app_thread);
+    ty_app_thread = NULL;
+}
+
+void tuya_app_main(void)
+{
+    THREAD_CFG_T thrd_param = {4096, 4, "tuya_app_main"};
+    tal_thread_create_and_start(&ty_app_thread, NULL, NULL, tuya_app_thread, NULL, &thrd_param);
+}
+#endif
@@ -0,0 +1,169 @@
+/**
+ * @file example_sw_timer_bench.c
+ * @brief Benchmark of the software timer start and stop path.
+ *
+ * This example creates a large number of software timers and measures the cost of
+ * starting, restarting and stopping all of them. Timers use long random intervals so
+ * none of them expires during the measurement, which keeps the cost limited to the
+ * timer container selected by SW_TIMER_BACKEND in Kconfig.
+ *
+ * Key operations demonstrated in this file:
+ * - Creation and deletion of many software timers.
+ * - Timing of tal_sw_timer_start, tal_sw_timer_start on a running timer and tal_sw_timer_stop.
+ * - Reporting of the average cost of each operation in ns.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include "tuya_cloud_types.h"
+#include "tal_api.h"
+#include "tal_sw_timer.h"
+#include "tkl_output.h"
+
+/***********************************************************
+************************macro define************************
+***********************************************************/
+#define BENCH_TIMER_NUM    10000
+#define BENCH_ROUNDS       10
+#define BENCH_INTERVAL_MIN (10 * 60 * 1000)
+#define BENCH_INTERVAL_MAX (60 * 60 * 1000)
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+static TIMER_ID sg_timer_id[BENCH_TIMER_NUM];
+static TIME_MS sg_interval[BENCH_TIMER_NUM];
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+
+static void __bench_timer_cb(TIMER_ID timer_id, void *arg)
+{
+    PR_ERR("timer %p expired during the bench", timer_id);
+}
+
+static void __bench_report(const char *op, SYS_TIME_T cost_ms)
+{
+    uint64_t ops = (uint64_t)BENCH_TIMER_NUM * BENCH_ROUNDS;
+
+    PR_NOTICE("%-8s timers:%d rounds:%d | total %6llu ms | %6llu ns/op", op, BENCH_TIMER_NUM, BENCH_ROUNDS,
+              (uint64_t)cost_ms, (uint64_t)cost_ms * 1000000 / ops);
+}
+
+static OPERATE_RET __bench_run(void)
+{
+    OPERATE_RET rt = OPRT_OK;
+    uint32_t idx = 0, round = 0;
+    SYS_TIME_T start = 0, start_ms = 0, restart_ms = 0, stop_ms = 0;
+
+    for (idx = 0; idx < BENCH_TIMER_NUM; idx++) {
+        TUYA_CALL_ERR_RETURN(tal_sw_timer_create(__bench_timer_cb, NULL, &sg_timer_id[idx]));
+        sg_interval[idx] = tal_system_get_random(BENCH_INTERVAL_MAX - BENCH_INTERVAL_MIN) + BENCH_INTERVAL_MIN;
+    }
+
+    for (round = 0; round < BENCH_ROUNDS; round++) {
+        start = tal_system_get_millisecond();
+        for (idx = 0; idx < BENCH_TIMER_NUM; idx++) {
+            tal_sw_timer_start(sg_timer_id[idx], sg_interval[idx], TAL_TIMER_ONCE);
+        }
+        start_ms += tal_system_get_millisecond() - start;
+
+        /* restart in reverse order, every timer moves inside the running container */
+        start = tal_system_get_millisecond();
+        for (idx = BENCH_TIMER_NUM; idx > 0; idx--) {
+            tal_sw_timer_start(sg_timer_id[idx - 1], sg_interval[BENCH_TIMER_NUM - idx], TAL_TIMER_ONCE);
+        }
+        restart_ms += tal_system_get_millisecond() - start;
+
+        start = tal_system_get_millisecond();
+        for (idx = 0; idx < BENCH_TIMER_NUM; idx++) {
+            tal_sw_timer_stop(sg_timer_id[idx]);
+        }
+        stop_ms += tal_system_get_millisecond() - start;
+    }
+
+    __bench_report("start", start_ms);
+    __bench_report("restart", restart_ms);
+    __bench_report("stop", stop_ms);
+
+    for (idx = 0; idx < BENCH_TIMER_NUM; idx++) {
+        tal_sw_timer_delete(sg_timer_id[idx]);
+        sg_timer_id[idx] = NULL;
+    }
+
+    return rt;
+}
+
+/**
+ * @brief user_main
+ *
+ * @return none
+ */
+void user_main(void)
+{
+    OPERATE_RET rt = OPRT_OK;
+
+    /* basic init */
+    tal_log_init(TAL_LOG_LEVEL_DEBUG, 1024, (TAL_LOG_OUTPUT_CB)tkl_log_output);
+
+    PR_NOTICE("Application information:");
+    PR_NOTICE("Project name:        %s", PROJECT_NAME);
+    PR_NOTICE("App version:         %s", PROJECT_VERSION);
+    PR_NOTICE("Compile time:        %s", __DATE__);
+    PR_NOTICE("TuyaOpen version:    %s", OPEN_VERSION);
+    PR_NOTICE("TuyaOpen commit-id:  %s", OPEN_COMMIT);
+    PR_NOTICE("Platform chip:       %s", PLATFORM_CHIP);
+    PR_NOTICE("Platform board:      %s", PLATFORM_BOARD);
+    PR_NOTICE("Platform commit-id:  %s", PLATFORM_COMMIT);
+
+    TUYA_CALL_ERR_GOTO(tal_sw_timer_init(), __EXIT);
+    TUYA_CALL_ERR_GOTO(__bench_run(), __EXIT);
+    PR_NOTICE("sw timer bench done");
+
+__EXIT:
+    return;
+}
+
+/**
+ * @brief main
+ *
+ * @param argc
+ * @param argv
+ * @return void
+ */
+#if OPERATING_SYSTEM == SYSTEM_LINUX
+void main(int argc, char *argv[])
+{
+    user_main();
+}
+#else
+
+/* Tuya thread handle */
+static THREAD_HANDLE ty_app_thread = NULL;
+
+/**
+ * @brief  task thread
+ *
+ * @param[in] arg:Parameters when creating a task
+ * @return none
+ */
+static void tuya_app_thread(void *arg)
+{
+    user_main();
+
+    tal_thread_delete(ty_app_thread);
+    ty_app_thread = NULL;
+}
+
+void tuya_app_main(void)
+{
+    THREAD_CFG_T thrd_param = {4096, 4, "tuya_app_main"};
+    tal_thread_create_and_start(&ty_app_thread, NULL, NULL, tuya_app_thread, NULL, &thrd_param);
+}
+#endif
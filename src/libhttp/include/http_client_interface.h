@@ -64,4 +64,12 @@ http_client_status_t http_client_request(const http_client_request_t *request, h
 
 int http_client_free(http_client_response_t *response);
 
+/**
+ * @brief close the idle connections kept by ENABLE_HTTP_KEEPALIVE_POOL
+ *
+ * They close by themselves once idle for HTTP_POOL_IDLE_MS, this releases
+ * their memory right away.
+ */
+void http_client_pool_flush(void);
+
 #endif /* ifndef HTTP_CLIENT_INTERFACE_H */
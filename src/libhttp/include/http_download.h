@@ -35,10 +35,29 @@ typedef struct {
     uint32_t timeout_ms;
     size_t range_length;
     size_t file_size;
+    /** offset of the first byte to download, 0 for the whole file */
+    size_t offset;
+    /** connections fetching blocks in parallel, 0 or 1 for a single stream */
+    uint8_t workers;
+    /** bytes fetched by one range request of a worker, 0 for the default */
+    size_t block_size;
     void *user_data;
     http_download_event_cb_t event_handler;
 } http_download_config_t;
 
+/**
+ * @brief download a file with range requests
+ *
+ * With workers > 1 every worker has its own connection and fetches the next
+ * block of the file not yet assigned. The blocks are delivered to the
+ * DL_EVENT_ON_DATA handler in file order, in pieces of range_length bytes,
+ * from the calling thread, so the handler sees the same stream as with a
+ * single connection.
+ *
+ * @param[in] config download configuration
+ *
+ * @return OPRT_OK on success, others on error
+ */
 int http_file_download(http_download_config_t *config);
 
 #ifdef __cplusplus
@@ -4,6 +4,8 @@
 #include "core_http_client.h"
 #include "tuya_tls.h"
 #include "tal_log.h"
+#include "tal_mutex.h"
+#include "tal_system.h"
 
 #define log_debug PR_DEBUG
 #define log_error PR_ERR
@@ -11,6 +13,21 @@
 #define HEADER_BUFFER_LENGTH (255)
 #define DEFAULT_HTTP_PORT    (80)
 #define DEFAULT_HTTPS_PORT   (443)
+/* coreHTTP keeps the response buffers of a request that failed on the network,
+ * a request that failed in the parser already freed them */
+static void http_client_response_drop(HTTPResponse_t *response, HTTPStatus_t status)
+{
+    if (HTTPNetworkError == status) {
+        if (response->pBuffer) {
+            tal_free(response->pBuffer);
+        }
+        if (response->pBody) {
+            tal_free((void *)response->pBody);
+        }
+    }
+    memset(response, 0, sizeof(HTTPResponse_t));
+}
+
 static http_client_status_t core_http_request_send(const TransportInterface_t *pTransportInterface,
                                                    const HTTPRequestInfo_t *requestInfo, http_client_header_t *headers,
                                                    uint8_t headers_count, const uint8_t *pRequestBodyBuf,
@@ -62,6 +79,7 @@ static http_client_status_t core_http_request_send(const TransportInterface_t *p
         log_error("Failed to send HTTP %.*s request to %.*s%.*s: Error=%s.", (int32_t)requestInfo->methodLen,
                   requestInfo->pMethod, (int32_t)requestInfo->hostLen, requestInfo->pHost,
                   (int32_t)requestInfo->pathLen, requestInfo->pPath, HTTPClient_strerror(httpStatus));
+        http_client_response_drop(response, httpStatus);
         return HTTP_CLIENT_SEND_FAULT;
     }
 
@@ -74,16 +92,74 @@ static http_client_status_t core_http_request_send(const TransportInterface_t *p
     return HTTP_CLIENT_SUCCESS;
 }
 
-http_client_status_t http_client_request(const http_client_request_t *request, http_client_response_t *response)
+/* the connection of a request and what went through it */
+typedef struct {
+    NetworkContext_t network; // first, the transport functions take it as their context
+    bool recv_started;        // the whole request was sent
+    size_t received;          // bytes of the response received
+} http_client_transport_t;
+
+static int32_t http_client_transport_send(NetworkContext_t *context, const void *buf, size_t len)
+{
+    http_client_transport_t *transport = (http_client_transport_t *)context;
+
+    return NetworkTransportSend(&transport->network, buf, len);
+}
+
+static int32_t http_client_transport_recv(NetworkContext_t *context, void *buf, size_t len)
+{
+    http_client_transport_t *transport = (http_client_transport_t *)context;
+    int32_t ret = 0;
+
+    transport->recv_started = true;
+    ret = NetworkTransportRecv(&transport->network, buf, len);
+    if (ret > 0) {
+        transport->received += ret;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief check if a failed request may be sent again on a new connection
+ *
+ * A request that was not sent whole cannot have been processed. A request
+ * that was sent but got no response byte was maybe processed, it is only sent
+ * again if repeating it does no harm.
+ *
+ * @param[in] request request
+ * @param[in] transport connection the request failed on
+ *
+ * @return true if the request can be retried
+ */
+static bool http_client_request_retryable(const http_client_request_t *request,
+                                          const http_client_transport_t *transport)
+{
+    if (!transport->recv_started) {
+        return true;
+    }
+    if (transport->received) {
+        return false;
+    }
+
+    return (0 != strcmp(request->method, "POST") && 0 != strcmp(request->method, "PATCH"));
+}
+
+static void http_client_disconnect(NetworkContext_t network)
+{
+    tuya_transporter_close(network);
+    tuya_transporter_destroy(network);
+}
+
+static http_client_status_t http_client_connect(NetworkContext_t *network, const char *host, uint16_t port,
+                                                const http_client_request_t *request)
 {
-    http_client_status_t rt = HTTP_CLIENT_SUCCESS;
     int ret = OPRT_OK;
 
     /* TLS pre init */
-    NetworkContext_t network;
     TUYA_TRANSPORT_TYPE_E transport_type = (request->cacert == NULL) ? TRANSPORT_TYPE_TCP : TRANSPORT_TYPE_TLS;
-    network = tuya_transporter_create(transport_type, NULL);
-    if (NULL == network) {
+    *network = tuya_transporter_create(transport_type, NULL);
+    if (NULL == *network) {
         return HTTP_CLIENT_MALLOC_FAULT;
     }
 
@@ -91,40 +167,184 @@ http_client_status_t http_client_request(const http_client_request_t *request, h
         tuya_tls_config_t tls_config = {
             .ca_cert = (char *)request->cacert,
             .ca_cert_size = request->cacert_len,
-            .hostname = (char *)request->host,
-            .port = (request->port == 0) ? DEFAULT_HTTPS_PORT : request->port,
+            .hostname = (char *)host,
+            .port = port,
             .timeout = request->timeout_ms,
             .mode = TUYA_TLS_SERVER_CERT_MODE,
             .verify = true,
         };
 
-        ret = tuya_transporter_ctrl(network, TUYA_TRANSPORTER_SET_TLS_CONFIG, &tls_config);
+        ret = tuya_transporter_ctrl(*network, TUYA_TRANSPORTER_SET_TLS_CONFIG, &tls_config);
         if (OPRT_OK != ret) {
             log_error("network_tls_init fail:%d", ret);
+            tuya_transporter_destroy(*network);
             return ret;
         }
+    }
 
-        ret = tuya_transporter_connect(network, tls_config.hostname, tls_config.port, tls_config.timeout);
-        if (OPRT_OK != ret) {
-            tuya_transporter_close(network);
-            tuya_transporter_destroy(network);
-            return HTTP_CLIENT_SEND_FAULT;
+    ret = tuya_transporter_connect(*network, (char *)host, port, request->timeout_ms);
+    if (OPRT_OK != ret) {
+        http_client_disconnect(*network);
+        return HTTP_CLIENT_SEND_FAULT;
+    }
+    log_debug("%s connencted!", (transport_type == TRANSPORT_TYPE_TLS) ? "tls" : "tcp");
+
+    return HTTP_CLIENT_SUCCESS;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                          Keep-alive connection pool                        */
+/* -------------------------------------------------------------------------- */
+#if defined(ENABLE_HTTP_KEEPALIVE_POOL) && (ENABLE_HTTP_KEEPALIVE_POOL == 1)
+typedef struct {
+    NetworkContext_t network; // NULL if the slot is empty
+    char *host;
+    uint16_t port;
+    const uint8_t *cacert; // the endpoint certificate, its address names it
+    SYS_TIME_T idle_ms;    // time the last response ended
+} http_client_conn_t;
+
+static http_client_conn_t s_http_pool[HTTP_POOL_CONN_NUM];
+static MUTEX_HANDLE s_http_pool_mutex = NULL;
+
+/* caller holds s_http_pool_mutex */
+static void http_client_pool_drop(http_client_conn_t *conn)
+{
+    http_client_disconnect(conn->network);
+    tal_free(conn->host);
+    memset(conn, 0, sizeof(http_client_conn_t));
+}
+
+/**
+ * @brief take an idle connection to the host of a request out of the pool
+ *
+ * @param[in] request request
+ * @param[in] port port of the request
+ *
+ * @return the connection, NULL if there is none
+ */
+static NetworkContext_t http_client_pool_take(const http_client_request_t *request, uint16_t port)
+{
+    NetworkContext_t network = NULL;
+    SYS_TIME_T now = tal_system_get_millisecond();
+    int i;
+
+    /* the first requests come from the startup, before any other thread uses the pool */
+    if (NULL == s_http_pool_mutex && OPRT_OK != tal_mutex_create_init(&s_http_pool_mutex)) {
+        s_http_pool_mutex = NULL;
+        return NULL;
+    }
+
+    tal_mutex_lock(s_http_pool_mutex);
+    for (i = 0; i < HTTP_POOL_CONN_NUM; i++) {
+        http_client_conn_t *conn = &s_http_pool[i];
+        if (NULL == conn->network) {
+            continue;
+        }
+        if (now - conn->idle_ms >= HTTP_POOL_IDLE_MS) {
+            http_client_pool_drop(conn);
+            continue;
         }
+        if (NULL == network && conn->port == port && conn->cacert == request->cacert &&
+            0 == strcmp(conn->host, request->host)) {
+            network = conn->network;
+            tal_free(conn->host);
+            memset(conn, 0, sizeof(http_client_conn_t));
+        }
+    }
+    tal_mutex_unlock(s_http_pool_mutex);
 
-        log_debug("tls connencted!");
-    } else {
-        ret = tuya_transporter_connect(network, request->host, (request->port == 0) ? DEFAULT_HTTP_PORT : request->port,
-                                       request->timeout_ms);
-        if (OPRT_OK != ret) {
-            tuya_transporter_close(network);
-            tuya_transporter_destroy(network);
-            return HTTP_CLIENT_SEND_FAULT;
+    /* an idle connection has nothing to read, a readable one was closed by the
+     * server and a request sent on it would get no response */
+    if (network && 0 != tuya_transporter_poll_read(network, 1)) {
+        log_debug("kept connection closed by the server");
+        http_client_disconnect(network);
+        network = NULL;
+    }
+
+    return network;
+}
+
+/**
+ * @brief keep the connection of a finished request for the next one
+ *
+ * The oldest idle connection makes room if the pool is full.
+ *
+ * @param[in] network connection, its response was read completely
+ * @param[in] request request
+ * @param[in] port port of the request
+ */
+static void http_client_pool_give(NetworkContext_t network, const http_client_request_t *request, uint16_t port)
+{
+    http_client_conn_t *slot = NULL;
+    char *host = tal_malloc(strlen(request->host) + 1);
+    int i;
+
+    if (NULL == host || NULL == s_http_pool_mutex) {
+        tal_free(host);
+        http_client_disconnect(network);
+        return;
+    }
+    strcpy(host, request->host);
+
+    tal_mutex_lock(s_http_pool_mutex);
+    for (i = 0; i < HTTP_POOL_CONN_NUM; i++) {
+        if (NULL == s_http_pool[i].network) {
+            slot = &s_http_pool[i];
+            break;
+        }
+        if (NULL == slot || s_http_pool[i].idle_ms < slot->idle_ms) {
+            slot = &s_http_pool[i];
+        }
+    }
+    if (slot->network) {
+        http_client_pool_drop(slot);
+    }
+    slot->network = network;
+    slot->host = host;
+    slot->port = port;
+    slot->cacert = request->cacert;
+    slot->idle_ms = tal_system_get_millisecond();
+    tal_mutex_unlock(s_http_pool_mutex);
+}
+
+/**
+ * @brief close the idle connections of the pool
+ *
+ * They close by themselves once idle for HTTP_POOL_IDLE_MS, this releases
+ * their memory right away, e.g. once the device is online.
+ */
+void http_client_pool_flush(void)
+{
+    int i;
+
+    if (NULL == s_http_pool_mutex) {
+        return;
+    }
+
+    tal_mutex_lock(s_http_pool_mutex);
+    for (i = 0; i < HTTP_POOL_CONN_NUM; i++) {
+        if (s_http_pool[i].network) {
+            http_client_pool_drop(&s_http_pool[i]);
         }
     }
-    /* http client TransportInterface */
-    TransportInterface_t pTransportInterface = {.pNetworkContext = (NetworkContext_t *)&network,
-                                                .recv = (TransportRecv_t)NetworkTransportRecv,
-                                                .send = (TransportSend_t)NetworkTransportSend};
+    tal_mutex_unlock(s_http_pool_mutex);
+}
+#else
+void http_client_pool_flush(void)
+{
+}
+#endif
+
+http_client_status_t http_client_request(const http_client_request_t *request, http_client_response_t *response)
+{
+    http_client_status_t rt = HTTP_CLIENT_SUCCESS;
+    uint16_t port = request->port;
+    bool reused = false;
+
+    if (0 == port) {
+        port = (request->cacert == NULL) ? DEFAULT_HTTP_PORT : DEFAULT_HTTPS_PORT;
+    }
 
     /* http client request object make */
     HTTPRequestInfo_t requestInfo = {
@@ -136,17 +356,57 @@ http_client_status_t http_client_request(const http_client_request_t *request, h
         .pathLen = strlen(request->path),
     };
 
+    http_client_transport_t transport = {0};
+#if defined(ENABLE_HTTP_KEEPALIVE_POOL) && (ENABLE_HTTP_KEEPALIVE_POOL == 1)
+    requestInfo.reqFlags = HTTP_REQUEST_KEEP_ALIVE_FLAG;
+    transport.network = http_client_pool_take(request, port);
+    reused = (NULL != transport.network);
+#endif
+
     HTTPResponse_t http_response = {0};
 
-    /* HTTP request send */
-    log_debug("http request send!");
-    rt = core_http_request_send((const TransportInterface_t *)&pTransportInterface,
-                                (const HTTPRequestInfo_t *)&requestInfo, request->headers, request->headers_count,
-                                (const uint8_t *)request->body, request->body_length, &http_response);
+    for (;;) {
+        if (NULL == transport.network) {
+            rt = http_client_connect(&transport.network, request->host, port, request);
+            if (HTTP_CLIENT_SUCCESS != rt) {
+                return rt;
+            }
+        }
+
+        /* http client TransportInterface */
+        TransportInterface_t pTransportInterface = {.pNetworkContext = (NetworkContext_t *)&transport,
+                                                    .recv = (TransportRecv_t)http_client_transport_recv,
+                                                    .send = (TransportSend_t)http_client_transport_send};
 
+        /* HTTP request send */
+        log_debug("http request send%s!", reused ? " on a kept connection" : "");
+        memset(&http_response, 0, sizeof(http_response));
+        transport.recv_started = false;
+        transport.received = 0;
+        rt = core_http_request_send((const TransportInterface_t *)&pTransportInterface,
+                                    (const HTTPRequestInfo_t *)&requestInfo, request->headers, request->headers_count,
+                                    (const uint8_t *)request->body, request->body_length, &http_response);
+        if (HTTP_CLIENT_SEND_FAULT == rt && reused && http_client_request_retryable(request, &transport)) {
+            /* the server closed the idle connection, retry once on a new one */
+            log_debug("kept connection lost, reconnect");
+            http_client_disconnect(transport.network);
+            transport.network = NULL;
+            reused = false;
+            continue;
+        }
+        break;
+    }
+
+#if defined(ENABLE_HTTP_KEEPALIVE_POOL) && (ENABLE_HTTP_KEEPALIVE_POOL == 1)
+    if (HTTP_CLIENT_SUCCESS == rt && 0 == (http_response.respFlags & HTTP_RESPONSE_CONNECTION_CLOSE_FLAG)) {
+        http_client_pool_give(transport.network, request, port);
+    } else {
+        http_client_disconnect(transport.network);
+    }
+#else
     /* tls disconnect */
-    tuya_transporter_close(network);
-    tuya_transporter_destroy(network);
+    http_client_disconnect(transport.network);
+#endif
 
     if (OPRT_OK != rt) {
         log_error("http_request_send error:%d", rt);
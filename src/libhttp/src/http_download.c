@@ -17,13 +17,40 @@ typedef enum {
     DL_STATE_COMPLETE,
 } http_download_state_t;
 
+typedef enum {
+    DL_WORKER_IDLE,
+    DL_WORKER_BUSY,
+    DL_WORKER_READY,
+    DL_WORKER_FAILED,
+} http_download_worker_state_t;
+
 typedef struct {
-    http_download_config_t config;
-    http_download_event_t event;
+    NetworkContext_t network;
     TransportInterface_t transport;
     HTTPRequestHeaders_t requestHeaders;
-    HTTPRequestInfo_t requestInfo;
     HTTPResponse_t response;
+    bool connected;
+} http_download_conn_t;
+
+typedef struct http_download http_download_t;
+
+typedef struct {
+    http_download_t *ctx;
+    http_download_conn_t conn;
+    THREAD_HANDLE thread;
+    SEM_HANDLE wakeup;
+    SEM_HANDLE exited; // posted by the worker as its last act
+    uint8_t *block;
+    size_t start;  // file offset of the block
+    size_t length; // bytes of the block
+    uint8_t state; // http_download_worker_state_t, changed under ctx->mutex
+} http_download_worker_t;
+
+struct http_download {
+    http_download_config_t config;
+    http_download_event_t event;
+    http_download_conn_t conn;
+    HTTPRequestInfo_t requestInfo;
     char *host;
     char *path;
     uint16_t port;
@@ -33,7 +60,12 @@ typedef struct {
     size_t offset;
     uint8_t state;
     uint8_t *buffer;
-} http_download_t;
+    /* parallel download */
+    http_download_worker_t *workers;
+    uint8_t worker_num;
+    MUTEX_HANDLE mutex;
+    SEM_HANDLE ready;
+};
 
 #define MAX_RETRY_TIMES (8u)
 /*-----------------------------------------------------------*/
@@ -46,6 +78,17 @@ typedef struct {
  */
 #define RANGE_REQUEST_LENGTH_DEFAULT (8 * 1024)
 
+/**
+ * @brief The bytes fetched by one range request of a worker.
+ *
+ * @note Every worker holds one block in RAM until it is delivered, so the
+ * parallel download needs workers * block size bytes of buffers.
+ */
+#define RANGE_BLOCK_LENGTH_DEFAULT (16 * 1024)
+
+//! most workers of a parallel download
+#define HTTP_DOWNLOAD_WORKER_MAX (8u)
+
 /**
  * @brief The length of the HTTP GET method.
  */
@@ -70,7 +113,95 @@ typedef struct {
 #define HTTP_DOWNLOAD_TIMEOUT 180
 
 /*-----------------------------------------------------------*/
-static int http_download_filesize_get(http_download_t *ctx)
+static void http_download_response_free(HTTPResponse_t *response)
+{
+    if (response->pBuffer) {
+        tal_free(response->pBuffer);
+    }
+    if (response->pBody) {
+        tal_free((void *)response->pBody);
+    }
+    memset(response, 0, sizeof(HTTPResponse_t));
+}
+
+/* a request that failed in the parser already freed the response buffers */
+static void http_download_response_drop(HTTPResponse_t *response, int rt)
+{
+    if (HTTPNetworkError == rt) {
+        http_download_response_free(response);
+    } else {
+        memset(response, 0, sizeof(HTTPResponse_t));
+    }
+}
+
+static int http_download_conn_init(http_download_t *ctx, http_download_conn_t *conn)
+{
+    int rt = OPRT_OK;
+    TUYA_TRANSPORT_TYPE_E transport_type = (ctx->config.cacert == NULL) ? TRANSPORT_TYPE_TCP : TRANSPORT_TYPE_TLS;
+
+    conn->network = tuya_transporter_create(transport_type, NULL);
+    TUYA_CHECK_NULL_RETURN(conn->network, OPRT_MALLOC_FAILED);
+    if (transport_type == TRANSPORT_TYPE_TLS) {
+        tuya_tls_config_t tls_config = {
+            .ca_cert = (char *)ctx->config.cacert,
+            .ca_cert_size = ctx->config.cacert_len,
+            .hostname = (char *)ctx->host,
+            .port = ctx->port,
+            .mode = TUYA_TLS_SERVER_CERT_MODE,
+            .verify = true,
+        };
+
+        TUYA_CALL_ERR_RETURN(tuya_transporter_ctrl(conn->network, TUYA_TRANSPORTER_SET_TLS_CONFIG, &tls_config));
+    }
+    /* http client TransportInterface */
+    conn->transport.pNetworkContext = &conn->network;
+    conn->transport.send = NetworkTransportSend;
+    conn->transport.recv = NetworkTransportRecv;
+
+    /* Set the buffer used for storing request headers. */
+    conn->requestHeaders.bufferLen = 512;
+    conn->requestHeaders.pBuffer = tal_malloc(conn->requestHeaders.bufferLen);
+    TUYA_CHECK_NULL_RETURN(conn->requestHeaders.pBuffer, OPRT_MALLOC_FAILED);
+
+    return rt;
+}
+
+static int http_download_conn_connect(http_download_t *ctx, http_download_conn_t *conn)
+{
+    int rt = OPRT_OK;
+
+    if (conn->connected) {
+        return OPRT_OK;
+    }
+    TUYA_CALL_ERR_RETURN(tuya_transporter_connect(conn->network, ctx->host, ctx->port, ctx->config.timeout_ms));
+    conn->connected = true;
+
+    return rt;
+}
+
+static void http_download_conn_close(http_download_conn_t *conn)
+{
+    if (conn->network) {
+        tuya_transporter_close(conn->network);
+    }
+    conn->connected = false;
+}
+
+static void http_download_conn_deinit(http_download_conn_t *conn)
+{
+    http_download_conn_close(conn);
+    if (conn->network) {
+        tuya_transporter_destroy(conn->network);
+        conn->network = NULL;
+    }
+    if (conn->requestHeaders.pBuffer) {
+        tal_free(conn->requestHeaders.pBuffer);
+        conn->requestHeaders.pBuffer = NULL;
+    }
+    http_download_response_free(&conn->response);
+}
+
+static int http_download_filesize_get(http_download_t *ctx, http_download_conn_t *conn)
 {
     int rt = 0;
     /* The location of the file size in contentRangeValStr. */
@@ -80,19 +211,23 @@ static int http_download_filesize_get(http_download_t *ctx)
     size_t contentRangeValStrLength = 0;
 
     PR_DEBUG("Getting file object size from host...");
-    TUYA_CALL_ERR_GOTO(HTTPClient_InitializeRequestHeaders(&ctx->requestHeaders, &ctx->requestInfo), __exit);
-    TUYA_CALL_ERR_GOTO(HTTPClient_AddRangeHeader(&ctx->requestHeaders, 0, 0), __exit);
-    TUYA_CALL_ERR_GOTO(HTTPClient_Request(&ctx->transport, &ctx->requestHeaders, NULL, 0, &ctx->response, 0), __exit);
+    TUYA_CALL_ERR_GOTO(HTTPClient_InitializeRequestHeaders(&conn->requestHeaders, &ctx->requestInfo), __exit);
+    TUYA_CALL_ERR_GOTO(HTTPClient_AddRangeHeader(&conn->requestHeaders, 0, 0), __exit);
+    rt = HTTPClient_Request(&conn->transport, &conn->requestHeaders, NULL, 0, &conn->response, 0);
+    if (OPRT_OK != rt) {
+        http_download_response_drop(&conn->response, rt);
+        goto __exit;
+    }
     PR_DEBUG("Received HTTP response from %s%s...", ctx->host, ctx->path);
-    PR_DEBUG("Response Headers:\n%.*s", (int32_t)ctx->response.headersLen, ctx->response.pHeaders);
-    if (ctx->response.statusCode != HTTP_STATUS_CODE_PARTIAL_CONTENT) {
+    PR_DEBUG("Response Headers:\n%.*s", (int32_t)conn->response.headersLen, conn->response.pHeaders);
+    if (conn->response.statusCode != HTTP_STATUS_CODE_PARTIAL_CONTENT) {
         PR_ERR("Received an invalid response from the server "
                "(Status Code: %u).",
-               ctx->response.statusCode);
+               conn->response.statusCode);
         rt = OPRT_NOT_SUPPORTED;
         goto __exit;
     }
-    TUYA_CALL_ERR_GOTO(HTTPClient_ReadHeader(&ctx->response, (char *)HTTP_CONTENT_RANGE_HEADER_FIELD,
+    TUYA_CALL_ERR_GOTO(HTTPClient_ReadHeader(&conn->response, (char *)HTTP_CONTENT_RANGE_HEADER_FIELD,
                                              (size_t)HTTP_CONTENT_RANGE_HEADER_FIELD_LENGTH,
                                              (const char **)&contentRangeValStr, &contentRangeValStrLength),
                        __exit);
@@ -105,31 +240,50 @@ static int http_download_filesize_get(http_download_t *ctx)
     pFileSizeStr += sizeof(char);
     ctx->file_size = (size_t)strtoul(pFileSizeStr, NULL, 10);
     PR_INFO("The file is %d bytes long.", (int32_t)ctx->file_size);
-    if (ctx->response.pBuffer) {
-        tal_free(ctx->response.pBuffer);
-    }
-    memset(&ctx->response, 0, sizeof(ctx->response));
 __exit:
+    http_download_response_free(&conn->response);
     return rt;
 }
 
-static int http_download_range_request(http_download_t *ctx, uint32_t range_start, uint32_t range_end)
+static int http_download_range_request(http_download_t *ctx, http_download_conn_t *conn, uint32_t range_start,
+                                       uint32_t range_end)
 {
     int rt = OPRT_OK;
 
     PR_DEBUG("Downloading bytes %d-%d, from %s...: ", range_start, range_end, ctx->host);
-    TUYA_CALL_ERR_GOTO(HTTPClient_InitializeRequestHeaders(&ctx->requestHeaders, &ctx->requestInfo), __exit);
-    TUYA_CALL_ERR_GOTO(HTTPClient_AddRangeHeader(&ctx->requestHeaders, range_start, range_end), __exit);
-    PR_TRACE("Request Headers:\n%.*s", (int32_t)ctx->requestHeaders.headersLen, (char *)ctx->requestHeaders.pBuffer);
-    TUYA_CALL_ERR_GOTO(HTTPClient_Request(&ctx->transport, &ctx->requestHeaders, NULL, 0, &ctx->response,
-                                          HTTP_SEND_DISABLE_RECV_BODY_FLAG),
-                       __exit);
+    http_download_response_free(&conn->response);
+    TUYA_CALL_ERR_GOTO(HTTPClient_InitializeRequestHeaders(&conn->requestHeaders, &ctx->requestInfo), __exit);
+    TUYA_CALL_ERR_GOTO(HTTPClient_AddRangeHeader(&conn->requestHeaders, range_start, range_end), __exit);
+    PR_TRACE("Request Headers:\n%.*s", (int32_t)conn->requestHeaders.headersLen, (char *)conn->requestHeaders.pBuffer);
+    rt = HTTPClient_Request(&conn->transport, &conn->requestHeaders, NULL, 0, &conn->response,
+                            HTTP_SEND_DISABLE_RECV_BODY_FLAG);
+    if (OPRT_OK != rt) {
+        http_download_response_drop(&conn->response, rt);
+        goto __exit;
+    }
     PR_TRACE("Received HTTP response from %s%s...", ctx->host, ctx->path);
-    PR_TRACE("Response Headers:\n%.*s", (int32_t)ctx->response.headersLen, ctx->response.pHeaders);
+    PR_TRACE("Response Headers:\n%.*s", (int32_t)conn->response.headersLen, conn->response.pHeaders);
 __exit:
     return rt;
 }
 
+/* hand the bytes after the carried remain of ctx->buffer to the handler */
+static void http_download_data_notify(http_download_t *ctx, size_t read_size)
+{
+    if (ctx->config.event_handler) {
+        ctx->event.data = (uint8_t *)ctx->buffer;
+        ctx->event.data_len = read_size + ctx->remain_len;
+        ctx->event.offset = ctx->received_size - ctx->remain_len;
+        ctx->event.remain_len = ctx->remain_len;
+        ctx->config.event_handler(DL_EVENT_ON_DATA, &ctx->event);
+        if (ctx->event.remain_len) {
+            memmove(ctx->buffer, ctx->buffer + (ctx->event.data_len - ctx->event.remain_len), ctx->event.remain_len);
+        }
+        ctx->remain_len = ctx->event.remain_len;
+    }
+    ctx->received_size += read_size;
+}
+
 /*-----------------------------------------------------------*/
 static int http_file_download_init(http_download_t *ctx, http_download_config_t *config)
 {
@@ -141,10 +295,17 @@ static int http_file_download_init(http_download_t *ctx, http_download_config_t
     memset(ctx, 0, sizeof(http_download_t));
     memcpy(&ctx->config, config, sizeof(http_download_config_t));
     ctx->file_size = ctx->config.file_size;
+    ctx->received_size = ctx->config.offset;
     ctx->config.range_length = config->range_length;
     if (config->range_length == 0) {
         ctx->config.range_length = RANGE_REQUEST_LENGTH_DEFAULT;
     }
+    if (config->block_size == 0) {
+        ctx->config.block_size = RANGE_BLOCK_LENGTH_DEFAULT;
+    }
+    if (config->workers > HTTP_DOWNLOAD_WORKER_MAX) {
+        ctx->config.workers = HTTP_DOWNLOAD_WORKER_MAX;
+    }
     ctx->event.user_data = ctx->config.user_data;
 
     /* url parse to host port path */
@@ -195,43 +356,14 @@ static int http_file_download_init(http_download_t *ctx, http_download_config_t
     requestInfo->pPath = ctx->path;
     requestInfo->pathLen = strlen(ctx->path);
     requestInfo->reqFlags = HTTP_REQUEST_KEEP_ALIVE_FLAG;
-    /* Set the buffer used for storing request headers. */
-
-    HTTPRequestHeaders_t *requestHeaders = &ctx->requestHeaders;
-    requestHeaders->bufferLen = 512;
-    requestHeaders->pBuffer = tal_malloc(requestHeaders->bufferLen);
-    TUYA_CHECK_NULL_RETURN(requestHeaders->pBuffer, OPRT_MALLOC_FAILED);
 
     return rt;
 }
 
-int http_file_download(http_download_config_t *config)
+static bool http_download_serial(http_download_t *ctx)
 {
     int rt = OPRT_OK;
-
-    http_download_t *ctx = tal_calloc(1, sizeof(http_download_t));
-    TUYA_CHECK_NULL_GOTO(ctx, __exit);
-    TUYA_CALL_ERR_GOTO(http_file_download_init(ctx, config), __exit);
-    /* TLS pre init */
-    TUYA_TRANSPORT_TYPE_E transport_type = (config->cacert == NULL) ? TRANSPORT_TYPE_TCP : TRANSPORT_TYPE_TLS;
-    NetworkContext_t network;
-    TUYA_CHECK_NULL_GOTO(network = tuya_transporter_create(transport_type, NULL), __exit);
-    if (transport_type == TRANSPORT_TYPE_TLS) {
-        tuya_tls_config_t tls_config = {
-            .ca_cert = (char *)config->cacert,
-            .ca_cert_size = config->cacert_len,
-            .hostname = (char *)ctx->host,
-            .port = ctx->port,
-            .mode = TUYA_TLS_SERVER_CERT_MODE,
-            .verify = true,
-        };
-
-        TUYA_CALL_ERR_GOTO(tuya_transporter_ctrl(network, TUYA_TRANSPORTER_SET_TLS_CONFIG, &tls_config), __exit);
-    }
-    /* http client TransportInterface */
-    ctx->transport.pNetworkContext = (NetworkContext_t *)&network;
-    ctx->transport.send = NetworkTransportSend;
-    ctx->transport.recv = NetworkTransportRecv;
+    http_download_conn_t *conn = &ctx->conn;
 
     ctx->state = DL_STATE_NETWORK_CONNECT;
     TIME_T download_time = tal_time_get_posix();
@@ -240,16 +372,12 @@ int http_file_download(http_download_config_t *config)
 
     int32_t read_size = 0;
 
-    if (ctx->config.event_handler) {
-        ctx->config.event_handler(DL_EVENT_START, &ctx->event);
-    }
-
     do {
 
         switch (ctx->state) {
 
         case DL_STATE_NETWORK_CONNECT:
-            rt = tuya_transporter_connect(network, ctx->host, ctx->port, config->timeout_ms);
+            rt = http_download_conn_connect(ctx, conn);
             if (OPRT_OK == rt) {
                 ctx->state = DL_STATE_FILESIZE_GET;
             } else {
@@ -259,7 +387,7 @@ int http_file_download(http_download_config_t *config)
 
         case DL_STATE_FILESIZE_GET:
             if (0 == ctx->file_size) {
-                rt = http_download_filesize_get(ctx);
+                rt = http_download_filesize_get(ctx, conn);
             }
             if (OPRT_OK != rt) {
                 ctx->state = DL_STATE_NETWORK_RECONNECT;
@@ -269,11 +397,11 @@ int http_file_download(http_download_config_t *config)
                 ctx->event.file_size = ctx->file_size;
                 ctx->config.event_handler(DL_EVENT_ON_FILESIZE, &ctx->event);
             }
-            ctx->state = DL_STATE_RANGE_REQUEST;
+            ctx->state = (ctx->received_size >= ctx->file_size) ? DL_STATE_COMPLETE : DL_STATE_RANGE_REQUEST;
             break;
 
         case DL_STATE_RANGE_REQUEST:
-            rt = http_download_range_request(ctx, ctx->received_size, ctx->file_size);
+            rt = http_download_range_request(ctx, conn, ctx->received_size, ctx->file_size);
             if (OPRT_OK != rt) {
                 ctx->state = DL_STATE_NETWORK_RECONNECT;
                 break;
@@ -281,7 +409,7 @@ int http_file_download(http_download_config_t *config)
             ctx->state = DL_STATE_DATE_GET;
 
         case DL_STATE_DATE_GET: {
-            read_size = HTTPClient_Recv(&ctx->transport, &ctx->response, ctx->buffer + ctx->remain_len,
+            read_size = HTTPClient_Recv(&conn->transport, &conn->response, ctx->buffer + ctx->remain_len,
                                         ctx->config.range_length - ctx->remain_len);
 
             if (read_size <= 0) {
@@ -289,19 +417,7 @@ int http_file_download(http_download_config_t *config)
                 ctx->state = DL_STATE_NETWORK_RECONNECT;
                 break;
             }
-            if (ctx->config.event_handler) {
-                ctx->event.data = (uint8_t *)ctx->buffer;
-                ctx->event.data_len = read_size + ctx->remain_len;
-                ctx->event.offset = ctx->received_size - ctx->remain_len;
-                ctx->event.remain_len = ctx->remain_len;
-                ctx->config.event_handler(DL_EVENT_ON_DATA, &ctx->event);
-                if (ctx->event.remain_len) {
-                    memmove(ctx->buffer, ctx->buffer + (ctx->event.data_len - ctx->event.remain_len),
-                            ctx->event.remain_len);
-                }
-                ctx->remain_len = ctx->event.remain_len;
-                ctx->received_size += read_size;
-            }
+            http_download_data_notify(ctx, read_size);
             //! reset time
             download_time = tal_time_get_posix();
             /* File download complete? */
@@ -312,7 +428,7 @@ int http_file_download(http_download_config_t *config)
         }
 
         case DL_STATE_NETWORK_RECONNECT:
-            tuya_transporter_close(network);
+            http_download_conn_close(conn);
             tal_system_sleep(3000);
             ctx->state = DL_STATE_NETWORK_CONNECT;
             break;
@@ -327,10 +443,302 @@ int http_file_download(http_download_config_t *config)
         }
     } while (((tal_time_get_posix() - download_time) < HTTP_DOWNLOAD_TIMEOUT) && !is_completed);
 
-    tuya_transporter_close(network);
-    tuya_transporter_destroy(network);
+    return is_completed;
+}
+
+/*-----------------------------------------------------------*/
+static int http_download_block_get(http_download_t *ctx, http_download_worker_t *worker)
+{
+    int rt = OPRT_OK;
+    int32_t read_size = 0;
+    size_t filled = 0;
+    http_download_conn_t *conn = &worker->conn;
+
+    TUYA_CALL_ERR_RETURN(http_download_conn_connect(ctx, conn));
+    TUYA_CALL_ERR_RETURN(
+        http_download_range_request(ctx, conn, worker->start, worker->start + worker->length - 1));
+    if (conn->response.statusCode != HTTP_STATUS_CODE_PARTIAL_CONTENT ||
+        conn->response.contentLength != worker->length || conn->response.bodyLen > worker->length) {
+        PR_ERR("range %d-%d: status %u, length %d", worker->start, worker->start + worker->length - 1,
+               conn->response.statusCode, conn->response.contentLength);
+        return OPRT_NOT_SUPPORTED;
+    }
+
+    while (filled < worker->length) {
+        read_size =
+            HTTPClient_Recv(&conn->transport, &conn->response, worker->block + filled, worker->length - filled);
+        if (read_size <= 0) {
+            return OPRT_RECV_ERR;
+        }
+        filled += read_size;
+    }
+
+    /* the body is read to its end, the connection takes the next request */
+    if (conn->response.respFlags & HTTP_RESPONSE_CONNECTION_CLOSE_FLAG) {
+        http_download_conn_close(conn);
+    }
+    http_download_response_free(&conn->response);
+
+    return rt;
+}
+
+static void http_download_worker_task(void *arg)
+{
+    int rt = OPRT_OK;
+    uint32_t retry = 0;
+    http_download_worker_t *worker = (http_download_worker_t *)arg;
+    http_download_t *ctx = worker->ctx;
+
+    while (THREAD_STATE_RUNNING == tal_thread_get_state(worker->thread)) {
+        tal_semaphore_wait_forever(worker->wakeup);
+        if (DL_WORKER_BUSY != worker->state) {
+            continue;
+        }
+
+        for (retry = 0; retry < MAX_RETRY_TIMES; retry++) {
+            rt = http_download_block_get(ctx, worker);
+            if (OPRT_OK == rt || THREAD_STATE_RUNNING != tal_thread_get_state(worker->thread)) {
+                break;
+            }
+            PR_WARN("range %d-%d get error:%d, goto retry", worker->start, worker->start + worker->length - 1, rt);
+            http_download_conn_close(&worker->conn);
+            tal_system_sleep(3000);
+        }
+
+        tal_mutex_lock(ctx->mutex);
+        worker->state = (OPRT_OK == rt) ? DL_WORKER_READY : DL_WORKER_FAILED;
+        tal_mutex_unlock(ctx->mutex);
+        tal_semaphore_post(ctx->ready);
+    }
+
+    tal_semaphore_post(worker->exited);
+}
+
+static void http_download_workers_stop(http_download_t *ctx)
+{
+    uint8_t i = 0;
+    http_download_worker_t *worker = NULL;
+
+    for (i = 0; i < ctx->worker_num; i++) {
+        worker = &ctx->workers[i];
+        if (worker->thread) {
+            // a thread that has not started running yet cannot be deleted
+            while (OPRT_COM_ERROR == tal_thread_delete(worker->thread)) {
+                tal_system_sleep(10);
+            }
+            tal_semaphore_post(worker->wakeup);
+        }
+    }
+
+    for (i = 0; i < ctx->worker_num; i++) {
+        worker = &ctx->workers[i];
+        // the thread handle is freed by TAL once the thread ends, it is not polled
+        if (worker->thread) {
+            tal_semaphore_wait_forever(worker->exited);
+        }
+        if (worker->wakeup) {
+            tal_semaphore_release(worker->wakeup);
+        }
+        if (worker->exited) {
+            tal_semaphore_release(worker->exited);
+        }
+        http_download_conn_deinit(&worker->conn);
+        if (worker->block) {
+            tal_free(worker->block);
+        }
+    }
+    tal_free(ctx->workers);
+    ctx->workers = NULL;
+    ctx->worker_num = 0;
+}
+
+static int http_download_workers_start(http_download_t *ctx)
+{
+    int rt = OPRT_OK;
+    uint8_t i = 0;
+    http_download_worker_t *worker = NULL;
+    THREAD_CFG_T thrd_param = {4096, THREAD_PRIO_3, "http_dl_worker"};
+
+    ctx->workers = tal_calloc(ctx->config.workers, sizeof(http_download_worker_t));
+    TUYA_CHECK_NULL_RETURN(ctx->workers, OPRT_MALLOC_FAILED);
+    ctx->worker_num = ctx->config.workers;
+
+    for (i = 0; i < ctx->worker_num; i++) {
+        worker = &ctx->workers[i];
+        worker->ctx = ctx;
+        worker->block = tal_malloc(ctx->config.block_size);
+        TUYA_CHECK_NULL_GOTO(worker->block, __exit);
+        TUYA_CALL_ERR_GOTO(http_download_conn_init(ctx, &worker->conn), __exit);
+        TUYA_CALL_ERR_GOTO(tal_semaphore_create_init(&worker->wakeup, 0, 1), __exit);
+        TUYA_CALL_ERR_GOTO(tal_semaphore_create_init(&worker->exited, 0, 1), __exit);
+    }
+
+    for (i = 0; i < ctx->worker_num; i++) {
+        worker = &ctx->workers[i];
+        TUYA_CALL_ERR_GOTO(tal_thread_create_and_start(&worker->thread, NULL, NULL, http_download_worker_task, worker,
+                                                       &thrd_param),
+                           __exit);
+    }
+
+    return OPRT_OK;
+
+__exit:
+    http_download_workers_stop(ctx);
+    return (OPRT_OK == rt) ? OPRT_MALLOC_FAILED : rt;
+}
+
+/* deliver a fetched block in pieces of range_length, after the carried remain */
+static int http_download_block_deliver(http_download_t *ctx, http_download_worker_t *worker)
+{
+    uint8_t *data = worker->block;
+    size_t left = worker->length;
+    size_t copy_len = 0;
+
+    while (left) {
+        copy_len = MIN(ctx->config.range_length - ctx->remain_len, left);
+        if (0 == copy_len) {
+            PR_ERR("download handler left %d bytes unconsumed", ctx->remain_len);
+            return OPRT_COM_ERROR;
+        }
+        memcpy(ctx->buffer + ctx->remain_len, data, copy_len);
+        http_download_data_notify(ctx, copy_len);
+        data += copy_len;
+        left -= copy_len;
+    }
+
+    return OPRT_OK;
+}
+
+static int http_download_parallel_filesize_get(http_download_t *ctx)
+{
+    int rt = OPRT_OK;
+    /* the first worker keeps the connection for its first block */
+    http_download_conn_t *conn = &ctx->workers[0].conn;
+    TIME_T download_time = tal_time_get_posix();
+
+    while (0 == ctx->file_size) {
+        rt = http_download_conn_connect(ctx, conn);
+        if (OPRT_OK == rt) {
+            rt = http_download_filesize_get(ctx, conn);
+        }
+        if (OPRT_OK == rt) {
+            break;
+        }
+        http_download_conn_close(conn);
+        if ((tal_time_get_posix() - download_time) >= HTTP_DOWNLOAD_TIMEOUT) {
+            return rt;
+        }
+        tal_system_sleep(3000);
+    }
+
+    return OPRT_OK;
+}
+
+static bool http_download_parallel(http_download_t *ctx)
+{
+    int rt = OPRT_OK;
+    uint8_t i = 0;
+    size_t next_fetch = ctx->received_size;
+    http_download_worker_t *worker = NULL;
+    http_download_worker_t *next = NULL;
+    bool failed = false;
+    bool is_completed = false;
+    TIME_T download_time = 0;
+
+    TUYA_CALL_ERR_GOTO(tal_mutex_create_init(&ctx->mutex), __exit);
+    TUYA_CALL_ERR_GOTO(tal_semaphore_create_init(&ctx->ready, 0, ctx->config.workers), __exit);
+    TUYA_CALL_ERR_GOTO(http_download_workers_start(ctx), __exit);
+    TUYA_CALL_ERR_GOTO(http_download_parallel_filesize_get(ctx), __exit);
+    if (ctx->config.event_handler) {
+        ctx->event.file_size = ctx->file_size;
+        ctx->config.event_handler(DL_EVENT_ON_FILESIZE, &ctx->event);
+    }
+
+    download_time = tal_time_get_posix();
+    while (ctx->received_size < ctx->file_size) {
+        next = NULL;
+        tal_mutex_lock(ctx->mutex);
+        for (i = 0; i < ctx->worker_num; i++) {
+            worker = &ctx->workers[i];
+            if (DL_WORKER_IDLE == worker->state && next_fetch < ctx->file_size) {
+                worker->start = next_fetch;
+                worker->length = MIN(ctx->config.block_size, ctx->file_size - next_fetch);
+                worker->state = DL_WORKER_BUSY;
+                next_fetch += worker->length;
+                tal_semaphore_post(worker->wakeup);
+            } else if (DL_WORKER_READY == worker->state && worker->start == ctx->received_size) {
+                next = worker;
+            } else if (DL_WORKER_FAILED == worker->state) {
+                failed = true;
+            }
+        }
+        tal_mutex_unlock(ctx->mutex);
+
+        if (failed) {
+            break;
+        }
+        if (next) {
+            if (OPRT_OK != http_download_block_deliver(ctx, next)) {
+                break;
+            }
+            tal_mutex_lock(ctx->mutex);
+            next->state = DL_WORKER_IDLE;
+            tal_mutex_unlock(ctx->mutex);
+            //! reset time
+            download_time = tal_time_get_posix();
+            continue;
+        }
+        if ((tal_time_get_posix() - download_time) >= HTTP_DOWNLOAD_TIMEOUT) {
+            PR_ERR("file download timeout at %d", ctx->received_size);
+            break;
+        }
+        tal_semaphore_wait(ctx->ready, 1000);
+    }
+
+    if (ctx->received_size >= ctx->file_size) {
+        PR_INFO("Download Complete!");
+        is_completed = true;
+        if (ctx->config.event_handler) {
+            ctx->config.event_handler(DL_EVENT_FINISH, &ctx->event);
+        }
+    }
+
+__exit:
+    if (ctx->workers) {
+        http_download_workers_stop(ctx);
+    }
+    if (ctx->ready) {
+        tal_semaphore_release(ctx->ready);
+    }
+    if (ctx->mutex) {
+        tal_mutex_release(ctx->mutex);
+    }
+    return is_completed;
+}
+
+int http_file_download(http_download_config_t *config)
+{
+    int rt = OPRT_OK;
+    bool is_completed = false;
+
+    http_download_t *ctx = tal_calloc(1, sizeof(http_download_t));
+    TUYA_CHECK_NULL_GOTO(ctx, __exit);
+    TUYA_CALL_ERR_GOTO(http_file_download_init(ctx, config), __exit);
+
+    if (ctx->config.event_handler) {
+        ctx->config.event_handler(DL_EVENT_START, &ctx->event);
+    }
+
+    if (ctx->config.workers > 1) {
+        is_completed = http_download_parallel(ctx);
+    } else {
+        /* TLS pre init */
+        TUYA_CALL_ERR_GOTO(http_download_conn_init(ctx, &ctx->conn), __exit);
+        is_completed = http_download_serial(ctx);
+    }
 
     if (!is_completed) {
+        rt = OPRT_COM_ERROR;
         if (ctx->config.event_handler) {
             ctx->config.event_handler(DL_EVENT_FAULT, &ctx->event);
         }
@@ -338,17 +746,15 @@ int http_file_download(http_download_config_t *config)
 
 __exit:
     if (ctx) {
+        http_download_conn_deinit(&ctx->conn);
         if (ctx->host) {
             tal_free(ctx->host);
         }
         if (ctx->path) {
             tal_free(ctx->path);
         }
-        if (ctx->requestHeaders.pBuffer) {
-            tal_free(ctx->requestHeaders.pBuffer);
-        }
-        if (ctx->response.pBuffer) {
-            tal_free(ctx->response.pBuffer);
+        if (ctx->buffer) {
+            tal_free(ctx->buffer);
         }
 
         tal_free(ctx);
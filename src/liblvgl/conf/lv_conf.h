@@ -98,10 +98,14 @@
  * - LV_OS_RTTHREAD
  * - LV_OS_WINDOWS
  * - LV_OS_CUSTOM */
+#if defined(LVGL_USE_OS) && (LVGL_USE_OS == 1)
+#define LV_USE_OS   LV_OS_CUSTOM
+#else
 #define LV_USE_OS   LV_OS_NONE
+#endif
 
 #if LV_USE_OS == LV_OS_CUSTOM
-    #define LV_OS_CUSTOM_INCLUDE <stdint.h>
+    #define LV_OS_CUSTOM_INCLUDE "lv_port_os.h"
 #endif
 
 /*========================
@@ -127,7 +131,11 @@
 	/* Set the number of draw unit.
      * > 1 requires an operating system enabled in `LV_USE_OS`
      * > 1 means multiply threads will render the screen in parallel */
+#if defined(LVGL_DRAW_UNIT_CNT) && (LV_USE_OS != LV_OS_NONE)
+    #define LV_DRAW_SW_DRAW_UNIT_CNT    LVGL_DRAW_UNIT_CNT
+#else
     #define LV_DRAW_SW_DRAW_UNIT_CNT    1
+#endif
 
     /* Use Arm-2D to accelerate the sw render */
     #define LV_USE_DRAW_ARM2D_SYNC      0
@@ -698,6 +706,13 @@
     #define LV_GIF_CACHE_DECODE_DATA 0
 #endif
 
+/*Player of the tiled frame sequences of tools/img_anim_conv.py*/
+#if defined(LVGL_ENABLE_TILE_ANIM) && (LVGL_ENABLE_TILE_ANIM == 1)
+#define LV_USE_TILE_ANIM 1
+#else
+#define LV_USE_TILE_ANIM 0
+#endif
+
 
 /*Decode bin images to RAM*/
 #define LV_BIN_DECODER_RAM_LOAD 0
@@ -744,7 +759,7 @@
 #define LV_USE_THORVG_EXTERNAL 0
 
 /*Use lvgl built-in LZ4 lib*/
-#define LV_USE_LZ4_INTERNAL  0
+#define LV_USE_LZ4_INTERNAL  LV_USE_TILE_ANIM
 
 /*Use external LZ4 library*/
 #define LV_USE_LZ4_EXTERNAL  0
@@ -0,0 +1,302 @@
+/**
+ * @file lv_tile_anim.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_tile_anim.h"
+#if LV_USE_TILE_ANIM
+
+#include "src/libs/lz4/lz4.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define MY_CLASS (&lv_tile_anim_class)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void lv_tile_anim_constructor(const lv_obj_class_t * class_p, lv_obj_t * obj);
+static void lv_tile_anim_destructor(const lv_obj_class_t * class_p, lv_obj_t * obj);
+static void next_frame_task_cb(lv_timer_t * t);
+static void free_buffers(lv_tile_anim_t * anim);
+static void apply_frame(lv_obj_t * obj, const lv_tile_anim_frame_t * frame);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+const lv_obj_class_t lv_tile_anim_class = {
+    .constructor_cb = lv_tile_anim_constructor,
+    .destructor_cb = lv_tile_anim_destructor,
+    .instance_size = sizeof(lv_tile_anim_t),
+    .base_class = &lv_image_class,
+    .name = "tile_anim",
+};
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+lv_obj_t * lv_tile_anim_create(lv_obj_t * parent)
+{
+
+    LV_LOG_INFO("begin");
+    lv_obj_t * obj = lv_obj_class_create_obj(MY_CLASS, parent);
+    lv_obj_class_init_obj(obj);
+    return obj;
+}
+
+void lv_tile_anim_set_src(lv_obj_t * obj, const lv_tile_anim_dsc_t * dsc)
+{
+    lv_tile_anim_t * anim = (lv_tile_anim_t *) obj;
+    lv_color_format_t cf = dsc->palette_alpha ? LV_COLOR_FORMAT_RGB565A8 : LV_COLOR_FORMAT_RGB565;
+    uint32_t px_cnt = (uint32_t)dsc->w * dsc->h;
+    uint32_t data_size = px_cnt * (dsc->palette_alpha ? 3 : 2);
+
+    lv_image_cache_drop(&anim->imgdsc);
+
+    /*Keep the buffers when the new animation fits in them*/
+    if(anim->dsc == NULL || anim->dsc->w != dsc->w || anim->dsc->h != dsc->h ||
+       (anim->dsc->palette_alpha != NULL) != (dsc->palette_alpha != NULL) ||
+       anim->dsc->tile_w * anim->dsc->tile_h < dsc->tile_w * dsc->tile_h) {
+        free_buffers(anim);
+        anim->imgdsc.data = lv_malloc(data_size);
+        anim->index_map = lv_malloc(px_cnt);
+        anim->tile_buf = lv_malloc(2 * dsc->tile_w * dsc->tile_h);
+        if(anim->imgdsc.data == NULL || anim->index_map == NULL || anim->tile_buf == NULL) {
+            LV_LOG_WARN("Couldn't allocate the frame buffers");
+            free_buffers(anim);
+            anim->dsc = NULL;
+            lv_timer_pause(anim->timer);
+            return;
+        }
+    }
+
+    anim->dsc = dsc;
+    anim->imgdsc.header.magic = LV_IMAGE_HEADER_MAGIC;
+    anim->imgdsc.header.cf = cf;
+    anim->imgdsc.header.w = dsc->w;
+    anim->imgdsc.header.h = dsc->h;
+    anim->imgdsc.header.stride = dsc->w * 2;
+    anim->imgdsc.data_size = data_size;
+
+    /*The first frame holds every tile*/
+    anim->frame_act = 0;
+    anim->loop_act = 0;
+    apply_frame(obj, &dsc->frames[0]);
+    anim->last_call = lv_tick_get();
+
+    lv_image_set_src(obj, &anim->imgdsc);
+    lv_obj_invalidate(obj);
+
+    lv_timer_resume(anim->timer);
+    lv_timer_reset(anim->timer);
+}
+
+void lv_tile_anim_restart(lv_obj_t * obj)
+{
+    lv_tile_anim_t * anim = (lv_tile_anim_t *) obj;
+
+    if(anim->dsc == NULL) {
+        LV_LOG_WARN("Tile animation not set");
+        return;
+    }
+
+    lv_tile_anim_set_src(obj, anim->dsc);
+}
+
+void lv_tile_anim_pause(lv_obj_t * obj)
+{
+    lv_tile_anim_t * anim = (lv_tile_anim_t *) obj;
+    lv_timer_pause(anim->timer);
+}
+
+void lv_tile_anim_resume(lv_obj_t * obj)
+{
+    lv_tile_anim_t * anim = (lv_tile_anim_t *) obj;
+
+    if(anim->dsc == NULL) {
+        LV_LOG_WARN("Tile animation not set");
+        return;
+    }
+
+    lv_timer_resume(anim->timer);
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static void lv_tile_anim_constructor(const lv_obj_class_t * class_p, lv_obj_t * obj)
+{
+    LV_UNUSED(class_p);
+
+    lv_tile_anim_t * anim = (lv_tile_anim_t *) obj;
+
+    anim->dsc = NULL;
+    anim->imgdsc.data = NULL;
+    anim->index_map = NULL;
+    anim->tile_buf = NULL;
+    anim->timer = lv_timer_create(next_frame_task_cb, 10, obj);
+    lv_timer_pause(anim->timer);
+}
+
+static void lv_tile_anim_destructor(const lv_obj_class_t * class_p, lv_obj_t * obj)
+{
+    LV_UNUSED(class_p);
+    lv_tile_anim_t * anim = (lv_tile_anim_t *) obj;
+
+    lv_image_cache_drop(&anim->imgdsc);
+
+    free_buffers(anim);
+    lv_timer_delete(anim->timer);
+}
+
+static void free_buffers(lv_tile_anim_t * anim)
+{
+    lv_free((void *)anim->imgdsc.data);
+    lv_free(anim->index_map);
+    lv_free(anim->tile_buf);
+    anim->imgdsc.data = NULL;
+    anim->imgdsc.data_size = 0;
+    anim->index_map = NULL;
+    anim->tile_buf = NULL;
+}
+
+static void next_frame_task_cb(lv_timer_t * t)
+{
+    lv_obj_t * obj = t->user_data;
+    lv_tile_anim_t * anim = (lv_tile_anim_t *) obj;
+    const lv_tile_anim_dsc_t * dsc = anim->dsc;
+    uint32_t elaps = lv_tick_elaps(anim->last_call);
+    if(elaps < dsc->frames[anim->frame_act].delay_ms) return;
+
+    anim->last_call = lv_tick_get();
+
+    if(anim->frame_act + 1 < dsc->frame_cnt) {
+        anim->frame_act++;
+        apply_frame(obj, &dsc->frames[anim->frame_act]);
+        return;
+    }
+
+    anim->loop_act++;
+    if(dsc->loop_cnt && anim->loop_act >= dsc->loop_cnt) {
+        /*It was the last repeat*/
+        lv_timer_pause(t);
+        lv_obj_send_event(obj, LV_EVENT_READY, NULL);
+        return;
+    }
+
+    /*The entry after the last frame takes it back to the first one*/
+    anim->frame_act = 0;
+    apply_frame(obj, &dsc->frames[dsc->frame_cnt]);
+}
+
+/**
+ * Decode the tiles of a frame into the index map and the image, then
+ * invalidate the area they cover.
+ */
+static void apply_frame(lv_obj_t * obj, const lv_tile_anim_frame_t * frame)
+{
+    lv_tile_anim_t * anim = (lv_tile_anim_t *) obj;
+    const lv_tile_anim_dsc_t * dsc = anim->dsc;
+    uint32_t cols = (dsc->w + dsc->tile_w - 1) / dsc->tile_w;
+    uint32_t tile_px_max = (uint32_t)dsc->tile_w * dsc->tile_h;
+    uint16_t * color_map = (uint16_t *)anim->imgdsc.data;
+    uint8_t * alpha_map = dsc->palette_alpha ? (uint8_t *)anim->imgdsc.data + (uint32_t)dsc->w * dsc->h * 2 : NULL;
+    lv_area_t inv = {LV_COORD_MAX, LV_COORD_MAX, LV_COORD_MIN, LV_COORD_MIN};
+    uint32_t i;
+
+    if(frame->tile_cnt == 0) return;
+
+    for(i = 0; i < frame->tile_cnt; i++) {
+        const lv_tile_anim_tile_t * tile = &dsc->tiles[frame->tile_first + i];
+        const uint8_t * src = dsc->data + tile->offset;
+        uint32_t x0 = (tile->index % cols) * dsc->tile_w;
+        uint32_t y0 = (tile->index / cols) * dsc->tile_h;
+        uint32_t tw = LV_MIN(dsc->tile_w, dsc->w - x0);
+        uint32_t th = LV_MIN(dsc->tile_h, dsc->h - y0);
+        uint32_t px_cnt = tw * th;
+        const uint8_t * idx = anim->tile_buf;
+        uint8_t * dict = anim->tile_buf + tile_px_max;
+        uint32_t x, y;
+        int res;
+
+        switch(tile->codec) {
+            case LV_TILE_ANIM_CODEC_FILL:
+                lv_memset(anim->tile_buf, src[0], px_cnt);
+                break;
+            case LV_TILE_ANIM_CODEC_RAW:
+                idx = src;
+                break;
+            case LV_TILE_ANIM_CODEC_LZ4:
+                res = LZ4_decompress_safe((const char *)src, (char *)anim->tile_buf, tile->size, px_cnt);
+                if(res != (int)px_cnt) {
+                    LV_LOG_WARN("Corrupt tile %d", tile->index);
+                    continue;
+                }
+                break;
+            default:
+                /*The dictionary is the tile as it is shown now*/
+                for(y = 0; y < th; y++) {
+                    lv_memcpy(dict + y * tw, anim->index_map + (y0 + y) * dsc->w + x0, tw);
+                }
+                res = LZ4_decompress_safe_usingDict((const char *)src, (char *)anim->tile_buf, tile->size, px_cnt,
+                                                    (const char *)dict, px_cnt);
+                if(res != (int)px_cnt) {
+                    LV_LOG_WARN("Corrupt tile %d", tile->index);
+                    continue;
+                }
+                break;
+        }
+
+        for(y = 0; y < th; y++) {
+            uint32_t ofs = (y0 + y) * dsc->w + x0;
+            const uint8_t * row = idx + y * tw;
+
+            lv_memcpy(anim->index_map + ofs, row, tw);
+            for(x = 0; x < tw; x++) {
+                color_map[ofs + x] = dsc->palette[row[x]];
+            }
+            if(alpha_map) {
+                for(x = 0; x < tw; x++) {
+                    alpha_map[ofs + x] = dsc->palette_alpha[row[x]];
+                }
+            }
+        }
+
+        inv.x1 = LV_MIN(inv.x1, (int32_t)x0);
+        inv.y1 = LV_MIN(inv.y1, (int32_t)y0);
+        inv.x2 = LV_MAX(inv.x2, (int32_t)(x0 + tw - 1));
+        inv.y2 = LV_MAX(inv.y2, (int32_t)(y0 + th - 1));
+    }
+
+    lv_image_cache_drop(&anim->imgdsc);
+
+    /*Redraw only the changed tiles when the image is drawn as it is*/
+    lv_area_t content;
+    lv_obj_get_content_coords(obj, &content);
+    if(inv.x1 > inv.x2 || lv_image_get_scale(obj) != LV_SCALE_NONE || lv_image_get_rotation(obj) != 0 ||
+       lv_image_get_offset_x(obj) != 0 || lv_image_get_offset_y(obj) != 0 ||
+       lv_area_get_width(&content) != dsc->w || lv_area_get_height(&content) != dsc->h) {
+        lv_obj_invalidate(obj);
+        return;
+    }
+
+    lv_area_move(&inv, content.x1, content.y1);
+    lv_obj_invalidate_area(obj, &inv);
+}
+
+#endif /*LV_USE_TILE_ANIM*/
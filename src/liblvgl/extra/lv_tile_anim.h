@@ -0,0 +1,132 @@
+/**
+ * @file lv_tile_anim.h
+ *
+ * Player of the tile animations written by tools/img_anim_conv.py. The frames
+ * are palette indices cut into tiles, a frame only stores the tiles that
+ * changed since the frame before it. The player keeps the shown frame as an
+ * RGB565 image, decodes the changed tiles into it and invalidates only the
+ * area they cover.
+ */
+
+#ifndef LV_TILE_ANIM_H
+#define LV_TILE_ANIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#if defined(LV_LVGL_H_INCLUDE_SIMPLE)
+#include "lvgl.h"
+#else
+#include "lvgl/lvgl.h"
+#endif
+
+#if LV_USE_TILE_ANIM
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef enum {
+    LV_TILE_ANIM_CODEC_FILL = 0,    /*One palette index for the whole tile*/
+    LV_TILE_ANIM_CODEC_RAW,         /*The palette indices as they are*/
+    LV_TILE_ANIM_CODEC_LZ4,         /*An LZ4 block of the palette indices*/
+    LV_TILE_ANIM_CODEC_LZ4_DELTA,   /*An LZ4 block with the indices the tile had before as dictionary*/
+} lv_tile_anim_codec_t;
+
+typedef struct {
+    uint32_t offset;        /*Offset of the tile data in `data`*/
+    uint16_t size;          /*Bytes of the tile data*/
+    uint16_t index : 14;    /*Tile in the grid, row by row*/
+    uint16_t codec : 2;     /*lv_tile_anim_codec_t*/
+} lv_tile_anim_tile_t;
+
+typedef struct {
+    uint16_t delay_ms;      /*How long the frame is shown*/
+    uint16_t tile_cnt;      /*Number of tiles changed by the frame*/
+    uint32_t tile_first;    /*First tile of the frame in `tiles`*/
+} lv_tile_anim_frame_t;
+
+typedef struct {
+    uint16_t w;
+    uint16_t h;
+    uint8_t tile_w;
+    uint8_t tile_h;
+    uint16_t frame_cnt;     /*`frames` has one more entry, it takes the last frame back to the first*/
+    uint16_t loop_cnt;      /*0: loop forever*/
+    uint16_t palette_cnt;
+    const uint16_t * palette;       /*RGB565 colors*/
+    const uint8_t * palette_alpha;  /*Opacity of the colors or NULL if all are opaque*/
+    const lv_tile_anim_frame_t * frames;
+    const lv_tile_anim_tile_t * tiles;
+    const uint8_t * data;
+} lv_tile_anim_dsc_t;
+
+typedef struct {
+    lv_image_t img;
+    const lv_tile_anim_dsc_t * dsc;
+    lv_image_dsc_t imgdsc;
+    uint8_t * index_map;    /*Palette indices of the shown frame*/
+    uint8_t * tile_buf;     /*The indices of a tile before and after decoding*/
+    lv_timer_t * timer;
+    uint32_t last_call;
+    uint16_t frame_act;
+    uint16_t loop_act;
+} lv_tile_anim_t;
+
+LV_ATTRIBUTE_EXTERN_DATA extern const lv_obj_class_t lv_tile_anim_class;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**
+ * Create a tile animation object
+ * @param parent    pointer to an object, it will be the parent of the new tile animation.
+ * @return          pointer to the tile animation obj
+ */
+lv_obj_t * lv_tile_anim_create(lv_obj_t * parent);
+
+/**
+ * Set the animation to play on the object, it starts from its first frame
+ * @param obj       pointer to a tile animation object
+ * @param dsc       pointer to an animation written by tools/img_anim_conv.py
+ */
+void lv_tile_anim_set_src(lv_obj_t * obj, const lv_tile_anim_dsc_t * dsc);
+
+/**
+ * Restart a tile animation.
+ * @param obj pointer to a tile animation obj
+ */
+void lv_tile_anim_restart(lv_obj_t * obj);
+
+/**
+ * Pause a tile animation.
+ * @param obj pointer to a tile animation obj
+ */
+void lv_tile_anim_pause(lv_obj_t * obj);
+
+/**
+ * Resume a tile animation.
+ * @param obj pointer to a tile animation obj
+ */
+void lv_tile_anim_resume(lv_obj_t * obj);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#endif /*LV_USE_TILE_ANIM*/
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /*LV_TILE_ANIM_H*/
@@ -16,6 +16,7 @@
 #include "tkl_memory.h"
 #include "tal_api.h"
 #include "tdl_display_manage.h"
+#include "tdl_display_convert.h"
 /*********************
  *      DEFINES
  *********************/
@@ -56,6 +57,9 @@ static TDL_DISP_HANDLE_T sg_tdl_disp_hdl = NULL;
 static TDL_DISP_DEV_INFO_T sg_display_info;
 static TDL_DISP_FRAME_BUFF_T *sg_p_display_fb = NULL;
 static uint8_t *sg_rotate_buf = NULL;
+static TDL_DISP_RECT_T sg_dirty_rects[TDL_DISP_RECT_MAX];
+static uint8_t sg_dirty_num = 0;
+static bool sg_dirty_overflow = false;
 /**********************
  *      MACROS
  **********************/
@@ -230,86 +234,58 @@ static uint8_t __disp_get_pixels_size_bytes(TUYA_DISPLAY_PIXEL_FMT_E pixel_fmt)
     }
 }
 
-static void __disp_mono_write_point(uint32_t x, uint32_t y, bool enable, TDL_DISP_FRAME_BUFF_T *fb)
-{
-    if(NULL == fb || x >= fb->width || y >= fb->height) {
-        PR_ERR("Point (%d, %d) out of bounds", x, y);
-        return;
-    }
-
-    uint32_t write_byte_index = y * (fb->width/8) + x/8;
-    uint8_t write_bit = x%8;
-
-    if (enable) {
-        fb->frame[write_byte_index] |= (1 << write_bit);
-    } else {
-        fb->frame[write_byte_index] &= ~(1 << write_bit);
-    }
-}
-
-static void __disp_i2_write_point(uint32_t x, uint32_t y, uint8_t color, TDL_DISP_FRAME_BUFF_T *fb)
-{
-    if(NULL == fb || x >= fb->width || y >= fb->height) {
-        PR_ERR("Point (%d, %d) out of bounds", x, y);
-        return;
-    }
-
-    uint32_t write_byte_index = y * (fb->width/4) + x/4;
-    uint8_t write_bit = (x%4)*2;
-    uint8_t cleared = fb->frame[write_byte_index] & (~(0x03 << write_bit)); // Clear the bits we are going to write
-
-    fb->frame[write_byte_index] = cleared | ((color & 0x03) << write_bit);
-}
-
 static void __disp_fill_display_framebuffer(const lv_area_t * area, uint8_t * px_map, \
                                             lv_color_format_t cf, TDL_DISP_FRAME_BUFF_T *fb)
 {
-    uint32_t offset = 0, x = 0, y = 0;
+    uint32_t offset = 0, y = 0, stride = 0;
     uint8_t *disp_buf = NULL;
-    int32_t width = 0;
+    int32_t width = 0, copy_width = 0;
 
     if(NULL == area || NULL == px_map || NULL == fb) {
         PR_ERR("Invalid parameters: area or px_map or fb is NULL");
         return;
     }
 
+    if(area->x1 < 0 || area->y1 < 0 || area->x1 >= fb->width) {
+        PR_ERR("Area (%d, %d) out of bounds", area->x1, area->y1);
+        return;
+    }
+
     width = lv_area_get_width(area);
+    copy_width = LV_MIN(width, fb->width - area->x1);
 
     disp_buf = fb->frame;
-    
+
+    /*Each row is converted and written in one pass by the kernels of the display layer*/
     if(fb->fmt == TUYA_PIXEL_FMT_MONOCHROME) {
-        for(y = area->y1 ; y <= area->y2; y++) {
-            for(x = area->x1; x <= area->x2; x++) {
-                uint16_t *px_map_u16 = (uint16_t *)px_map;
-                bool enable = (px_map_u16[offset++]> 0x8FFF) ? false : true;
-                __disp_mono_write_point(x, y, enable, fb);
-            }
+        stride = TDL_DISP_MONO_STRIDE(fb->width);
+        for(y = area->y1; y <= area->y2 && y < fb->height; y++) {
+            tdl_disp_convert_mono_row((uint16_t *)px_map, disp_buf + y * stride, area->x1, copy_width);
+            px_map += width * sizeof(uint16_t);
         }
-    }else if(fb->fmt == TUYA_PIXEL_FMT_I2) { 
-        for(y = area->y1 ; y <= area->y2; y++) {
-            for(x = area->x1; x <= area->x2; x++) {
-                lv_color16_t *px_map_color16 = (lv_color16_t *)px_map;
-                uint8_t grey2 = ~((px_map_color16[offset].red + px_map_color16[offset].green*2 +\
-                                 px_map_color16[offset].blue) >> 2);
-                offset++;
-                __disp_i2_write_point(x, y, grey2, fb);
-            }
+    }else if(fb->fmt == TUYA_PIXEL_FMT_I2) {
+        stride = TDL_DISP_I2_STRIDE(fb->width);
+        for(y = area->y1; y <= area->y2 && y < fb->height; y++) {
+            tdl_disp_convert_i2_row((uint16_t *)px_map, disp_buf + y * stride, area->x1, y, copy_width);
+            px_map += width * sizeof(uint16_t);
         }
     }else {
-        if(LV_COLOR_FORMAT_RGB565 == cf) {
-            #if defined(LVGL_COLOR_16_SWAP) && (LVGL_COLOR_16_SWAP == 1)
-            lv_draw_sw_rgb565_swap(px_map, lv_area_get_width(area) * lv_area_get_height(area));
-            #endif
-        }
-
-        uint8_t *color_ptr = px_map;
         uint8_t per_pixel_byte = __disp_get_pixels_size_bytes(fb->fmt);
+        bool swap = false;
+
+        #if defined(LVGL_COLOR_16_SWAP) && (LVGL_COLOR_16_SWAP == 1)
+        swap = (LV_COLOR_FORMAT_RGB565 == cf);
+        #endif
 
         offset = (area->y1 * fb->width + area->x1) * per_pixel_byte;
         for (y = area->y1; y <= area->y2 && y < fb->height; y++) {
-            memcpy(disp_buf + offset, color_ptr, width * per_pixel_byte);
+            if(swap) {
+                tdl_disp_convert_swap_row((uint16_t *)px_map, (uint16_t *)(disp_buf + offset), copy_width);
+            }else {
+                memcpy(disp_buf + offset, px_map, copy_width * per_pixel_byte);
+            }
             offset += fb->width * per_pixel_byte; // Move to the next line in the display buffer
-            color_ptr += width * per_pixel_byte;
+            px_map += width * per_pixel_byte;
         }
     }
 }
@@ -376,13 +352,34 @@ static void disp_flush(lv_display_t * disp, const lv_area_t * area, uint8_t * px
             target_area = &rotated_area;
         }
 
+        /*The panel may still be reading the frame buffer, the draw buffers were rendered meanwhile*/
+        tdl_disp_dev_flush_wait(sg_tdl_disp_hdl, SEM_WAIT_FOREVER);
+
         __disp_fill_display_framebuffer(target_area, color_ptr, cf, sg_p_display_fb);
 
+        /*Only the areas rendered for this refresh are sent to the panel*/
+        if (sg_dirty_num < TDL_DISP_RECT_MAX) {
+            sg_dirty_rects[sg_dirty_num].x1 = target_area->x1;
+            sg_dirty_rects[sg_dirty_num].y1 = target_area->y1;
+            sg_dirty_rects[sg_dirty_num].x2 = target_area->x2;
+            sg_dirty_rects[sg_dirty_num].y2 = target_area->y2;
+            sg_dirty_num++;
+        } else {
+            sg_dirty_overflow = true;
+        }
+
         if (lv_disp_flush_is_last(disp)) {
-            tdl_disp_dev_flush(sg_tdl_disp_hdl, sg_p_display_fb);
+            if (sg_dirty_overflow) {
+                tdl_disp_dev_flush(sg_tdl_disp_hdl, sg_p_display_fb);
+            } else {
+                tdl_disp_dev_flush_rects(sg_tdl_disp_hdl, sg_p_display_fb, sg_dirty_rects, sg_dirty_num);
+            }
+            sg_dirty_num = 0;
+            sg_dirty_overflow = false;
         }
     }
 
+    /*px_map is in the frame buffer now, LVGL renders into it again while the panel is sent*/
     lv_disp_flush_ready(disp);
 }
 
@@ -0,0 +1,202 @@
+/**
+ * @file lv_port_os.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lvgl.h"
+
+#if LV_USE_OS == LV_OS_CUSTOM
+
+#include "tal_system.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void thread_entry(void * arg);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static const uint8_t prio_map[] = {
+    [LV_THREAD_PRIO_LOWEST] = THREAD_PRIO_4,
+    [LV_THREAD_PRIO_LOW] = THREAD_PRIO_3,
+    [LV_THREAD_PRIO_MID] = THREAD_PRIO_2,
+    [LV_THREAD_PRIO_HIGH] = THREAD_PRIO_1,
+    [LV_THREAD_PRIO_HIGHEST] = THREAD_PRIO_0,
+};
+
+static uint32_t thread_cnt = 0;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+lv_result_t lv_thread_init(lv_thread_t * thread, lv_thread_prio_t prio, void (*callback)(void *), size_t stack_size,
+                           void * user_data)
+{
+    char name[16];
+    THREAD_CFG_T cfg = {0};
+
+    /*The name is copied by the thread layer*/
+    lv_snprintf(name, sizeof(name), "lvgl_draw_%d", (int)thread_cnt++);
+
+    cfg.stackDepth = stack_size;
+    cfg.priority = prio_map[prio];
+    cfg.thrdname = name;
+
+    thread->callback = callback;
+    thread->user_data = user_data;
+    if(OPRT_OK != tal_semaphore_create_init(&thread->exited, 0, 1)) {
+        LV_LOG_ERROR("semaphore create failed");
+        return LV_RESULT_INVALID;
+    }
+
+    if(OPRT_OK != tal_thread_create_and_start(&thread->handle, NULL, NULL, thread_entry, thread, &cfg)) {
+        LV_LOG_ERROR("thread create failed");
+        tal_semaphore_release(thread->exited);
+        thread->exited = NULL;
+        return LV_RESULT_INVALID;
+    }
+
+    return LV_RESULT_OK;
+}
+
+lv_result_t lv_thread_delete(lv_thread_t * thread)
+{
+    if(thread->handle == NULL) return LV_RESULT_INVALID;
+
+    /*Join: the caller frees what the thread uses once this returns*/
+    if(OPRT_OK != tal_semaphore_wait(thread->exited, SEM_WAIT_FOREVER)) {
+        LV_LOG_WARN("thread join failed");
+        return LV_RESULT_INVALID;
+    }
+
+    /*TAL refuses to delete a thread that is not marked running yet*/
+    while(OPRT_COM_ERROR == tal_thread_delete(thread->handle)) {
+        tal_system_sleep(10);
+    }
+
+    tal_semaphore_release(thread->exited);
+    thread->exited = NULL;
+    thread->handle = NULL;
+
+    return LV_RESULT_OK;
+}
+
+lv_result_t lv_mutex_init(lv_mutex_t * mutex)
+{
+    if(OPRT_OK != tal_mutex_create_init(mutex)) {
+        LV_LOG_ERROR("mutex create failed");
+        return LV_RESULT_INVALID;
+    }
+
+    return LV_RESULT_OK;
+}
+
+lv_result_t lv_mutex_lock(lv_mutex_t * mutex)
+{
+    if(OPRT_OK != tal_mutex_lock(*mutex)) {
+        LV_LOG_WARN("mutex lock failed");
+        return LV_RESULT_INVALID;
+    }
+
+    return LV_RESULT_OK;
+}
+
+lv_result_t lv_mutex_lock_isr(lv_mutex_t * mutex)
+{
+    /*TAL has no lock from interrupt, LVGL only takes the mutex from threads*/
+    return lv_mutex_lock(mutex);
+}
+
+lv_result_t lv_mutex_unlock(lv_mutex_t * mutex)
+{
+    if(OPRT_OK != tal_mutex_unlock(*mutex)) {
+        LV_LOG_WARN("mutex unlock failed");
+        return LV_RESULT_INVALID;
+    }
+
+    return LV_RESULT_OK;
+}
+
+lv_result_t lv_mutex_delete(lv_mutex_t * mutex)
+{
+    /*lv_deinit calls lv_draw_sw_deinit twice, the second time finds the mutex deleted*/
+    if(*mutex == NULL) return LV_RESULT_OK;
+
+    tal_mutex_release(*mutex);
+    *mutex = NULL;
+
+    return LV_RESULT_OK;
+}
+
+lv_result_t lv_thread_sync_init(lv_thread_sync_t * sync)
+{
+    if(OPRT_OK != tal_semaphore_create_init(sync, 0, 1)) {
+        LV_LOG_ERROR("semaphore create failed");
+        return LV_RESULT_INVALID;
+    }
+
+    return LV_RESULT_OK;
+}
+
+lv_result_t lv_thread_sync_wait(lv_thread_sync_t * sync)
+{
+    if(OPRT_OK != tal_semaphore_wait(*sync, SEM_WAIT_FOREVER)) {
+        LV_LOG_WARN("semaphore wait failed");
+        return LV_RESULT_INVALID;
+    }
+
+    return LV_RESULT_OK;
+}
+
+lv_result_t lv_thread_sync_signal(lv_thread_sync_t * sync)
+{
+    if(OPRT_OK != tal_semaphore_post(*sync)) {
+        LV_LOG_WARN("semaphore post failed");
+        return LV_RESULT_INVALID;
+    }
+
+    return LV_RESULT_OK;
+}
+
+lv_result_t lv_thread_sync_delete(lv_thread_sync_t * sync)
+{
+    if(*sync == NULL) return LV_RESULT_OK;
+
+    tal_semaphore_release(*sync);
+    *sync = NULL;
+
+    return LV_RESULT_OK;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static void thread_entry(void * arg)
+{
+    lv_thread_t * thread = arg;
+
+    thread->callback(thread->user_data);
+
+    /*The last access, the thread can be freed right after*/
+    tal_semaphore_post(thread->exited);
+}
+
+#endif /*LV_USE_OS == LV_OS_CUSTOM*/
@@ -0,0 +1,55 @@
+/**
+ * @file lv_port_os.h
+ *
+ * OS abstraction of LVGL on the TAL threads, mutexes and semaphores. It is
+ * included by lv_os.h through LV_OS_CUSTOM_INCLUDE when LV_USE_OS is
+ * LV_OS_CUSTOM.
+ */
+
+#ifndef LV_PORT_OS_H
+#define LV_PORT_OS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "tuya_cloud_types.h"
+#include "tal_thread.h"
+#include "tal_mutex.h"
+#include "tal_semaphore.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct {
+    THREAD_HANDLE handle;
+    SEM_HANDLE exited;          /*Posted when the callback returned, lv_thread_delete waits for it like a join*/
+    void (*callback)(void *);
+    void * user_data;
+} lv_thread_t;
+
+typedef MUTEX_HANDLE lv_mutex_t;
+
+/*A binary semaphore, a signal sent before the wait is kept like the flag of the pthread port*/
+typedef SEM_HANDLE lv_thread_sync_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**********************
+ *      MACROS
+ **********************/
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*LV_PORT_OS_H*/
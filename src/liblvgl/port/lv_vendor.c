@@ -14,6 +14,8 @@
 static TKL_THREAD_HANDLE g_disp_thread_handle = NULL;
 static TKL_MUTEX_HANDLE g_disp_mutex = NULL;
 static TKL_SEM_HANDLE lvgl_sem = NULL;
+static TKL_SEM_HANDLE lvgl_wake_sem = NULL;
+static volatile bool lvgl_in_handler = false;
 static uint8_t lvgl_task_state = STATE_INIT;
 static bool lv_vendor_initialized = false;
 
@@ -32,6 +34,25 @@ void lv_vendor_disp_unlock(void)
     tkl_mutex_unlock(g_disp_mutex);
 }
 
+void lv_vendor_wakeup(void)
+{
+    if (lvgl_wake_sem) {
+        tkl_semaphore_post(lvgl_wake_sem);
+    }
+}
+
+/* called by LVGL when a timer gets ready, e.g. on an invalidation or a new animation */
+static void lv_timer_resume_callback(void *data)
+{
+    LV_UNUSED(data);
+
+    /* the task loop computes its next wait after the handler, only changes
+     * made by other threads under the disp lock need to wake it */
+    if (!lvgl_in_handler) {
+        lv_vendor_wakeup();
+    }
+}
+
 void lv_vendor_init(void *device)
 {
     if (lv_vendor_initialized) {
@@ -57,6 +78,13 @@ void lv_vendor_init(void *device)
         return;
     }
 
+    if (OPRT_OK != tkl_semaphore_create_init(&lvgl_wake_sem, 0, 1)) {
+        LV_LOG_ERROR("%s wake semaphore init failed\n", __func__);
+        return;
+    }
+
+    lv_timer_handler_set_resume_cb(lv_timer_resume_callback, NULL);
+
     lv_vendor_initialized = true;
 
     LV_LOG_INFO("%s complete\n", __func__);
@@ -72,7 +100,9 @@ static void lv_tast_entry(void *arg)
 
     while(lvgl_task_state == STATE_RUNNING) {
         lv_vendor_disp_lock();
+        lvgl_in_handler = true;
         sleep_time = lv_task_handler();
+        lvgl_in_handler = false;
         lv_vendor_disp_unlock();
 
         #if CONFIG_LVGL_TASK_SLEEP_TIME_CUSTOMIZE
@@ -85,8 +115,8 @@ static void lv_tast_entry(void *arg)
             }
         #endif
 
-        tkl_system_sleep(sleep_time);
-
+        /* sleep until the next timer is due or until something needs a redraw */
+        tkl_semaphore_wait(lvgl_wake_sem, sleep_time);
     }
 
     tkl_semaphore_post(lvgl_sem);
@@ -120,6 +150,7 @@ void lv_vendor_stop(void)
     }
 
     lvgl_task_state = STATE_STOP;
+    lv_vendor_wakeup();
 
     tkl_semaphore_wait(lvgl_sem, TKL_SEM_WAIT_FOREVER);
 
@@ -22,6 +22,8 @@ void lv_vendor_start(void);
 void lv_vendor_stop(void);
 void lv_vendor_disp_lock(void);
 void lv_vendor_disp_unlock(void);
+/* wake the LVGL task before its next timer is due, e.g. from an input driver */
+void lv_vendor_wakeup(void);
 int lv_vendor_display_frame_cnt(void);
 int lv_vendor_draw_buffer_cnt(void);
 
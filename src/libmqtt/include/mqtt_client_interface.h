@@ -73,10 +73,29 @@ mqtt_client_status_t mqtt_client_disconnect(void *client);
 
 mqtt_client_status_t mqtt_client_yield(void *client);
 
+/* Event driven use: wait on mqtt_client_socket until it is readable, then let
+ * mqtt_client_process handle what arrived. mqtt_client_read_pending reports
+ * data already buffered by the TLS layer, mqtt_client_keepalive_remain the
+ * time before the keep alive needs mqtt_client_process. */
+int mqtt_client_socket(void *client);
+
+bool mqtt_client_read_pending(void *client);
+
+uint32_t mqtt_client_keepalive_remain(void *client);
+
+mqtt_client_status_t mqtt_client_process(void *client);
+
 uint16_t mqtt_client_subscribe(void *client, const char *topic, uint8_t qos);
 
 uint16_t mqtt_client_unsubscribe(void *client, const char *topic, uint8_t qos);
 
 uint16_t mqtt_client_publish(void *client, const char *topic, const uint8_t *payload, size_t length, uint8_t qos);
 
+/* With ENABLE_MQTT_WRITE_COALESCE the packets sent while connected wait in a
+ * buffer. mqtt_client_process sends it once mqtt_client_flush_remain reaches
+ * 0, mqtt_client_flush sends it at once. UINT32_MAX means nothing waits. */
+mqtt_client_status_t mqtt_client_flush(void *client);
+
+uint32_t mqtt_client_flush_remain(void *client);
+
 #endif /* ifndef MQTT_CLIENT_INTERFACE_H */
@@ -13,11 +13,28 @@
 #define log_debug PR_DEBUG
 #define log_error PR_ERR
 
+/* wait for the first byte of a packet in mqtt_client_process, the socket
+ * was readable so a packet is either there or nothing is */
+#define MQTT_CLIENT_PROCESS_WAIT_MS 1
+
+#if defined(ENABLE_MQTT_WRITE_COALESCE) && (ENABLE_MQTT_WRITE_COALESCE == 1)
+#define MQTT_CLIENT_WRITE_COALESCE 1
+#include "tal_mutex.h"
+#endif
+
 typedef struct {
     mqtt_client_config_t config;
     MQTTContext_t mqclient;
     tuya_transporter_t network;
+    bool processing;     // in mqtt_client_process
+    bool in_fixed_header; // type byte read, remaining length bytes follow
     uint8_t mqttbuffer[CORE_MQTT_BUFFER_SIZE];
+#ifdef MQTT_CLIENT_WRITE_COALESCE
+    MUTEX_HANDLE wmutex;
+    uint32_t wfirst_ms; // time the oldest packet of wbuf was written
+    size_t wlen;
+    uint8_t wbuf[MQTT_WRITE_COALESCE_SIZE];
+#endif
 } mqtt_client_context_t;
 
 static void core_mqtt_library_callback(struct MQTTContext *pContext, struct MQTTPacketInfo *pPacketInfo,
@@ -91,16 +108,75 @@ void mqtt_client_free(void *client)
     tal_free(client);
 }
 
+static int network_write_all(tuya_transporter_t transporter, const uint8_t *buf, size_t len)
+{
+    size_t sent = 0;
+
+    while (sent < len) {
+        int ret = tuya_transporter_write(transporter, (uint8_t *)buf + sent, len - sent, 0);
+        if (ret <= 0) {
+            return -1;
+        }
+        sent += ret;
+    }
+    return (int)sent;
+}
+
+static uint32_t __mqtt_client_get_current_time(void);
+
+#ifdef MQTT_CLIENT_WRITE_COALESCE
+/* caller holds wmutex */
+static int network_flush_locked(mqtt_client_context_t *context)
+{
+    int ret = 0;
+
+    if (context->wlen) {
+        ret = network_write_all(context->network, context->wbuf, context->wlen);
+        context->wlen = 0;
+    }
+    return ret < 0 ? -1 : 0;
+}
+#endif
+
 static int network_write(NetworkContext_t *pNetwork, const unsigned char *pMsg, size_t len)
 {
     tuya_transporter_t transporter = *pNetwork;
 
-    return tuya_transporter_write(transporter, (uint8_t *)pMsg, len, 0);
+#ifdef MQTT_CLIENT_WRITE_COALESCE
+    mqtt_client_context_t *context =
+        (mqtt_client_context_t *)((uint8_t *)pNetwork - offsetof(mqtt_client_context_t, network));
+
+    /* CONNECT goes out alone, the core waits for the CONNACK right after it.
+     * Once connected every packet, the header and the payload of a PUBLISH
+     * alike, is appended to wbuf and leaves in the next flush. */
+    if (context->mqclient.connectStatus == MQTTConnected && context->wmutex) {
+        int ret = (int)len;
+
+        tal_mutex_lock(context->wmutex);
+        if (context->wlen + len > sizeof(context->wbuf) && network_flush_locked(context) < 0) {
+            ret = -1;
+        } else if (len > sizeof(context->wbuf)) {
+            ret = network_write_all(transporter, pMsg, len);
+        } else {
+            if (0 == context->wlen) {
+                context->wfirst_ms = __mqtt_client_get_current_time();
+            }
+            memcpy(context->wbuf + context->wlen, pMsg, len);
+            context->wlen += len;
+        }
+        tal_mutex_unlock(context->wmutex);
+        return ret;
+    }
+#endif
+
+    return network_write_all(transporter, pMsg, len);
 }
 
 static int network_read(NetworkContext_t *pNetwork, unsigned char *pMsg, size_t len)
 {
     tuya_transporter_t transporter = *pNetwork;
+    mqtt_client_context_t *context =
+        (mqtt_client_context_t *)((uint8_t *)pNetwork - offsetof(mqtt_client_context_t, network));
 
     tuya_tls_config_t *tls_config = NULL;
 
@@ -108,8 +184,30 @@ static int network_read(NetworkContext_t *pNetwork, unsigned char *pMsg, size_t
 
     int timeout = tls_config ? tls_config->timeout : 5000;
 
+    /* The fixed header is read byte by byte into the stack of the core, the
+     * rest of the packet into mqttbuffer. Only the type byte may find nothing. */
+    bool header = (pMsg < context->mqttbuffer) || (pMsg >= context->mqttbuffer + CORE_MQTT_BUFFER_SIZE);
+    if (header && !context->in_fixed_header && context->processing) {
+        timeout = MQTT_CLIENT_PROCESS_WAIT_MS;
+    }
+
     int result = tuya_transporter_read(transporter, (uint8_t *)pMsg, len, timeout);
 
+    /* The core gives up on a packet body as soon as its own time budget is
+     * spent, complete partial reads here */
+    while (!header && result > 0 && (size_t)result < len) {
+        int more = tuya_transporter_read(transporter, (uint8_t *)pMsg + result, len - result, timeout);
+        if (more <= 0) {
+            break;
+        }
+        result += more;
+    }
+
+    if (header && result == 1) {
+        // remaining length bytes continue while their top bit is set
+        context->in_fixed_header = context->in_fixed_header ? ((pMsg[0] & 0x80) != 0) : true;
+    }
+
     if (result == OPRT_RESOURCE_NOT_READY) {
         return 0;
     }
@@ -177,6 +275,14 @@ mqtt_client_status_t mqtt_client_init(void *client, const mqtt_client_config_t *
         return OPRT_COM_ERROR;
     }
 
+#ifdef MQTT_CLIENT_WRITE_COALESCE
+    /* without the mutex the packets are written one by one */
+    if (OPRT_OK != tal_mutex_create_init(&context->wmutex)) {
+        log_error("mqtt write mutex create fail");
+        context->wmutex = NULL;
+    }
+#endif
+
     return MQTT_STATUS_SUCCESS;
 }
 
@@ -186,6 +292,12 @@ mqtt_client_status_t mqtt_client_deinit(void *client)
 
     tuya_transporter_close(context->network);
     tuya_transporter_destroy(context->network);
+#ifdef MQTT_CLIENT_WRITE_COALESCE
+    if (context->wmutex) {
+        tal_mutex_release(context->wmutex);
+        context->wmutex = NULL;
+    }
+#endif
     return MQTT_STATUS_SUCCESS;
 }
 
@@ -194,6 +306,10 @@ mqtt_client_status_t mqtt_client_connect(void *client)
     mqtt_client_context_t *context = (mqtt_client_context_t *)client;
     MQTTStatus_t mqtt_status;
 
+    context->in_fixed_header = false;
+#ifdef MQTT_CLIENT_WRITE_COALESCE
+    context->wlen = 0; // left by a broken connection
+#endif
     int ret = tuya_transporter_connect(context->network, context->config.host, context->config.port,
                                        context->config.timeout_ms);
     if (OPRT_OK != ret) {
@@ -239,6 +355,7 @@ mqtt_client_status_t mqtt_client_disconnect(void *client)
     if (MQTTSuccess != mqtt_status) {
         log_error("mqtt disconnect err: %s(%d)", MQTT_Status_strerror(mqtt_status), mqtt_status);
     }
+    mqtt_client_flush(context);
 
     tuya_transporter_close(context->network);
 
@@ -264,6 +381,7 @@ uint16_t mqtt_client_subscribe(void *client, const char *topic, uint8_t qos)
         log_error("Failed to send SUBSCRIBE packet to broker with error = %s.", MQTT_Status_strerror(mqtt_status));
         return 0;
     }
+    mqtt_client_flush(context);
 
     return msgid;
 }
@@ -283,6 +401,7 @@ uint16_t mqtt_client_unsubscribe(void *client, const char *topic, uint8_t qos)
         log_error("Failed to send SUBSCRIBE packet to broker with error = %s.", MQTT_Status_strerror(mqtt_status));
         return 0;
     }
+    mqtt_client_flush(context);
 
     return msgid;
 }
@@ -316,8 +435,121 @@ mqtt_client_status_t mqtt_client_yield(void *client)
     mqtt_status = MQTT_ProcessLoop(&context->mqclient, context->config.timeout_ms);
     if (mqtt_status != MQTTSuccess) {
         log_error("MQTT_ProcessLoop returned with status = %s.", MQTT_Status_strerror(mqtt_status));
+        context->in_fixed_header = false;
+        mqtt_client_disconnect(context);
+        return MQTT_STATUS_NETWORK_TIMEOUT;
+    }
+    return MQTT_STATUS_SUCCESS;
+}
+
+int mqtt_client_socket(void *client)
+{
+    mqtt_client_context_t *context = (mqtt_client_context_t *)client;
+    int fd = -1;
+
+    if (OPRT_OK != tuya_transporter_ctrl(context->network, TUYA_TRANSPORTER_GET_TCP_SOCKET, &fd)) {
+        return -1;
+    }
+    return fd;
+}
+
+bool mqtt_client_read_pending(void *client)
+{
+    mqtt_client_context_t *context = (mqtt_client_context_t *)client;
+    int pending = 0;
+
+    tuya_transporter_ctrl(context->network, TUYA_TRANSPORTER_GET_READ_PENDING, &pending);
+    return pending > 0;
+}
+
+uint32_t mqtt_client_keepalive_remain(void *client)
+{
+    mqtt_client_context_t *context = (mqtt_client_context_t *)client;
+    MQTTContext_t *mqclient = &context->mqclient;
+    uint32_t now = __mqtt_client_get_current_time();
+    uint32_t keepalive_ms = 1000U * mqclient->keepAliveIntervalSec;
+    uint32_t elapsed, limit;
+
+    if (0 == keepalive_ms) {
+        return UINT32_MAX;
+    }
+
+    /* the core pings once keepalive_ms passed since the last packet, then
+     * fails if the PINGRESP is MQTT_PINGRESP_TIMEOUT_MS late */
+    if (mqclient->waitingForPingResp) {
+        elapsed = now - mqclient->pingReqSendTimeMs;
+        limit = MQTT_PINGRESP_TIMEOUT_MS;
+    } else {
+        elapsed = now - mqclient->lastPacketTime;
+        limit = keepalive_ms;
+    }
+    return (elapsed > limit) ? 0 : (limit - elapsed + 1);
+}
+
+mqtt_client_status_t mqtt_client_process(void *client)
+{
+    mqtt_client_context_t *context = (mqtt_client_context_t *)client;
+    MQTTStatus_t mqtt_status;
+
+    /* One run handles the packets that are there and the keep alive, it ends
+     * at the first type byte that does not come within
+     * MQTT_CLIENT_PROCESS_WAIT_MS. Records left in the TLS layer need more. */
+    context->processing = true;
+    do {
+        mqtt_status = MQTT_ProcessLoop(&context->mqclient, 0);
+    } while (mqtt_status == MQTTSuccess && mqtt_client_read_pending(client));
+    context->processing = false;
+
+    /* the acks of what arrived join the batch, it leaves once it is due */
+    if (mqtt_status == MQTTSuccess && 0 == mqtt_client_flush_remain(client) &&
+        MQTT_STATUS_SUCCESS != mqtt_client_flush(client)) {
+        mqtt_status = MQTTSendFailed;
+    }
+
+    if (mqtt_status != MQTTSuccess) {
+        log_error("MQTT_ProcessLoop returned with status = %s.", MQTT_Status_strerror(mqtt_status));
+        context->in_fixed_header = false;
         mqtt_client_disconnect(context);
         return MQTT_STATUS_NETWORK_TIMEOUT;
     }
     return MQTT_STATUS_SUCCESS;
-}
\ No newline at end of file
+}
+
+mqtt_client_status_t mqtt_client_flush(void *client)
+{
+#ifdef MQTT_CLIENT_WRITE_COALESCE
+    mqtt_client_context_t *context = (mqtt_client_context_t *)client;
+    int ret = 0;
+
+    if (context->wmutex) {
+        tal_mutex_lock(context->wmutex);
+        ret = network_flush_locked(context);
+        tal_mutex_unlock(context->wmutex);
+    }
+    if (ret < 0) {
+        return MQTT_STATUS_NETWORK_TIMEOUT;
+    }
+#endif
+    return MQTT_STATUS_SUCCESS;
+}
+
+uint32_t mqtt_client_flush_remain(void *client)
+{
+#ifdef MQTT_CLIENT_WRITE_COALESCE
+    mqtt_client_context_t *context = (mqtt_client_context_t *)client;
+    uint32_t remain = UINT32_MAX;
+
+    if (NULL == context->wmutex) {
+        return remain;
+    }
+    tal_mutex_lock(context->wmutex);
+    if (context->wlen) {
+        uint32_t elapsed = __mqtt_client_get_current_time() - context->wfirst_ms;
+        remain = (elapsed >= MQTT_WRITE_COALESCE_MS) ? 0 : (MQTT_WRITE_COALESCE_MS - elapsed);
+    }
+    tal_mutex_unlock(context->wmutex);
+    return remain;
+#else
+    return UINT32_MAX;
+#endif
+}
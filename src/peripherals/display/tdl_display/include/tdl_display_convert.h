@@ -0,0 +1,79 @@
+/**
+ * @file tdl_display_convert.h
+ * @brief TDL display pixel format conversion header file
+ *
+ * This file declares the row kernels that convert RGB565 pixels into the frame
+ * buffer formats of the panels: 1 bit per pixel for monochrome panels, 2 bits
+ * per pixel for I2 panels and byte swapped RGB565 for panels that take the high
+ * byte first. Each kernel converts and writes a run of pixels in one pass.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#ifndef __TDL_DISPLAY_CONVERT_H__
+#define __TDL_DISPLAY_CONVERT_H__
+
+#include "tuya_cloud_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***********************************************************
+************************macro define************************
+***********************************************************/
+#define TDL_DISP_MONO_STRIDE(width) (((width) + 7) / 8) // bytes of a monochrome row
+#define TDL_DISP_I2_STRIDE(width)   (((width) + 3) / 4) // bytes of an I2 row
+
+/***********************************************************
+********************function declaration********************
+***********************************************************/
+/**
+ * @brief Converts a run of RGB565 pixels into a monochrome row.
+ *
+ * A pixel up to 0x8FFF sets its bit and a brighter one clears it, bit x % 8 of
+ * byte x / 8 holds pixel x. The bits of the row outside the run are kept.
+ *
+ * @param src RGB565 pixels of the run.
+ * @param dst_row First byte of the row in the frame buffer.
+ * @param x Column of the first pixel of the run.
+ * @param num Number of pixels.
+ *
+ * @return None.
+ */
+void tdl_disp_convert_mono_row(const uint16_t *src, uint8_t *dst_row, uint32_t x, uint32_t num);
+
+/**
+ * @brief Converts a run of RGB565 pixels into an I2 row.
+ *
+ * The luminance of each pixel is dithered to 4 grey levels with a 2x2 ordered
+ * matrix, 0 for white and 3 for black. Bits 2 * (x % 4) of byte x / 4 hold
+ * pixel x. The pixels of the row outside the run are kept.
+ *
+ * @param src RGB565 pixels of the run.
+ * @param dst_row First byte of the row in the frame buffer.
+ * @param x Column of the first pixel of the run.
+ * @param y Row of the run, it selects the line of the dither matrix.
+ * @param num Number of pixels.
+ *
+ * @return None.
+ */
+void tdl_disp_convert_i2_row(const uint16_t *src, uint8_t *dst_row, uint32_t x, uint32_t y, uint32_t num);
+
+/**
+ * @brief Copies a run of RGB565 pixels and swaps the bytes of each.
+ *
+ * @param src RGB565 pixels of the run.
+ * @param dst Destination of the swapped pixels, it must not overlap src.
+ * @param num Number of pixels.
+ *
+ * @return None.
+ */
+void tdl_disp_convert_swap_row(const uint16_t *src, uint16_t *dst, uint32_t num);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TDL_DISPLAY_CONVERT_H__ */
@@ -65,6 +65,8 @@ typedef struct {
     TUYA_DISPLAY_ROTATION_E rotation;
     TUYA_DISPLAY_BL_CTRL_T bl;
     TUYA_DISPLAY_IO_CTRL_T power;
+    uint16_t rect_x_align; // dirty rects start and end on multiples of it, only read with flush_rects
+    uint16_t rect_y_align;
 } TDD_DISP_DEV_INFO_T;
 
 #if defined(ENABLE_RGB) && (ENABLE_RGB==1)
@@ -90,6 +92,7 @@ typedef struct {
     uint8_t cmd_caset;
     uint8_t cmd_raset;
     uint8_t cmd_ramwr;
+    uint8_t rect_align; // window alignment of the controller in pixels, 0 for none
 } DISP_SPI_BASE_CFG_T;
 
 typedef void (*TDD_DISP_SPI_SET_WINDOW_CB)(DISP_SPI_BASE_CFG_T *p_cfg, uint16_t x_start, uint16_t y_start,\
@@ -118,6 +121,7 @@ typedef struct {
     uint8_t                     cmd_caset;
     uint8_t                     cmd_raset;
     uint8_t                     cmd_ramwr;
+    uint8_t                     rect_align; // window alignment of the controller in pixels, 0 for none
 }DISP_QSPI_BASE_CFG_T;
 
 typedef struct { 
@@ -149,8 +153,15 @@ typedef struct {
     OPERATE_RET (*open)(TDD_DISP_DEV_HANDLE_T device);
     OPERATE_RET (*flush)(TDD_DISP_DEV_HANDLE_T device, TDL_DISP_FRAME_BUFF_T *frame_buff);
     OPERATE_RET (*close)(TDD_DISP_DEV_HANDLE_T device);
+    // optional, sends regions of the frame, the rects are clipped, aligned and merged
+    OPERATE_RET (*flush_rects)(TDD_DISP_DEV_HANDLE_T device, TDL_DISP_FRAME_BUFF_T *frame_buff,
+                               const TDL_DISP_RECT_T *rects, uint8_t rect_num);
+    // optional, for a flush that returns before the panel has the frame
+    OPERATE_RET (*flush_wait)(TDD_DISP_DEV_HANDLE_T device, uint32_t timeout_ms);
 } TDD_DISP_INTFS_T;
 
+typedef OPERATE_RET (*TDL_DISP_DATA_SEND_CB)(void *arg, uint8_t *data, uint32_t len);
+
 /***********************************************************
 ********************function declaration********************
 ***********************************************************/
@@ -171,6 +182,25 @@ typedef struct {
 OPERATE_RET tdl_disp_device_register(char *name, TDD_DISP_DEV_HANDLE_T tdd_hdl, \
                                      TDD_DISP_INTFS_T *intfs, TDD_DISP_DEV_INFO_T *dev_info);
 
+/**
+ * @brief Sends the pixels of a rect of the frame buffer, row after row.
+ *
+ * A rect as wide as the frame is sent in one piece from the frame buffer. The
+ * rows of a narrower rect are packed into buf, as many as it holds per send,
+ * and they are sent one by one when buf is NULL or a row does not fit.
+ *
+ * @param frame_buff Pointer to the frame buffer, its format has whole bytes per pixel.
+ * @param rect The rect to send, inside the frame.
+ * @param buf Buffer to pack the rows in, can be NULL.
+ * @param buf_len Length of buf in bytes.
+ * @param send_cb Function sending a piece of pixel data to the panel.
+ * @param arg Argument of send_cb.
+ *
+ * @return Returns OPRT_OK on success, or the first error of send_cb.
+ */
+OPERATE_RET tdl_disp_rect_send(TDL_DISP_FRAME_BUFF_T *frame_buff, const TDL_DISP_RECT_T *rect, uint8_t *buf,
+                               uint32_t buf_len, TDL_DISP_DATA_SEND_CB send_cb, void *arg);
+
 #if defined(ENABLE_RGB) && (ENABLE_RGB==1) 
 /**
  * @brief Registers an RGB display device with the display management system.
@@ -23,6 +23,7 @@ extern "C" {
 /***********************************************************
 ************************macro define************************
 ***********************************************************/
+#define TDL_DISP_RECT_MAX 16 // dirty rects of one flush, more are sent as the whole frame
 
 /***********************************************************
 ***********************typedef define***********************
@@ -56,6 +57,20 @@ struct TDL_DISP_FRAME_BUFF_T {
     uint8_t *frame;
 };
 
+typedef struct {
+    uint16_t x1;
+    uint16_t y1;
+    uint16_t x2; // inclusive
+    uint16_t y2; // inclusive
+} TDL_DISP_RECT_T;
+
+typedef struct {
+    uint32_t frames;      // flushes
+    uint32_t full_frames; // flushes sent as the whole frame
+    uint32_t rects;       // rects sent by the other flushes
+    uint64_t bytes;       // pixel bytes sent to the panel
+} TDL_DISP_FLUSH_STAT_T;
+
 typedef struct {
     TUYA_DISPLAY_TYPE_E type;
     TUYA_DISPLAY_ROTATION_E rotation;
@@ -101,6 +116,52 @@ OPERATE_RET tdl_disp_dev_open(TDL_DISP_HANDLE_T disp_hdl);
  */
 OPERATE_RET tdl_disp_dev_flush(TDL_DISP_HANDLE_T disp_hdl, TDL_DISP_FRAME_BUFF_T *frame_buff);
 
+/**
+ * @brief Flushes the dirty rects of the frame buffer to the display device.
+ *
+ * The rects are clipped to the frame, aligned to the constraints of the display
+ * controller and merged where it saves bus time, then the device sends only
+ * those regions. The whole frame is sent instead when the device cannot update
+ * part of the panel, when there are too many rects or when their area is above
+ * DISPLAY_FLUSH_FULL_PERCENT of the frame.
+ *
+ * @param disp_hdl Handle to the display device.
+ * @param frame_buff Pointer to the frame buffer holding the whole frame.
+ * @param rects Regions of the frame that changed since the last flush.
+ * @param rect_num Number of rects, 0 sends nothing.
+ *
+ * @return Returns OPRT_OK on success, or an appropriate error code if flushing fails.
+ */
+OPERATE_RET tdl_disp_dev_flush_rects(TDL_DISP_HANDLE_T disp_hdl, TDL_DISP_FRAME_BUFF_T *frame_buff,
+                                     const TDL_DISP_RECT_T *rects, uint8_t rect_num);
+
+/**
+ * @brief Waits until the panel has every frame flushed before.
+ *
+ * The flush of some devices returns while the frame is still being sent, the
+ * frame buffer must not be written again before this returns. It returns at
+ * once for the devices that send the frame inside the flush.
+ *
+ * @param disp_hdl Handle to the display device.
+ * @param timeout_ms Time to wait for each pending flush, SEM_WAIT_FOREVER to wait until done.
+ *
+ * @return Returns OPRT_OK when the flushes are done, or an appropriate error code on timeout.
+ */
+OPERATE_RET tdl_disp_dev_flush_wait(TDL_DISP_HANDLE_T disp_hdl, uint32_t timeout_ms);
+
+/**
+ * @brief Retrieves the flush counters of a display device.
+ *
+ * The counters add up every flush since the device was registered, the bytes
+ * are the pixel data sent to the panel, commands and windows not included.
+ *
+ * @param disp_hdl Handle to the display device.
+ * @param stat Pointer to the structure where the counters will be stored.
+ *
+ * @return Returns OPRT_OK on success, or an appropriate error code if the operation fails.
+ */
+OPERATE_RET tdl_disp_dev_get_flush_stat(TDL_DISP_HANDLE_T disp_hdl, TDL_DISP_FLUSH_STAT_T *stat);
+
 /**
  * @brief Retrieves information about a registered display device.
  *
@@ -0,0 +1,193 @@
+/**
+ * @file tdl_display_convert.c
+ * @brief TDL display pixel format conversion implementation
+ *
+ * This file implements the row kernels converting RGB565 pixels into the frame
+ * buffer formats of the panels. The kernels load two pixels in a 32-bit word
+ * and work on both 16-bit lanes at once, the lanes never carry into each
+ * other. Words are loaded and stored with memcpy, so the rows need no
+ * alignment beyond that of a pixel. The first pixel of a run is the low lane,
+ * as on the little endian chips the display layer runs on.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include <string.h>
+
+#include "tdl_display_convert.h"
+
+/***********************************************************
+************************macro define************************
+***********************************************************/
+#define DISP_LANE_LO(v) ((uint32_t)(v) * 0x00010001UL) // v in both 16-bit lanes
+
+// luminance weights of the 5, 6 and 5 bit channels, white sums to 255 << 8
+#define DISP_LUMA_R 632
+#define DISP_LUMA_G 610
+#define DISP_LUMA_B 241
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+// 2x2 ordered dither thresholds, in 1/256 of a grey level
+static const uint16_t sg_i2_dither[2][2] = {
+    {32, 160},
+    {224, 96},
+};
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+static inline uint32_t __load_pair(const uint16_t *src)
+{
+    uint32_t w = 0;
+
+    memcpy(&w, src, sizeof(w));
+    return w;
+}
+
+/* bit 0 for the low lane and bit 1 for the high lane, set when the pixel is dark */
+static inline uint32_t __mono_pair(uint32_t w)
+{
+    uint32_t t = (w >> 12) & DISP_LANE_LO(0x000F);
+
+    // the top nibble is at most 8 exactly when adding 7 leaves bit 4 clear
+    t = ~(t + DISP_LANE_LO(0x0007)) & DISP_LANE_LO(0x0010);
+
+    return ((t >> 4) | (t >> 19)) & 0x03;
+}
+
+static inline uint8_t __mono_bit(uint16_t px)
+{
+    return (px <= 0x8FFF) ? 1 : 0;
+}
+
+/* the grey levels of both lanes, 0 for white, in bits 0-1 and 16-17 */
+static inline uint32_t __i2_pair(uint32_t w, uint32_t dither)
+{
+    uint32_t r = (w >> 11) & DISP_LANE_LO(0x001F);
+    uint32_t g = (w >> 5) & DISP_LANE_LO(0x003F);
+    uint32_t b = w & DISP_LANE_LO(0x001F);
+    uint32_t luma = ((r * DISP_LUMA_R + g * DISP_LUMA_G + b * DISP_LUMA_B) >> 8) & DISP_LANE_LO(0x00FF);
+
+    return (((luma * 3 + dither) >> 8) & DISP_LANE_LO(0x0003)) ^ DISP_LANE_LO(0x0003);
+}
+
+static inline uint8_t __i2_level(uint16_t px, uint32_t x, uint32_t y)
+{
+    return (uint8_t)__i2_pair(px, sg_i2_dither[y & 1][x & 1]);
+}
+
+/**
+ * @brief Converts a run of RGB565 pixels into a monochrome row.
+ *
+ * @param src RGB565 pixels of the run.
+ * @param dst_row First byte of the row in the frame buffer.
+ * @param x Column of the first pixel of the run.
+ * @param num Number of pixels.
+ *
+ * @return None.
+ */
+void tdl_disp_convert_mono_row(const uint16_t *src, uint8_t *dst_row, uint32_t x, uint32_t num)
+{
+    uint8_t *dst = dst_row + x / 8;
+    uint32_t bit = x % 8, w0 = 0, w1 = 0, w2 = 0, w3 = 0;
+    uint8_t byte = 0;
+
+    if (bit) {
+        byte = *dst;
+        for (; bit < 8 && num; bit++, num--) {
+            byte = (byte & ~(1 << bit)) | (__mono_bit(*src++) << bit);
+        }
+        *dst++ = byte;
+    }
+
+    for (; num >= 8; num -= 8) {
+        w0 = __load_pair(src);
+        w1 = __load_pair(src + 2);
+        w2 = __load_pair(src + 4);
+        w3 = __load_pair(src + 6);
+        *dst++ = (uint8_t)(__mono_pair(w0) | (__mono_pair(w1) << 2) | (__mono_pair(w2) << 4) |
+                           (__mono_pair(w3) << 6));
+        src += 8;
+    }
+
+    if (num) {
+        byte = *dst;
+        for (bit = 0; bit < num; bit++) {
+            byte = (byte & ~(1 << bit)) | (__mono_bit(*src++) << bit);
+        }
+        *dst = byte;
+    }
+}
+
+/**
+ * @brief Converts a run of RGB565 pixels into an I2 row.
+ *
+ * @param src RGB565 pixels of the run.
+ * @param dst_row First byte of the row in the frame buffer.
+ * @param x Column of the first pixel of the run.
+ * @param y Row of the run, it selects the line of the dither matrix.
+ * @param num Number of pixels.
+ *
+ * @return None.
+ */
+void tdl_disp_convert_i2_row(const uint16_t *src, uint8_t *dst_row, uint32_t x, uint32_t y, uint32_t num)
+{
+    uint8_t *dst = dst_row + x / 4;
+    uint32_t shift = (x % 4) * 2, q0 = 0, q1 = 0;
+    // the body starts on a byte, so on an even column
+    uint32_t dither = sg_i2_dither[y & 1][0] | ((uint32_t)sg_i2_dither[y & 1][1] << 16);
+    uint8_t byte = 0;
+
+    if (shift) {
+        byte = *dst;
+        for (; shift < 8 && num; shift += 2, num--, x++) {
+            byte = (byte & ~(0x03 << shift)) | (__i2_level(*src++, x, y) << shift);
+        }
+        *dst++ = byte;
+    }
+
+    for (; num >= 4; num -= 4) {
+        q0 = __i2_pair(__load_pair(src), dither);
+        q1 = __i2_pair(__load_pair(src + 2), dither);
+        *dst++ = (uint8_t)(((q0 | (q0 >> 14)) & 0x0F) | (((q1 | (q1 >> 14)) & 0x0F) << 4));
+        src += 4;
+        x += 4;
+    }
+
+    if (num) {
+        byte = *dst;
+        for (shift = 0; num; shift += 2, num--, x++) {
+            byte = (byte & ~(0x03 << shift)) | (__i2_level(*src++, x, y) << shift);
+        }
+        *dst = byte;
+    }
+}
+
+/**
+ * @brief Copies a run of RGB565 pixels and swaps the bytes of each.
+ *
+ * @param src RGB565 pixels of the run.
+ * @param dst Destination of the swapped pixels, it must not overlap src.
+ * @param num Number of pixels.
+ *
+ * @return None.
+ */
+void tdl_disp_convert_swap_row(const uint16_t *src, uint16_t *dst, uint32_t num)
+{
+    uint32_t w = 0;
+
+    for (; num >= 2; num -= 2) {
+        w = __load_pair(src);
+        w = ((w & DISP_LANE_LO(0x00FF)) << 8) | ((w >> 8) & DISP_LANE_LO(0x00FF));
+        memcpy(dst, &w, sizeof(w));
+        src += 2;
+        dst += 2;
+    }
+
+    if (num) {
+        *dst = (uint16_t)((*src << 8) | (*src >> 8));
+    }
+}
@@ -29,6 +29,12 @@
 ***********************************************************/
 #define TDL_DISP_DRAW_BUF_ALIGN 4
 
+#if defined(DISPLAY_FLUSH_FULL_PERCENT)
+#define TDL_DISP_FLUSH_FULL_PERCENT DISPLAY_FLUSH_FULL_PERCENT
+#else
+#define TDL_DISP_FLUSH_FULL_PERCENT 60
+#endif
+
 /***********************************************************
 ***********************typedef define***********************
 ***********************************************************/
@@ -44,6 +50,10 @@ typedef struct {
 
     TDD_DISP_DEV_HANDLE_T tdd_hdl;
     TDD_DISP_INTFS_T intfs;
+    uint16_t rect_x_align;
+    uint16_t rect_y_align;
+
+    TDL_DISP_FLUSH_STAT_T stat;
 } DISPLAY_DEVICE_T;
 
 /***********************************************************
@@ -148,6 +158,80 @@ static void __tdl_blacklight_deinit(TUYA_DISPLAY_BL_CTRL_T *bl_cfg)
     return;
 }
 
+static uint8_t __disp_pixel_bytes(TUYA_DISPLAY_PIXEL_FMT_E fmt)
+{
+    switch (fmt) {
+    case TUYA_PIXEL_FMT_RGB565:
+        return 2;
+    case TUYA_PIXEL_FMT_RGB666:
+    case TUYA_PIXEL_FMT_RGB888:
+        return 3;
+    default:
+        return 0; // several pixels per byte
+    }
+}
+
+static uint32_t __disp_rect_area(const TDL_DISP_RECT_T *rect)
+{
+    return (uint32_t)(rect->x2 - rect->x1 + 1) * (rect->y2 - rect->y1 + 1);
+}
+
+static uint16_t __disp_align_down(uint16_t value, uint16_t align)
+{
+    return (align > 1) ? (value / align * align) : value;
+}
+
+static uint16_t __disp_align_up_end(uint16_t end, uint16_t align, uint16_t size)
+{
+    uint32_t aligned = (align > 1) ? ((uint32_t)(end / align + 1) * align - 1) : end;
+
+    return (aligned < size) ? aligned : (size - 1);
+}
+
+/* clip, align and merge the rects into out, returns the number of rects */
+static uint8_t __disp_rects_prepare(DISPLAY_DEVICE_T *display_dev, TDL_DISP_FRAME_BUFF_T *frame_buff,
+                                    const TDL_DISP_RECT_T *rects, uint8_t rect_num, TDL_DISP_RECT_T *out)
+{
+    uint8_t i = 0, j = 0, num = 0;
+    bool joined = false;
+    TDL_DISP_RECT_T join;
+
+    for (i = 0; i < rect_num; i++) {
+        if (rects[i].x1 > rects[i].x2 || rects[i].y1 > rects[i].y2 || rects[i].x1 >= frame_buff->width ||
+            rects[i].y1 >= frame_buff->height) {
+            continue;
+        }
+        out[num].x1 = __disp_align_down(rects[i].x1, display_dev->rect_x_align);
+        out[num].y1 = __disp_align_down(rects[i].y1, display_dev->rect_y_align);
+        out[num].x2 = __disp_align_up_end(MIN(rects[i].x2, frame_buff->width - 1), display_dev->rect_x_align,
+                                          frame_buff->width);
+        out[num].y2 = __disp_align_up_end(MIN(rects[i].y2, frame_buff->height - 1), display_dev->rect_y_align,
+                                          frame_buff->height);
+        num++;
+    }
+
+    // two rects become their bounding rect when it is not larger than both of them,
+    // overlapping and adjoining rects are sent once
+    do {
+        joined = false;
+        for (i = 0; i < num && !joined; i++) {
+            for (j = i + 1; j < num; j++) {
+                join.x1 = MIN(out[i].x1, out[j].x1);
+                join.y1 = MIN(out[i].y1, out[j].y1);
+                join.x2 = MAX(out[i].x2, out[j].x2);
+                join.y2 = MAX(out[i].y2, out[j].y2);
+                if (__disp_rect_area(&join) <= __disp_rect_area(&out[i]) + __disp_rect_area(&out[j])) {
+                    out[i] = join;
+                    out[j] = out[--num];
+                    joined = true;
+                    break;
+                }
+            }
+        }
+    } while (joined);
+
+    return num;
+}
 
 /**
  * @brief Finds a registered display device by its name.
@@ -233,6 +317,122 @@ OPERATE_RET tdl_disp_dev_flush(TDL_DISP_HANDLE_T disp_hdl, TDL_DISP_FRAME_BUFF_T
         TUYA_CALL_ERR_RETURN(display_dev->intfs.flush(display_dev->tdd_hdl, frame_buff));
     }
 
+    display_dev->stat.frames++;
+    display_dev->stat.full_frames++;
+    display_dev->stat.bytes += frame_buff->len;
+
+    return OPRT_OK;
+}
+
+/**
+ * @brief Flushes the dirty rects of the frame buffer to the display device.
+ *
+ * The rects are clipped to the frame, aligned to the constraints of the display
+ * controller and merged where it saves bus time, then the device sends only
+ * those regions. The whole frame is sent instead when the device cannot update
+ * part of the panel, when there are too many rects or when their area is above
+ * DISPLAY_FLUSH_FULL_PERCENT of the frame.
+ *
+ * @param disp_hdl Handle to the display device.
+ * @param frame_buff Pointer to the frame buffer holding the whole frame.
+ * @param rects Regions of the frame that changed since the last flush.
+ * @param rect_num Number of rects, 0 sends nothing.
+ *
+ * @return Returns OPRT_OK on success, or an appropriate error code if flushing fails.
+ */
+OPERATE_RET tdl_disp_dev_flush_rects(TDL_DISP_HANDLE_T disp_hdl, TDL_DISP_FRAME_BUFF_T *frame_buff,
+                                     const TDL_DISP_RECT_T *rects, uint8_t rect_num)
+{
+    OPERATE_RET rt = OPRT_OK;
+    DISPLAY_DEVICE_T *display_dev = NULL;
+    TDL_DISP_RECT_T dirty[TDL_DISP_RECT_MAX];
+    uint8_t i = 0, dirty_num = 0, pixel_bytes = 0;
+    uint32_t area = 0;
+
+    if (NULL == disp_hdl || NULL == frame_buff || (NULL == rects && rect_num)) {
+        return OPRT_INVALID_PARM;
+    }
+
+    display_dev = (DISPLAY_DEVICE_T *)disp_hdl;
+
+    if (false == display_dev->is_open) {
+        return OPRT_COM_ERROR;
+    }
+
+    pixel_bytes = __disp_pixel_bytes(frame_buff->fmt);
+    if (NULL == display_dev->intfs.flush_rects || 0 == pixel_bytes || rect_num > TDL_DISP_RECT_MAX) {
+        return tdl_disp_dev_flush(disp_hdl, frame_buff);
+    }
+
+    dirty_num = __disp_rects_prepare(display_dev, frame_buff, rects, rect_num, dirty);
+    if (0 == dirty_num) {
+        return OPRT_OK;
+    }
+
+    for (i = 0; i < dirty_num; i++) {
+        area += __disp_rect_area(&dirty[i]);
+    }
+    if ((uint64_t)area * 100 >= (uint64_t)frame_buff->width * frame_buff->height * TDL_DISP_FLUSH_FULL_PERCENT) {
+        return tdl_disp_dev_flush(disp_hdl, frame_buff);
+    }
+
+    TUYA_CALL_ERR_RETURN(display_dev->intfs.flush_rects(display_dev->tdd_hdl, frame_buff, dirty, dirty_num));
+
+    display_dev->stat.frames++;
+    display_dev->stat.rects += dirty_num;
+    display_dev->stat.bytes += (uint64_t)area * pixel_bytes;
+
+    return OPRT_OK;
+}
+
+/**
+ * @brief Waits until the panel has every frame flushed before.
+ *
+ * @param disp_hdl Handle to the display device.
+ * @param timeout_ms Time to wait for each pending flush, SEM_WAIT_FOREVER to wait until done.
+ *
+ * @return Returns OPRT_OK when the flushes are done, or an appropriate error code on timeout.
+ */
+OPERATE_RET tdl_disp_dev_flush_wait(TDL_DISP_HANDLE_T disp_hdl, uint32_t timeout_ms)
+{
+    DISPLAY_DEVICE_T *display_dev = NULL;
+
+    if (NULL == disp_hdl) {
+        return OPRT_INVALID_PARM;
+    }
+
+    display_dev = (DISPLAY_DEVICE_T *)disp_hdl;
+
+    if (false == display_dev->is_open || NULL == display_dev->intfs.flush_wait) {
+        return OPRT_OK;
+    }
+
+    return display_dev->intfs.flush_wait(display_dev->tdd_hdl, timeout_ms);
+}
+
+/**
+ * @brief Retrieves the flush counters of a display device.
+ *
+ * The counters add up every flush since the device was registered, the bytes
+ * are the pixel data sent to the panel, commands and windows not included.
+ *
+ * @param disp_hdl Handle to the display device.
+ * @param stat Pointer to the structure where the counters will be stored.
+ *
+ * @return Returns OPRT_OK on success, or an appropriate error code if the operation fails.
+ */
+OPERATE_RET tdl_disp_dev_get_flush_stat(TDL_DISP_HANDLE_T disp_hdl, TDL_DISP_FLUSH_STAT_T *stat)
+{
+    DISPLAY_DEVICE_T *display_dev = NULL;
+
+    if (NULL == disp_hdl || NULL == stat) {
+        return OPRT_INVALID_PARM;
+    }
+
+    display_dev = (DISPLAY_DEVICE_T *)disp_hdl;
+
+    memcpy(stat, &display_dev->stat, sizeof(TDL_DISP_FLUSH_STAT_T));
+
     return OPRT_OK;
 }
 
@@ -389,7 +589,7 @@ TDL_DISP_FRAME_BUFF_T *tdl_disp_create_frame_buff(DISP_FB_RAM_TP_E type, uint32_
 
     p_frame = (uint8_t *)fb + sizeof(TDL_DISP_FRAME_BUFF_T);
     p_frame += TDL_DISP_DRAW_BUF_ALIGN - 1;
-    p_frame = (uint8_t *)((uint32_t)p_frame & ~(TDL_DISP_DRAW_BUF_ALIGN - 1));
+    p_frame = (uint8_t *)((uintptr_t)p_frame & ~(TDL_DISP_DRAW_BUF_ALIGN - 1));
 
     fb->type = fb_type;
     fb->frame = p_frame;
@@ -423,6 +623,66 @@ void tdl_disp_free_frame_buff(TDL_DISP_FRAME_BUFF_T *frame_buff)
     }
 }
 
+/**
+ * @brief Sends the pixels of a rect of the frame buffer, row after row.
+ *
+ * A rect as wide as the frame is sent in one piece from the frame buffer. The
+ * rows of a narrower rect are packed into buf, as many as it holds per send,
+ * and they are sent one by one when buf is NULL or a row does not fit.
+ *
+ * @param frame_buff Pointer to the frame buffer, its format has whole bytes per pixel.
+ * @param rect The rect to send, inside the frame.
+ * @param buf Buffer to pack the rows in, can be NULL.
+ * @param buf_len Length of buf in bytes.
+ * @param send_cb Function sending a piece of pixel data to the panel.
+ * @param arg Argument of send_cb.
+ *
+ * @return Returns OPRT_OK on success, or the first error of send_cb.
+ */
+OPERATE_RET tdl_disp_rect_send(TDL_DISP_FRAME_BUFF_T *frame_buff, const TDL_DISP_RECT_T *rect, uint8_t *buf,
+                               uint32_t buf_len, TDL_DISP_DATA_SEND_CB send_cb, void *arg)
+{
+    OPERATE_RET rt = OPRT_OK;
+    uint8_t pixel_bytes = 0;
+    uint32_t stride = 0, row_len = 0, rows = 0, i = 0;
+    uint16_t y = 0;
+    uint8_t *src = NULL;
+
+    if (NULL == frame_buff || NULL == rect || NULL == send_cb) {
+        return OPRT_INVALID_PARM;
+    }
+
+    pixel_bytes = __disp_pixel_bytes(frame_buff->fmt);
+    if (0 == pixel_bytes) {
+        return OPRT_NOT_SUPPORTED;
+    }
+
+    stride = frame_buff->width * pixel_bytes;
+    row_len = (rect->x2 - rect->x1 + 1) * pixel_bytes;
+    src = frame_buff->frame + rect->y1 * stride + rect->x1 * pixel_bytes;
+
+    if (row_len == stride) {
+        return send_cb(arg, src, stride * (rect->y2 - rect->y1 + 1));
+    }
+
+    rows = (buf && row_len <= buf_len) ? (buf_len / row_len) : 0;
+    for (y = rect->y1; y <= rect->y2;) {
+        if (0 == rows) {
+            TUYA_CALL_ERR_RETURN(send_cb(arg, src, row_len));
+            src += stride;
+            y++;
+            continue;
+        }
+        for (i = 0; i < rows && y <= rect->y2; i++, y++) {
+            memcpy(buf + i * row_len, src, row_len);
+            src += stride;
+        }
+        TUYA_CALL_ERR_RETURN(send_cb(arg, buf, i * row_len));
+    }
+
+    return rt;
+}
+
 /**
  * @brief Registers a display device with the display management system.
  *
@@ -466,6 +726,10 @@ OPERATE_RET tdl_disp_device_register(char *name, TDD_DISP_DEV_HANDLE_T tdd_hdl,
     display_dev->tdd_hdl = tdd_hdl;
 
     memcpy(&display_dev->intfs, intfs, sizeof(TDD_DISP_INTFS_T));
+    if (intfs->flush_rects) {
+        display_dev->rect_x_align = dev_info->rect_x_align;
+        display_dev->rect_y_align = dev_info->rect_y_align;
+    }
 
     tuya_list_add(&display_dev->node, &sg_display_list);
 
@@ -158,6 +158,27 @@ static void __disp_8080_set_window(DISP_8080_DEV_T *p_cfg, uint32_t width, uint3
     tkl_8080_cmd_send_with_param(p_cfg->cmd_raset, lcd_data, 4);
 }
 
+static void __disp_8080_set_rect(DISP_8080_DEV_T *p_cfg, const TDL_DISP_RECT_T *rect)
+{
+    uint32_t lcd_data[4];
+
+    if (NULL == p_cfg || NULL == rect) {
+        return;
+    }
+
+    lcd_data[0] = (rect->x1 >> 8) & 0xFF;
+    lcd_data[1] = (rect->x1 & 0xFF);
+    lcd_data[2] = (rect->x2 >> 8) & 0xFF;
+    lcd_data[3] = (rect->x2 & 0xFF);
+    tkl_8080_cmd_send_with_param(p_cfg->cmd_caset, lcd_data, 4);
+
+    lcd_data[0] = (rect->y1 >> 8) & 0xFF;
+    lcd_data[1] = (rect->y1 & 0xFF);
+    lcd_data[2] = (rect->y2 >> 8) & 0xFF;
+    lcd_data[3] = (rect->y2 & 0xFF);
+    tkl_8080_cmd_send_with_param(p_cfg->cmd_raset, lcd_data, 4);
+}
+
 static OPERATE_RET __tdd_display_mcu8080_open(TDD_DISP_DEV_HANDLE_T device)
 {
     OPERATE_RET rt = OPRT_OK;
@@ -231,6 +252,60 @@ static OPERATE_RET __tdd_display_mcu8080_flush(TDD_DISP_DEV_HANDLE_T device, TDL
     return tal_semaphore_wait(sg_display_8080.tx_sem, SEM_WAIT_FOREVER);
 }
 
+/* The 8080 engine reads the pixels from one address on, the rects are bands of
+ * whole rows so that each of them is a contiguous part of the frame buffer. */
+static OPERATE_RET __tdd_display_mcu8080_flush_rects(TDD_DISP_DEV_HANDLE_T device, TDL_DISP_FRAME_BUFF_T *frame_buff,
+                                                     const TDL_DISP_RECT_T *rects, uint8_t rect_num)
+{
+    OPERATE_RET rt = OPRT_OK;
+    DISP_8080_DEV_T *tdd_8080 = NULL;
+    uint32_t stride = 0;
+    uint16_t rows = 0;
+    uint8_t i = 0;
+
+    if (NULL == device || NULL == frame_buff || NULL == rects || 0 == frame_buff->height) {
+        return OPRT_INVALID_PARM;
+    }
+    tdd_8080 = (DISP_8080_DEV_T *)device;
+    stride = frame_buff->len / frame_buff->height;
+
+    if (sg_display_8080.fmt != frame_buff->fmt) {
+        tkl_8080_pixel_mode_set(frame_buff->fmt);
+        sg_display_8080.fmt = frame_buff->fmt;
+    }
+
+    /*One TE wait for all the bands, as the whole frame does.*/
+    if (tdd_8080->te_pin < TUYA_GPIO_NUM_MAX) {
+        sg_display_8080.flush_start_flag = true;
+        rt = tal_semaphore_wait(sg_display_8080.te_sem, 5000);
+        sg_display_8080.flush_start_flag = false;
+        if (rt) {
+            PR_ERR("flush error(%d)...", rt);
+            return rt;
+        }
+    }
+
+    for (i = 0; i < rect_num; i++) {
+        rows = rects[i].y2 - rects[i].y1 + 1;
+        if (sg_display_8080.width != frame_buff->width || sg_display_8080.height != rows) {
+            tkl_8080_ppi_set(frame_buff->width, rows);
+            sg_display_8080.width = frame_buff->width;
+            sg_display_8080.height = rows;
+        }
+
+        tkl_8080_base_addr_set((uint32_t)(frame_buff->frame + rects[i].y1 * stride));
+
+        __disp_8080_set_rect(tdd_8080, &rects[i]);
+        tkl_8080_cmd_send(tdd_8080->cmd_ramwr);
+
+        tkl_8080_transfer_start();
+
+        TUYA_CALL_ERR_RETURN(tal_semaphore_wait(sg_display_8080.tx_sem, SEM_WAIT_FOREVER));
+    }
+
+    return rt;
+}
+
 static OPERATE_RET __tdd_display_mcu8080_close(TDD_DISP_DEV_HANDLE_T device)
 {
     OPERATE_RET rt = OPRT_OK;
@@ -300,6 +375,8 @@ OPERATE_RET tdl_disp_mcu8080_device_register(char *name, TDD_DISP_MCU8080_CFG_T
     mcu8080_dev_info.height = mcu8080->cfg.height;
     mcu8080_dev_info.fmt = mcu8080->cfg.pixel_fmt;
     mcu8080_dev_info.rotation = mcu8080->rotation;
+    mcu8080_dev_info.rect_x_align = mcu8080->cfg.width; // whole rows
+    mcu8080_dev_info.rect_y_align = 1;
 
     memcpy(&mcu8080_dev_info.bl, &mcu8080->bl, sizeof(TUYA_DISPLAY_BL_CTRL_T));
     memcpy(&mcu8080_dev_info.power, &mcu8080->power, sizeof(TUYA_DISPLAY_IO_CTRL_T));
@@ -308,6 +385,7 @@ OPERATE_RET tdl_disp_mcu8080_device_register(char *name, TDD_DISP_MCU8080_CFG_T
         .open = __tdd_display_mcu8080_open,
         .flush = __tdd_display_mcu8080_flush,
         .close = __tdd_display_mcu8080_close,
+        .flush_rects = __tdd_display_mcu8080_flush_rects,
     };
 
     TUYA_CALL_ERR_RETURN(
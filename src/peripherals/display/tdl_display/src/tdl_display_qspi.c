@@ -22,6 +22,7 @@
 /***********************************************************
 ************************macro define************************
 ***********************************************************/
+#define DISP_QSPI_RECT_BUF_LEN (8 * 1024) // rows of a dirty rect packed per transfer
 
 /***********************************************************
 ***********************typedef define***********************
@@ -29,6 +30,7 @@
 typedef struct {
     DISP_QSPI_BASE_CFG_T cfg;
     const uint8_t *init_seq;
+    uint8_t *rect_buf;
 } DISP_QSPI_DEV_T;
 
 /***********************************************************
@@ -140,6 +142,34 @@ static void __disp_qspi_set_window(DISP_QSPI_BASE_CFG_T *p_cfg, uint32_t width,
     __disp_qspi_send_data(p_cfg, lcd_data, 4);
 }
 
+static void __disp_qspi_set_rect(DISP_QSPI_BASE_CFG_T *p_cfg, const TDL_DISP_RECT_T *rect)
+{
+    uint8_t lcd_data[4];
+
+    if (NULL == p_cfg || NULL == rect) {
+        return;
+    }
+
+    lcd_data[0] = (rect->x1 >> 8) & 0xFF;
+    lcd_data[1] = (rect->x1 & 0xFF);
+    lcd_data[2] = (rect->x2 >> 8) & 0xFF;
+    lcd_data[3] = (rect->x2 & 0xFF);
+    __disp_qspi_send_cmd(p_cfg, p_cfg->cmd_caset);
+    __disp_qspi_send_data(p_cfg, lcd_data, 4);
+
+    lcd_data[0] = (rect->y1 >> 8) & 0xFF;
+    lcd_data[1] = (rect->y1 & 0xFF);
+    lcd_data[2] = (rect->y2 >> 8) & 0xFF;
+    lcd_data[3] = (rect->y2 & 0xFF);
+    __disp_qspi_send_cmd(p_cfg, p_cfg->cmd_raset);
+    __disp_qspi_send_data(p_cfg, lcd_data, 4);
+}
+
+static OPERATE_RET __disp_qspi_rect_data_send(void *arg, uint8_t *data, uint32_t len)
+{
+    return __disp_qspi_send_data((DISP_QSPI_BASE_CFG_T *)arg, data, len);
+}
+
 static void __tdd_disp_reset(TUYA_GPIO_NUM_E rst_pin)
 {
     if(rst_pin >= TUYA_GPIO_NUM_MAX) {
@@ -218,6 +248,34 @@ static OPERATE_RET __tdd_display_qspi_flush(TDD_DISP_DEV_HANDLE_T device, TDL_DI
     return rt;
 }
 
+static OPERATE_RET __tdd_display_qspi_flush_rects(TDD_DISP_DEV_HANDLE_T device, TDL_DISP_FRAME_BUFF_T *frame_buff,
+                                                  const TDL_DISP_RECT_T *rects, uint8_t rect_num)
+{
+    OPERATE_RET rt = OPRT_OK;
+    DISP_QSPI_DEV_T *disp_qspi_dev = NULL;
+    uint8_t i = 0;
+
+    if (NULL == device || NULL == frame_buff || NULL == rects) {
+        return OPRT_INVALID_PARM;
+    }
+
+    disp_qspi_dev = (DISP_QSPI_DEV_T *)device;
+
+    // without it the rows of narrow rects are sent one by one
+    if (NULL == disp_qspi_dev->rect_buf) {
+        disp_qspi_dev->rect_buf = tal_malloc(DISP_QSPI_RECT_BUF_LEN);
+    }
+
+    for (i = 0; i < rect_num; i++) {
+        __disp_qspi_set_rect(&disp_qspi_dev->cfg, &rects[i]);
+        __disp_qspi_send_cmd(&disp_qspi_dev->cfg, disp_qspi_dev->cfg.cmd_ramwr);
+        TUYA_CALL_ERR_RETURN(tdl_disp_rect_send(frame_buff, &rects[i], disp_qspi_dev->rect_buf, DISP_QSPI_RECT_BUF_LEN,
+                                                __disp_qspi_rect_data_send, &disp_qspi_dev->cfg));
+    }
+
+    return rt;
+}
+
 static OPERATE_RET __tdd_display_qspi_close(TDD_DISP_DEV_HANDLE_T device)
 {
     return OPRT_NOT_SUPPORTED;
@@ -248,6 +306,7 @@ OPERATE_RET tdl_disp_qspi_device_register(char *name, TDD_DISP_QSPI_CFG_T *spi)
     if (NULL == disp_qspi_dev) {
         return OPRT_MALLOC_FAILED;
     }
+    memset(disp_qspi_dev, 0x00, sizeof(DISP_QSPI_DEV_T));
     memcpy(&disp_qspi_dev->cfg, &spi->cfg, sizeof(DISP_QSPI_BASE_CFG_T));
 
     disp_qspi_dev->init_seq = spi->init_seq;
@@ -257,6 +316,8 @@ OPERATE_RET tdl_disp_qspi_device_register(char *name, TDD_DISP_QSPI_CFG_T *spi)
     disp_qspi_dev_info.height = spi->cfg.height;
     disp_qspi_dev_info.fmt = spi->cfg.pixel_fmt;
     disp_qspi_dev_info.rotation = spi->rotation;
+    disp_qspi_dev_info.rect_x_align = spi->cfg.rect_align;
+    disp_qspi_dev_info.rect_y_align = spi->cfg.rect_align;
 
     memcpy(&disp_qspi_dev_info.bl, &spi->bl, sizeof(TUYA_DISPLAY_BL_CTRL_T));
     memcpy(&disp_qspi_dev_info.power, &spi->power, sizeof(TUYA_DISPLAY_IO_CTRL_T));
@@ -265,6 +326,7 @@ OPERATE_RET tdl_disp_qspi_device_register(char *name, TDD_DISP_QSPI_CFG_T *spi)
         .open = __tdd_display_qspi_open,
         .flush = __tdd_display_qspi_flush,
         .close = __tdd_display_qspi_close,
+        .flush_rects = __tdd_display_qspi_flush_rects,
     };
 
     TUYA_CALL_ERR_RETURN(
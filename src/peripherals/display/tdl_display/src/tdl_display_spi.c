@@ -22,6 +22,11 @@
 /***********************************************************
 ************************macro define************************
 ***********************************************************/
+#define DISP_SPI_RECT_BUF_LEN (8 * 1024) // rows of a dirty rect packed per transfer
+
+#if defined(DISPLAY_SPI_ASYNC_FLUSH) && (DISPLAY_SPI_ASYNC_FLUSH == 1)
+#define DISP_SPI_FLUSH_QUEUE_NUM 2 // flushes queued behind the one being sent
+#endif
 
 /***********************************************************
 ***********************typedef define***********************
@@ -30,10 +35,32 @@ typedef struct {
     SEM_HANDLE tx_sem;
 } DISP_SPI_SYNC_T;
 
+#if defined(DISPLAY_SPI_ASYNC_FLUSH) && (DISPLAY_SPI_ASYNC_FLUSH == 1)
+typedef enum {
+    DISP_SPI_FLUSH_FRAME = 0,
+    DISP_SPI_FLUSH_RECTS,
+} DISP_SPI_FLUSH_EVENT_E;
+
+typedef struct {
+    DISP_SPI_FLUSH_EVENT_E event;
+    TDL_DISP_FRAME_BUFF_T *frame_buff;
+    uint8_t rect_num;
+    TDL_DISP_RECT_T rects[TDL_DISP_RECT_MAX];
+} DISP_SPI_FLUSH_MSG_T;
+#endif
+
 typedef struct {
     DISP_SPI_BASE_CFG_T         cfg;
     const uint8_t              *init_seq;
     TDD_DISP_SPI_SET_WINDOW_CB  set_window_cb;
+    uint8_t                    *rect_buf;
+#if defined(DISPLAY_SPI_ASYNC_FLUSH) && (DISPLAY_SPI_ASYNC_FLUSH == 1)
+    THREAD_HANDLE               task;
+    QUEUE_HANDLE                queue;
+    MUTEX_HANDLE                mutex;
+    SEM_HANDLE                  done_sem;
+    volatile uint32_t           pending; // flushes queued or being sent
+#endif
 }DISP_SPI_DEV_T;
 
 /***********************************************************
@@ -155,6 +182,122 @@ static void __disp_spi_set_window(DISP_SPI_BASE_CFG_T *p_cfg, uint16_t x_start,
     tdl_disp_spi_send_data(p_cfg, lcd_data, 4);
 }
 
+static OPERATE_RET __disp_spi_frame_send(DISP_SPI_DEV_T *disp_spi_dev, TDL_DISP_FRAME_BUFF_T *frame_buff)
+{
+    if(disp_spi_dev->set_window_cb) {
+        disp_spi_dev->set_window_cb(&disp_spi_dev->cfg, 0, 0, frame_buff->width-1, frame_buff->height-1);
+    }else {
+        __disp_spi_set_window(&disp_spi_dev->cfg, 0, 0, frame_buff->width - 1, frame_buff->height - 1);
+    }
+
+    tdl_disp_spi_send_cmd(&disp_spi_dev->cfg, disp_spi_dev->cfg.cmd_ramwr);
+
+    return tdl_disp_spi_send_data(&disp_spi_dev->cfg, frame_buff->frame, frame_buff->len);
+}
+
+static OPERATE_RET __disp_spi_rect_data_send(void *arg, uint8_t *data, uint32_t len)
+{
+    return tdl_disp_spi_send_data((DISP_SPI_BASE_CFG_T *)arg, data, len);
+}
+
+static OPERATE_RET __disp_spi_rects_send(DISP_SPI_DEV_T *disp_spi_dev, TDL_DISP_FRAME_BUFF_T *frame_buff,
+                                         const TDL_DISP_RECT_T *rects, uint8_t rect_num)
+{
+    OPERATE_RET rt = OPRT_OK;
+    uint8_t i = 0;
+
+    // without it the rows of narrow rects are sent one by one
+    if (NULL == disp_spi_dev->rect_buf) {
+        disp_spi_dev->rect_buf = tal_malloc(DISP_SPI_RECT_BUF_LEN);
+    }
+
+    for (i = 0; i < rect_num; i++) {
+        if (disp_spi_dev->set_window_cb) {
+            disp_spi_dev->set_window_cb(&disp_spi_dev->cfg, rects[i].x1, rects[i].y1, rects[i].x2, rects[i].y2);
+        } else {
+            __disp_spi_set_window(&disp_spi_dev->cfg, rects[i].x1, rects[i].y1, rects[i].x2, rects[i].y2);
+        }
+
+        tdl_disp_spi_send_cmd(&disp_spi_dev->cfg, disp_spi_dev->cfg.cmd_ramwr);
+        TUYA_CALL_ERR_RETURN(tdl_disp_rect_send(frame_buff, &rects[i], disp_spi_dev->rect_buf, DISP_SPI_RECT_BUF_LEN,
+                                                __disp_spi_rect_data_send, &disp_spi_dev->cfg));
+    }
+
+    return rt;
+}
+
+#if defined(DISPLAY_SPI_ASYNC_FLUSH) && (DISPLAY_SPI_ASYNC_FLUSH == 1)
+static void __disp_spi_flush_task(void *arg)
+{
+    DISP_SPI_DEV_T *disp_spi_dev = (DISP_SPI_DEV_T *)arg;
+    DISP_SPI_FLUSH_MSG_T msg;
+    OPERATE_RET rt = OPRT_OK;
+
+    while (1) {
+        if (OPRT_OK != tal_queue_fetch(disp_spi_dev->queue, &msg, SEM_WAIT_FOREVER)) {
+            continue;
+        }
+
+        if (DISP_SPI_FLUSH_RECTS == msg.event) {
+            rt = __disp_spi_rects_send(disp_spi_dev, msg.frame_buff, msg.rects, msg.rect_num);
+        } else {
+            rt = __disp_spi_frame_send(disp_spi_dev, msg.frame_buff);
+        }
+        if (OPRT_OK != rt) {
+            PR_ERR("spi flush failed, rt:%d", rt);
+        }
+
+        // the panel keeps the frame in its gram, the frame buffer is free again
+        if (msg.frame_buff->free_cb) {
+            msg.frame_buff->free_cb(msg.frame_buff);
+        }
+
+        tal_mutex_lock(disp_spi_dev->mutex);
+        disp_spi_dev->pending--;
+        tal_mutex_unlock(disp_spi_dev->mutex);
+        tal_semaphore_post(disp_spi_dev->done_sem);
+    }
+}
+
+static OPERATE_RET __disp_spi_flush_post(DISP_SPI_DEV_T *disp_spi_dev, DISP_SPI_FLUSH_MSG_T *msg)
+{
+    OPERATE_RET rt = OPRT_OK;
+
+    tal_mutex_lock(disp_spi_dev->mutex);
+    disp_spi_dev->pending++;
+    tal_mutex_unlock(disp_spi_dev->mutex);
+
+    rt = tal_queue_post(disp_spi_dev->queue, msg, SEM_WAIT_FOREVER);
+    if (OPRT_OK != rt) {
+        tal_mutex_lock(disp_spi_dev->mutex);
+        disp_spi_dev->pending--;
+        tal_mutex_unlock(disp_spi_dev->mutex);
+    }
+
+    return rt;
+}
+
+static OPERATE_RET __disp_spi_flush_task_start(DISP_SPI_DEV_T *disp_spi_dev)
+{
+    OPERATE_RET rt = OPRT_OK;
+
+    if (disp_spi_dev->task) {
+        return OPRT_OK;
+    }
+
+    TUYA_CALL_ERR_RETURN(tal_mutex_create_init(&disp_spi_dev->mutex));
+    TUYA_CALL_ERR_RETURN(tal_semaphore_create_init(&disp_spi_dev->done_sem, 0, 1));
+    TUYA_CALL_ERR_RETURN(
+        tal_queue_create_init(&disp_spi_dev->queue, sizeof(DISP_SPI_FLUSH_MSG_T), DISP_SPI_FLUSH_QUEUE_NUM));
+
+    THREAD_CFG_T thread_cfg = {4096, THREAD_PRIO_1, "disp_spi_flush"};
+    TUYA_CALL_ERR_RETURN(
+        tal_thread_create_and_start(&disp_spi_dev->task, NULL, NULL, __disp_spi_flush_task, disp_spi_dev, &thread_cfg));
+
+    return rt;
+}
+#endif
+
 static OPERATE_RET __tdl_display_spi_open(TDD_DISP_DEV_HANDLE_T device)
 {
     DISP_SPI_DEV_T *disp_spi_dev = NULL;
@@ -168,31 +311,68 @@ static OPERATE_RET __tdl_display_spi_open(TDD_DISP_DEV_HANDLE_T device)
 
     tdl_disp_spi_init_seq(&(disp_spi_dev->cfg), disp_spi_dev->init_seq);
 
+#if defined(DISPLAY_SPI_ASYNC_FLUSH) && (DISPLAY_SPI_ASYNC_FLUSH == 1)
+    return __disp_spi_flush_task_start(disp_spi_dev);
+#else
     return OPRT_OK;
+#endif
 }
 
 static OPERATE_RET __tdl_display_spi_flush(TDD_DISP_DEV_HANDLE_T device, TDL_DISP_FRAME_BUFF_T *frame_buff)
+{
+    if (NULL == device || NULL == frame_buff) {
+        return OPRT_INVALID_PARM;
+    }
+
+#if defined(DISPLAY_SPI_ASYNC_FLUSH) && (DISPLAY_SPI_ASYNC_FLUSH == 1)
+    DISP_SPI_FLUSH_MSG_T msg = {.event = DISP_SPI_FLUSH_FRAME, .frame_buff = frame_buff};
+
+    return __disp_spi_flush_post((DISP_SPI_DEV_T *)device, &msg);
+#else
+    return __disp_spi_frame_send((DISP_SPI_DEV_T *)device, frame_buff);
+#endif
+}
+
+static OPERATE_RET __tdl_display_spi_flush_rects(TDD_DISP_DEV_HANDLE_T device, TDL_DISP_FRAME_BUFF_T *frame_buff,
+                                                 const TDL_DISP_RECT_T *rects, uint8_t rect_num)
+{
+    if (NULL == device || NULL == frame_buff || NULL == rects || rect_num > TDL_DISP_RECT_MAX) {
+        return OPRT_INVALID_PARM;
+    }
+
+#if defined(DISPLAY_SPI_ASYNC_FLUSH) && (DISPLAY_SPI_ASYNC_FLUSH == 1)
+    DISP_SPI_FLUSH_MSG_T msg = {.event = DISP_SPI_FLUSH_RECTS, .frame_buff = frame_buff, .rect_num = rect_num};
+
+    memcpy(msg.rects, rects, rect_num * sizeof(TDL_DISP_RECT_T));
+
+    return __disp_spi_flush_post((DISP_SPI_DEV_T *)device, &msg);
+#else
+    return __disp_spi_rects_send((DISP_SPI_DEV_T *)device, frame_buff, rects, rect_num);
+#endif
+}
+
+#if defined(DISPLAY_SPI_ASYNC_FLUSH) && (DISPLAY_SPI_ASYNC_FLUSH == 1)
+static OPERATE_RET __tdl_display_spi_flush_wait(TDD_DISP_DEV_HANDLE_T device, uint32_t timeout_ms)
 {
     OPERATE_RET rt = OPRT_OK;
     DISP_SPI_DEV_T *disp_spi_dev = NULL;
 
-    if (NULL == device || NULL == frame_buff) {
+    if (NULL == device) {
         return OPRT_INVALID_PARM;
     }
 
     disp_spi_dev = (DISP_SPI_DEV_T *)device;
 
-    if(disp_spi_dev->set_window_cb) {
-        disp_spi_dev->set_window_cb(&disp_spi_dev->cfg, 0, 0, frame_buff->width-1, frame_buff->height-1);
-    }else {
-        __disp_spi_set_window(&disp_spi_dev->cfg, 0, 0, frame_buff->width - 1, frame_buff->height - 1);
+    // drop the posts left from flushes nobody waited for, then wait for the pending ones
+    while (OPRT_OK == tal_semaphore_wait(disp_spi_dev->done_sem, 0)) {
+    }
+    while (disp_spi_dev->pending) {
+        TUYA_CALL_ERR_RETURN(tal_semaphore_wait(disp_spi_dev->done_sem, timeout_ms));
     }
-
-    tdl_disp_spi_send_cmd(&disp_spi_dev->cfg, disp_spi_dev->cfg.cmd_ramwr);
-    tdl_disp_spi_send_data(&disp_spi_dev->cfg, frame_buff->frame, frame_buff->len);
 
     return rt;
 }
+#endif
 
 static OPERATE_RET __tdl_display_spi_close(TDD_DISP_DEV_HANDLE_T device)
 {
@@ -406,6 +586,8 @@ OPERATE_RET tdl_disp_spi_device_register(char *name, TDD_DISP_SPI_CFG_T *spi)
     disp_spi_dev_info.height = spi->cfg.height;
     disp_spi_dev_info.fmt = spi->cfg.pixel_fmt;
     disp_spi_dev_info.rotation = spi->rotation;
+    disp_spi_dev_info.rect_x_align = spi->cfg.rect_align;
+    disp_spi_dev_info.rect_y_align = spi->cfg.rect_align;
 
     memcpy(&disp_spi_dev_info.bl, &spi->bl, sizeof(TUYA_DISPLAY_BL_CTRL_T));
     memcpy(&disp_spi_dev_info.power, &spi->power, sizeof(TUYA_DISPLAY_IO_CTRL_T));
@@ -414,6 +596,10 @@ OPERATE_RET tdl_disp_spi_device_register(char *name, TDD_DISP_SPI_CFG_T *spi)
         .open = __tdl_display_spi_open,
         .flush = __tdl_display_spi_flush,
         .close = __tdl_display_spi_close,
+        .flush_rects = __tdl_display_spi_flush_rects,
+#if defined(DISPLAY_SPI_ASYNC_FLUSH) && (DISPLAY_SPI_ASYNC_FLUSH == 1)
+        .flush_wait = __tdl_display_spi_flush_wait,
+#endif
     };
 
     TUYA_CALL_ERR_RETURN(
@@ -125,6 +125,48 @@ int tal_kv_free(uint8_t *value);
  */
 int tal_kv_del(const char *key);
 
+/**
+ * @brief Writes the pending values and deletions of the KV cache to flash.
+ *
+ * Pending entries only exist with ENABLE_KV_WRITE_BACK or inside a batch,
+ * call it before a reboot or a power down.
+ *
+ * @return 0 if every pending entry was written, or the error code of the first
+ * entry that failed.
+ */
+int tal_kv_flush(void);
+
+/**
+ * @brief Starts a batch of key-value updates.
+ *
+ * The sets and deletions until tal_kv_batch_commit are written together at
+ * commit, so related keys are updated in one flash pass. Batches can be
+ * nested. Needs ENABLE_KV_CACHE, otherwise updates are written immediately.
+ *
+ * @return 0 on success.
+ */
+int tal_kv_batch_begin(void);
+
+/**
+ * @brief Ends a batch of key-value updates and writes them to flash.
+ *
+ * @return 0 if the updates were written, or the error code of the first update
+ * that failed.
+ */
+int tal_kv_batch_commit(void);
+
+/**
+ * @brief Gets the bytes programmed and erased by the KV storage since boot.
+ *
+ * The counters include the files written through tal_fs, they share the
+ * littlefs partition with the keys.
+ *
+ * @param write_bytes Pointer to the bytes programmed, can be NULL.
+ * @param erase_bytes Pointer to the bytes erased, can be NULL.
+ * @return OPRT_OK on success.
+ */
+int tal_kv_flash_stat(uint32_t *write_bytes, uint32_t *erase_bytes);
+
 /**
  * @brief Serializes and sets the value of a key in the key-value database.
  *
@@ -0,0 +1,761 @@
+/**
+ * @file kv_log_store.c
+ * @brief Private log-structured key-value engine of tal_kv.
+ *
+ * Records are only appended, the sector with the smallest sequence number is
+ * the oldest. A deletion appends a tombstone, it is dropped when its sector
+ * is reclaimed: the sectors are reclaimed oldest first, so no older record of
+ * the key is left by then. The callers serialize the access to a store.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include <string.h>
+#include <stddef.h>
+#include "kv_log_store.h"
+#include "tal_memory.h"
+#include "tal_log.h"
+#include "crc32i.h"
+
+/***********************************************************
+*************************micro define***********************
+***********************************************************/
+#define KV_LOG_SECTOR_MAGIC 0x4C564B54 // "TKVL"
+#define KV_LOG_RECORD_MAGIC 0x4B56
+
+#define KV_LOG_FLAG_DEL 0x01
+
+#define KV_LOG_ALIGN(size) (((size) + 3) & ~3u)
+
+// free sectors kept for the reclaim, and the level where kv_log_gc starts
+#define KV_LOG_FREE_RESERVE 1
+#define KV_LOG_FREE_GC      2
+
+#define KV_LOG_INDEX_MIN 16
+#define KV_LOG_CHUNK     64
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t reserved;
+    uint32_t crc;
+} KV_LOG_SECTOR_HEAD_T;
+
+typedef struct {
+    uint16_t magic;
+    uint8_t flags;
+    uint8_t key_len;
+    uint32_t value_len;
+    uint32_t crc;
+} KV_LOG_RECORD_HEAD_T;
+
+#define KV_LOG_SECTOR_HEAD_SIZE sizeof(KV_LOG_SECTOR_HEAD_T)
+#define KV_LOG_RECORD_HEAD_SIZE sizeof(KV_LOG_RECORD_HEAD_T)
+
+#define KV_LOG_RECORD_SIZE(key_len, value_len) KV_LOG_ALIGN(KV_LOG_RECORD_HEAD_SIZE + (key_len) + (value_len))
+
+/***********************************************************
+*************************function define********************
+***********************************************************/
+static OPERATE_RET __kv_log_read(KV_LOG_STORE_T *store, uint32_t addr, void *buf, uint32_t size)
+{
+    return store->ops.read(store->start + addr, (uint8_t *)buf, size);
+}
+
+static OPERATE_RET __kv_log_write(KV_LOG_STORE_T *store, uint32_t addr, const void *buf, uint32_t size)
+{
+    return store->ops.write(store->start + addr, (const uint8_t *)buf, size);
+}
+
+static uint32_t __kv_log_hash(const char *key, uint32_t key_len)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    uint32_t i = 0;
+
+    for (i = 0; i < key_len; i++) {
+        hash = (hash ^ (uint8_t)key[i]) * 16777619u;
+    }
+
+    return hash;
+}
+
+static uint32_t __kv_log_crc_begin(uint32_t seq, const KV_LOG_RECORD_HEAD_T *head)
+{
+    uint32_t crc = hash_crc32i_init();
+
+    crc = hash_crc32i_update(crc, &seq, sizeof(seq));
+    return hash_crc32i_update(crc, head, offsetof(KV_LOG_RECORD_HEAD_T, crc));
+}
+
+static BOOL_T __kv_log_record_valid(KV_LOG_STORE_T *store, uint32_t addr, const KV_LOG_RECORD_HEAD_T *head)
+{
+    uint32_t offset = addr % store->sector_size;
+    uint32_t seq = store->sectors[addr / store->sector_size].seq;
+    uint32_t remain = head->key_len + head->value_len;
+    uint32_t crc = 0, size = 0;
+    uint8_t chunk[KV_LOG_CHUNK];
+
+    if (KV_LOG_RECORD_MAGIC != head->magic || 0 == head->key_len ||
+        head->value_len > store->sector_size - KV_LOG_SECTOR_HEAD_SIZE ||
+        KV_LOG_RECORD_SIZE(head->key_len, head->value_len) > store->sector_size - offset) {
+        return FALSE;
+    }
+
+    crc = __kv_log_crc_begin(seq, head);
+    addr += KV_LOG_RECORD_HEAD_SIZE;
+    while (remain) {
+        size = remain > KV_LOG_CHUNK ? KV_LOG_CHUNK : remain;
+        if (OPRT_OK != __kv_log_read(store, addr, chunk, size)) {
+            return FALSE;
+        }
+        crc = hash_crc32i_update(crc, chunk, size);
+        addr += size;
+        remain -= size;
+    }
+
+    return hash_crc32i_finish(crc) == head->crc;
+}
+
+static BOOL_T __kv_log_key_equal(KV_LOG_STORE_T *store, uint32_t addr, const char *key, uint32_t key_len,
+                                 KV_LOG_RECORD_HEAD_T *head)
+{
+    uint32_t offset = 0, size = 0;
+    uint8_t chunk[KV_LOG_CHUNK];
+
+    if (OPRT_OK != __kv_log_read(store, addr, head, KV_LOG_RECORD_HEAD_SIZE) || head->key_len != key_len) {
+        return FALSE;
+    }
+
+    addr += KV_LOG_RECORD_HEAD_SIZE;
+    for (offset = 0; offset < key_len; offset += size) {
+        size = (key_len - offset) > KV_LOG_CHUNK ? KV_LOG_CHUNK : (key_len - offset);
+        if (OPRT_OK != __kv_log_read(store, addr + offset, chunk, size) || memcmp(chunk, key + offset, size)) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+// return TRUE and the slot of the key, or FALSE and the empty slot to insert it
+static BOOL_T __kv_log_index_find(KV_LOG_STORE_T *store, const char *key, uint32_t key_len, uint32_t hash,
+                                  uint32_t *slot, KV_LOG_RECORD_HEAD_T *head)
+{
+    uint32_t i = hash & store->slot_mask;
+
+    for (; store->slots[i].addr; i = (i + 1) & store->slot_mask) {
+        if (store->slots[i].hash == hash && __kv_log_key_equal(store, store->slots[i].addr, key, key_len, head)) {
+            *slot = i;
+            return TRUE;
+        }
+    }
+    *slot = i;
+
+    return FALSE;
+}
+
+static OPERATE_RET __kv_log_index_resize(KV_LOG_STORE_T *store, uint32_t slot_num)
+{
+    KV_LOG_SLOT_T *slots = tal_malloc(slot_num * sizeof(KV_LOG_SLOT_T));
+    uint32_t i = 0, j = 0;
+
+    if (NULL == slots) {
+        return OPRT_MALLOC_FAILED;
+    }
+    memset(slots, 0, slot_num * sizeof(KV_LOG_SLOT_T));
+
+    if (store->slots) {
+        for (i = 0; i <= store->slot_mask; i++) {
+            if (0 == store->slots[i].addr) {
+                continue;
+            }
+            for (j = store->slots[i].hash & (slot_num - 1); slots[j].addr; j = (j + 1) & (slot_num - 1)) {
+            }
+            slots[j] = store->slots[i];
+        }
+        tal_free(store->slots);
+    }
+    store->slots = slots;
+    store->slot_mask = slot_num - 1;
+
+    return OPRT_OK;
+}
+
+// keep the load under 3/4 so an insert never fails after the record is written
+static OPERATE_RET __kv_log_index_reserve(KV_LOG_STORE_T *store)
+{
+    if ((store->count + 1) * 4 <= (store->slot_mask + 1) * 3) {
+        return OPRT_OK;
+    }
+
+    return __kv_log_index_resize(store, (store->slot_mask + 1) * 2);
+}
+
+// linear probing removal, shift back the entries that probed past the slot
+static void __kv_log_index_remove(KV_LOG_STORE_T *store, uint32_t slot)
+{
+    uint32_t i = slot, j = slot, k = 0;
+
+    for (;;) {
+        j = (j + 1) & store->slot_mask;
+        if (0 == store->slots[j].addr) {
+            break;
+        }
+        k = store->slots[j].hash & store->slot_mask;
+        if ((i <= j) ? (i < k && k <= j) : (i < k || k <= j)) {
+            continue;
+        }
+        store->slots[i] = store->slots[j];
+        i = j;
+    }
+    store->slots[i].addr = 0;
+    store->count--;
+}
+
+// point the index to a new record, superseded records become garbage
+static void __kv_log_index_apply(KV_LOG_STORE_T *store, const char *key, uint32_t key_len, uint32_t addr,
+                                 const KV_LOG_RECORD_HEAD_T *head)
+{
+    KV_LOG_RECORD_HEAD_T old;
+    uint32_t hash = __kv_log_hash(key, key_len);
+    uint32_t slot = 0;
+    BOOL_T found = __kv_log_index_find(store, key, key_len, hash, &slot, &old);
+
+    if (found) {
+        store->sectors[store->slots[slot].addr / store->sector_size].garbage +=
+            KV_LOG_RECORD_SIZE(old.key_len, old.value_len);
+    }
+
+    if (head->flags & KV_LOG_FLAG_DEL) {
+        store->sectors[addr / store->sector_size].garbage += KV_LOG_RECORD_SIZE(head->key_len, head->value_len);
+        if (found) {
+            __kv_log_index_remove(store, slot);
+        }
+    } else if (found) {
+        store->slots[slot].addr = addr;
+    } else {
+        store->slots[slot].hash = hash;
+        store->slots[slot].addr = addr;
+        store->count++;
+    }
+}
+
+static OPERATE_RET __kv_log_sector_open(KV_LOG_STORE_T *store)
+{
+    KV_LOG_SECTOR_HEAD_T head;
+    uint32_t i = 0, sector = 0;
+
+    // take the first free sector after the head so the erases go round the region
+    for (i = 1; i <= store->sector_num; i++) {
+        sector = (store->head + i) % store->sector_num;
+        if (0 == store->sectors[sector].seq) {
+            break;
+        }
+    }
+    if (i > store->sector_num) {
+        return OPRT_KVS_WR_FAIL;
+    }
+
+    head.magic = KV_LOG_SECTOR_MAGIC;
+    head.seq = store->seq_next;
+    head.reserved = 0xFFFFFFFF;
+    head.crc = hash_crc32i_total(&head, offsetof(KV_LOG_SECTOR_HEAD_T, crc));
+    if (OPRT_OK != store->ops.erase(store->start + sector * store->sector_size, store->sector_size) ||
+        OPRT_OK != __kv_log_write(store, sector * store->sector_size, &head, sizeof(head))) {
+        PR_ERR("kv log open sector %d fail", sector);
+        return OPRT_KVS_WR_FAIL;
+    }
+
+    store->seq_next++;
+    store->sectors[sector].seq = head.seq;
+    store->sectors[sector].end = KV_LOG_SECTOR_HEAD_SIZE;
+    store->sectors[sector].garbage = 0;
+    store->sectors[sector].full = FALSE;
+    store->free_num--;
+    store->head = sector;
+
+    return OPRT_OK;
+}
+
+static uint32_t __kv_log_oldest(KV_LOG_STORE_T *store)
+{
+    uint32_t i = 0, oldest = store->sector_num;
+
+    for (i = 0; i < store->sector_num; i++) {
+        if (i == store->head || 0 == store->sectors[i].seq) {
+            continue;
+        }
+        if (oldest == store->sector_num || store->sectors[i].seq < store->sectors[oldest].seq) {
+            oldest = i;
+        }
+    }
+
+    return oldest;
+}
+
+static OPERATE_RET __kv_log_reserve(KV_LOG_STORE_T *store, uint32_t size, BOOL_T for_gc);
+
+static OPERATE_RET __kv_log_erase(KV_LOG_STORE_T *store, uint32_t sector)
+{
+    uint32_t magic = 0;
+
+    // clear the magic first, the sector stays free even if the erase is cut or not supported
+    __kv_log_write(store, sector * store->sector_size, &magic, sizeof(magic));
+
+    return store->ops.erase(store->start + sector * store->sector_size, store->sector_size);
+}
+
+// fill the crc of a record built in buf and program it at the end of the head
+static OPERATE_RET __kv_log_program(KV_LOG_STORE_T *store, uint8_t *buf, uint32_t size, uint32_t *addr)
+{
+    KV_LOG_RECORD_HEAD_T *head = (KV_LOG_RECORD_HEAD_T *)buf;
+    uint32_t crc = __kv_log_crc_begin(store->sectors[store->head].seq, head);
+
+    crc = hash_crc32i_update(crc, buf + KV_LOG_RECORD_HEAD_SIZE, head->key_len + head->value_len);
+    head->crc = hash_crc32i_finish(crc);
+
+    *addr = store->head * store->sector_size + store->sectors[store->head].end;
+    if (OPRT_OK != __kv_log_write(store, *addr, buf, size)) {
+        // the sector may hold a broken record now, move on to a new one
+        store->sectors[store->head].full = TRUE;
+        PR_ERR("kv log write %d fail", *addr);
+        return OPRT_KVS_WR_FAIL;
+    }
+    store->sectors[store->head].end += size;
+
+    return OPRT_OK;
+}
+
+// copy a live record to the head
+static OPERATE_RET __kv_log_record_move(KV_LOG_STORE_T *store, uint32_t slot, const KV_LOG_RECORD_HEAD_T *head)
+{
+    OPERATE_RET rt = OPRT_OK;
+    uint32_t size = KV_LOG_RECORD_SIZE(head->key_len, head->value_len);
+    uint32_t addr = 0;
+    uint8_t *buf = tal_malloc(size);
+
+    if (NULL == buf) {
+        return OPRT_MALLOC_FAILED;
+    }
+    TUYA_CALL_ERR_GOTO(__kv_log_read(store, store->slots[slot].addr, buf, size), __exit);
+    TUYA_CALL_ERR_GOTO(__kv_log_reserve(store, size, TRUE), __exit);
+    TUYA_CALL_ERR_GOTO(__kv_log_program(store, buf, size, &addr), __exit);
+    store->slots[slot].addr = addr;
+
+__exit:
+    tal_free(buf);
+    return rt;
+}
+
+// move the live records of the oldest sector to the head and erase it
+static OPERATE_RET __kv_log_gc_sector(KV_LOG_STORE_T *store)
+{
+    OPERATE_RET rt = OPRT_OK;
+    KV_LOG_RECORD_HEAD_T head, live;
+    uint32_t sector = __kv_log_oldest(store);
+    uint32_t addr = 0, end = 0, slot = 0;
+    char key[KV_LOG_KEY_MAX + 1];
+
+    if (sector == store->sector_num) {
+        return OPRT_KVS_WR_FAIL;
+    }
+
+    addr = sector * store->sector_size + KV_LOG_SECTOR_HEAD_SIZE;
+    end = sector * store->sector_size + store->sectors[sector].end;
+    while (addr < end) {
+        TUYA_CALL_ERR_RETURN(__kv_log_read(store, addr, &head, KV_LOG_RECORD_HEAD_SIZE));
+        if (0 == (head.flags & KV_LOG_FLAG_DEL)) {
+            TUYA_CALL_ERR_RETURN(__kv_log_read(store, addr + KV_LOG_RECORD_HEAD_SIZE, key, head.key_len));
+            if (__kv_log_index_find(store, key, head.key_len, __kv_log_hash(key, head.key_len), &slot, &live) &&
+                store->slots[slot].addr == addr) {
+                rt = __kv_log_record_move(store, slot, &live);
+                if (OPRT_OK != rt) {
+                    PR_ERR("kv log move fail %d", rt);
+                    return rt;
+                }
+            }
+        }
+        addr += KV_LOG_RECORD_SIZE(head.key_len, head.value_len);
+    }
+
+    if (OPRT_OK != __kv_log_erase(store, sector)) {
+        return OPRT_KVS_WR_FAIL;
+    }
+    memset(&store->sectors[sector], 0, sizeof(KV_LOG_SECTOR_T));
+    store->free_num++;
+
+    return OPRT_OK;
+}
+
+// make room for size bytes in the head sector
+static OPERATE_RET __kv_log_reserve(KV_LOG_STORE_T *store, uint32_t size, BOOL_T for_gc)
+{
+    OPERATE_RET rt = OPRT_OK;
+    uint32_t i = 0;
+
+    for (i = 0; i < store->sector_num; i++) {
+        if (!store->sectors[store->head].full && store->sectors[store->head].end + size <= store->sector_size) {
+            return OPRT_OK;
+        }
+        if (for_gc || store->free_num > KV_LOG_FREE_RESERVE) {
+            return __kv_log_sector_open(store);
+        }
+        // the moved records may leave room in the head, check again
+        rt = __kv_log_gc_sector(store);
+        if (OPRT_OK != rt) {
+            return rt;
+        }
+    }
+    PR_ERR("kv log full");
+
+    return OPRT_KVS_WR_FAIL;
+}
+
+static OPERATE_RET __kv_log_append(KV_LOG_STORE_T *store, const char *key, uint32_t key_len, uint8_t flags,
+                                   const uint8_t *value, uint32_t length)
+{
+    OPERATE_RET rt = OPRT_OK;
+    KV_LOG_RECORD_HEAD_T *head = NULL;
+    uint32_t size = KV_LOG_RECORD_SIZE(key_len, length);
+    uint32_t addr = 0;
+    uint8_t *buf = NULL;
+
+    if (size > store->sector_size - KV_LOG_SECTOR_HEAD_SIZE) {
+        return OPRT_EXCEED_UPPER_LIMIT;
+    }
+    TUYA_CALL_ERR_RETURN(__kv_log_index_reserve(store));
+    TUYA_CALL_ERR_RETURN(__kv_log_reserve(store, size, FALSE));
+
+    // one program per record
+    buf = tal_malloc(size);
+    if (NULL == buf) {
+        return OPRT_MALLOC_FAILED;
+    }
+    memset(buf, 0xFF, size);
+    head = (KV_LOG_RECORD_HEAD_T *)buf;
+    head->magic = KV_LOG_RECORD_MAGIC;
+    head->flags = flags;
+    head->key_len = key_len;
+    head->value_len = length;
+    memcpy(buf + KV_LOG_RECORD_HEAD_SIZE, key, key_len);
+    if (length) {
+        memcpy(buf + KV_LOG_RECORD_HEAD_SIZE + key_len, value, length);
+    }
+
+    rt = __kv_log_program(store, buf, size, &addr);
+    if (OPRT_OK == rt) {
+        __kv_log_index_apply(store, key, key_len, addr, head);
+    }
+    tal_free(buf);
+
+    return rt;
+}
+
+static void __kv_log_sector_scan(KV_LOG_STORE_T *store, uint32_t sector)
+{
+    KV_LOG_RECORD_HEAD_T head;
+    uint32_t base = sector * store->sector_size;
+    uint32_t offset = KV_LOG_SECTOR_HEAD_SIZE;
+    char key[KV_LOG_KEY_MAX + 1];
+
+    while (offset + KV_LOG_RECORD_HEAD_SIZE <= store->sector_size) {
+        if (OPRT_OK != __kv_log_read(store, base + offset, &head, KV_LOG_RECORD_HEAD_SIZE) ||
+            !__kv_log_record_valid(store, base + offset, &head) ||
+            OPRT_OK != __kv_log_read(store, base + offset + KV_LOG_RECORD_HEAD_SIZE, key, head.key_len)) {
+            break;
+        }
+        key[head.key_len] = 0;
+        if (OPRT_OK != __kv_log_index_reserve(store)) {
+            break;
+        }
+        __kv_log_index_apply(store, key, head.key_len, base + offset, &head);
+        offset += KV_LOG_RECORD_SIZE(head.key_len, head.value_len);
+    }
+    store->sectors[sector].end = offset;
+}
+
+// the head can only take more records if the rest of it is still erased
+static BOOL_T __kv_log_sector_clean(KV_LOG_STORE_T *store, uint32_t sector)
+{
+    uint32_t offset = store->sectors[sector].end, size = 0, i = 0;
+    uint8_t chunk[KV_LOG_CHUNK];
+
+    for (; offset < store->sector_size; offset += size) {
+        size = (store->sector_size - offset) > KV_LOG_CHUNK ? KV_LOG_CHUNK : (store->sector_size - offset);
+        if (OPRT_OK != __kv_log_read(store, sector * store->sector_size + offset, chunk, size)) {
+            return FALSE;
+        }
+        for (i = 0; i < size; i++) {
+            if (0xFF != chunk[i]) {
+                return FALSE;
+            }
+        }
+    }
+
+    return TRUE;
+}
+
+// rebuild the sector table and the index from the flash
+static OPERATE_RET __kv_log_replay(KV_LOG_STORE_T *store)
+{
+    OPERATE_RET rt = OPRT_OK;
+    KV_LOG_SECTOR_HEAD_T head;
+    uint32_t i = 0, next = 0, last_seq = 0;
+
+    memset(store->sectors, 0, store->sector_num * sizeof(KV_LOG_SECTOR_T));
+    if (store->slots) {
+        tal_free(store->slots);
+        store->slots = NULL;
+    }
+    store->count = 0;
+    store->free_num = 0;
+    TUYA_CALL_ERR_RETURN(__kv_log_index_resize(store, KV_LOG_INDEX_MIN));
+
+    for (i = 0; i < store->sector_num; i++) {
+        TUYA_CALL_ERR_RETURN(__kv_log_read(store, i * store->sector_size, &head, sizeof(head)));
+        if (KV_LOG_SECTOR_MAGIC == head.magic && 0 != head.seq &&
+            head.crc == hash_crc32i_total(&head, offsetof(KV_LOG_SECTOR_HEAD_T, crc))) {
+            store->sectors[i].seq = head.seq;
+        } else {
+            store->free_num++;
+        }
+    }
+
+    // replay the sectors oldest first, the newest one is the head
+    for (;;) {
+        next = store->sector_num;
+        for (i = 0; i < store->sector_num; i++) {
+            if (store->sectors[i].seq > last_seq &&
+                (next == store->sector_num || store->sectors[i].seq < store->sectors[next].seq)) {
+                next = i;
+            }
+        }
+        if (next == store->sector_num) {
+            break;
+        }
+        __kv_log_sector_scan(store, next);
+        last_seq = store->sectors[next].seq;
+        store->head = next;
+    }
+    store->seq_next = last_seq + 1;
+
+    return OPRT_OK;
+}
+
+/**
+ * @brief mount the store, an empty or foreign region is formatted
+ *
+ * @param[out] store store handle
+ * @param[in] ops flash access functions
+ * @param[in] start start address of the region
+ * @param[in] sector_size erase block size
+ * @param[in] sector_num number of sectors, at least 3
+ *
+ * @return OPRT_OK on success, others on error
+ */
+OPERATE_RET kv_log_mount(KV_LOG_STORE_T *store, const KV_LOG_FLASH_OPS_T *ops, uint32_t start, uint32_t sector_size,
+                         uint32_t sector_num)
+{
+    OPERATE_RET rt = OPRT_OK;
+
+    if (NULL == store || NULL == ops || sector_num < KV_LOG_FREE_RESERVE + 2 ||
+        sector_size < KV_LOG_SECTOR_HEAD_SIZE + KV_LOG_RECORD_SIZE(KV_LOG_KEY_MAX, 0)) {
+        return OPRT_INVALID_PARM;
+    }
+
+    memset(store, 0, sizeof(KV_LOG_STORE_T));
+    store->ops = *ops;
+    store->start = start;
+    store->sector_size = sector_size;
+    store->sector_num = sector_num;
+    store->sectors = tal_malloc(sector_num * sizeof(KV_LOG_SECTOR_T));
+    if (NULL == store->sectors) {
+        return OPRT_MALLOC_FAILED;
+    }
+    TUYA_CALL_ERR_GOTO(__kv_log_replay(store), __exit);
+
+    if (store->free_num < KV_LOG_FREE_RESERVE) {
+        // only a cut reclaim takes the reserved sector, the newest sector then only holds
+        // copies of records still in the oldest one
+        PR_WARN("kv log drop unfinished reclaim");
+        TUYA_CALL_ERR_GOTO(__kv_log_erase(store, store->head), __exit);
+        TUYA_CALL_ERR_GOTO(__kv_log_replay(store), __exit);
+    }
+
+    if (1 == store->seq_next) {
+        store->head = sector_num - 1;
+        TUYA_CALL_ERR_GOTO(__kv_log_sector_open(store), __exit);
+    } else if (!__kv_log_sector_clean(store, store->head)) {
+        // a write was cut, do not program over it
+        store->sectors[store->head].full = TRUE;
+    }
+    PR_DEBUG("kv log mount %d keys, %d free sectors", store->count, store->free_num);
+
+    return OPRT_OK;
+
+__exit:
+    kv_log_unmount(store);
+    return rt;
+}
+
+/**
+ * @brief release the RAM of the store, the flash is not changed
+ *
+ * @param[in] store store handle
+ */
+void kv_log_unmount(KV_LOG_STORE_T *store)
+{
+    if (store->sectors) {
+        tal_free(store->sectors);
+        store->sectors = NULL;
+    }
+    if (store->slots) {
+        tal_free(store->slots);
+        store->slots = NULL;
+    }
+    store->count = 0;
+}
+
+/**
+ * @brief append a value
+ *
+ * @param[in] store store handle
+ * @param[in] key key, at most KV_LOG_KEY_MAX bytes
+ * @param[in] value value
+ * @param[in] length value length
+ *
+ * @return OPRT_OK on success, OPRT_EXCEED_UPPER_LIMIT if the record does not
+ * fit in a sector, OPRT_KVS_WR_FAIL if the store is full or the flash fails
+ */
+OPERATE_RET kv_log_set(KV_LOG_STORE_T *store, const char *key, const uint8_t *value, uint32_t length)
+{
+    uint32_t key_len = strlen(key);
+
+    if (0 == key_len || key_len > KV_LOG_KEY_MAX) {
+        return OPRT_INVALID_PARM;
+    }
+
+    return __kv_log_append(store, key, key_len, 0, value, length);
+}
+
+/**
+ * @brief read a value
+ *
+ * @param[in] store store handle
+ * @param[in] key key
+ * @param[out] value value, a 0 is appended, free it with tal_free
+ * @param[out] length value length
+ *
+ * @return OPRT_OK on success, OPRT_NOT_FOUND if the key does not exist
+ */
+OPERATE_RET kv_log_get(KV_LOG_STORE_T *store, const char *key, uint8_t **value, uint32_t *length)
+{
+    KV_LOG_RECORD_HEAD_T head;
+    uint32_t key_len = strlen(key);
+    uint32_t slot = 0;
+    uint8_t *data = NULL;
+
+    if (!__kv_log_index_find(store, key, key_len, __kv_log_hash(key, key_len), &slot, &head)) {
+        return OPRT_NOT_FOUND;
+    }
+
+    data = tal_malloc(head.value_len + 1);
+    if (NULL == data) {
+        return OPRT_MALLOC_FAILED;
+    }
+    if (OPRT_OK !=
+        __kv_log_read(store, store->slots[slot].addr + KV_LOG_RECORD_HEAD_SIZE + key_len, data, head.value_len)) {
+        tal_free(data);
+        return OPRT_KVS_RD_FAIL;
+    }
+    data[head.value_len] = 0;
+    *value = data;
+    *length = head.value_len;
+
+    return OPRT_OK;
+}
+
+/**
+ * @brief append a deletion
+ *
+ * @param[in] store store handle
+ * @param[in] key key
+ *
+ * @return OPRT_OK on success, OPRT_NOT_FOUND if the key does not exist
+ */
+OPERATE_RET kv_log_del(KV_LOG_STORE_T *store, const char *key)
+{
+    KV_LOG_RECORD_HEAD_T head;
+    uint32_t key_len = strlen(key);
+    uint32_t slot = 0;
+
+    if (!__kv_log_index_find(store, key, key_len, __kv_log_hash(key, key_len), &slot, &head)) {
+        return OPRT_NOT_FOUND;
+    }
+
+    return __kv_log_append(store, key, key_len, KV_LOG_FLAG_DEL, NULL, 0);
+}
+
+/**
+ * @brief check if kv_log_gc has work to do
+ *
+ * @param[in] store store handle
+ *
+ * @return TRUE if kv_log_gc would reclaim a sector
+ */
+BOOL_T kv_log_gc_needed(KV_LOG_STORE_T *store)
+{
+    uint32_t oldest = 0;
+
+    if (store->free_num > KV_LOG_FREE_GC) {
+        return FALSE;
+    }
+    oldest = __kv_log_oldest(store);
+
+    return (oldest != store->sector_num && store->sectors[oldest].garbage) ? TRUE : FALSE;
+}
+
+/**
+ * @brief reclaim the oldest sector ahead of time when few sectors are free
+ *
+ * @param[in] store store handle
+ *
+ * @return TRUE if a sector was reclaimed
+ */
+BOOL_T kv_log_gc(KV_LOG_STORE_T *store)
+{
+    if (!kv_log_gc_needed(store)) {
+        return FALSE;
+    }
+
+    return (OPRT_OK == __kv_log_gc_sector(store)) ? TRUE : FALSE;
+}
+
+/**
+ * @brief call cb for every live key
+ *
+ * @param[in] store store handle
+ * @param[in] cb callback, must not modify the store
+ * @param[in] arg callback argument
+ */
+void kv_log_foreach(KV_LOG_STORE_T *store, KV_LOG_ITER_CB cb, void *arg)
+{
+    KV_LOG_RECORD_HEAD_T head;
+    uint32_t i = 0;
+    char key[KV_LOG_KEY_MAX + 1];
+
+    for (i = 0; i <= store->slot_mask; i++) {
+        if (0 == store->slots[i].addr ||
+            OPRT_OK != __kv_log_read(store, store->slots[i].addr, &head, KV_LOG_RECORD_HEAD_SIZE) ||
+            OPRT_OK != __kv_log_read(store, store->slots[i].addr + KV_LOG_RECORD_HEAD_SIZE, key, head.key_len)) {
+            continue;
+        }
+        key[head.key_len] = 0;
+        cb(key, head.value_len, arg);
+    }
+}
@@ -0,0 +1,165 @@
+/**
+ * @file kv_log_store.h
+ * @brief Private log-structured key-value engine of tal_kv.
+ *
+ * The store appends every set or delete as a record to a flash region cut in
+ * sectors of one erase block, nothing is rewritten in place. A hash index in
+ * RAM maps each live key to the address of its newest record, it is rebuilt
+ * by scanning the records at mount. Superseded records are reclaimed by
+ * copying the live records of the oldest sector to the head and erasing it,
+ * one sector always stays free for this.
+ *
+ * Sector layout: magic(4) seq(4) reserved(4) crc(4), then the records.
+ * Record layout: magic(2) flags(1) key_len(1) value_len(4) crc(4) key value,
+ * padded to 4 bytes. The record crc covers the sequence number of its sector,
+ * so data left by an erase that did not happen is never taken as a record.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#ifndef __KV_LOG_STORE_H__
+#define __KV_LOG_STORE_H__
+
+#include "tuya_cloud_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***********************************************************
+*************************micro define***********************
+***********************************************************/
+#define KV_LOG_KEY_MAX 255
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+typedef struct {
+    OPERATE_RET (*read)(uint32_t addr, uint8_t *dst, uint32_t size);
+    OPERATE_RET (*write)(uint32_t addr, const uint8_t *src, uint32_t size);
+    OPERATE_RET (*erase)(uint32_t addr, uint32_t size);
+} KV_LOG_FLASH_OPS_T;
+
+typedef struct {
+    uint32_t seq;     // 0 if the sector is free
+    uint32_t end;     // offset after the last record
+    uint32_t garbage; // bytes of superseded records
+    BOOL_T full;      // no more records, a write was cut after end
+} KV_LOG_SECTOR_T;
+
+typedef struct {
+    uint32_t hash;
+    uint32_t addr; // offset of the record in the region, 0 if the slot is empty
+} KV_LOG_SLOT_T;
+
+typedef struct {
+    KV_LOG_FLASH_OPS_T ops;
+    uint32_t start;
+    uint32_t sector_size;
+    uint32_t sector_num;
+    KV_LOG_SECTOR_T *sectors;
+    uint32_t head;     // sector receiving the records
+    uint32_t seq_next; // sequence number of the next sector put in use
+    uint32_t free_num;
+    KV_LOG_SLOT_T *slots;
+    uint32_t slot_mask;
+    uint32_t count; // live keys
+} KV_LOG_STORE_T;
+
+typedef void (*KV_LOG_ITER_CB)(const char *key, uint32_t length, void *arg);
+
+/***********************************************************
+********************function declaration********************
+***********************************************************/
+/**
+ * @brief mount the store, an empty or foreign region is formatted
+ *
+ * @param[out] store store handle
+ * @param[in] ops flash access functions
+ * @param[in] start start address of the region
+ * @param[in] sector_size erase block size
+ * @param[in] sector_num number of sectors, at least 3
+ *
+ * @return OPRT_OK on success, others on error
+ */
+OPERATE_RET kv_log_mount(KV_LOG_STORE_T *store, const KV_LOG_FLASH_OPS_T *ops, uint32_t start, uint32_t sector_size,
+                         uint32_t sector_num);
+
+/**
+ * @brief release the RAM of the store, the flash is not changed
+ *
+ * @param[in] store store handle
+ */
+void kv_log_unmount(KV_LOG_STORE_T *store);
+
+/**
+ * @brief append a value
+ *
+ * @param[in] store store handle
+ * @param[in] key key, at most KV_LOG_KEY_MAX bytes
+ * @param[in] value value
+ * @param[in] length value length
+ *
+ * @return OPRT_OK on success, OPRT_EXCEED_UPPER_LIMIT if the record does not
+ * fit in a sector, OPRT_KVS_WR_FAIL if the store is full or the flash fails
+ */
+OPERATE_RET kv_log_set(KV_LOG_STORE_T *store, const char *key, const uint8_t *value, uint32_t length);
+
+/**
+ * @brief read a value
+ *
+ * @param[in] store store handle
+ * @param[in] key key
+ * @param[out] value value, a 0 is appended, free it with tal_free
+ * @param[out] length value length
+ *
+ * @return OPRT_OK on success, OPRT_NOT_FOUND if the key does not exist
+ */
+OPERATE_RET kv_log_get(KV_LOG_STORE_T *store, const char *key, uint8_t **value, uint32_t *length);
+
+/**
+ * @brief append a deletion
+ *
+ * @param[in] store store handle
+ * @param[in] key key
+ *
+ * @return OPRT_OK on success, OPRT_NOT_FOUND if the key does not exist
+ */
+OPERATE_RET kv_log_del(KV_LOG_STORE_T *store, const char *key);
+
+/**
+ * @brief reclaim the oldest sector ahead of time when few sectors are free
+ *
+ * Writes reclaim sectors by themselves when the store runs out of free
+ * sectors, calling this from an idle context keeps that work off the writes.
+ *
+ * @param[in] store store handle
+ *
+ * @return TRUE if a sector was reclaimed
+ */
+BOOL_T kv_log_gc(KV_LOG_STORE_T *store);
+
+/**
+ * @brief check if kv_log_gc has work to do
+ *
+ * @param[in] store store handle
+ *
+ * @return TRUE if kv_log_gc would reclaim a sector
+ */
+BOOL_T kv_log_gc_needed(KV_LOG_STORE_T *store);
+
+/**
+ * @brief call cb for every live key
+ *
+ * @param[in] store store handle
+ * @param[in] cb callback, must not modify the store
+ * @param[in] arg callback argument
+ */
+void kv_log_foreach(KV_LOG_STORE_T *store, KV_LOG_ITER_CB cb, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KV_LOG_STORE_H__ */
@@ -29,12 +29,59 @@
 #include "tkl_flash.h"
 #include "tal_api.h"
 #include "tal_security.h"
+#if defined(KV_BACKEND_LOG) && (KV_BACKEND_LOG == 1)
+#include "kv_log_store.h"
+#endif
+
+#if defined(ENABLE_KV_CACHE) && (ENABLE_KV_CACHE == 1)
+#ifndef KV_CACHE_MAX_SIZE
+#define KV_CACHE_MAX_SIZE 4096
+#endif
+// larger values are not cached, so a few of them can not flush the whole cache
+#define KV_CACHE_ENTRY_MAX_SIZE (KV_CACHE_MAX_SIZE / 4)
+
+#ifndef KV_WRITE_BACK_DELAY_MS
+#define KV_WRITE_BACK_DELAY_MS 2000
+#endif
+
+#define KV_ENTRY_CLEAN 0 // same as flash
+#define KV_ENTRY_DIRTY 1 // value or deletion not written to flash yet
+
+typedef struct {
+    LIST_HEAD node;
+    uint8_t state;
+    size_t length;
+    uint8_t *value; // decrypted value, NULL if the key does not exist
+    char key[0];
+} KV_CACHE_ENTRY_T;
+
+typedef struct {
+    LIST_HEAD lru; // most recently used first
+    uint32_t size; // bytes of entries, keys and values
+    uint32_t batch_depth;
+#if defined(ENABLE_KV_WRITE_BACK) && (ENABLE_KV_WRITE_BACK == 1)
+    TIMER_ID flush_timer;
+#endif
+} KV_CACHE_T;
+
+#define __kv_cache_entry_size(key, length) (sizeof(KV_CACHE_ENTRY_T) + strlen(key) + 1 + (length))
+#endif
 
 // variables used by the filesystem
 static lfs_t lfs;
 static lfs_size_t lfs_flash_addr;
 static tal_kv_cfg_t lfs_kv_cfg;
 static MUTEX_HANDLE lfs_mutex;
+#if defined(ENABLE_KV_CACHE) && (ENABLE_KV_CACHE == 1)
+static KV_CACHE_T kv_cache;
+#endif
+#if defined(KV_BACKEND_LOG) && (KV_BACKEND_LOG == 1)
+static KV_LOG_STORE_T kv_log;
+static BOOL_T kv_log_ready;
+static BOOL_T kv_log_gc_pending;
+#endif
+static uint32_t kv_flash_write_bytes;
+static uint32_t kv_flash_erase_bytes;
 
 extern int kv_serialize(const kv_db_t *db, const uint32_t dbcnt, char **out, uint32_t *out_len);
 extern int kv_deserialize(const char *in, kv_db_t *db, const uint32_t dbcnt);
@@ -87,6 +134,7 @@ int user_provided_block_device_prog(const struct lfs_config *c, lfs_block_t bloc
     if (OPRT_OK != ret) {
         return LFS_ERR_IO;
     }
+    kv_flash_write_bytes += size;
     return LFS_ERR_OK;
 }
 
@@ -108,6 +156,7 @@ int user_provided_block_device_erase(const struct lfs_config *c, lfs_block_t blo
     if (OPRT_OK != ret) {
         return LFS_ERR_IO;
     }
+    kv_flash_erase_bytes += c->block_size;
     return LFS_ERR_OK;
 }
 
@@ -126,6 +175,76 @@ int user_provided_block_device_sync(const struct lfs_config *c)
     return LFS_ERR_OK;
 }
 
+#if defined(KV_BACKEND_LOG) && (KV_BACKEND_LOG == 1)
+static OPERATE_RET __kv_log_flash_write(uint32_t addr, const uint8_t *src, uint32_t size)
+{
+    OPERATE_RET ret = tkl_flash_write(addr, src, size);
+
+    if (OPRT_OK == ret) {
+        kv_flash_write_bytes += size;
+    }
+    return ret;
+}
+
+static OPERATE_RET __kv_log_flash_erase(uint32_t addr, uint32_t size)
+{
+    OPERATE_RET ret = tkl_flash_erase(addr, size);
+
+    if (OPRT_OK == ret) {
+        kv_flash_erase_bytes += size;
+    }
+    return ret;
+}
+
+static void __kv_log_init(void)
+{
+    TUYA_FLASH_BASE_INFO_T info;
+    KV_LOG_FLASH_OPS_T ops = {tkl_flash_read, __kv_log_flash_write, __kv_log_flash_erase};
+
+    memset(&info, 0, sizeof(info));
+    if (OPRT_OK != tkl_flash_get_one_type_info(TUYA_FLASH_TYPE_KV_DATA, &info) || 0 == info.partition_num ||
+        0 == info.partition[0].block_size) {
+        PR_ERR("no kv data partition, use littlefs");
+        return;
+    }
+
+    if (OPRT_OK != kv_log_mount(&kv_log, &ops, info.partition[0].start_addr, info.partition[0].block_size,
+                                info.partition[0].size / info.partition[0].block_size)) {
+        PR_ERR("kv log mount fail, use littlefs");
+        return;
+    }
+    kv_log_ready = TRUE;
+}
+
+static void __kv_log_gc_work(void *data)
+{
+    BOOL_T again = FALSE;
+
+    tal_mutex_lock(lfs_mutex);
+    kv_log_gc(&kv_log);
+    again = kv_log_gc_needed(&kv_log);
+    kv_log_gc_pending = again;
+    tal_mutex_unlock(lfs_mutex);
+
+    // one sector per work, the writes waiting for the lock get in between
+    if (again && OPRT_OK != tal_workq_schedule(WORKQ_SYSTEM, __kv_log_gc_work, NULL)) {
+        kv_log_gc_pending = FALSE;
+    }
+}
+
+// reclaim in the background before the writes have to, called with lfs_mutex locked
+static void __kv_log_gc_schedule(void)
+{
+    if (kv_log_gc_pending || !kv_log_gc_needed(&kv_log)) {
+        return;
+    }
+    // the work queue may not run yet, the writes reclaim by themselves then
+    if (OPRT_OK == tal_workq_schedule(WORKQ_SYSTEM, __kv_log_gc_work, NULL)) {
+        kv_log_gc_pending = TRUE;
+    }
+}
+#endif
+
 /**
  * @brief Initializes the TAL Key-Value (KV) module.
  *
@@ -147,6 +266,10 @@ int tal_kv_init(tal_kv_cfg_t *kv_cfg)
     memcpy(lfs_kv_cfg.key, sha256_ret, TAL_LV_KEY_LEN);
 
     tal_mutex_create_init(&lfs_mutex);
+#if defined(ENABLE_KV_CACHE) && (ENABLE_KV_CACHE == 1)
+    memset(&kv_cache, 0, sizeof(kv_cache));
+    INIT_LIST_HEAD(&kv_cache.lru);
+#endif
 
     TUYA_FLASH_BASE_INFO_T info;
     tkl_flash_get_one_type_info(TUYA_FLASH_TYPE_UF, &info);
@@ -178,9 +301,345 @@ int tal_kv_init(tal_kv_cfg_t *kv_cfg)
         err = lfs_mount(&lfs, &lfs_cfg);
     }
 
+#if defined(KV_BACKEND_LOG) && (KV_BACKEND_LOG == 1)
+    // littlefs stays mounted for tal_fs, for the values written before the switch and
+    // for the values larger than a sector of the log
+    __kv_log_init();
+#endif
+
     return err;
 }
 
+// write one encrypted value to its littlefs file
+static int __kv_file_write(const char *key, const uint8_t *data, uint32_t length)
+{
+    int result;
+    lfs_file_t file;
+
+    result = lfs_file_open(&lfs, &file, key, LFS_O_RDWR | LFS_O_CREAT | LFS_O_TRUNC);
+    if (LFS_ERR_OK != result) {
+        PR_ERR("lfs open %s err", key);
+        return result;
+    }
+    result = lfs_file_write(&lfs, &file, data, length);
+    lfs_file_close(&lfs, &file);
+    if (result != length) {
+        PR_ERR("kv write fail %d", result);
+        return OPRT_KVS_WR_FAIL;
+    }
+
+    return OPRT_OK;
+}
+
+// read one encrypted value from its littlefs file
+static int __kv_file_read(const char *key, uint8_t **data, uint32_t *length)
+{
+    int result;
+    lfs_file_t file;
+
+    result = lfs_file_open(&lfs, &file, key, LFS_O_RDONLY);
+    if (LFS_ERR_OK != result) {
+        PR_ERR("lfs open %s %d err", key, result);
+        return result;
+    }
+    uint8_t *ec_data = NULL;
+    uint32_t ec_len = lfs_file_size(&lfs, &file);
+
+    ec_data = tal_malloc(ec_len + 1);
+    if (NULL == ec_data) {
+        lfs_file_close(&lfs, &file);
+        return OPRT_MALLOC_FAILED;
+    }
+    PR_DEBUG("key:%s, len:%d", key, ec_len);
+    result = lfs_file_read(&lfs, &file, ec_data, ec_len);
+    lfs_file_close(&lfs, &file);
+    if (result <= 0) {
+        tal_free(ec_data);
+        PR_ERR("kv read error %d", result);
+        return OPRT_KVS_RD_FAIL;
+    }
+    *data = ec_data;
+    *length = ec_len;
+
+    return OPRT_OK;
+}
+
+// write one encrypted value to the backend
+static int __kv_store_write(const char *key, const uint8_t *data, uint32_t length)
+{
+#if defined(KV_BACKEND_LOG) && (KV_BACKEND_LOG == 1)
+    if (kv_log_ready) {
+        int result = kv_log_set(&kv_log, key, data, length);
+        if (OPRT_EXCEED_UPPER_LIMIT != result) {
+            __kv_log_gc_schedule();
+            return (OPRT_OK == result) ? OPRT_OK : OPRT_KVS_WR_FAIL;
+        }
+        // larger than a sector, keep it in littlefs and drop the older value from the log
+        result = __kv_file_write(key, data, length);
+        if (OPRT_OK == result) {
+            result = kv_log_del(&kv_log, key);
+            result = (OPRT_OK == result || OPRT_NOT_FOUND == result) ? OPRT_OK : OPRT_KVS_WR_FAIL;
+        }
+        return result;
+    }
+#endif
+
+    return __kv_file_write(key, data, length);
+}
+
+// read one encrypted value from the backend, *data is freed with tal_free
+static int __kv_store_read(const char *key, uint8_t **data, uint32_t *length)
+{
+#if defined(KV_BACKEND_LOG) && (KV_BACKEND_LOG == 1)
+    if (kv_log_ready) {
+        int result = kv_log_get(&kv_log, key, data, length);
+        // not in the log, it may be large or written before the switch to the log
+        if (OPRT_NOT_FOUND != result) {
+            return result;
+        }
+    }
+#endif
+
+    return __kv_file_read(key, data, length);
+}
+
+// remove one value from the backend, return LFS_ERR_NOENT if it does not exist
+static int __kv_store_remove(const char *key)
+{
+    int result = lfs_remove(&lfs, key);
+
+#if defined(KV_BACKEND_LOG) && (KV_BACKEND_LOG == 1)
+    if (kv_log_ready) {
+        int log_result = kv_log_del(&kv_log, key);
+        if (OPRT_OK == log_result) {
+            __kv_log_gc_schedule();
+            return (LFS_ERR_OK == result || LFS_ERR_NOENT == result) ? LFS_ERR_OK : result;
+        }
+        if (OPRT_NOT_FOUND != log_result) {
+            return OPRT_KVS_WR_FAIL;
+        }
+    }
+#endif
+
+    return result;
+}
+
+// encrypt and write one value, called with lfs_mutex locked
+static int __kv_flash_set(const char *key, const uint8_t *value, size_t length)
+{
+    int result;
+    uint8_t *ec_data = NULL;
+    uint32_t ec_len = 0;
+    uint8_t iv[16];
+
+    // encrypt first, a failure must not truncate the stored value
+    memcpy(iv, lfs_kv_cfg.seed, 16);
+    result =
+        tal_aes128_cbc_encode((uint8_t *)value, length, (uint8_t *)lfs_kv_cfg.key, iv, &ec_data, (uint32_t *)&ec_len);
+    if (OPRT_OK != result) {
+        PR_DEBUG("key %s encrypt failed", key);
+        return result;
+    }
+
+    result = __kv_store_write(key, ec_data, ec_len);
+    tal_aes_free_data(ec_data);
+
+    return result;
+}
+
+// read and decrypt one value, called with lfs_mutex locked
+static int __kv_flash_get(const char *key, uint8_t **value, size_t *length)
+{
+    int result;
+    uint8_t *ec_data = NULL;
+    uint32_t ec_len = 0;
+
+    result = __kv_store_read(key, &ec_data, &ec_len);
+    if (OPRT_OK != result) {
+        *length = 0;
+        return result;
+    }
+    uint8_t *dec_data = NULL;
+    uint32_t dec_len = 0;
+    uint8_t iv[16];
+
+    memcpy(iv, lfs_kv_cfg.seed, 16);
+    result = tal_aes128_cbc_decode(ec_data, ec_len, (uint8_t *)lfs_kv_cfg.key, iv, &dec_data, (uint32_t *)&dec_len);
+    dec_len = tal_aes_get_actual_length(dec_data, dec_len);
+    tal_free(ec_data);
+    if (OPRT_OK != result || dec_len > ec_len) {
+        PR_ERR("key %s decrypt failed %d, %d-%d", key, result, dec_len, ec_len);
+        return OPRT_BUFFER_NOT_ENOUGH;
+    }
+    *value = dec_data;
+    *length = (size_t)dec_len;
+    dec_data[dec_len] = 0;
+
+    return OPRT_OK;
+}
+
+// remove one value, a missing key is not an error, called with lfs_mutex locked
+static int __kv_flash_del(const char *key)
+{
+    int result = __kv_store_remove(key);
+
+    return (LFS_ERR_OK == result || LFS_ERR_NOENT == result) ? OPRT_OK : result;
+}
+
+#if defined(ENABLE_KV_CACHE) && (ENABLE_KV_CACHE == 1)
+static void __kv_cache_entry_free(KV_CACHE_ENTRY_T *entry)
+{
+    tuya_list_del(&entry->node);
+    kv_cache.size -= __kv_cache_entry_size(entry->key, entry->length);
+    if (entry->value) {
+        tal_free(entry->value);
+    }
+    tal_free(entry);
+}
+
+static KV_CACHE_ENTRY_T *__kv_cache_find(const char *key)
+{
+    P_LIST_HEAD pos = NULL;
+    KV_CACHE_ENTRY_T *entry = NULL;
+
+    tuya_list_for_each(pos, &kv_cache.lru)
+    {
+        entry = tuya_list_entry(pos, KV_CACHE_ENTRY_T, node);
+        if (0 == strcmp(entry->key, key)) {
+            // most recently used first
+            tuya_list_del(&entry->node);
+            tuya_list_add(&entry->node, &kv_cache.lru);
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+// write a pending value or deletion to flash
+static int __kv_cache_entry_write(KV_CACHE_ENTRY_T *entry)
+{
+    int result = OPRT_OK;
+
+    if (KV_ENTRY_CLEAN == entry->state) {
+        return OPRT_OK;
+    }
+
+    if (entry->value) {
+        result = __kv_flash_set(entry->key, entry->value, entry->length);
+    } else {
+        result = __kv_flash_del(entry->key);
+    }
+    if (OPRT_OK == result) {
+        entry->state = KV_ENTRY_CLEAN;
+    }
+
+    return result;
+}
+
+// evict the least recently used entries but keep until need more bytes fit
+static void __kv_cache_shrink(uint32_t need, KV_CACHE_ENTRY_T *keep)
+{
+    KV_CACHE_ENTRY_T *entry = NULL;
+    P_LIST_HEAD pos = kv_cache.lru.prev;
+
+    while (kv_cache.size + need > KV_CACHE_MAX_SIZE && pos != &kv_cache.lru) {
+        entry = tuya_list_entry(pos, KV_CACHE_ENTRY_T, node);
+        pos = pos->prev;
+        // a pending entry that can not be written stays cached
+        if (entry != keep && OPRT_OK == __kv_cache_entry_write(entry)) {
+            __kv_cache_entry_free(entry);
+        }
+    }
+}
+
+// cache a value, value NULL caches a missing key, return NULL if it can not be cached
+static KV_CACHE_ENTRY_T *__kv_cache_put(const char *key, const uint8_t *value, size_t length, uint8_t state)
+{
+    KV_CACHE_ENTRY_T *entry = __kv_cache_find(key);
+    uint8_t *copy = NULL;
+    uint32_t size = __kv_cache_entry_size(key, length);
+
+    if (size > KV_CACHE_ENTRY_MAX_SIZE) {
+        // an old pending value would overwrite the newer one in flash later
+        if (entry) {
+            __kv_cache_entry_free(entry);
+        }
+        return NULL;
+    }
+
+    if (value) {
+        copy = tal_malloc(length + 1);
+        if (NULL == copy) {
+            if (entry) {
+                __kv_cache_entry_free(entry);
+            }
+            return NULL;
+        }
+        memcpy(copy, value, length);
+        copy[length] = 0;
+    }
+
+    if (NULL == entry) {
+        __kv_cache_shrink(size, NULL);
+        entry = tal_malloc(sizeof(KV_CACHE_ENTRY_T) + strlen(key) + 1);
+        if (NULL == entry) {
+            if (copy) {
+                tal_free(copy);
+            }
+            return NULL;
+        }
+        memset(entry, 0, sizeof(KV_CACHE_ENTRY_T));
+        strcpy(entry->key, key);
+        tuya_list_add(&entry->node, &kv_cache.lru);
+        kv_cache.size += __kv_cache_entry_size(key, 0);
+    } else if (length > entry->length) {
+        __kv_cache_shrink(length - entry->length, entry);
+    }
+
+    if (entry->value) {
+        tal_free(entry->value);
+    }
+    kv_cache.size += length;
+    kv_cache.size -= entry->length;
+    entry->value = copy;
+    entry->length = value ? length : 0;
+    entry->state = state;
+
+    return entry;
+}
+
+#if defined(ENABLE_KV_WRITE_BACK) && (ENABLE_KV_WRITE_BACK == 1)
+static void __kv_write_back_timer_cb(TIMER_ID timer_id, void *arg)
+{
+    tal_kv_flush();
+}
+#endif
+
+// TRUE if a write can stay in the cache instead of going to flash now
+static BOOL_T __kv_cache_defer(void)
+{
+    if (kv_cache.batch_depth) {
+        return TRUE;
+    }
+
+#if defined(ENABLE_KV_WRITE_BACK) && (ENABLE_KV_WRITE_BACK == 1)
+    // the timer service is usually started after tal_kv_init, create the timer on demand
+    if (NULL == kv_cache.flush_timer &&
+        OPRT_OK != tal_sw_timer_create(__kv_write_back_timer_cb, NULL, &kv_cache.flush_timer)) {
+        kv_cache.flush_timer = NULL;
+        return FALSE;
+    }
+    if (!tal_sw_timer_is_running(kv_cache.flush_timer)) {
+        tal_sw_timer_start(kv_cache.flush_timer, KV_WRITE_BACK_DELAY_MS, TAL_TIMER_ONCE);
+    }
+    return TRUE;
+#else
+    return FALSE;
+#endif
+}
+#endif
+
 /**
  * @brief Sets a key-value pair in the key-value store.
  *
@@ -188,6 +647,10 @@ int tal_kv_init(tal_kv_cfg_t *kv_cfg)
  * string, the value is a byte array, and the length specifies the number of
  * bytes in the value.
  *
+ * With ENABLE_KV_CACHE a value equal to the cached one is not written again.
+ * Inside a batch, or with ENABLE_KV_WRITE_BACK, the value is only cached and
+ * written by tal_kv_batch_commit or tal_kv_flush.
+ *
  * @param key The key to set in the key-value store.
  * @param value The value to associate with the key.
  * @param length The length of the value in bytes.
@@ -197,7 +660,6 @@ int tal_kv_init(tal_kv_cfg_t *kv_cfg)
 int tal_kv_set(const char *key, const uint8_t *value, size_t length)
 {
     int result;
-    lfs_file_t file;
 
     PR_DEBUG("key:%s, len %d", key, length);
 
@@ -206,36 +668,28 @@ int tal_kv_set(const char *key, const uint8_t *value, size_t length)
     }
 
     tal_mutex_lock(lfs_mutex);
-    result = lfs_file_open(&lfs, &file, key, LFS_O_RDWR | LFS_O_CREAT | LFS_O_TRUNC);
-    if (LFS_ERR_OK != result) {
+#if defined(ENABLE_KV_CACHE) && (ENABLE_KV_CACHE == 1)
+    KV_CACHE_ENTRY_T *entry = __kv_cache_find(key);
+    if (entry && entry->value && entry->length == length && 0 == memcmp(entry->value, value, length)) {
         tal_mutex_unlock(lfs_mutex);
-        PR_ERR("lfs open %s err", key);
-        return result;
+        return OPRT_OK;
     }
-    uint8_t *ec_data = NULL;
-    uint32_t ec_len = 0;
-    uint8_t iv[16];
-
-    memcpy(iv, lfs_kv_cfg.seed, 16);
-    result =
-        tal_aes128_cbc_encode((uint8_t *)value, length, (uint8_t *)lfs_kv_cfg.key, iv, &ec_data, (uint32_t *)&ec_len);
-    if (OPRT_OK != result) {
-        lfs_file_close(&lfs, &file);
+    if (__kv_cache_defer() && __kv_cache_put(key, value, length, KV_ENTRY_DIRTY)) {
         tal_mutex_unlock(lfs_mutex);
-        PR_DEBUG("key %s encrypt failed", key);
-        return result;
+        return OPRT_OK;
     }
-    lfs_file_rewind(&lfs, &file);
-    result = lfs_file_write(&lfs, &file, ec_data, ec_len);
-    lfs_file_close(&lfs, &file);
-    tal_aes_free_data(ec_data);
-    tal_mutex_unlock(lfs_mutex);
-    if (result != ec_len) {
-        PR_ERR("kv write fail %d", result);
-        return OPRT_KVS_WR_FAIL;
+#endif
+    result = __kv_flash_set(key, value, length);
+#if defined(ENABLE_KV_CACHE) && (ENABLE_KV_CACHE == 1)
+    if (OPRT_OK == result) {
+        __kv_cache_put(key, value, length, KV_ENTRY_CLEAN);
+    } else if (NULL != (entry = __kv_cache_find(key))) {
+        __kv_cache_entry_free(entry);
     }
+#endif
+    tal_mutex_unlock(lfs_mutex);
 
-    return OPRT_OK;
+    return result;
 }
 
 /**
@@ -246,6 +700,9 @@ int tal_kv_set(const char *key, const uint8_t *value, size_t length)
  * key-value store. The retrieved value is stored in the `value` parameter, and
  * its length is stored in the `length` parameter.
  *
+ * With ENABLE_KV_CACHE the value, or the absence of the key, is served from
+ * the cache when possible.
+ *
  * @param key The key to retrieve the value for.
  * @param value A pointer to a pointer that will store the retrieved value.
  * @param length A pointer to a variable that will store the length of the
@@ -257,55 +714,43 @@ int tal_kv_set(const char *key, const uint8_t *value, size_t length)
 int tal_kv_get(const char *key, uint8_t **value, size_t *length)
 {
     int result;
-    lfs_file_t file;
 
     if (NULL == key || NULL == value || NULL == length) {
         return OPRT_INVALID_PARM;
     }
 
     tal_mutex_lock(lfs_mutex);
-    result = lfs_file_open(&lfs, &file, key, LFS_O_RDONLY);
-    if (LFS_ERR_OK != result) {
-        PR_ERR("lfs open %s %d err", key, result);
+#if defined(ENABLE_KV_CACHE) && (ENABLE_KV_CACHE == 1)
+    KV_CACHE_ENTRY_T *entry = __kv_cache_find(key);
+    if (entry) {
+        if (NULL == entry->value) {
+            tal_mutex_unlock(lfs_mutex);
+            PR_DEBUG("kv %s not exist", key);
+            return LFS_ERR_NOENT;
+        }
+        uint8_t *copy = tal_malloc(entry->length + 1);
+        if (NULL == copy) {
+            tal_mutex_unlock(lfs_mutex);
+            return OPRT_MALLOC_FAILED;
+        }
+        memcpy(copy, entry->value, entry->length + 1);
+        *value = copy;
+        *length = entry->length;
         tal_mutex_unlock(lfs_mutex);
-        return result;
+        return OPRT_OK;
     }
-    uint8_t *ec_data = NULL;
-    uint32_t ec_len = lfs_file_size(&lfs, &file);
-
-    ec_data = tal_malloc(ec_len + 1);
-    if (NULL == ec_data) {
-        result = OPRT_MALLOC_FAILED;
-        tal_mutex_unlock(lfs_mutex);
-        return result;
+#endif
+    result = __kv_flash_get(key, value, length);
+#if defined(ENABLE_KV_CACHE) && (ENABLE_KV_CACHE == 1)
+    if (OPRT_OK == result) {
+        __kv_cache_put(key, *value, *length, KV_ENTRY_CLEAN);
+    } else if (LFS_ERR_NOENT == result) {
+        __kv_cache_put(key, NULL, 0, KV_ENTRY_CLEAN);
     }
-    PR_DEBUG("key:%s, len:%d", key, ec_len);
-    result = lfs_file_read(&lfs, &file, ec_data, ec_len);
-    lfs_file_close(&lfs, &file);
+#endif
     tal_mutex_unlock(lfs_mutex);
-    if (result <= 0) {
-        *length = 0;
-        tal_free(ec_data);
-        PR_ERR("kv read error %d", result);
-        return OPRT_KVS_RD_FAIL;
-    }
-    uint8_t *dec_data = NULL;
-    uint32_t dec_len = 0;
-    uint8_t iv[16];
-
-    memcpy(iv, lfs_kv_cfg.seed, 16);
-    result = tal_aes128_cbc_decode(ec_data, ec_len, (uint8_t *)lfs_kv_cfg.key, iv, &dec_data, (uint32_t *)&dec_len);
-    dec_len = tal_aes_get_actual_length(dec_data, dec_len);
-    tal_free(ec_data);
-    if (OPRT_OK != result || dec_len > ec_len) {
-        PR_ERR("key %s decrypt failed %d, %d-%d", key, result, dec_len, ec_len);
-        return OPRT_BUFFER_NOT_ENOUGH;
-    }
-    *value = dec_data;
-    *length = (size_t)dec_len;
-    dec_data[dec_len] = 0;
 
-    return OPRT_OK;
+    return result;
 }
 
 /**
@@ -322,7 +767,25 @@ int tal_kv_del(const char *key)
     PR_DEBUG("key:%s", key);
 
     tal_mutex_lock(lfs_mutex);
-    int result = lfs_remove(&lfs, key);
+#if defined(ENABLE_KV_CACHE) && (ENABLE_KV_CACHE == 1)
+    KV_CACHE_ENTRY_T *entry = __kv_cache_find(key);
+    if (entry && NULL == entry->value && KV_ENTRY_CLEAN == entry->state) {
+        // known missing, same result as removing a missing file
+        tal_mutex_unlock(lfs_mutex);
+        PR_DEBUG("Deleted failed %d", LFS_ERR_NOENT);
+        return OPRT_COM_ERROR;
+    }
+    if (__kv_cache_defer() && __kv_cache_put(key, NULL, 0, KV_ENTRY_DIRTY)) {
+        tal_mutex_unlock(lfs_mutex);
+        return OPRT_OK;
+    }
+#endif
+    int result = __kv_store_remove(key);
+#if defined(ENABLE_KV_CACHE) && (ENABLE_KV_CACHE == 1)
+    if (LFS_ERR_OK == result || LFS_ERR_NOENT == result) {
+        __kv_cache_put(key, NULL, 0, KV_ENTRY_CLEAN);
+    }
+#endif
     tal_mutex_unlock(lfs_mutex);
     if (LFS_ERR_OK == result) {
         PR_DEBUG("Deleted successfully");
@@ -334,6 +797,90 @@ int tal_kv_del(const char *key)
     return OPRT_COM_ERROR;
 }
 
+/**
+ * @brief Writes the pending values and deletions of the cache to flash.
+ *
+ * This function does nothing if ENABLE_KV_CACHE is not set or if nothing is
+ * pending. A value that fails to be written stays pending.
+ *
+ * @return OPRT_OK if every pending entry is written, otherwise the error of
+ * the first failed entry.
+ */
+int tal_kv_flush(void)
+{
+    int result = OPRT_OK;
+
+#if defined(ENABLE_KV_CACHE) && (ENABLE_KV_CACHE == 1)
+    P_LIST_HEAD pos = NULL;
+    KV_CACHE_ENTRY_T *entry = NULL;
+    int ret = OPRT_OK;
+
+    tal_mutex_lock(lfs_mutex);
+    tuya_list_for_each(pos, &kv_cache.lru)
+    {
+        entry = tuya_list_entry(pos, KV_CACHE_ENTRY_T, node);
+        ret = __kv_cache_entry_write(entry);
+        if (OPRT_OK != ret && OPRT_OK == result) {
+            PR_ERR("kv flush %s err %d", entry->key, ret);
+            result = ret;
+        }
+    }
+    tal_mutex_unlock(lfs_mutex);
+#endif
+
+    return result;
+}
+
+/**
+ * @brief Starts a batch of key-value updates.
+ *
+ * The sets and deletions until the matching tal_kv_batch_commit are kept in
+ * the cache and written together at commit, a key set several times in the
+ * batch is written once. Batches can be nested, the outermost commit writes.
+ * Values too large for the cache are written immediately. Without
+ * ENABLE_KV_CACHE the updates are written immediately.
+ *
+ * @return OPRT_OK on success.
+ */
+int tal_kv_batch_begin(void)
+{
+#if defined(ENABLE_KV_CACHE) && (ENABLE_KV_CACHE == 1)
+    tal_mutex_lock(lfs_mutex);
+    kv_cache.batch_depth++;
+    tal_mutex_unlock(lfs_mutex);
+#endif
+
+    return OPRT_OK;
+}
+
+/**
+ * @brief Ends a batch of key-value updates and writes them to flash.
+ *
+ * @return OPRT_OK if the updates are written, otherwise the error of the first
+ * failed update, which stays pending.
+ */
+int tal_kv_batch_commit(void)
+{
+#if defined(ENABLE_KV_CACHE) && (ENABLE_KV_CACHE == 1)
+    uint32_t depth = 0;
+
+    tal_mutex_lock(lfs_mutex);
+    if (kv_cache.batch_depth) {
+        kv_cache.batch_depth--;
+    }
+    depth = kv_cache.batch_depth;
+    tal_mutex_unlock(lfs_mutex);
+
+    if (depth) {
+        return OPRT_OK;
+    }
+
+    return tal_kv_flush();
+#else
+    return OPRT_OK;
+#endif
+}
+
 /**
  * @brief Frees the memory allocated for a value in the TAL Key-Value store.
  *
@@ -354,6 +901,35 @@ int tal_kv_free(uint8_t *value)
     return OPRT_OK;
 }
 
+/**
+ * @brief Gets the bytes programmed and erased by the KV storage since boot.
+ *
+ * The counters include the files written through tal_fs, they share the
+ * littlefs partition with the keys.
+ *
+ * @param write_bytes Pointer to the bytes programmed, can be NULL.
+ * @param erase_bytes Pointer to the bytes erased, can be NULL.
+ * @return OPRT_OK on success.
+ */
+int tal_kv_flash_stat(uint32_t *write_bytes, uint32_t *erase_bytes)
+{
+    if (write_bytes) {
+        *write_bytes = kv_flash_write_bytes;
+    }
+    if (erase_bytes) {
+        *erase_bytes = kv_flash_erase_bytes;
+    }
+
+    return OPRT_OK;
+}
+
+#if defined(KV_BACKEND_LOG) && (KV_BACKEND_LOG == 1)
+static void __kv_log_list_cb(const char *key, uint32_t length, void *arg)
+{
+    PR_DEBUG_RAW("%s  ", key);
+}
+#endif
+
 /**
  * @brief Executes the TAL KV command.
  *
@@ -381,6 +957,7 @@ void tal_kv_cmd(int argc, char *argv[])
     } else if (0 == strcmp("del", argv[1])) {
         tal_kv_del(argv[2]);
     } else if (0 == strcmp("list", argv[1])) {
+        tal_kv_flush();
         lfs_dir_t dir;
         lfs_dir_open(&lfs, &dir, argv[2]);
         struct lfs_info info;
@@ -389,6 +966,18 @@ void tal_kv_cmd(int argc, char *argv[])
         }
         PR_DEBUG_RAW("\r\n", info.name);
         lfs_dir_close(&lfs, &dir);
+#if defined(KV_BACKEND_LOG) && (KV_BACKEND_LOG == 1)
+        if (kv_log_ready) {
+            tal_mutex_lock(lfs_mutex);
+            kv_log_foreach(&kv_log, __kv_log_list_cb, NULL);
+            tal_mutex_unlock(lfs_mutex);
+            PR_DEBUG_RAW("\r\n");
+        }
+#endif
+    } else if (0 == strcmp("stat", argv[1])) {
+        uint32_t write_bytes = 0, erase_bytes = 0;
+        tal_kv_flash_stat(&write_bytes, &erase_bytes);
+        PR_DEBUG("flash write %u, erase %u", write_bytes, erase_bytes);
     }
 }
 
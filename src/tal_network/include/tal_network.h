@@ -108,6 +108,16 @@ OPERATE_RET tal_net_fd_zero(TUYA_FD_SET_T *fds);
 // Clear all descriptor in set
 #define TAL_FD_ZERO(p) tal_net_fd_zero(p)
 
+/* events of tal_net_poll */
+#define TAL_NET_POLLIN  0x01 // readable, or a connection to accept
+#define TAL_NET_POLLERR 0x02 // error or hang up, always reported
+
+typedef struct {
+    int fd;          // negative entries are ignored
+    uint8_t events;  // TAL_NET_POLLIN
+    uint8_t revents; // set by tal_net_poll
+} TAL_NET_POLL_T;
+
 /**
  * @brief Get available file descriptors
  *
@@ -124,6 +134,20 @@ OPERATE_RET tal_net_fd_zero(TUYA_FD_SET_T *fds);
 int tal_net_select(const int maxfd, TUYA_FD_SET_T *readfds, TUYA_FD_SET_T *writefds, TUYA_FD_SET_T *errorfds,
                    const uint32_t ms_timeout);
 
+/**
+ * @brief Wait until one of a set of file descriptors is ready
+ *
+ * @param[in,out] fds: file descriptors and the events to wait for
+ * @param[in] nfds: count of fds
+ * @param[in] ms_timeout: time out, 0 to return at once
+ *
+ * @note The descriptors are kept by the caller from one call to the next. On
+ * Linux this is poll, the stacks without it fall back to select.
+ *
+ * @return the count of entries with revents set, 0 on time out, <0 error.
+ */
+int tal_net_poll(TAL_NET_POLL_T *fds, int nfds, const uint32_t ms_timeout);
+
 /**
  * @brief Get no block file descriptors
  *
@@ -424,6 +448,20 @@ OPERATE_RET tal_net_set_keepalive(int fd, const BOOL_T alive, const uint32_t idl
  */
 OPERATE_RET tal_net_get_socket_ip(int fd, TUYA_IP_ADDR_T *addr);
 
+/**
+ * @brief Get the local address and port a socket is bound to
+ *
+ * @param[in] fd: file descriptor
+ * @param[out] addr: ip address
+ * @param[out] port: port
+ *
+ * @note This API is used for getting the port picked by a bind to port 0.
+ *
+ * @return OPRT_OK on success. Others on error, please refer to
+ * tuya_error_code.h
+ */
+OPERATE_RET tal_net_getsockname(int fd, TUYA_IP_ADDR_T *addr, uint16_t *port);
+
 /**
  * @brief Change ip string to address
  *
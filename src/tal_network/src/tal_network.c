@@ -31,6 +31,7 @@
  */
 #include "tuya_iot_config.h"
 #include "tal_api.h"
+#include "tal_network.h"
 
 #if 100 == OPERATING_SYSTEM
 #include <unistd.h>
@@ -45,6 +46,7 @@
 #include <sys/time.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <poll.h>
 
 #define ENABLE_BIND_INTERFACE 1
 
@@ -270,6 +272,87 @@ int tal_net_select(const int maxfd, TUYA_FD_SET_T *readfds, TUYA_FD_SET_T *write
     return ret;
 }
 
+/**
+ * @brief Wait until one of a set of file descriptors is ready
+ *
+ * @param[in,out] fds: file descriptors and the events to wait for
+ * @param[in] nfds: count of fds
+ * @param[in] ms_timeout: time out, 0 to return at once
+ *
+ * @note This API is used to wait for readiness without rebuilding fd sets.
+ *
+ * @return the count of entries with revents set, 0 on time out, <0 error.
+ */
+int tal_net_poll(TAL_NET_POLL_T *fds, int nfds, const uint32_t ms_timeout)
+{
+    int ret = -1;
+    int idx = 0;
+
+    if (NULL == fds || nfds <= 0) {
+        return OPRT_INVALID_PARM;
+    }
+
+#if 100 == OPERATING_SYSTEM
+    struct pollfd pfds[nfds];
+
+    for (idx = 0; idx < nfds; idx++) {
+        pfds[idx].fd = fds[idx].fd;
+        pfds[idx].events = (fds[idx].events & TAL_NET_POLLIN) ? POLLIN : 0;
+        pfds[idx].revents = 0;
+    }
+    ret = poll(pfds, nfds, ms_timeout);
+    for (idx = 0; idx < nfds; idx++) {
+        fds[idx].revents = 0;
+        if (ret > 0 && pfds[idx].fd >= 0) {
+            fds[idx].revents |= (pfds[idx].revents & POLLIN) ? TAL_NET_POLLIN : 0;
+            fds[idx].revents |= (pfds[idx].revents & (POLLERR | POLLHUP | POLLNVAL)) ? TAL_NET_POLLERR : 0;
+        }
+    }
+#else
+    int maxfd = -1;
+    TUYA_FD_SET_T rfds, efds;
+
+    tal_net_fd_zero(&rfds);
+    tal_net_fd_zero(&efds);
+    for (idx = 0; idx < nfds; idx++) {
+        fds[idx].revents = 0;
+        if (fds[idx].fd < 0) {
+            continue;
+        }
+        if (fds[idx].events & TAL_NET_POLLIN) {
+            tal_net_fd_set(fds[idx].fd, &rfds);
+        }
+        tal_net_fd_set(fds[idx].fd, &efds);
+        maxfd = (fds[idx].fd > maxfd) ? fds[idx].fd : maxfd;
+    }
+    if (maxfd < 0) {
+        tal_system_sleep(ms_timeout);
+        return 0;
+    }
+    /* select takes 0 as wait forever, 1 ms is the closest to no wait */
+    ret = tal_net_select(maxfd + 1, &rfds, NULL, &efds, ms_timeout ? ms_timeout : 1);
+    if (ret <= 0) {
+        return ret;
+    }
+    for (idx = 0; idx < nfds; idx++) {
+        if (fds[idx].fd < 0) {
+            continue;
+        }
+        fds[idx].revents |= tal_net_fd_isset(fds[idx].fd, &rfds) ? TAL_NET_POLLIN : 0;
+        fds[idx].revents |= tal_net_fd_isset(fds[idx].fd, &efds) ? TAL_NET_POLLERR : 0;
+    }
+#endif
+
+    if (ret < 0) {
+        return ret;
+    }
+    for (idx = 0, ret = 0; idx < nfds; idx++) {
+        ret += (fds[idx].revents != 0);
+    }
+
+    return ret;
+}
+
 /**
  * @brief Get no block file descriptors
  *
@@ -1121,6 +1204,39 @@ OPERATE_RET tal_net_get_socket_ip(int fd, TUYA_IP_ADDR_T *addr)
     return ret;
 }
 
+/**
+ * @brief Get the local address and port a socket is bound to
+ *
+ * @param[in] fd: file descriptor
+ * @param[out] addr: ip address
+ * @param[out] port: port
+ *
+ * @note This API is used for getting the port picked by a bind to port 0.
+ *
+ * @return OPRT_OK on success. Others on error, please refer to
+ * tuya_error_code.h
+ */
+OPERATE_RET tal_net_getsockname(int fd, TUYA_IP_ADDR_T *addr, uint16_t *port)
+{
+    int ret = -1;
+
+#if NET_USING_POSIX
+    struct sockaddr_in sock_addr;
+    memset(&sock_addr, 0, sizeof(sock_addr));
+    socklen_t len = sizeof(sock_addr);
+
+    if (0 == getsockname(fd, (struct sockaddr *)&sock_addr, &len)) {
+        *addr = ntohl(sock_addr.sin_addr.s_addr);
+        *port = ntohs(sock_addr.sin_port);
+        ret = OPRT_OK;
+    }
+#else
+    ret = tkl_net_getsockname(fd, addr, port);
+#endif
+
+    return ret;
+}
+
 /**
  * @brief Change ip string to address
  *
@@ -50,6 +50,31 @@ extern "C" {
  */
 #define EVENT_DESC_MAX_LEN (32)
 
+/**
+ * @brief bucket number of the event name hash table, must be power of 2
+ *
+ */
+#ifndef EVENT_HASH_BUCKET_NUM
+#define EVENT_HASH_BUCKET_NUM (32)
+#endif
+
+/**
+ * @brief event id table is allocated by page, max event number is
+ * EVENT_ID_PAGE_SIZE * EVENT_ID_PAGE_NUM
+ *
+ */
+#define EVENT_ID_PAGE_SIZE (16)
+#ifndef EVENT_ID_PAGE_NUM
+#define EVENT_ID_PAGE_NUM (32)
+#endif
+
+/**
+ * @brief event id, interned from the event name, never changed after created
+ *
+ */
+typedef uint16_t EVENT_ID_T;
+#define EVENT_ID_INVALID 0
+
 /**
  * @brief subscriber type
  *
@@ -90,15 +115,30 @@ typedef struct {
 } SUBSCRIBE_NODE_T;
 
 /**
- * @brief the event node
+ * @brief the subscriber snapshot, a read-only copy of the subscribe list
  *
  */
 typedef struct {
-    MUTEX_HANDLE mutex; // mutex, protection the event publish and subscribe
+    int ref;                  // publishers still dispatching this snapshot
+    int num;                  // callback number
+    int onetime_cnt;          // one time subscriber number
+    EVENT_SUBSCRIBE_CB cb[0]; // callbacks in the dispatch order
+} SUBSCRIBE_SNAPSHOT_T;
+
+/**
+ * @brief the event node
+ *
+ */
+typedef struct event_node {
+    MUTEX_HANDLE mutex; // mutex, protection the subscribe list and the snapshot
 
     char name[EVENT_NAME_MAX_LEN + 1];    // name, the event name
+    EVENT_ID_T id;                        // id, the interned event name
+    uint32_t hash;                        // hash of the event name
+    struct event_node *hash_next;         // next event in the same hash bucket
     struct tuya_list_head node;           // list node, used to attach to the event manage module
     struct tuya_list_head subscribe_root; // subscibe root, used to manage the subscriber
+    SUBSCRIBE_SNAPSHOT_T *snapshot;       // current snapshot, replaced when the subscriber changed
 } EVENT_NODE_T;
 
 /**
@@ -107,11 +147,11 @@ typedef struct {
  */
 typedef struct {
     int inited;
-    MUTEX_HANDLE mutex;                        // mutex, used to protection event manage node
-    int event_cnt;                             // current event number
-    struct tuya_list_head event_root;          // event root, used to manage the event
-    struct tuya_list_head free_subscribe_root; // free subscriber list, used to manage the
-                                               // subscribe which not found the event
+    MUTEX_HANDLE mutex;                               // mutex, used to protection event manage node
+    int event_cnt;                                    // current event number
+    struct tuya_list_head event_root;                 // event root, used to manage the event
+    EVENT_NODE_T *hash_bucket[EVENT_HASH_BUCKET_NUM]; // event name hash table
+    EVENT_NODE_T **id_page[EVENT_ID_PAGE_NUM];        // event id table, event id is never released
 } EVENT_MANAGE_T;
 
 /**
@@ -132,6 +172,26 @@ OPERATE_RET tal_event_init(void);
  */
 OPERATE_RET tal_event_publish(const char *name, void *data);
 
+/**
+ * @brief: get the event id, the event is created if not exist
+ *
+ * @param[in] name: event name
+ * @param[out] id: event id, can be used by tal_event_publish_by_id
+ * @return OPRT_OK on success. Others on error, please refer to
+ * tuya_error_code.h
+ */
+OPERATE_RET tal_event_id_get(const char *name, EVENT_ID_T *id);
+
+/**
+ * @brief: publish event by id, no name lookup
+ *
+ * @param[in] id: event id, get from tal_event_id_get
+ * @param[in] data: event data
+ * @return OPRT_OK on success. Others on error, please refer to
+ * tuya_error_code.h
+ */
+OPERATE_RET tal_event_publish_by_id(EVENT_ID_T id, void *data);
+
 /**
  * @brief: subscribe event
  *
@@ -133,6 +133,9 @@ OPERATE_RET tal_log_print(const TAL_LOG_LEVEL_E level, const char *file, const i
 // prototype of log output function
 typedef void (*TAL_LOG_OUTPUT_CB)(const char *str);
 
+// prototype of binary log output function, data is one COBS encoded frame ending with 0x00
+typedef void (*TAL_LOG_BIN_OUTPUT_CB)(const uint8_t *data, uint32_t len);
+
 /***********************************************************************
  ********************* variable ****************************************
  **********************************************************************/
@@ -168,6 +171,22 @@ OPERATE_RET tal_log_init(const TAL_LOG_LEVEL_E level, const int buf_len, const T
  */
 OPERATE_RET tal_log_add_output_term(const char *name, const TAL_LOG_OUTPUT_CB term);
 
+/**
+ * @brief add one binary output terminal.
+ *
+ * @param[in] name , terminal name
+ * @param[in] term , binary output function pointer
+ *
+ * @note The terminal receives compact frames that keep the format string
+ * out of the output, decode them on the host with tools/tal_log_decode.py
+ * and the ELF of the firmware. A terminal added with the name of an existing
+ * one replaces it. Needs ENABLE_LOG_BINARY.
+ *
+ * @return OPRT_OK on success. Others on error, please refer to
+ * tuya_error_code.h
+ */
+OPERATE_RET tal_log_add_binary_term(const char *name, const TAL_LOG_BIN_OUTPUT_CB term);
+
 /**
  * @brief delete one output terminal.
  *
@@ -288,6 +307,25 @@ OPERATE_RET tal_log_print_raw(const char *pFmt, ...);
  */
 void tal_log_release(void);
 
+/**
+ * @brief wait until the deferred logs are output
+ *
+ * @param[in] timeout_ms, max wait time in ms
+ *
+ * @note This API does nothing if ENABLE_LOG_ASYNC is not set, call it
+ * before reboot to keep the last logs.
+ *
+ * @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+ */
+OPERATE_RET tal_log_flush(uint32_t timeout_ms);
+
+/**
+ * @brief get the number of deferred logs dropped because the log ring was full
+ *
+ * @return the dropped log count
+ */
+uint32_t tal_log_get_drop_cnt(void);
+
 /**
  * @brief print a buffer in hex format
  *
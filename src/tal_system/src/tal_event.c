@@ -11,8 +11,8 @@
  * consumers, facilitating a more modular and maintainable codebase. It includes
  * mechanisms for validating event names and descriptions, creating and
  * initializing event nodes, managing subscriptions, and dispatching events to
- * subscribed listeners. Additionally, it supports the management of free
- * subscriptions to optimize memory usage.
+ * subscribed listeners. Event names are interned to ids through a hash table,
+ * and subscribers are dispatched from a snapshot without holding the lock.
  *
  * Key functionalities include:
  * - Event name and description validation
@@ -62,8 +62,69 @@ BOOL_T _event_desc_is_valid(const char *desc)
     return TRUE;
 }
 
+uint32_t _event_name_hash(const char *name)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+
+    while (*name) {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+EVENT_NODE_T *_event_node_get(const char *name)
+{
+    // try to get event from the hash bucket, must be called in manager mutex
+    uint32_t hash = _event_name_hash(name);
+    EVENT_NODE_T *entry = g_event_manager.hash_bucket[hash & (EVENT_HASH_BUCKET_NUM - 1)];
+
+    while (entry) {
+        if (entry->hash == hash && 0 == strcmp(entry->name, name)) {
+            return entry;
+        }
+        entry = entry->hash_next;
+    }
+
+    return NULL;
+}
+
+EVENT_NODE_T *_event_node_get_by_id(EVENT_ID_T id)
+{
+    // event is never released, the id table can be read without lock
+    EVENT_NODE_T **page = NULL;
+
+    if (id == EVENT_ID_INVALID || id > EVENT_ID_PAGE_SIZE * EVENT_ID_PAGE_NUM) {
+        return NULL;
+    }
+
+    page = g_event_manager.id_page[(id - 1) / EVENT_ID_PAGE_SIZE];
+    if (!page) {
+        return NULL;
+    }
+
+    return page[(id - 1) % EVENT_ID_PAGE_SIZE];
+}
+
 EVENT_NODE_T *_event_node_create_init(const char *name)
 {
+    EVENT_ID_T id = g_event_manager.event_cnt + 1;
+    EVENT_NODE_T ***page = NULL;
+
+    if (id > EVENT_ID_PAGE_SIZE * EVENT_ID_PAGE_NUM) {
+        PR_ERR("event %s exceed max %d", name, EVENT_ID_PAGE_SIZE * EVENT_ID_PAGE_NUM);
+        return NULL;
+    }
+
+    // the id page is allocated when the first event of the page is created
+    page = &g_event_manager.id_page[(id - 1) / EVENT_ID_PAGE_SIZE];
+    if (*page == NULL) {
+        *page = tal_calloc(EVENT_ID_PAGE_SIZE, sizeof(EVENT_NODE_T *));
+        TUYA_CHECK_NULL_RETURN(*page, NULL);
+    }
+
     // allocate memory
     EVENT_NODE_T *event = tal_malloc(sizeof(EVENT_NODE_T));
     TUYA_CHECK_NULL_RETURN(event, NULL);
@@ -72,68 +133,47 @@ EVENT_NODE_T *_event_node_create_init(const char *name)
     // initialze the event node
     memcpy(event->name, name, strlen(name));
     event->name[strlen(name)] = '\0';
+    event->id = id;
+    event->hash = _event_name_hash(name);
     INIT_LIST_HEAD(&event->subscribe_root);
-    tal_mutex_create_init(&event->mutex);
-
-    tal_mutex_lock(g_event_manager.mutex);
-
-    // need check if there have free subscriber which subscribe this event
-    struct tuya_list_head *free_pos = NULL;
-    struct tuya_list_head *free_next = NULL;
-    SUBSCRIBE_NODE_T *free_entry = NULL;
-    tuya_list_for_each_safe(free_pos, free_next, &g_event_manager.free_subscribe_root)
-    {
-        // find by event name, and add it to subscribe list
-        free_entry = tuya_list_entry(free_pos, SUBSCRIBE_NODE_T, node);
-        if (0 == strcmp(free_entry->name, name)) {
-            // del from free subscrbe list
-            tuya_list_del(&free_entry->node);
-
-            // add to different position according to the emergence flag
-            if (free_entry->type == SUBSCRIBE_TYPE_EMERGENCY) {
-                tuya_list_add(&free_entry->node, &event->subscribe_root);
-            } else {
-                tuya_list_add_tail(&free_entry->node, &event->subscribe_root);
-            }
-        }
+    if (OPRT_OK != tal_mutex_create_init(&event->mutex)) {
+        tal_free(event);
+        return NULL;
     }
 
-    // at last, need add this event to event manage root
+    // at last, need add this event to event manage root, hash bucket and id table
+    uint32_t bucket = event->hash & (EVENT_HASH_BUCKET_NUM - 1);
+    event->hash_next = g_event_manager.hash_bucket[bucket];
+    g_event_manager.hash_bucket[bucket] = event;
     tuya_list_add_tail(&event->node, &g_event_manager.event_root);
+    (*page)[(id - 1) % EVENT_ID_PAGE_SIZE] = event;
     g_event_manager.event_cnt++;
 
-    tal_mutex_unlock(g_event_manager.mutex);
-
     return event;
 }
 
-EVENT_NODE_T *_event_node_get(const char *name)
+EVENT_NODE_T *_event_node_intern(const char *name)
 {
-    // try to get event from event root
-    EVENT_NODE_T *entry = NULL;
-    struct tuya_list_head *pos = NULL;
-    tuya_list_for_each(pos, &g_event_manager.event_root)
-    {
-        // find by name
-        entry = tuya_list_entry(pos, EVENT_NODE_T, node);
-        if (0 == strcmp(entry->name, name)) {
-            return entry;
-        }
+    // get or create the event in one lock, so one name only has one id
+    tal_mutex_lock(g_event_manager.mutex);
+    EVENT_NODE_T *event = _event_node_get(name);
+    if (!event) {
+        event = _event_node_create_init(name);
     }
+    tal_mutex_unlock(g_event_manager.mutex);
 
-    return NULL;
+    return event;
 }
 
-SUBSCRIBE_NODE_T *_event_node_get_free_subscribe(SUBSCRIBE_NODE_T *subscribe)
+SUBSCRIBE_NODE_T *_event_node_get_subscribe(EVENT_NODE_T *event, SUBSCRIBE_NODE_T *subscribe)
 {
     struct tuya_list_head *pos = NULL;
     SUBSCRIBE_NODE_T *entry = NULL;
-    tuya_list_for_each(pos, &g_event_manager.free_subscribe_root)
+    tuya_list_for_each(pos, &event->subscribe_root)
     {
         // find by desc
         entry = tuya_list_entry(pos, SUBSCRIBE_NODE_T, node);
-        if (0 == strcmp(entry->name, subscribe->name) && 0 == strcmp(entry->desc, subscribe->desc) &&
-            entry->cb == subscribe->cb) {
+        if (0 == strcmp(entry->desc, subscribe->desc) && entry->cb == subscribe->cb) {
             return entry;
         }
     }
@@ -141,71 +181,110 @@ SUBSCRIBE_NODE_T *_event_node_get_free_subscribe(SUBSCRIBE_NODE_T *subscribe)
     return NULL;
 }
 
-SUBSCRIBE_NODE_T *_event_node_get_subscribe(EVENT_NODE_T *event, SUBSCRIBE_NODE_T *subscribe)
+SUBSCRIBE_SNAPSHOT_T *_event_snapshot_build(EVENT_NODE_T *event, BOOL_T skip_onetime, SUBSCRIBE_NODE_T *skip)
 {
+    // copy the subscribe list to a new snapshot, must be called in event mutex
     struct tuya_list_head *pos = NULL;
     SUBSCRIBE_NODE_T *entry = NULL;
+    SUBSCRIBE_SNAPSHOT_T *snapshot = NULL;
+    int num = 0;
+
+    tuya_list_for_each(pos, &event->subscribe_root)
+    {
+        num++;
+    }
+
+    snapshot = tal_malloc(sizeof(SUBSCRIBE_SNAPSHOT_T) + num * sizeof(EVENT_SUBSCRIBE_CB));
+    TUYA_CHECK_NULL_RETURN(snapshot, NULL);
+    memset(snapshot, 0, sizeof(SUBSCRIBE_SNAPSHOT_T));
+
     tuya_list_for_each(pos, &event->subscribe_root)
     {
-        // find by desc
         entry = tuya_list_entry(pos, SUBSCRIBE_NODE_T, node);
-        if (0 == strcmp(entry->desc, subscribe->desc) && entry->cb == subscribe->cb) {
-            return entry;
+        if (entry == skip) {
+            continue;
         }
+        if (entry->type == SUBSCRIBE_TYPE_ONETIME) {
+            if (skip_onetime) {
+                continue;
+            }
+            snapshot->onetime_cnt++;
+        }
+        snapshot->cb[snapshot->num++] = entry->cb;
     }
 
-    return NULL;
+    return snapshot;
+}
+
+void _event_snapshot_put(EVENT_NODE_T *event, SUBSCRIBE_SNAPSHOT_T *snapshot)
+{
+    // the replaced snapshot is released by the last publisher, must be called in event mutex
+    if (snapshot && snapshot->ref == 0 && snapshot != event->snapshot) {
+        tal_free(snapshot);
+    }
+}
+
+void _event_snapshot_replace(EVENT_NODE_T *event, SUBSCRIBE_SNAPSHOT_T *snapshot)
+{
+    SUBSCRIBE_SNAPSHOT_T *old = event->snapshot;
+
+    event->snapshot = snapshot;
+    _event_snapshot_put(event, old);
 }
 
 OPERATE_RET _event_node_dispatch(EVENT_NODE_T *event, void *data)
 {
     OPERATE_RET rt = OPRT_OK;
-
-    // dispatch in order
+    SUBSCRIBE_SNAPSHOT_T *snapshot = NULL;
+    SUBSCRIBE_SNAPSHOT_T *next = NULL;
     struct tuya_list_head *p = NULL;
     struct tuya_list_head *n = NULL;
     SUBSCRIBE_NODE_T *entry = NULL;
-    tuya_list_for_each_safe(p, n, &event->subscribe_root)
-    {
-        // find and call cb one by one
-        entry = tuya_list_entry(p, SUBSCRIBE_NODE_T, node);
-        if (entry->cb) {
-            TUYA_CALL_ERR_LOG(entry->cb(data));
-        }
+    int i = 0;
 
-        // one-time event should be removed after dispatch
-        if (entry->type == SUBSCRIBE_TYPE_ONETIME) {
-            tuya_list_del(&entry->node);
-            tal_free(entry);
-            entry = NULL;
+    // only hold the mutex to take the snapshot, the subscribers are called without lock
+    tal_mutex_lock(event->mutex);
+    snapshot = event->snapshot;
+    if (!snapshot || snapshot->num == 0) {
+        tal_mutex_unlock(event->mutex);
+        return OPRT_OK;
+    }
+    snapshot->ref++;
+
+    // one-time subscriber should be removed before dispatch, so other publishers never see it again
+    if (snapshot->onetime_cnt) {
+        next = _event_snapshot_build(event, TRUE, NULL);
+        if (next) {
+            tuya_list_for_each_safe(p, n, &event->subscribe_root)
+            {
+                entry = tuya_list_entry(p, SUBSCRIBE_NODE_T, node);
+                if (entry->type == SUBSCRIBE_TYPE_ONETIME) {
+                    tuya_list_del(&entry->node);
+                    tal_free(entry);
+                }
+            }
+            _event_snapshot_replace(event, next);
         }
     }
+    tal_mutex_unlock(event->mutex);
 
-    return rt;
-}
-
-OPERATE_RET _event_node_add_free_subscribe(SUBSCRIBE_NODE_T *subscribe)
-{
-    OPERATE_RET rt = OPRT_OK;
-
-    // existed, return ok, dont care, pretend to success
-    SUBSCRIBE_NODE_T *new_entry = _event_node_get_free_subscribe(subscribe);
-    if (new_entry) {
-        return OPRT_OK;
+    // dispatch in order
+    for (i = 0; i < snapshot->num; i++) {
+        TUYA_CALL_ERR_LOG(snapshot->cb[i](data));
     }
 
-    // malloc a new entry and prepare to add
-    new_entry = (SUBSCRIBE_NODE_T *)tal_malloc(sizeof(SUBSCRIBE_NODE_T));
-    TUYA_CHECK_NULL_RETURN(new_entry, OPRT_MALLOC_FAILED);
-    memcpy(new_entry, subscribe, sizeof(SUBSCRIBE_NODE_T));
+    tal_mutex_lock(event->mutex);
+    snapshot->ref--;
+    _event_snapshot_put(event, snapshot);
+    tal_mutex_unlock(event->mutex);
 
-    tuya_list_add_tail(&new_entry->node, &g_event_manager.free_subscribe_root);
     return rt;
 }
 
 OPERATE_RET _event_node_add_subscribe(EVENT_NODE_T *event, SUBSCRIBE_NODE_T *subscribe)
 {
     OPERATE_RET rt = OPRT_OK;
+    SUBSCRIBE_SNAPSHOT_T *snapshot = NULL;
 
     // existed, return ok, dont care, pretend to success
     SUBSCRIBE_NODE_T *new_entry = _event_node_get_subscribe(event, subscribe);
@@ -225,22 +304,14 @@ OPERATE_RET _event_node_add_subscribe(EVENT_NODE_T *event, SUBSCRIBE_NODE_T *sub
         tuya_list_add_tail(&new_entry->node, &event->subscribe_root);
     }
 
-    return rt;
-}
-
-OPERATE_RET _event_node_del_free_subscribe(SUBSCRIBE_NODE_T *subscribe)
-{
-    OPERATE_RET rt = OPRT_OK;
-    // not existed, return ok, dont care, pretend to success
-    SUBSCRIBE_NODE_T *new_entry = _event_node_get_free_subscribe(subscribe);
-    if (new_entry == NULL) {
-        return OPRT_OK;
+    // publish the new subscriber list
+    snapshot = _event_snapshot_build(event, FALSE, NULL);
+    if (!snapshot) {
+        tuya_list_del(&new_entry->node);
+        tal_free(new_entry);
+        return OPRT_MALLOC_FAILED;
     }
-
-    // dont forget remove and free
-    tuya_list_del(&new_entry->node);
-    tal_free(new_entry);
-    new_entry = NULL;
+    _event_snapshot_replace(event, snapshot);
 
     return rt;
 }
@@ -249,12 +320,18 @@ OPERATE_RET _event_node_del_subscribe(EVENT_NODE_T *event, SUBSCRIBE_NODE_T *sub
 {
     OPERATE_RET rt = OPRT_OK;
     SUBSCRIBE_NODE_T *new_entry = NULL;
+    SUBSCRIBE_SNAPSHOT_T *snapshot = NULL;
     // not existed, return ok, dont care, pretend to success
     new_entry = _event_node_get_subscribe(event, subscribe);
     if (new_entry == NULL) {
         return OPRT_OK;
     }
 
+    // build the snapshot first, the subscriber is kept if no memory
+    snapshot = _event_snapshot_build(event, FALSE, new_entry);
+    TUYA_CHECK_NULL_RETURN(snapshot, OPRT_MALLOC_FAILED);
+    _event_snapshot_replace(event, snapshot);
+
     // dont forget remove and free
     tuya_list_del(&new_entry->node);
     tal_free(new_entry);
@@ -292,18 +369,6 @@ int _ty_event_dump()
         }
     }
 
-    // free subscribe
-    PR_DEBUG("------------------------free--------------------------------------");
-    PR_DEBUG("name                desc                                cb");
-    PR_DEBUG("------------------------------------------------------------------");
-    SUBSCRIBE_NODE_T * subscribe = NULL;
-    tuya_list_for_each(s_pos, &g_event_manager.free_subscribe_root) {
-        subscribe = tuya_list_entry(s_pos, SUBSCRIBE_NODE_T, node);
-        if (subscribe) {
-            PR_DEBUG("%-16s    %-32s    0x%08x", subscribe->name, subscribe->desc, subscribe->cb);
-        }
-    }
-
     PR_DEBUG("\n");
 
     return OPRT_OK;
@@ -317,7 +382,7 @@ int _ty_event_dump()
  * steps:
  * 1. Checks if the event manager is already initialized. If it is, the function
  * returns OPRT_OK.
- * 2. Initializes the event root and free subscribe root lists.
+ * 2. Initializes the event root list.
  * 3. Creates and initializes the event manager mutex.
  * 4. Sets the event count to 0 and marks the event manager as initialized.
  *
@@ -336,7 +401,6 @@ OPERATE_RET tal_event_init(void)
     // we will add os adapter and base layer init here to make it success
 
     INIT_LIST_HEAD(&g_event_manager.event_root);
-    INIT_LIST_HEAD(&g_event_manager.free_subscribe_root);
     tal_mutex_create_init(&g_event_manager.mutex);
     g_event_manager.event_cnt = 0;
     g_event_manager.inited = TRUE;
@@ -359,6 +423,9 @@ OPERATE_RET tal_event_init(void)
  * subscribers fail, the function continues dispatching the event but returns a
  * failed status to record the execution status.
  *
+ * The subscribers are called from a snapshot of the subscribe list, without
+ * holding any lock, so they can publish, subscribe or unsubscribe again.
+ *
  * @param[in] name The name of the event to publish.
  * @param[in] data The data associated with the event.
  * @return The operation result. Returns OPRT_OK on success, or an error code on
@@ -376,20 +443,67 @@ OPERATE_RET tal_event_publish(const char *name, void *data)
 
     OPERATE_RET rt = OPRT_OK;
     // try to get event, if not exist, create and init.
-    EVENT_NODE_T *event = _event_node_get(name);
-    if (!event) {
-        event = _event_node_create_init(name);
-        TUYA_CHECK_NULL_RETURN(event, OPRT_MALLOC_FAILED);
-    }
+    EVENT_NODE_T *event = _event_node_intern(name);
+    TUYA_CHECK_NULL_RETURN(event, OPRT_MALLOC_FAILED);
 
-    // to keep the consistency, dispatch will done in mutex lock
-    tal_mutex_lock(event->mutex);
     // try to dispatch event to all subscribe
     // if one of the subscribe failed, it will continue but will return failed
     // to record the execute status
     TUYA_CALL_ERR_LOG(_event_node_dispatch(event, data));
 
-    tal_mutex_unlock(event->mutex);
+    return rt;
+}
+
+/**
+ * @brief Gets the id of an event.
+ *
+ * This function interns the event name to an id. If the event does not exist,
+ * it creates and initializes a new event node. The id is valid until reboot and
+ * can be used by tal_event_publish_by_id to skip the name lookup.
+ *
+ * @param[in] name The name of the event.
+ * @param[out] id The id of the event.
+ * @return The operation result. Returns OPRT_OK on success, or an error code on
+ * failure.
+ */
+OPERATE_RET tal_event_id_get(const char *name, EVENT_ID_T *id)
+{
+    if (g_event_manager.inited != TRUE) {
+        tal_event_init();
+    }
+
+    if (!_event_name_is_valid(name)) {
+        return OPRT_BASE_EVENT_INVALID_EVENT_NAME;
+    }
+    TUYA_CHECK_NULL_RETURN(id, OPRT_INVALID_PARM);
+
+    EVENT_NODE_T *event = _event_node_intern(name);
+    TUYA_CHECK_NULL_RETURN(event, OPRT_MALLOC_FAILED);
+
+    *id = event->id;
+
+    return OPRT_OK;
+}
+
+/**
+ * @brief Publishes an event with the given id and data.
+ *
+ * This function works as tal_event_publish, but the event is resolved from the
+ * id table directly, no string handling and no manager lock is needed.
+ *
+ * @param[in] id The id of the event, get from tal_event_id_get.
+ * @param[in] data The data associated with the event.
+ * @return The operation result. Returns OPRT_OK on success, or an error code on
+ * failure.
+ */
+OPERATE_RET tal_event_publish_by_id(EVENT_ID_T id, void *data)
+{
+    OPERATE_RET rt = OPRT_OK;
+
+    EVENT_NODE_T *event = _event_node_get_by_id(id);
+    TUYA_CHECK_NULL_RETURN(event, OPRT_INVALID_PARM);
+
+    TUYA_CALL_ERR_LOG(_event_node_dispatch(event, data));
 
     return rt;
 }
@@ -399,6 +513,7 @@ OPERATE_RET tal_event_publish(const char *name, void *data)
  *
  * This function subscribes to an event with the specified name and description.
  * The provided callback function will be called when the event is triggered.
+ * The event name is interned here, so the event exists before it is published.
  *
  * @param name The name of the event to subscribe to.
  * @param desc The description of the event.
@@ -432,18 +547,13 @@ OPERATE_RET tal_event_subscribe(const char *name, const char *desc, const EVENT_
     memcpy(subscribe.desc, desc, strlen(desc));
     subscribe.desc[strlen(desc)] = '\0';
 
-    EVENT_NODE_T *event = _event_node_get(name);
-    if (!event) {
-        // if not found the event, add to the free list
-        tal_mutex_lock(g_event_manager.mutex);
-        TUYA_CALL_ERR_LOG(_event_node_add_free_subscribe(&subscribe));
-        tal_mutex_unlock(g_event_manager.mutex);
-    } else {
-        // if found the event, add to the subscribe list
-        tal_mutex_lock(event->mutex);
-        TUYA_CALL_ERR_LOG(_event_node_add_subscribe(event, &subscribe));
-        tal_mutex_unlock(event->mutex);
-    }
+    // intern the event name, the event is created if not published yet
+    EVENT_NODE_T *event = _event_node_intern(name);
+    TUYA_CHECK_NULL_RETURN(event, OPRT_MALLOC_FAILED);
+
+    tal_mutex_lock(event->mutex);
+    TUYA_CALL_ERR_LOG(_event_node_add_subscribe(event, &subscribe));
+    tal_mutex_unlock(event->mutex);
 
     return rt;
 }
@@ -456,7 +566,7 @@ OPERATE_RET tal_event_subscribe(const char *name, const char *desc, const EVENT_
  * it will be initialized before unsubscribing. The function checks if the event
  * description and name are valid before proceeding with the unsubscribe
  * operation. If the event is found, it is removed from the subscribe list. If
- * the event is not found, the subscription is removed from the free list.
+ * the event is not found, nothing need to be done.
  *
  * @param[in] name The name of the event to unsubscribe from.
  * @param[in] desc The description of the event to unsubscribe from.
@@ -487,14 +597,12 @@ OPERATE_RET tal_event_unsubscribe(const char *name, const char *desc, EVENT_SUBS
     memcpy(subscribe.desc, desc, strlen(desc));
     subscribe.desc[strlen(desc)] = '\0';
 
+    tal_mutex_lock(g_event_manager.mutex);
     EVENT_NODE_T *event = _event_node_get(name);
-    if (!event) {
-        // if not found the event, del from the free list
-        tal_mutex_lock(g_event_manager.mutex);
-        TUYA_CALL_ERR_LOG(_event_node_del_free_subscribe(&subscribe));
-        tal_mutex_unlock(g_event_manager.mutex);
-    } else {
-        // if found the event, del from the subscribe list
+    tal_mutex_unlock(g_event_manager.mutex);
+
+    // not found the event, nobody subscribed it
+    if (event) {
         tal_mutex_lock(event->mutex);
         TUYA_CALL_ERR_LOG(_event_node_del_subscribe(event, &subscribe));
         tal_mutex_unlock(event->mutex);
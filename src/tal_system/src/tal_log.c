@@ -13,6 +13,10 @@
  * - Configurable log levels ranging from debug to critical errors.
  * - Support for multiple log output destinations through callback registration.
  * - Thread-safe log message output using mutexes.
+ * - Optional deferred output, log calls only copy the format arguments into a
+ *   ring buffer and a background thread formats and outputs them.
+ * - Optional binary output terminals, they receive compact frames holding the
+ *   format string address and the raw arguments, a host tool expands them.
  * - Integration with Tuya's IoT SDK for memory management and system utilities.
  *
  * The logging system is implemented using a linked list to manage output
@@ -38,6 +42,10 @@
 #include "tal_system.h"
 #include "tal_time_service.h"
 #include "tal_memory.h"
+#include "tal_thread.h"
+#include "tal_semaphore.h"
+#include "tal_log_args.h"
+#include "tal_log_bin.h"
 
 /***********************************************************
 *************************micro define***********************
@@ -45,10 +53,60 @@
 #define LOG_LEVEL_MIN 0
 #define LOG_LEVEL_MAX 5
 
+#if defined(ENABLE_LOG_ASYNC) && (ENABLE_LOG_ASYNC == 1)
+#ifndef LOG_ASYNC_RING_SIZE
+#define LOG_ASYNC_RING_SIZE (8 * 1024)
+#endif
+
+#ifndef STACK_SIZE_LOG_ASYNC
+#define STACK_SIZE_LOG_ASYNC (4 * 1024)
+#endif
+
+#define LOG_ASYNC_RETRY_MS 10
+#define LOG_REC_ALIGN      8
+#define LOG_REC_RAW        0x80 // level flag, output without head and suffix
+
+#define LOG_REC_RESERVED  0 // the producer is still copying the arguments
+#define LOG_REC_COMMITTED 1
+#define LOG_REC_PAD       2 // unused space at the end of the ring
+
+typedef struct {
+    uint32_t len; // record length including the arguments, aligned to LOG_REC_ALIGN
+    uint8_t state;
+    uint8_t level;
+    uint16_t args_len;
+    uint32_t line;
+    SYS_TICK_T time_ms;
+    const char *file;
+    const char *fmt;
+} LOG_REC_S;
+
+typedef struct {
+    uint8_t *ring;
+    uint32_t size;
+    uint32_t head; // next reserve offset, updated by producers in critical section
+    uint32_t tail; // oldest record offset, updated by the drain thread in critical section
+    uint32_t used;
+    uint32_t drop_cnt;
+    uint32_t drop_reported;
+    volatile BOOL_T running;
+    SEM_HANDLE sem;
+    SEM_HANDLE exit_sem;
+    THREAD_HANDLE thread;
+} LOG_ASYNC_S;
+#endif
+
+#if defined(ENABLE_LOG_BINARY) && (ENABLE_LOG_BINARY == 1)
+#define LOG_BIN_SYNC_INTERVAL 256 // resend the sync frame so a late host can attach
+#endif
+
 typedef struct {
     LIST_HEAD node;
     char *name;
     TAL_LOG_OUTPUT_CB out_term;
+#if defined(ENABLE_LOG_BINARY) && (ENABLE_LOG_BINARY == 1)
+    TAL_LOG_BIN_OUTPUT_CB bin_term;
+#endif
 } LOG_OUT_NODE_S;
 
 typedef struct {
@@ -73,6 +131,13 @@ typedef struct {
     int log_buf_len;
     BOOL_T ms_level;
     char *log_buf;
+#if defined(ENABLE_LOG_ASYNC) && (ENABLE_LOG_ASYNC == 1)
+    LOG_ASYNC_S async;
+#endif
+#if defined(ENABLE_LOG_BINARY) && (ENABLE_LOG_BINARY == 1)
+    uint8_t *bin_buf; // binary frame before COBS, the encoded frame goes to log_buf
+    uint32_t bin_cnt;
+#endif
 } LOG_MANAGE, *P_LOG_MANAGE;
 
 #define DEF_OUTPUT_NAME "def_output"
@@ -91,6 +156,13 @@ const LOG_TEXT_STYLE_S sDefaultStyle[LOG_LEVEL_MAX + 1] = {
     {TAL_LOG_DISPLAY_MODE_DEFAULT, TAL_LOG_FONT_COLOR_GREEN, TAL_LOG_BACKGROUND_COLOR_DEFAULT},
     {TAL_LOG_DISPLAY_MODE_DEFAULT, TAL_LOG_FONT_COLOR_WHITE, TAL_LOG_BACKGROUND_COLOR_DEFAULT}};
 
+/***********************************************************
+*************************function declaration***************
+***********************************************************/
+#if defined(ENABLE_LOG_ASYNC) && (ENABLE_LOG_ASYNC == 1)
+static OPERATE_RET __log_async_start(void);
+#endif
+
 /***********************************************************
 *************************function define********************
 ***********************************************************/
@@ -119,12 +191,20 @@ OPERATE_RET tal_log_init(const TAL_LOG_LEVEL_E level, const int buf_len, const T
     if (!pLogManage) {
         OPERATE_RET op_ret = OPRT_OK;
 
-        P_LOG_MANAGE tmp_log_mng = (P_LOG_MANAGE)tal_malloc(sizeof(LOG_MANAGE) + buf_len + 1);
+        int alloc_len = sizeof(LOG_MANAGE) + buf_len + 1;
+#if defined(ENABLE_LOG_BINARY) && (ENABLE_LOG_BINARY == 1)
+        alloc_len += buf_len;
+#endif
+        P_LOG_MANAGE tmp_log_mng = (P_LOG_MANAGE)tal_malloc(alloc_len);
         if (!tmp_log_mng) {
             return OPRT_MALLOC_FAILED;
         }
+        memset(tmp_log_mng, 0, sizeof(LOG_MANAGE));
         tmp_log_mng->log_buf_len = buf_len;
         tmp_log_mng->log_buf = (char *)(tmp_log_mng + 1);
+#if defined(ENABLE_LOG_BINARY) && (ENABLE_LOG_BINARY == 1)
+        tmp_log_mng->bin_buf = (uint8_t *)tmp_log_mng->log_buf + buf_len + 1;
+#endif
         op_ret = tal_mutex_create_init(&tmp_log_mng->mutex);
         if (OPRT_OK != op_ret) {
             tal_free(tmp_log_mng);
@@ -146,6 +226,11 @@ OPERATE_RET tal_log_init(const TAL_LOG_LEVEL_E level, const int buf_len, const T
             tal_free(tmp_log_mng);
             return op_ret;
         }
+
+#if defined(ENABLE_LOG_ASYNC) && (ENABLE_LOG_ASYNC == 1)
+        // keep the synchronous output if the drain thread can not be started
+        __log_async_start();
+#endif
     } else {
         pLogManage->curLogLevel = level;
     }
@@ -197,33 +282,82 @@ OPERATE_RET __find_out_term_node(const char *name, LOG_OUT_NODE_S **node)
  *     - OPRT_INVALID_PARM: Invalid parameter.
  *     - OPRT_MALLOC_FAILED: Memory allocation failed.
  */
+static OPERATE_RET __log_add_term(const char *name, const TAL_LOG_OUTPUT_CB term, const TAL_LOG_BIN_OUTPUT_CB bin_term)
+{
+    LOG_OUT_NODE_S *output_node;
+    OPERATE_RET ret = OPRT_OK;
+
+    tal_mutex_lock(pLogManage->mutex);
+    ret = __find_out_term_node(name, &output_node);
+    if (ret != OPRT_OK) {
+        NEW_LIST_NODE(LOG_OUT_NODE_S, output_node);
+        if (!output_node) {
+            tal_mutex_unlock(pLogManage->mutex);
+            return OPRT_MALLOC_FAILED;
+        }
+        output_node->name = tal_malloc(strlen(name) + 1);
+        if (!output_node->name) {
+            tal_free(output_node);
+            tal_mutex_unlock(pLogManage->mutex);
+            return OPRT_MALLOC_FAILED;
+        }
+        strcpy(output_node->name, name);
+        tuya_list_add(&(output_node->node), &(pLogManage->log_list));
+    }
+
+    // a terminal is either text or binary, the new callback replaces the old one
+    output_node->out_term = term;
+#if defined(ENABLE_LOG_BINARY) && (ENABLE_LOG_BINARY == 1)
+    output_node->bin_term = bin_term;
+    if (bin_term) {
+        // start the new terminal with a sync frame
+        pLogManage->bin_cnt = 0;
+    }
+#endif
+    tal_mutex_unlock(pLogManage->mutex);
+
+    return OPRT_OK;
+}
+
 OPERATE_RET tal_log_add_output_term(const char *name, const TAL_LOG_OUTPUT_CB term)
 {
     if (NULL == name || NULL == term || NULL == pLogManage) {
         return OPRT_INVALID_PARM;
     }
 
-    LOG_OUT_NODE_S *output_node;
-    OPERATE_RET ret = __find_out_term_node(name, &output_node);
-    if (ret == OPRT_OK) {
-        output_node->out_term = term;
-        return OPRT_OK;
-    }
+    return __log_add_term(name, term, NULL);
+}
 
-    NEW_LIST_NODE(LOG_OUT_NODE_S, output_node);
-    if (!output_node) {
-        return OPRT_MALLOC_FAILED;
-    }
-    output_node->name = tal_malloc(strlen(name) + 1);
-    if (!output_node->name) {
-        tal_free(output_node);
-        return OPRT_MALLOC_FAILED;
+/**
+ * @brief Adds a binary output terminal for logging.
+ *
+ * The terminal receives COBS encoded frames ending with a 0x00 byte instead of
+ * text. A frame holds the level, the time, the addresses of the file name and
+ * of the format string and the raw arguments, tools/tal_log_decode.py expands
+ * the frames back to text with the ELF of the firmware. Adding a binary
+ * terminal with the name of an existing terminal replaces it, so the default
+ * output can be switched to binary with the name "def_output".
+ *
+ * @param[in] name The name of the output terminal.
+ * @param[in] term The callback function for the output terminal.
+ *
+ * @return The result of the operation.
+ *     - OPRT_OK: Operation successful.
+ *     - OPRT_INVALID_PARM: Invalid parameter.
+ *     - OPRT_MALLOC_FAILED: Memory allocation failed.
+ *     - OPRT_NOT_SUPPORTED: ENABLE_LOG_BINARY is not set.
+ */
+OPERATE_RET tal_log_add_binary_term(const char *name, const TAL_LOG_BIN_OUTPUT_CB term)
+{
+#if defined(ENABLE_LOG_BINARY) && (ENABLE_LOG_BINARY == 1)
+    if (NULL == name || NULL == term || NULL == pLogManage) {
+        return OPRT_INVALID_PARM;
     }
-    strcpy(output_node->name, name);
-    output_node->out_term = term;
-    tuya_list_add(&(output_node->node), &(pLogManage->log_list));
 
-    return OPRT_OK;
+    return __log_add_term(name, NULL, term);
+#else
+    return OPRT_NOT_SUPPORTED;
+#endif
 }
 
 static int tal_log_strrchr(char *str, char ch)
@@ -363,40 +497,28 @@ OPERATE_RET tal_log_get_level(TAL_LOG_LEVEL_E *level)
  *     - OPRT_BASE_LOG_MNG_FORMAT_STRING_FAILED if there was an error formatting
  * the log message.
  */
-OPERATE_RET PrintLogV(LOG_LEVEL logLevel, char *pFile, uint32_t line, const char *pFmt, va_list ap)
+static const char *__log_file_name(const char *pFile)
 {
-    int len = 0;
-    int cnt = 0;
+    int pos = 0;
 
-    if (!pLogManage) {
-        return OPRT_INVALID_PARM;
-    }
-    if (logLevel < LOG_LEVEL_MIN || logLevel > LOG_LEVEL_MAX) {
-        return OPRT_INVALID_PARM;
-    }
-    LOG_LEVEL tmpLogLevel = pLogManage->curLogLevel;
-    if (logLevel > tmpLogLevel) {
-        return OPRT_BASE_LOG_MNG_PRINT_LOG_LEVEL_HIGHER;
+    if (NULL == pFile) {
+        return "Null";
     }
-    const char *pTmpModuleName = "ty";
-    const char *pTmpFilename = NULL;
 
-    if (NULL == pFile) {
-        pTmpFilename = "Null";
-    } else {
-        int pos = 0;
-        pTmpFilename = pFile;
-        pos = tal_log_strrchr((char *)pFile, '/');
-        if (pos < 0) {
-            pos = tal_log_strrchr((char *)pFile, '\\');
-            if (pos >= 0) {
-                pTmpFilename = pFile + pos + 1;
-            }
-        } else {
-            pTmpFilename = pFile + pos + 1;
-        }
+    pos = tal_log_strrchr((char *)pFile, '/');
+    if (pos < 0) {
+        pos = tal_log_strrchr((char *)pFile, '\\');
     }
-    tal_mutex_lock(pLogManage->mutex);
+
+    return (pos >= 0) ? pFile + pos + 1 : pFile;
+}
+
+// format color prefix, time and position into log_buf, time_ms 0 means now
+static int __log_head_format(LOG_LEVEL logLevel, const char *pTmpFilename, uint32_t line, SYS_TICK_T time_ms)
+{
+    int len = 0;
+    int cnt = 0;
+    const char *pTmpModuleName = "ty";
 
     // color prefix
     if (pLogManage->log_color.enable_color) {
@@ -405,7 +527,7 @@ OPERATE_RET PrintLogV(LOG_LEVEL logLevel, char *pFile, uint32_t line, const char
                        pLogManage->log_color.style[logLevel].font_color,
                        pLogManage->log_color.style[logLevel].background_color);
         if (cnt <= 0) {
-            goto ERR_EXIT;
+            return -1;
         }
         len += cnt;
     }
@@ -414,12 +536,12 @@ OPERATE_RET PrintLogV(LOG_LEVEL logLevel, char *pFile, uint32_t line, const char
     memset(&tm, 0, sizeof(tm));
 
     if (pLogManage->ms_level == FALSE) {
-        tal_time_get_local_time_custom(0, &tm);
+        tal_time_get_local_time_custom((TIME_T)(time_ms / 1000), &tm);
         cnt = snprintf(pLogManage->log_buf + len, pLogManage->log_buf_len - len,
                        "[%02d-%02d %02d:%02d:%02d %s %s][%s:%" PRIu32 "] ", tm.tm_mon + 1, tm.tm_mday, tm.tm_hour,
                        tm.tm_min, tm.tm_sec, pTmpModuleName, sLevelStr[logLevel], pTmpFilename, line);
     } else {
-        SYS_TICK_T time_ms = tal_time_get_posix_ms();
+        time_ms = time_ms ? time_ms : tal_time_get_posix_ms();
         TIME_T sec = (TIME_T)(time_ms / 1000);
         uint32_t ms = (uint32_t)(time_ms % 1000);
         tal_time_get_local_time_custom(sec, &tm);
@@ -428,14 +550,16 @@ OPERATE_RET PrintLogV(LOG_LEVEL logLevel, char *pFile, uint32_t line, const char
                        tm.tm_hour, tm.tm_min, tm.tm_sec, ms, pTmpModuleName, sLevelStr[logLevel], pTmpFilename, line);
     }
     if (cnt <= 0) {
-        goto ERR_EXIT;
-    }
-    len += cnt;
-    cnt = vsnprintf(pLogManage->log_buf + len, pLogManage->log_buf_len - len, pFmt, ap);
-    if (cnt <= 0) {
-        goto ERR_EXIT;
+        return -1;
     }
-    len += cnt;
+
+    return len + cnt;
+}
+
+// append the color suffix and the line end to log_buf
+static int __log_tail_format(int len)
+{
+    int cnt = 0;
 
     char *p_suffix = (pLogManage->log_color.enable_color) ? "\033[0m\r\n" : "\r\n";
     if (len > (int)(pLogManage->log_buf_len - strlen(p_suffix) - 1)) { // 1 -> "\0"
@@ -443,11 +567,465 @@ OPERATE_RET PrintLogV(LOG_LEVEL logLevel, char *pFile, uint32_t line, const char
     }
     cnt = snprintf(pLogManage->log_buf + len, pLogManage->log_buf_len - len, "%s", p_suffix);
     if (cnt <= 0) {
-        goto ERR_EXIT;
+        return -1;
     }
     len += cnt;
     pLogManage->log_buf[len] = '\0';
 
+    return len;
+}
+
+#if defined(ENABLE_LOG_BINARY) && (ENABLE_LOG_BINARY == 1)
+// format of the frames whose arguments were formatted on the device
+static const char sLogBinTextFmt[] = "%s";
+
+static BOOL_T __log_term_exist(BOOL_T binary)
+{
+    P_LIST_HEAD pPos;
+    LOG_OUT_NODE_S *output_node;
+
+    tuya_list_for_each(pPos, &(pLogManage->log_list))
+    {
+        output_node = tuya_list_entry(pPos, LOG_OUT_NODE_S, node);
+        if (binary ? (NULL != output_node->bin_term) : (NULL != output_node->out_term)) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+// max frame length in bin_buf that still fits log_buf once COBS encoded
+static int __log_bin_raw_max(void)
+{
+    return pLogManage->log_buf_len - pLogManage->log_buf_len / 254 - 2;
+}
+
+// encode the frame of bin_buf into log_buf and output it to the binary terminals
+static void __log_bin_output(int raw_len)
+{
+    P_LIST_HEAD pPos;
+    LOG_OUT_NODE_S *output_node;
+    int len = 0;
+
+    len = tal_log_bin_frame(pLogManage->bin_buf, raw_len, (uint8_t *)pLogManage->log_buf, pLogManage->log_buf_len + 1);
+    if (len <= 0) {
+        return;
+    }
+
+    tuya_list_for_each(pPos, &(pLogManage->log_list))
+    {
+        output_node = tuya_list_entry(pPos, LOG_OUT_NODE_S, node);
+        if (output_node->bin_term) {
+            output_node->bin_term((const uint8_t *)pLogManage->log_buf, len);
+        }
+    }
+}
+
+static int __log_bin_head(BOOL_T raw, LOG_LEVEL level, const char *file, uint32_t line, SYS_TICK_T time_ms,
+                          const char *fmt)
+{
+    if (raw) {
+        return tal_log_bin_raw_head(pLogManage->bin_buf, fmt);
+    }
+
+    return tal_log_bin_head(pLogManage->bin_buf, level, time_ms, file, line, fmt);
+}
+
+static void __log_bin_sync_check(void)
+{
+    if (0 == pLogManage->bin_cnt++ % LOG_BIN_SYNC_INTERVAL) {
+        __log_bin_output(tal_log_bin_sync(pLogManage->bin_buf, tal_time_get_posix_ms()));
+    }
+}
+
+// output one binary frame from the format arguments, called with the mutex locked, ap is not consumed
+static void __log_bin_print_v(BOOL_T raw, LOG_LEVEL level, const char *file, uint32_t line, const char *fmt,
+                              va_list ap)
+{
+    int raw_max = __log_bin_raw_max();
+    int len = 0, args_len = 0, cnt = 0;
+    va_list cp;
+
+    __log_bin_sync_check();
+
+    len = __log_bin_head(raw, level, file, line, tal_time_get_posix_ms(), fmt);
+    args_len = tal_log_args_size(fmt, ap, raw_max - len - 1);
+    if (args_len >= 0 && args_len <= raw_max - len) {
+        len += tal_log_args_encode(fmt, ap, raw_max - len - 1, pLogManage->bin_buf + len);
+    } else {
+        // unsupported conversion or too many strings, send the text instead
+        len = __log_bin_head(raw, level, file, line, tal_time_get_posix_ms(), sLogBinTextFmt);
+        va_copy(cp, ap);
+        cnt = vsnprintf((char *)pLogManage->bin_buf + len, raw_max - len, fmt, cp);
+        va_end(cp);
+        if (cnt < 0) {
+            return;
+        }
+        len += ((cnt < raw_max - len) ? cnt : raw_max - len - 1) + 1;
+    }
+
+    __log_bin_output(len);
+}
+
+// output one binary frame from arguments encoded by tal_log_args, called with the mutex locked
+static void __log_bin_print(BOOL_T raw, LOG_LEVEL level, const char *file, uint32_t line, SYS_TICK_T time_ms,
+                            const char *fmt, const uint8_t *args, int args_len)
+{
+    int raw_max = __log_bin_raw_max();
+    int len = 0;
+
+    __log_bin_sync_check();
+
+    len = __log_bin_head(raw, level, file, line, time_ms, fmt);
+    if (args_len <= raw_max - len) {
+        memcpy(pLogManage->bin_buf + len, args, args_len);
+        len += args_len;
+    } else {
+        len = __log_bin_head(raw, level, file, line, time_ms, sLogBinTextFmt);
+        len += tal_log_args_format((char *)pLogManage->bin_buf + len, raw_max - len, fmt, args, args_len) + 1;
+    }
+
+    __log_bin_output(len);
+}
+
+static void __log_bin_print_raw(const char *fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, fmt);
+    __log_bin_print_v(TRUE, 0, NULL, 0, fmt, ap);
+    va_end(ap);
+}
+#endif
+
+#if defined(ENABLE_LOG_ASYNC) && (ENABLE_LOG_ASYNC == 1)
+static const char sLogDropFmt[] = "[log] %" PRIu32 " records dropped, ring full\r\n";
+
+static LOG_REC_S *__log_async_reserve(uint32_t len)
+{
+    LOG_ASYNC_S *async = &pLogManage->async;
+    LOG_REC_S *rec = NULL;
+    uint32_t pad_len = 0;
+
+    uint32_t irq_mask = tal_system_enter_critical();
+    if (async->head + len > async->size) {
+        pad_len = async->size - async->head;
+    }
+    if (pad_len + len <= async->size - async->used) {
+        if (pad_len) {
+            // records never wrap, skip the end of the ring
+            rec = (LOG_REC_S *)(async->ring + async->head);
+            rec->len = pad_len;
+            rec->state = LOG_REC_PAD;
+            async->used += pad_len;
+            async->head = 0;
+        }
+        rec = (LOG_REC_S *)(async->ring + async->head);
+        rec->len = len;
+        rec->state = LOG_REC_RESERVED;
+        async->used += len;
+        async->head = (async->head + len) % async->size;
+    } else {
+        async->drop_cnt++;
+        rec = NULL;
+    }
+    tal_system_exit_critical(irq_mask);
+
+    return rec;
+}
+
+static OPERATE_RET __log_async_post(uint8_t level, const char *file, uint32_t line, const char *fmt, va_list ap)
+{
+    LOG_REC_S *rec = NULL;
+    const char *rec_fmt = fmt;
+    int args_len = 0;
+    uint32_t rec_len = 0;
+    va_list cp;
+
+    // the string arguments never need more than the output buffer
+    args_len = tal_log_args_size(fmt, ap, pLogManage->log_buf_len);
+    if (args_len < 0) {
+        // unsupported conversion, format the text now and defer the output only
+        va_copy(cp, ap);
+        args_len = vsnprintf(NULL, 0, fmt, cp);
+        va_end(cp);
+        if (args_len < 0) {
+            return OPRT_BASE_LOG_MNG_FORMAT_STRING_FAILED;
+        }
+        args_len = ((args_len < pLogManage->log_buf_len) ? args_len : pLogManage->log_buf_len) + 1;
+        rec_fmt = "%s";
+    }
+
+    rec_len = (sizeof(LOG_REC_S) + args_len + LOG_REC_ALIGN - 1) & ~(LOG_REC_ALIGN - 1);
+    if (rec_len > pLogManage->async.size / 2 || NULL == (rec = __log_async_reserve(rec_len))) {
+        return OPRT_EXCEED_UPPER_LIMIT;
+    }
+
+    rec->level = level;
+    rec->args_len = args_len;
+    rec->line = line;
+    rec->file = file;
+    rec->fmt = rec_fmt;
+    rec->time_ms = (level & LOG_REC_RAW) ? 0 : tal_time_get_posix_ms();
+    if (rec_fmt == fmt) {
+        tal_log_args_encode(fmt, ap, pLogManage->log_buf_len, (uint8_t *)(rec + 1));
+    } else {
+        va_copy(cp, ap);
+        vsnprintf((char *)(rec + 1), args_len, fmt, cp);
+        va_end(cp);
+    }
+
+    uint32_t irq_mask = tal_system_enter_critical();
+    rec->state = LOG_REC_COMMITTED;
+    tal_system_exit_critical(irq_mask);
+
+    tal_semaphore_post(pLogManage->async.sem);
+
+    return OPRT_OK;
+}
+
+static OPERATE_RET __log_async_post_raw(const char *fmt, ...)
+{
+    OPERATE_RET rt = OPRT_OK;
+    va_list ap;
+
+    va_start(ap, fmt);
+    rt = __log_async_post(LOG_REC_RAW, NULL, 0, fmt, ap);
+    va_end(ap);
+
+    return rt;
+}
+
+static void __log_async_output(LOG_REC_S *rec)
+{
+    LOG_LEVEL level = (LOG_LEVEL)(rec->level & ~LOG_REC_RAW);
+    const uint8_t *args = (const uint8_t *)(rec + 1);
+    int len = 0;
+
+    tal_mutex_lock(pLogManage->mutex);
+#if defined(ENABLE_LOG_BINARY) && (ENABLE_LOG_BINARY == 1)
+    if (__log_term_exist(TRUE)) {
+        __log_bin_print((rec->level & LOG_REC_RAW) ? TRUE : FALSE, level, rec->file, rec->line, rec->time_ms, rec->fmt,
+                        args, rec->args_len);
+    }
+    if (!__log_term_exist(FALSE)) {
+        tal_mutex_unlock(pLogManage->mutex);
+        return;
+    }
+#endif
+    if (rec->level & LOG_REC_RAW) {
+        len = tal_log_args_format(pLogManage->log_buf, pLogManage->log_buf_len, rec->fmt, args, rec->args_len);
+    } else {
+        len = __log_head_format(level, rec->file, rec->line, rec->time_ms);
+        if (len > 0 && len < pLogManage->log_buf_len) {
+            len += tal_log_args_format(pLogManage->log_buf + len, pLogManage->log_buf_len - len, rec->fmt, args,
+                                       rec->args_len);
+            len = __log_tail_format(len);
+        }
+    }
+    if (len > 0) {
+        __output_logManage_buf();
+    }
+    tal_mutex_unlock(pLogManage->mutex);
+}
+
+// output all committed records, return FALSE if stopped at a record still being copied
+static BOOL_T __log_async_drain(void)
+{
+    LOG_ASYNC_S *async = &pLogManage->async;
+    LOG_REC_S *rec = NULL;
+    uint32_t used = 0, drop_cnt = 0;
+    uint8_t state = 0;
+    uint32_t irq_mask = 0;
+
+    for (;;) {
+        irq_mask = tal_system_enter_critical();
+        used = async->used;
+        rec = (LOG_REC_S *)(async->ring + async->tail);
+        state = used ? rec->state : LOG_REC_PAD;
+        drop_cnt = async->drop_cnt;
+        tal_system_exit_critical(irq_mask);
+
+        // report the overflow once the ring has room again
+        if (drop_cnt != async->drop_reported && used < async->size / 2) {
+            tal_mutex_lock(pLogManage->mutex);
+            snprintf(pLogManage->log_buf, pLogManage->log_buf_len, sLogDropFmt, drop_cnt - async->drop_reported);
+            __output_logManage_buf();
+#if defined(ENABLE_LOG_BINARY) && (ENABLE_LOG_BINARY == 1)
+            __log_bin_print_raw(sLogDropFmt, drop_cnt - async->drop_reported);
+#endif
+            tal_mutex_unlock(pLogManage->mutex);
+            async->drop_reported = drop_cnt;
+        }
+
+        if (0 == used) {
+            return TRUE;
+        }
+        if (state == LOG_REC_RESERVED) {
+            return FALSE;
+        }
+        if (state == LOG_REC_COMMITTED) {
+            __log_async_output(rec);
+        }
+
+        irq_mask = tal_system_enter_critical();
+        async->used -= rec->len;
+        async->tail = (async->tail + rec->len) % async->size;
+        tal_system_exit_critical(irq_mask);
+    }
+}
+
+static void __log_async_thread(void *arg)
+{
+    LOG_ASYNC_S *async = &pLogManage->async;
+    THREAD_HANDLE thread = NULL;
+    uint32_t timeout = SEM_WAIT_FOREVER;
+
+    while (async->running) {
+        tal_semaphore_wait(async->sem, timeout);
+        timeout = __log_async_drain() ? SEM_WAIT_FOREVER : LOG_ASYNC_RETRY_MS;
+    }
+
+    // the manager may be freed as soon as exit_sem is posted
+    __log_async_drain();
+    thread = async->thread;
+    tal_semaphore_post(async->exit_sem);
+    tal_thread_delete(thread);
+}
+
+static OPERATE_RET __log_async_start(void)
+{
+    OPERATE_RET rt = OPRT_OK;
+    LOG_ASYNC_S *async = &pLogManage->async;
+    THREAD_CFG_T thread_cfg = {.stackDepth = STACK_SIZE_LOG_ASYNC, .priority = THREAD_PRIO_5, .thrdname = "log_async"};
+
+    async->size = LOG_ASYNC_RING_SIZE & ~(LOG_REC_ALIGN - 1);
+    async->ring = tal_malloc(async->size);
+    TUYA_CHECK_NULL_RETURN(async->ring, OPRT_MALLOC_FAILED);
+
+    TUYA_CALL_ERR_GOTO(tal_semaphore_create_init(&async->sem, 0, 1), __ERR);
+    TUYA_CALL_ERR_GOTO(tal_semaphore_create_init(&async->exit_sem, 0, 1), __ERR);
+
+    async->running = TRUE;
+    TUYA_CALL_ERR_GOTO(tal_thread_create_and_start(&async->thread, NULL, NULL, __log_async_thread, NULL, &thread_cfg),
+                       __ERR);
+
+    return OPRT_OK;
+
+__ERR:
+    async->running = FALSE;
+    if (async->exit_sem) {
+        tal_semaphore_release(async->exit_sem);
+    }
+    if (async->sem) {
+        tal_semaphore_release(async->sem);
+    }
+    tal_free(async->ring);
+    memset(async, 0, sizeof(LOG_ASYNC_S));
+    return rt;
+}
+
+static void __log_async_stop(void)
+{
+    LOG_ASYNC_S *async = &pLogManage->async;
+
+    if (!async->running) {
+        return;
+    }
+
+    async->running = FALSE;
+    tal_semaphore_post(async->sem);
+    tal_semaphore_wait(async->exit_sem, SEM_WAIT_FOREVER);
+
+    tal_semaphore_release(async->exit_sem);
+    tal_semaphore_release(async->sem);
+    tal_free(async->ring);
+    memset(async, 0, sizeof(LOG_ASYNC_S));
+}
+#endif
+
+/**
+ * @brief Prints a log message with the specified log level, file name, line
+ * number, and format string.
+ *
+ * This function is used to print log messages with different log levels. It
+ * takes the log level, file name, line number, format string, and a variable
+ * argument list as parameters. The log level determines the severity of the log
+ * message. The file name and line number indicate the location where the log
+ * message is printed. The format string specifies the format of the log
+ * message, and the variable argument list contains the values to be formatted
+ * and printed.
+ *
+ * When ENABLE_LOG_ASYNC is set, the arguments are copied into the log ring and
+ * the message is formatted and output later by the log thread. If the ring is
+ * full the message is dropped and counted, the caller is never blocked.
+ *
+ * @param logLevel The log level of the message.
+ * @param pFile The name of the source file where the log message is printed.
+ * @param line The line number in the source file where the log message is
+ * printed.
+ * @param pFmt The format string for the log message.
+ * @param ap The variable argument list for the format string.
+ * @return The result of the log printing operation.
+ *     - OPRT_OK if the log message was printed successfully.
+ *     - OPRT_INVALID_PARM if the log level is invalid or the log manager is not
+ * initialized.
+ *     - OPRT_BASE_LOG_MNG_PRINT_LOG_LEVEL_HIGHER if the log level is higher
+ * than the current log level.
+ *     - OPRT_BASE_LOG_MNG_FORMAT_STRING_FAILED if there was an error formatting
+ * the log message.
+ *     - OPRT_EXCEED_UPPER_LIMIT if the log ring is full.
+ */
+OPERATE_RET PrintLogV(LOG_LEVEL logLevel, char *pFile, uint32_t line, const char *pFmt, va_list ap)
+{
+    int len = 0;
+    int cnt = 0;
+
+    if (!pLogManage) {
+        return OPRT_INVALID_PARM;
+    }
+    if (logLevel < LOG_LEVEL_MIN || logLevel > LOG_LEVEL_MAX) {
+        return OPRT_INVALID_PARM;
+    }
+    LOG_LEVEL tmpLogLevel = pLogManage->curLogLevel;
+    if (logLevel > tmpLogLevel) {
+        return OPRT_BASE_LOG_MNG_PRINT_LOG_LEVEL_HIGHER;
+    }
+    const char *pTmpFilename = __log_file_name(pFile);
+
+#if defined(ENABLE_LOG_ASYNC) && (ENABLE_LOG_ASYNC == 1)
+    if (pLogManage->async.running) {
+        return __log_async_post(logLevel, pTmpFilename, line, pFmt, ap);
+    }
+#endif
+
+    tal_mutex_lock(pLogManage->mutex);
+
+#if defined(ENABLE_LOG_BINARY) && (ENABLE_LOG_BINARY == 1)
+    if (__log_term_exist(TRUE)) {
+        __log_bin_print_v(FALSE, logLevel, pTmpFilename, line, pFmt, ap);
+    }
+    if (!__log_term_exist(FALSE)) {
+        tal_mutex_unlock(pLogManage->mutex);
+        return OPRT_OK;
+    }
+#endif
+
+    len = __log_head_format(logLevel, pTmpFilename, line, 0);
+    if (len <= 0) {
+        goto ERR_EXIT;
+    }
+    cnt = vsnprintf(pLogManage->log_buf + len, pLogManage->log_buf_len - len, pFmt, ap);
+    if (cnt <= 0) {
+        goto ERR_EXIT;
+    }
+    len += cnt;
+
+    if (__log_tail_format(len) <= 0) {
+        goto ERR_EXIT;
+    }
+
     __output_logManage_buf();
     tal_mutex_unlock(pLogManage->mutex);
 
@@ -492,6 +1070,15 @@ OPERATE_RET tal_log_print(const TAL_LOG_LEVEL_E level, const char *file, const i
 static OPERATE_RET __PrintLogVRaw(const char *pFmt, va_list ap)
 {
     int cnt = 0;
+
+#if defined(ENABLE_LOG_BINARY) && (ENABLE_LOG_BINARY == 1)
+    if (__log_term_exist(TRUE)) {
+        __log_bin_print_v(TRUE, 0, NULL, 0, pFmt, ap);
+    }
+    if (!__log_term_exist(FALSE)) {
+        return OPRT_OK;
+    }
+#endif
     cnt = vsnprintf(pLogManage->log_buf, pLogManage->log_buf_len, pFmt, ap);
     if (cnt <= 0) {
         return OPRT_BASE_LOG_MNG_FORMAT_STRING_FAILED;
@@ -522,6 +1109,15 @@ OPERATE_RET tal_log_print_raw(const char *pFmt, ...)
     OPERATE_RET opRet = 0;
     va_list ap;
 
+#if defined(ENABLE_LOG_ASYNC) && (ENABLE_LOG_ASYNC == 1)
+    if (pLogManage->async.running) {
+        va_start(ap, pFmt);
+        opRet = __log_async_post(LOG_REC_RAW, NULL, 0, pFmt, ap);
+        va_end(ap);
+        return opRet;
+    }
+#endif
+
     tal_mutex_lock(pLogManage->mutex);
     va_start(ap, pFmt);
     opRet = __PrintLogVRaw(pFmt, ap);
@@ -545,9 +1141,13 @@ void tal_log_release(void)
         return;
     }
 
+#if defined(ENABLE_LOG_ASYNC) && (ENABLE_LOG_ASYNC == 1)
+    __log_async_stop();
+#endif
+
     while (!tuya_list_empty(&(pLogManage->log_list))) {
         LOG_OUT_NODE_S *log_out_nd = NULL;
-        log_out_nd = tuya_list_entry(&(pLogManage->log_list.next), LOG_OUT_NODE_S, node);
+        log_out_nd = tuya_list_entry(pLogManage->log_list.next, LOG_OUT_NODE_S, node);
         tuya_list_del(&(log_out_nd->node));
         if (log_out_nd->name) {
             tal_free(log_out_nd->name);
@@ -558,6 +1158,54 @@ void tal_log_release(void)
     pLogManage = NULL;
 }
 
+/**
+ * @brief Waits until the deferred logs are output.
+ *
+ * This function wakes the log thread and waits until the log ring is empty or
+ * the timeout expires. It returns immediately when the deferred output is not
+ * enabled.
+ *
+ * @param timeout_ms The max wait time in ms.
+ * @return OPRT_OK if the ring is empty, OPRT_TIMEOUT otherwise.
+ */
+OPERATE_RET tal_log_flush(uint32_t timeout_ms)
+{
+#if defined(ENABLE_LOG_ASYNC) && (ENABLE_LOG_ASYNC == 1)
+    SYS_TIME_T start = tal_system_get_millisecond();
+
+    if (!pLogManage || !pLogManage->async.running) {
+        return OPRT_OK;
+    }
+
+    while (pLogManage->async.used) {
+        if (tal_system_get_millisecond() - start >= timeout_ms) {
+            return OPRT_TIMEOUT;
+        }
+        tal_semaphore_post(pLogManage->async.sem);
+        tal_system_sleep(LOG_ASYNC_RETRY_MS);
+    }
+#endif
+
+    return OPRT_OK;
+}
+
+/**
+ * @brief Gets the number of deferred logs dropped because the log ring was full.
+ *
+ * @return The dropped log count, always 0 when the deferred output is not
+ * enabled.
+ */
+uint32_t tal_log_get_drop_cnt(void)
+{
+#if defined(ENABLE_LOG_ASYNC) && (ENABLE_LOG_ASYNC == 1)
+    if (pLogManage) {
+        return pLogManage->async.drop_cnt;
+    }
+#endif
+
+    return 0;
+}
+
 /**
  * @brief Logs a hexadecimal dump of a buffer.
  *
@@ -595,28 +1243,29 @@ void tal_log_hex_dump(const TAL_LOG_LEVEL_E level, const char *file, const int l
     }
     tal_log_print(level, file, line, "%s %d <%p>", title, size, buf);
 
+    // one raw output per line, keep the line together in the deferred mode
+    char line_buf[8 + 64 * 3 + 2 + 64 + 3];
+    int len = 0;
+
     for (i = 0; i < size; i += width) {
-        tal_log_print_raw("%04lX | ", i);
+        len = snprintf(line_buf, sizeof(line_buf), "%04X | ", i);
 
         for (j = i; j < i + width; j++) {
             if (j < size) {
-                tal_log_print_raw("%02X ", buf[j]);
+                len += snprintf(line_buf + len, sizeof(line_buf) - len, "%02X ", buf[j]);
             } else {
-                tal_log_print_raw("   ");
+                len += snprintf(line_buf + len, sizeof(line_buf) - len, "   ");
             }
         }
 
-        tal_log_print_raw("| ");
+        len += snprintf(line_buf + len, sizeof(line_buf) - len, "| ");
 
         for (j = i; j < i + width && j < size; j++) {
-            if (isprint(buf[j])) {
-                tal_log_print_raw("%c", buf[j]);
-            } else {
-                tal_log_print_raw(".");
-            }
+            line_buf[len++] = isprint(buf[j]) ? buf[j] : '.';
         }
+        line_buf[len] = '\0';
 
-        tal_log_print_raw("\r\n");
+        tal_log_print_raw("%s\r\n", line_buf);
     }
     tal_log_print_raw("\r\n");
 }
@@ -727,7 +1376,22 @@ OPERATE_RET tal_log_color_print_raw(TAL_LOG_DISPLAY_MODE_E display_mode, TAL_LOG
 
     pLogManage->log_buf[len] = 0;
 
+#if defined(ENABLE_LOG_ASYNC) && (ENABLE_LOG_ASYNC == 1)
+    // keep the order with the deferred logs
+    if (pLogManage->async.running) {
+        opRet = __log_async_post_raw("%s", pLogManage->log_buf);
+        goto __EXIT;
+    }
+#endif
     __output_logManage_buf();
+#if defined(ENABLE_LOG_BINARY) && (ENABLE_LOG_BINARY == 1)
+    if (__log_term_exist(TRUE)) {
+        // log_buf holds the binary frame afterwards, restart the arguments
+        va_end(ap);
+        va_start(ap, pFmt);
+        __log_bin_print_v(TRUE, 0, NULL, 0, pFmt, ap);
+    }
+#endif
 
 __EXIT:
     va_end(ap);
@@ -0,0 +1,427 @@
+/**
+ * @file tal_log_args.c
+ * @brief Private codec of printf style log arguments.
+ *
+ * Encoded layout, in the order of the conversions of the format string:
+ * - '*' width and precision: int
+ * - d, i, o, u, x, X, c: int, long, long long, size_t, intmax_t or ptrdiff_t
+ *   according to the length modifier, char and short are stored as int
+ * - p: void *
+ * - a, e, f, g and their upper case: double
+ * - s: the string bytes with the terminating NUL
+ *
+ * Wide characters, long double and %n are not supported.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "tal_log_args.h"
+
+/***********************************************************
+*************************micro define***********************
+***********************************************************/
+#define LOG_ARG_SPEC_MAX_LEN 48
+
+typedef uint8_t LOG_ARG_TYPE_E;
+#define LOG_ARG_NONE    0 // "%%", no argument
+#define LOG_ARG_INT     1
+#define LOG_ARG_LONG    2
+#define LOG_ARG_LLONG   3
+#define LOG_ARG_SIZE    4
+#define LOG_ARG_INTMAX  5
+#define LOG_ARG_PTRDIFF 6
+#define LOG_ARG_PTR     7
+#define LOG_ARG_DOUBLE  8
+#define LOG_ARG_STR     9
+#define LOG_ARG_BAD     10 // unsupported conversion
+
+typedef struct {
+    const char *start; // the '%' of the conversion
+    const char *end;   // the char after the conversion
+    uint8_t star_num;  // number of '*' int arguments before the value
+    uint8_t prec_star; // precision is given by '*'
+    int prec;          // literal precision, -1 if not given
+    LOG_ARG_TYPE_E type;
+} LOG_ARG_SPEC_T;
+
+static const char sNullStr[] = "(null)";
+
+/***********************************************************
+*************************function define********************
+***********************************************************/
+static BOOL_T __arg_is_digit(char ch)
+{
+    return (ch >= '0' && ch <= '9') ? TRUE : FALSE;
+}
+
+static const char *__arg_spec_parse(const char *p, LOG_ARG_SPEC_T *spec)
+{
+    uint8_t length = 0; // 'H' for hh, 'h', 'l', 'q' for ll, 'z', 'j', 't', 'L'
+
+    memset(spec, 0, sizeof(LOG_ARG_SPEC_T));
+    spec->start = p++;
+    spec->prec = -1;
+
+    if (*p == '%') {
+        spec->type = LOG_ARG_NONE;
+        spec->end = p + 1;
+        return spec->end;
+    }
+
+    // flags
+    while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0') {
+        p++;
+    }
+
+    // width
+    if (*p == '*') {
+        spec->star_num++;
+        p++;
+    } else {
+        while (__arg_is_digit(*p)) {
+            p++;
+        }
+    }
+
+    // precision
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            spec->prec_star = TRUE;
+            spec->star_num++;
+            p++;
+        } else {
+            spec->prec = 0;
+            while (__arg_is_digit(*p)) {
+                spec->prec = spec->prec * 10 + (*p++ - '0');
+            }
+        }
+    }
+
+    // length modifier
+    if (*p == 'h') {
+        length = (*(p + 1) == 'h') ? 'H' : 'h';
+        p += (length == 'H') ? 2 : 1;
+    } else if (*p == 'l') {
+        length = (*(p + 1) == 'l') ? 'q' : 'l';
+        p += (length == 'q') ? 2 : 1;
+    } else if (*p == 'z' || *p == 'j' || *p == 't' || *p == 'L') {
+        length = *p++;
+    }
+
+    // conversion
+    switch (*p) {
+    case 'd':
+    case 'i':
+    case 'o':
+    case 'u':
+    case 'x':
+    case 'X':
+        if (length == 'l') {
+            spec->type = LOG_ARG_LONG;
+        } else if (length == 'q') {
+            spec->type = LOG_ARG_LLONG;
+        } else if (length == 'z') {
+            spec->type = LOG_ARG_SIZE;
+        } else if (length == 'j') {
+            spec->type = LOG_ARG_INTMAX;
+        } else if (length == 't') {
+            spec->type = LOG_ARG_PTRDIFF;
+        } else if (length == 'L') {
+            spec->type = LOG_ARG_BAD;
+        } else {
+            spec->type = LOG_ARG_INT;
+        }
+        break;
+    case 'c':
+        spec->type = length ? LOG_ARG_BAD : LOG_ARG_INT;
+        break;
+    case 's':
+        spec->type = length ? LOG_ARG_BAD : LOG_ARG_STR;
+        break;
+    case 'p':
+        spec->type = LOG_ARG_PTR;
+        break;
+    case 'a':
+    case 'A':
+    case 'e':
+    case 'E':
+    case 'f':
+    case 'F':
+    case 'g':
+    case 'G':
+        spec->type = (length == 'L') ? LOG_ARG_BAD : LOG_ARG_DOUBLE;
+        break;
+    default:
+        spec->type = LOG_ARG_BAD;
+        break;
+    }
+
+    spec->end = (*p) ? p + 1 : p;
+    return spec->end;
+}
+
+static int __arg_type_size(LOG_ARG_TYPE_E type)
+{
+    switch (type) {
+    case LOG_ARG_INT:
+        return sizeof(int);
+    case LOG_ARG_LONG:
+        return sizeof(long);
+    case LOG_ARG_LLONG:
+        return sizeof(long long);
+    case LOG_ARG_SIZE:
+        return sizeof(size_t);
+    case LOG_ARG_INTMAX:
+        return sizeof(intmax_t);
+    case LOG_ARG_PTRDIFF:
+        return sizeof(ptrdiff_t);
+    case LOG_ARG_PTR:
+        return sizeof(void *);
+    case LOG_ARG_DOUBLE:
+        return sizeof(double);
+    default:
+        return 0;
+    }
+}
+
+static int __arg_str_len(const char *str, int max)
+{
+    int len = 0;
+
+    while (len < max && str[len]) {
+        len++;
+    }
+
+    return len;
+}
+
+// walk the arguments, only count the size if buf is NULL
+static int __args_walk(const char *fmt, va_list ap, int str_max, uint8_t *buf)
+{
+    LOG_ARG_SPEC_T spec;
+    const char *p = fmt;
+    const char *str = NULL;
+    int pos = 0, star = 0, prec = 0, str_len = 0;
+    va_list cp;
+
+    union {
+        int i;
+        long l;
+        long long ll;
+        size_t z;
+        intmax_t j;
+        ptrdiff_t t;
+        void *ptr;
+        double d;
+    } val;
+
+    va_copy(cp, ap);
+    while (*p) {
+        if (*p != '%') {
+            p++;
+            continue;
+        }
+
+        p = __arg_spec_parse(p, &spec);
+        if (spec.type == LOG_ARG_BAD) {
+            pos = -1;
+            break;
+        }
+
+        // '*' width and precision come first
+        prec = spec.prec;
+        for (star = 0; star < spec.star_num; star++) {
+            val.i = va_arg(cp, int);
+            if (spec.prec_star && star == spec.star_num - 1) {
+                prec = val.i;
+            }
+            if (buf) {
+                memcpy(buf + pos, &val.i, sizeof(int));
+            }
+            pos += sizeof(int);
+        }
+
+        switch (spec.type) {
+        case LOG_ARG_NONE:
+            continue;
+        case LOG_ARG_STR:
+            str = va_arg(cp, const char *);
+            str = str ? str : sNullStr;
+            str_len = __arg_str_len(str, (prec >= 0 && prec < str_max) ? prec : str_max);
+            if (buf) {
+                memcpy(buf + pos, str, str_len);
+                buf[pos + str_len] = '\0';
+            }
+            pos += str_len + 1;
+            continue;
+        case LOG_ARG_INT:
+            val.i = va_arg(cp, int);
+            break;
+        case LOG_ARG_LONG:
+            val.l = va_arg(cp, long);
+            break;
+        case LOG_ARG_LLONG:
+            val.ll = va_arg(cp, long long);
+            break;
+        case LOG_ARG_SIZE:
+            val.z = va_arg(cp, size_t);
+            break;
+        case LOG_ARG_INTMAX:
+            val.j = va_arg(cp, intmax_t);
+            break;
+        case LOG_ARG_PTRDIFF:
+            val.t = va_arg(cp, ptrdiff_t);
+            break;
+        case LOG_ARG_PTR:
+            val.ptr = va_arg(cp, void *);
+            break;
+        case LOG_ARG_DOUBLE:
+            val.d = va_arg(cp, double);
+            break;
+        default:
+            break;
+        }
+
+        if (buf) {
+            memcpy(buf + pos, &val, __arg_type_size(spec.type));
+        }
+        pos += __arg_type_size(spec.type);
+    }
+    va_end(cp);
+
+    return pos;
+}
+
+int tal_log_args_size(const char *fmt, va_list ap, int str_max)
+{
+    return __args_walk(fmt, ap, str_max, NULL);
+}
+
+int tal_log_args_encode(const char *fmt, va_list ap, int str_max, uint8_t *buf)
+{
+    return __args_walk(fmt, ap, str_max, buf);
+}
+
+int tal_log_args_format(char *out, int out_len, const char *fmt, const uint8_t *args, int args_len)
+{
+    LOG_ARG_SPEC_T spec;
+    char spec_buf[LOG_ARG_SPEC_MAX_LEN];
+    const char *p = fmt;
+    const char *s = NULL;
+    int len = 0, pos = 0, spec_len = 0, star = 0, size = 0, cnt = 0;
+
+    union {
+        int i;
+        long l;
+        long long ll;
+        size_t z;
+        intmax_t j;
+        ptrdiff_t t;
+        void *ptr;
+        double d;
+    } val;
+
+    if (out_len <= 0) {
+        return 0;
+    }
+
+    while (*p && len < out_len - 1) {
+        if (*p != '%') {
+            out[len++] = *p++;
+            continue;
+        }
+
+        p = __arg_spec_parse(p, &spec);
+        if (spec.type == LOG_ARG_NONE) {
+            out[len++] = '%';
+            continue;
+        }
+        if (spec.type == LOG_ARG_BAD) {
+            break;
+        }
+
+        // rebuild the conversion with the '*' replaced by the encoded values
+        spec_len = 0;
+        star = 0;
+        for (s = spec.start; s < spec.end && spec_len < LOG_ARG_SPEC_MAX_LEN - 12; s++) {
+            if (*s != '*') {
+                spec_buf[spec_len++] = *s;
+                continue;
+            }
+            if (pos + (int)sizeof(int) > args_len) {
+                goto __EXIT;
+            }
+            memcpy(&val.i, args + pos, sizeof(int));
+            pos += sizeof(int);
+            star++;
+            if (val.i < 0 && spec_len > 0 && spec_buf[spec_len - 1] == '.') {
+                // negative precision is taken as if the precision were omitted
+                spec_len--;
+                continue;
+            }
+            spec_len += snprintf(spec_buf + spec_len, LOG_ARG_SPEC_MAX_LEN - spec_len, "%d", val.i);
+        }
+        spec_buf[spec_len] = '\0';
+        if (s != spec.end || star != spec.star_num) {
+            break;
+        }
+
+        if (spec.type == LOG_ARG_STR) {
+            size = __arg_str_len((const char *)args + pos, args_len - pos);
+            if (pos + size >= args_len) {
+                break;
+            }
+            cnt = snprintf(out + len, out_len - len, spec_buf, (const char *)args + pos);
+            pos += size + 1;
+        } else {
+            size = __arg_type_size(spec.type);
+            if (pos + size > args_len) {
+                break;
+            }
+            memcpy(&val, args + pos, size);
+            pos += size;
+
+            switch (spec.type) {
+            case LOG_ARG_INT:
+                cnt = snprintf(out + len, out_len - len, spec_buf, val.i);
+                break;
+            case LOG_ARG_LONG:
+                cnt = snprintf(out + len, out_len - len, spec_buf, val.l);
+                break;
+            case LOG_ARG_LLONG:
+                cnt = snprintf(out + len, out_len - len, spec_buf, val.ll);
+                break;
+            case LOG_ARG_SIZE:
+                cnt = snprintf(out + len, out_len - len, spec_buf, val.z);
+                break;
+            case LOG_ARG_INTMAX:
+                cnt = snprintf(out + len, out_len - len, spec_buf, val.j);
+                break;
+            case LOG_ARG_PTRDIFF:
+                cnt = snprintf(out + len, out_len - len, spec_buf, val.t);
+                break;
+            case LOG_ARG_PTR:
+                cnt = snprintf(out + len, out_len - len, spec_buf, val.ptr);
+                break;
+            default:
+                cnt = snprintf(out + len, out_len - len, spec_buf, val.d);
+                break;
+            }
+        }
+
+        if (cnt < 0) {
+            break;
+        }
+        len += (cnt < out_len - len) ? cnt : out_len - len - 1;
+    }
+
+__EXIT:
+    out[len] = '\0';
+    return len;
+}
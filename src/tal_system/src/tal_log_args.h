@@ -0,0 +1,64 @@
+/**
+ * @file tal_log_args.h
+ * @brief Private codec of printf style log arguments.
+ *
+ * The codec walks a printf format string and copies the arguments of a
+ * va_list into a flat byte buffer, so the format string and the buffer can be
+ * expanded to text later, in another thread or on a host. Strings are copied
+ * by value, every other argument is stored with its native size.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#ifndef __TAL_LOG_ARGS_H__
+#define __TAL_LOG_ARGS_H__
+
+#include <stdarg.h>
+#include "tuya_cloud_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief get the encoded size of the arguments
+ *
+ * @param[in] fmt printf style format string
+ * @param[in] ap arguments of the format string, not consumed
+ * @param[in] str_max max copied length of one string argument
+ *
+ * @return encoded size, -1 if the format has an unsupported conversion
+ */
+int tal_log_args_size(const char *fmt, va_list ap, int str_max);
+
+/**
+ * @brief encode the arguments
+ *
+ * @param[in] fmt printf style format string
+ * @param[in] ap arguments of the format string, not consumed
+ * @param[in] str_max max copied length of one string argument
+ * @param[out] buf encoded arguments, must have tal_log_args_size bytes
+ *
+ * @return encoded size, -1 if the format has an unsupported conversion
+ */
+int tal_log_args_encode(const char *fmt, va_list ap, int str_max, uint8_t *buf);
+
+/**
+ * @brief expand the format string with the encoded arguments
+ *
+ * @param[out] out output text, always NUL terminated
+ * @param[in] out_len size of out
+ * @param[in] fmt printf style format string
+ * @param[in] args encoded arguments
+ * @param[in] args_len size of the encoded arguments
+ *
+ * @return length of the output text
+ */
+int tal_log_args_format(char *out, int out_len, const char *fmt, const uint8_t *args, int args_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TAL_LOG_ARGS_H__ */
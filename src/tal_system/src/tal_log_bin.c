@@ -0,0 +1,100 @@
+/**
+ * @file tal_log_bin.c
+ * @brief Private encoder of the binary log frames.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "tal_log_bin.h"
+
+/***********************************************************
+*************************variable define********************
+***********************************************************/
+// the host decoder looks this symbol up in the ELF to get the load offset
+const char tal_log_bin_anchor[] = "tal_log_bin";
+
+/***********************************************************
+*************************function define********************
+***********************************************************/
+static int __bin_put(uint8_t *raw, int pos, const void *val, int size)
+{
+    memcpy(raw + pos, val, size);
+    return pos + size;
+}
+
+int tal_log_bin_sync(uint8_t *raw, SYS_TICK_T time_ms)
+{
+    int pos = 0;
+    uint32_t endian = LOG_BIN_ENDIAN_MARK;
+    uint64_t time64 = (uint64_t)time_ms;
+    const char *anchor = tal_log_bin_anchor;
+
+    // sizes of int, long, long long, size_t, intmax_t, ptrdiff_t, void * and double
+    const uint8_t sizes[8] = {sizeof(int),      sizeof(long),      sizeof(long long), sizeof(size_t),
+                              sizeof(intmax_t), sizeof(ptrdiff_t), sizeof(void *),    sizeof(double)};
+
+    raw[pos++] = LOG_BIN_TYPE_SYNC;
+    raw[pos++] = LOG_BIN_VERSION;
+    pos = __bin_put(raw, pos, &endian, sizeof(endian));
+    pos = __bin_put(raw, pos, sizes, sizeof(sizes));
+    pos = __bin_put(raw, pos, &anchor, sizeof(anchor));
+    pos = __bin_put(raw, pos, &time64, sizeof(time64));
+
+    return pos;
+}
+
+int tal_log_bin_head(uint8_t *raw, uint8_t level, SYS_TICK_T time_ms, const char *file, uint32_t line,
+                     const char *fmt)
+{
+    int pos = 0;
+    uint32_t time32 = (uint32_t)time_ms;
+    uint16_t line16 = (line > 0xFFFF) ? 0xFFFF : (uint16_t)line;
+
+    raw[pos++] = LOG_BIN_TYPE_LOG | (level & 0x0F);
+    pos = __bin_put(raw, pos, &time32, sizeof(time32));
+    pos = __bin_put(raw, pos, &file, sizeof(file));
+    pos = __bin_put(raw, pos, &line16, sizeof(line16));
+    pos = __bin_put(raw, pos, &fmt, sizeof(fmt));
+
+    return pos;
+}
+
+int tal_log_bin_raw_head(uint8_t *raw, const char *fmt)
+{
+    int pos = 0;
+
+    raw[pos++] = LOG_BIN_TYPE_RAW;
+    pos = __bin_put(raw, pos, &fmt, sizeof(fmt));
+
+    return pos;
+}
+
+int tal_log_bin_frame(const uint8_t *raw, int raw_len, uint8_t *out, int out_len)
+{
+    int i = 0, pos = 1, code_pos = 0;
+    uint8_t code = 1;
+
+    if (out_len < LOG_BIN_FRAME_MAX(raw_len)) {
+        return -1;
+    }
+
+    for (i = 0; i < raw_len; i++) {
+        if (raw[i]) {
+            out[pos++] = raw[i];
+            code++;
+        }
+        if (0 == raw[i] || 0xFF == code) {
+            out[code_pos] = code;
+            code_pos = pos++;
+            code = 1;
+        }
+    }
+    out[code_pos] = code;
+    out[pos++] = 0x00;
+
+    return pos;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file tal_log_bin.h
+ * @brief Private encoder of the binary log frames.
+ *
+ * A binary log frame carries the addresses of the format string and of the
+ * file name instead of the text, the host decoder reads both strings back
+ * from the ELF of the firmware. The arguments are stored as encoded by
+ * tal_log_args, the frames are COBS encoded and end with a 0x00 byte so the
+ * host can resync on a lossy link.
+ *
+ * Frame layout before the COBS encoding, all fields in the device byte order:
+ * - sync: type(1) version(1) endian(4) sizes(8) anchor(ptr) time_ms(8)
+ * - log:  type|level(1) time_ms(4) file(ptr) line(2) fmt(ptr) args
+ * - raw:  type(1) fmt(ptr) args
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#ifndef __TAL_LOG_BIN_H__
+#define __TAL_LOG_BIN_H__
+
+#include "tuya_cloud_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***********************************************************
+*************************micro define***********************
+***********************************************************/
+#define LOG_BIN_TYPE_SYNC 0x00
+#define LOG_BIN_TYPE_LOG  0x10 // low nibble is the log level
+#define LOG_BIN_TYPE_RAW  0x20
+
+#define LOG_BIN_VERSION     1
+#define LOG_BIN_ENDIAN_MARK 0x01020304
+
+// max length of the sync frame or of a log frame without the arguments
+#define LOG_BIN_HEAD_MAX 32
+
+// max encoded length of a frame of raw_len bytes, COBS overhead and delimiter included
+#define LOG_BIN_FRAME_MAX(raw_len) ((raw_len) + (raw_len) / 254 + 2)
+
+/***********************************************************
+*************************function define********************
+***********************************************************/
+/**
+ * @brief build the sync frame, it lets the host find the load address and
+ * the type sizes of the device
+ *
+ * @param[out] raw frame before COBS, at least LOG_BIN_HEAD_MAX bytes
+ * @param[in] time_ms posix time in ms
+ *
+ * @return frame length
+ */
+int tal_log_bin_sync(uint8_t *raw, SYS_TICK_T time_ms);
+
+/**
+ * @brief build the head of a log frame, the encoded arguments follow it
+ *
+ * @param[out] raw frame before COBS, at least LOG_BIN_HEAD_MAX bytes
+ * @param[in] level log level
+ * @param[in] time_ms posix time in ms, only the low 32 bits are kept
+ * @param[in] file file name, must point into the firmware image
+ * @param[in] line line number
+ * @param[in] fmt format string, must point into the firmware image
+ *
+ * @return head length
+ */
+int tal_log_bin_head(uint8_t *raw, uint8_t level, SYS_TICK_T time_ms, const char *file, uint32_t line,
+                     const char *fmt);
+
+/**
+ * @brief build the head of a raw frame, the encoded arguments follow it
+ *
+ * @param[out] raw frame before COBS, at least LOG_BIN_HEAD_MAX bytes
+ * @param[in] fmt format string, must point into the firmware image
+ *
+ * @return head length
+ */
+int tal_log_bin_raw_head(uint8_t *raw, const char *fmt);
+
+/**
+ * @brief COBS encode a frame and append the 0x00 delimiter
+ *
+ * @param[in] raw frame before COBS
+ * @param[in] raw_len frame length
+ * @param[out] out encoded frame
+ * @param[in] out_len size of out, at least LOG_BIN_FRAME_MAX(raw_len)
+ *
+ * @return encoded length, -1 if out is too small
+ */
+int tal_log_bin_frame(const uint8_t *raw, int raw_len, uint8_t *out, int out_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TAL_LOG_BIN_H__ */
@@ -12,6 +12,14 @@
 #define STACK_SIZE_TIMERQ (4 * 1024)
 #endif
 
+#if defined(SW_TIMER_BACKEND_HEAP) && (SW_TIMER_BACKEND_HEAP == 1)
+#define SW_TIMER_USE_HEAP 1
+#else
+#define SW_TIMER_USE_HEAP 0
+#endif
+
+#define SW_TIMER_HEAP_MIN_CAP 16
+
 typedef struct {
     LIST_HEAD node;
 
@@ -23,6 +31,9 @@ typedef struct {
     BOOL_T is_running;
     TIMER_ID timer_id;
     TIMER_TYPE type;
+#if SW_TIMER_USE_HEAP
+    uint32_t heap_idx; // position in the heap while running
+#endif
 } TIMER_T;
 
 typedef struct {
@@ -36,10 +47,123 @@ typedef struct {
     THREAD_HANDLE thread;
     SEM_HANDLE sem;
     TAL_TIMER_CB last_cb; // used to debug which cb is blocked
+#if SW_TIMER_USE_HEAP
+    TIMER_T **heap; // min-heap of running timers ordered by expire_time
+    uint32_t heap_num;
+    uint32_t heap_cap;
+#endif
 } SW_TIMER_MGR_T;
 
 static SW_TIMER_MGR_T s_timer_mgr;
 
+#if SW_TIMER_USE_HEAP
+static void __timer_heap_set(uint32_t idx, TIMER_T *timer)
+{
+    s_timer_mgr.heap[idx] = timer;
+    timer->heap_idx = idx;
+}
+
+static void __timer_heap_sift_up(uint32_t idx)
+{
+    TIMER_T *timer = s_timer_mgr.heap[idx];
+    uint32_t parent = 0;
+
+    while (idx > 0) {
+        parent = (idx - 1) / 2;
+        if (s_timer_mgr.heap[parent]->expire_time <= timer->expire_time) {
+            break;
+        }
+        __timer_heap_set(idx, s_timer_mgr.heap[parent]);
+        idx = parent;
+    }
+    __timer_heap_set(idx, timer);
+}
+
+static void __timer_heap_sift_down(uint32_t idx)
+{
+    TIMER_T *timer = s_timer_mgr.heap[idx];
+    uint32_t child = 0;
+
+    while ((child = idx * 2 + 1) < s_timer_mgr.heap_num) {
+        if (child + 1 < s_timer_mgr.heap_num &&
+            s_timer_mgr.heap[child + 1]->expire_time < s_timer_mgr.heap[child]->expire_time) {
+            child++;
+        }
+        if (timer->expire_time <= s_timer_mgr.heap[child]->expire_time) {
+            break;
+        }
+        __timer_heap_set(idx, s_timer_mgr.heap[child]);
+        idx = child;
+    }
+    __timer_heap_set(idx, timer);
+}
+
+static void __timer_heap_remove(TIMER_T *timer)
+{
+    uint32_t idx = timer->heap_idx;
+    TIMER_T *last = s_timer_mgr.heap[--s_timer_mgr.heap_num];
+
+    if (idx == s_timer_mgr.heap_num) {
+        return;
+    }
+
+    __timer_heap_set(idx, last);
+    if (idx > 0 && s_timer_mgr.heap[(idx - 1) / 2]->expire_time > last->expire_time) {
+        __timer_heap_sift_up(idx);
+    } else {
+        __timer_heap_sift_down(idx);
+    }
+}
+
+/* every created timer owns a heap slot, so start never allocates */
+static OPERATE_RET __timer_heap_reserve(uint32_t num)
+{
+    TIMER_T **heap = NULL;
+    uint32_t cap = 0;
+
+    if (num <= s_timer_mgr.heap_cap) {
+        return OPRT_OK;
+    }
+
+    cap = s_timer_mgr.heap_cap ? s_timer_mgr.heap_cap * 2 : SW_TIMER_HEAP_MIN_CAP;
+    heap = (TIMER_T **)tal_realloc(s_timer_mgr.heap, cap * sizeof(TIMER_T *));
+    if (NULL == heap) {
+        return OPRT_MALLOC_FAILED;
+    }
+
+    s_timer_mgr.heap = heap;
+    s_timer_mgr.heap_cap = cap;
+    return OPRT_OK;
+}
+
+/* timer must be running, expire_time has been updated by the caller */
+static void __timer_attach(TIMER_T *timer)
+{
+    if (tuya_list_empty(&(timer->node))) {
+        __timer_heap_sift_up(timer->heap_idx);
+        __timer_heap_sift_down(timer->heap_idx);
+        return;
+    }
+
+    tuya_list_del_init(&(timer->node));
+    __timer_heap_set(s_timer_mgr.heap_num++, timer);
+    __timer_heap_sift_up(timer->heap_idx);
+}
+
+static void __timer_detach(TIMER_T *timer)
+{
+    if (tuya_list_empty(&(timer->node))) {
+        __timer_heap_remove(timer);
+    } else {
+        tuya_list_del(&(timer->node));
+    }
+}
+
+static TIMER_T *__timer_first(void)
+{
+    return s_timer_mgr.heap_num ? s_timer_mgr.heap[0] : NULL;
+}
+#else
 static void __timer_attach(TIMER_T *timer)
 {
     tuya_list_del(&(timer->node));
@@ -65,12 +189,37 @@ static void __timer_attach(TIMER_T *timer)
     }
 }
 
+static void __timer_detach(TIMER_T *timer)
+{
+    tuya_list_del(&(timer->node));
+}
+
+static TIMER_T *__timer_first(void)
+{
+    if (tuya_list_empty(&(s_timer_mgr.list_active))) {
+        return NULL;
+    }
+    return tuya_list_entry(s_timer_mgr.list_active.next, TIMER_T, node);
+}
+#endif
+
+static void __timer_dump_one(TIMER_T *timer)
+{
+    TAL_TIMER_CB *cb = &(timer->cb);
+    TIMER_ID *timer_id = NULL;
+
+    if (timer->data) {
+        timer_id = timer->data;
+        if (*timer_id == timer->timer_id) {
+            cb = (TAL_TIMER_CB *)((char *)timer->data + sizeof(TIMER_ID));
+        }
+    }
+    PR_NOTICE("%08x %d %d %p", timer->timer_id, timer->type, timer->interval, *cb);
+}
+
 static void __timer_dump(void)
 {
     struct tuya_list_head *p = NULL;
-    TIMER_T *timer = NULL;
-    TAL_TIMER_CB *cb = NULL;
-    TIMER_ID *timer_id = NULL;
 
     TIME_S nowSecTime = 0;
     TIME_MS nowMsTime = 0;
@@ -86,31 +235,22 @@ static void __timer_dump(void)
     tal_mutex_lock(s_timer_mgr.mutex);
 
     PR_NOTICE("running timers count:%d", s_timer_mgr.running_cnt);
+#if SW_TIMER_USE_HEAP
+    uint32_t idx = 0;
+    for (idx = 0; idx < s_timer_mgr.heap_num; idx++) {
+        __timer_dump_one(s_timer_mgr.heap[idx]);
+    }
+#else
     tuya_list_for_each(p, &(s_timer_mgr.list_active))
     {
-        timer = tuya_list_entry(p, TIMER_T, node);
-        cb = &(timer->cb);
-        if (timer->data) {
-            timer_id = timer->data;
-            if (*timer_id == timer->timer_id) {
-                cb = (TAL_TIMER_CB *)((char *)timer->data + sizeof(TIMER_ID));
-            }
-        }
-        PR_NOTICE("%08x %d %d %p", timer->timer_id, timer->type, timer->interval, *cb);
+        __timer_dump_one(tuya_list_entry(p, TIMER_T, node));
     }
+#endif
 
     PR_NOTICE("standby timers count:%d", s_timer_mgr.total_cnt - s_timer_mgr.running_cnt);
     tuya_list_for_each(p, &(s_timer_mgr.list_standby))
     {
-        timer = tuya_list_entry(p, TIMER_T, node);
-        cb = &(timer->cb);
-        if (timer->data) {
-            timer_id = timer->data;
-            if (*timer_id == timer->timer_id) {
-                cb = (TAL_TIMER_CB *)((char *)timer->data + sizeof(TIMER_ID));
-            }
-        }
-        PR_NOTICE("%08x %d %d %p", timer->timer_id, timer->type, timer->interval, *cb);
+        __timer_dump_one(tuya_list_entry(p, TIMER_T, node));
     }
 
     tal_mutex_unlock(s_timer_mgr.mutex);
@@ -123,7 +263,8 @@ static void __timer_dispatch(SYS_TIME_T *next_expired)
     uint64_t nowMS = 0;
     TIMER_T *timer = NULL;
     TAL_TIMER_CB timer_cb = NULL;
-    struct tuya_list_head *p = NULL;
+    TIMER_ID timer_id = NULL;
+    void *timer_data = NULL;
 
     *next_expired = SEM_WAIT_FOREVER;
 
@@ -134,39 +275,34 @@ static void __timer_dispatch(SYS_TIME_T *next_expired)
         tal_mutex_lock(s_timer_mgr.mutex);
 
         timer_cb = NULL;
-        tuya_list_for_each(p, &(s_timer_mgr.list_active))
-        {
-            timer = tuya_list_entry(p, TIMER_T, node);
-
-            if (timer->expire_time > nowMS) {
-                p = &(s_timer_mgr.list_active);
-                *next_expired = timer->expire_time - nowMS;
+        timer = __timer_first();
+        if (timer && timer->expire_time > nowMS) {
+            *next_expired = timer->expire_time - nowMS;
+        } else if (timer) {
+            // the timer may be deleted once the lock is released, take what the cb needs now
+            timer_cb = timer->cb;
+            timer_id = timer->timer_id;
+            timer_data = timer->data;
+
+            if (TAL_TIMER_ONCE == timer->type) {
+                timer->is_running = FALSE;
+                s_timer_mgr.running_cnt--;
+                __timer_detach(timer);
+                tuya_list_add_tail(&(timer->node), &(s_timer_mgr.list_standby));
             } else {
-                timer_cb = timer->cb;
-
-                if (TAL_TIMER_ONCE == timer->type) {
-                    timer->is_running = FALSE;
-                    s_timer_mgr.running_cnt--;
-                    tuya_list_del(&(timer->node));
-                    tuya_list_add_tail(&(timer->node), &(s_timer_mgr.list_standby));
-                } else {
-                    timer->expire_time = nowMS + timer->interval;
-                    __timer_attach(timer);
-                }
+                timer->expire_time = nowMS + timer->interval;
+                __timer_attach(timer);
             }
-
-            break;
         }
 
         tal_mutex_unlock(s_timer_mgr.mutex);
 
         if (timer_cb) {
             s_timer_mgr.last_cb = timer_cb;
-            timer_cb(timer->timer_id, timer->data);
-            timer_cb = NULL;
+            timer_cb(timer_id, timer_data);
             s_timer_mgr.last_cb = NULL;
         }
-    } while (p != &(s_timer_mgr.list_active));
+    } while (timer_cb);
 }
 
 static void __timer_thread_cb(void *data)
@@ -242,6 +378,13 @@ OPERATE_RET tal_sw_timer_create(TAL_TIMER_CB func, void *arg, TIMER_ID *timer_id
     timer->timer_id = (TIMER_ID)timer;
 
     tal_mutex_lock(s_timer_mgr.mutex);
+#if SW_TIMER_USE_HEAP
+    if (OPRT_OK != __timer_heap_reserve(s_timer_mgr.total_cnt + 1)) {
+        tal_mutex_unlock(s_timer_mgr.mutex);
+        tal_free(timer);
+        return OPRT_MALLOC_FAILED;
+    }
+#endif
     s_timer_mgr.total_cnt++;
     tuya_list_add_tail(&(timer->node), &(s_timer_mgr.list_standby));
     tal_mutex_unlock(s_timer_mgr.mutex);
@@ -270,7 +413,7 @@ OPERATE_RET tal_sw_timer_delete(TIMER_ID timer_id)
     TIMER_T *timer = (TIMER_T *)timer_id;
 
     tal_mutex_lock(s_timer_mgr.mutex);
-    tuya_list_del(&(timer->node));
+    __timer_detach(timer);
     s_timer_mgr.total_cnt--;
     if (timer->is_running) {
         s_timer_mgr.running_cnt--;
@@ -305,7 +448,7 @@ OPERATE_RET tal_sw_timer_stop(TIMER_ID timer_id)
         timer->is_running = FALSE;
 
         s_timer_mgr.running_cnt--;
-        tuya_list_del(&(timer->node));
+        __timer_detach(timer);
         tuya_list_add_tail(&(timer->node), &(s_timer_mgr.list_standby));
     }
     tal_mutex_unlock(s_timer_mgr.mutex);
@@ -442,8 +585,7 @@ OPERATE_RET tal_sw_timer_trigger(TIMER_ID timer_id)
     tal_mutex_lock(s_timer_mgr.mutex);
     timer->expire_time = 0;
     if (timer->is_running) {
-        tuya_list_del(&(timer->node));
-        tuya_list_add(&(timer->node), &(s_timer_mgr.list_active));
+        __timer_attach(timer);
     }
     tal_mutex_unlock(s_timer_mgr.mutex);
     tal_semaphore_post(s_timer_mgr.sem);
@@ -30,6 +30,10 @@
 #define AI_MAX_SESSION_ID_NUM 5
 #endif
 
+typedef uint8_t AI_BIZ_DROP_POLICY;
+#define AI_BIZ_DROP_NEWEST 0 // reject new data when send queue is full
+#define AI_BIZ_DROP_OLDEST 1 // drop the oldest queued data when send queue is full
+
 #define EVENT_AI_SESSION_NEW   "ai.session.new"
 #define EVENT_AI_SESSION_CLOSE "ai.session.close"
 
@@ -129,8 +133,19 @@ typedef struct {
     AI_BIZ_SEND_GET_CB get_cb;
     /** send channel free cb */
     AI_BIZ_SEND_FREE_CB free_cb;
+    /** send queue full policy */
+    AI_BIZ_DROP_POLICY drop_policy;
 } AI_BIZ_SEND_DATA_T;
 
+typedef struct {
+    /** data waiting in send queue */
+    uint32_t depth;
+    /** data dropped because send queue was full */
+    uint32_t dropped;
+    /** data taken from send queue */
+    uint32_t sent;
+} AI_BIZ_SEND_STAT_T;
+
 typedef struct {
     /** recv channel id */
     uint16_t id;
@@ -191,6 +206,29 @@ OPERATE_RET tuya_ai_biz_del_session(AI_SESSION_ID id, AI_STATUS_CODE code);
 OPERATE_RET tuya_ai_send_biz_pkt(uint16_t id, AI_BIZ_ATTR_INFO_T *attr, AI_PACKET_PT type, AI_BIZ_HEAD_INFO_T *head,
                                  char *payload);
 
+/**
+ * @brief queue ai biz packet to the send channel, sent by biz thread
+ *
+ * @param[in] id channel id
+ * @param[in] attr attribute, can be NULL, pointed data must be valid until sent
+ * @param[in] head data head
+ * @param[in] payload data, released by channel free_cb once sent or dropped
+ *
+ * @return OPRT_OK on success. Others on error and payload is left to caller,
+ * please refer to tuya_error_code.h
+ */
+OPERATE_RET tuya_ai_biz_send_enqueue(uint16_t id, AI_BIZ_ATTR_INFO_T *attr, AI_BIZ_HEAD_INFO_T *head, char *payload);
+
+/**
+ * @brief get send channel queue statistics
+ *
+ * @param[in] id channel id
+ * @param[out] stat queue statistics
+ *
+ * @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+ */
+OPERATE_RET tuya_ai_biz_get_send_stat(uint16_t id, AI_BIZ_SEND_STAT_T *stat);
+
 /**
  * @brief get send id
  *
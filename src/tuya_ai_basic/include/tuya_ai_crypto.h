@@ -0,0 +1,132 @@
+/**
+ * @file tuya_ai_crypto.h
+ * @brief Persistent crypto engine of the Tuya AI protocol.
+ *
+ * One engine is bound to one direction of one connection. The cipher key
+ * schedule and the HMAC inner/outer pads are expanded once after key
+ * derivation, so the per packet cost is only the cipher and hash rounds.
+ * All cipher operations work in place on the packet arena.
+ *
+ * Supported security levels:
+ * - AI_PACKET_SL2: ChaCha20 (requires MBEDTLS_CHACHA20_C)
+ * - AI_PACKET_SL3: AES-256-CBC
+ * - AI_PACKET_SL4: AES-256-GCM, tag appended after the ciphertext
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#ifndef __TUYA_AI_CRYPTO_H__
+#define __TUYA_AI_CRYPTO_H__
+
+#include <stdint.h>
+
+#include "tuya_cloud_types.h"
+#include "tal_hash.h"
+#include "tal_symmetry.h"
+#include "mbedtls/gcm.h"
+#include "mbedtls/chacha20.h"
+#include "tuya_ai_protocol.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    AI_PACKET_SL sl;
+    uint8_t is_encrypt;
+    uint8_t inited;
+    tal_hash_mac_context_t hmac;
+    TKL_SYMMETRY_HANDLE aes;
+#if defined(MBEDTLS_GCM_C)
+    mbedtls_gcm_context gcm;
+#endif
+#if defined(MBEDTLS_CHACHA20_C)
+    mbedtls_chacha20_context chacha;
+#endif
+} AI_CRYPTO_T;
+
+/**
+ * @brief init crypto engine, expand the key schedule and hmac pads
+ *
+ * @param[out] crypto crypto engine
+ * @param[in] sl security level of the cipher
+ * @param[in] is_encrypt 1: encrypt direction, 0: decrypt direction
+ * @param[in] crypt_key cipher key, AI_KEY_LEN bytes
+ * @param[in] sign_key hmac key, AI_KEY_LEN bytes
+ *
+ * @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+ */
+OPERATE_RET tuya_ai_crypto_init(AI_CRYPTO_T *crypto, AI_PACKET_SL sl, uint8_t is_encrypt, uint8_t *crypt_key,
+                                uint8_t *sign_key);
+
+/**
+ * @brief deinit crypto engine and wipe the key material
+ *
+ * @param[in] crypto crypto engine
+ */
+void tuya_ai_crypto_deinit(AI_CRYPTO_T *crypto);
+
+/**
+ * @brief encrypt in place, pad the data and append the tag if any
+ *
+ * @param[in] crypto crypto engine
+ * @param[in,out] iv packet iv, updated in place by AI_PACKET_SL3
+ * @param[in,out] buf data, must have AI_IV_LEN + AI_GCM_TAG_LEN bytes of room after len
+ * @param[in] len plain data length
+ * @param[out] out_len cipher data length
+ *
+ * @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+ */
+OPERATE_RET tuya_ai_crypto_encrypt(AI_CRYPTO_T *crypto, uint8_t *iv, uint8_t *buf, uint32_t len, uint32_t *out_len);
+
+/**
+ * @brief decrypt and strip the padding, input and output may overlap
+ *
+ * @param[in] crypto crypto engine
+ * @param[in,out] iv packet iv, updated in place by AI_PACKET_SL3
+ * @param[in] in cipher data
+ * @param[in] len cipher data length, including the tag if any
+ * @param[out] out plain data
+ * @param[out] out_len plain data length
+ *
+ * @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+ */
+OPERATE_RET tuya_ai_crypto_decrypt(AI_CRYPTO_T *crypto, uint8_t *iv, uint8_t *in, uint32_t len, uint8_t *out,
+                                   uint32_t *out_len);
+
+/**
+ * @brief start a new signature with the precomputed hmac pads
+ *
+ * @param[in] crypto crypto engine
+ *
+ * @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+ */
+OPERATE_RET tuya_ai_crypto_sign_starts(AI_CRYPTO_T *crypto);
+
+/**
+ * @brief feed signature data, can be called once per produced fragment
+ *
+ * @param[in] crypto crypto engine
+ * @param[in] data data to sign
+ * @param[in] len data length
+ *
+ * @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+ */
+OPERATE_RET tuya_ai_crypto_sign_update(AI_CRYPTO_T *crypto, const uint8_t *data, uint32_t len);
+
+/**
+ * @brief finish the signature
+ *
+ * @param[in] crypto crypto engine
+ * @param[out] signature AI_SIGN_LEN bytes
+ *
+ * @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+ */
+OPERATE_RET tuya_ai_crypto_sign_finish(AI_CRYPTO_T *crypto, uint8_t *signature);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -273,6 +273,11 @@ typedef struct {
     uint8_t reserve;
 } AI_PACKET_HEAD_T;
 
+typedef struct {
+    char *data;
+    uint32_t len;
+} AI_SEND_VEC_T;
+
 typedef struct {
     AI_PACKET_PT type;
     uint32_t count;
@@ -280,6 +285,8 @@ typedef struct {
 	uint32_t total_len;
     uint32_t len;
     char *data;
+    AI_SEND_VEC_T *vec; // if vec_num != 0, data is gathered from vec and len is the sum of vec lengths
+    uint32_t vec_num;
 } AI_SEND_PACKET_T;
 
 typedef struct {
@@ -424,6 +431,9 @@ OPERATE_RET tuya_ai_basic_conn_close(AI_STATUS_CODE code);
  * @param[out] out packet data
  * @param[out] out_len packet data length
  * @param[out] out_frag packet fragment flag
+ * @note
+ * The packet lives in the receive pool until tuya_ai_basic_pkt_free is called,
+ * it may be released from another thread and in any order.
  *
  * @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
  */
@@ -589,6 +599,21 @@ OPERATE_RET tuya_ai_basic_text(AI_TEXT_ATTR_T *text, char *data, uint32_t len);
  */
 OPERATE_RET tuya_ai_basic_event(AI_EVENT_ATTR_T *event, char *data, uint32_t len);
 
+/**
+ * @brief send biz packet gathered from several buffers
+ *
+ * The segments are packed straight into the connection send buffer, so the
+ * caller does not need to join biz head and payload beforehand.
+ *
+ * @param[in] type packet type, AI_PT_VIDEO/AUDIO/IMAGE/FILE/TEXT
+ * @param[in] attr attr matching type (AI_VIDEO_ATTR_T etc.), can be NULL except image and file
+ * @param[in] vec data segments
+ * @param[in] vec_num data segment num
+ *
+ * @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+ */
+OPERATE_RET tuya_ai_basic_biz_sendv(AI_PACKET_PT type, void *attr, AI_SEND_VEC_T *vec, uint32_t vec_num);
+
 /**
  * @brief get attr value
  *
@@ -673,9 +698,9 @@ OPERATE_RET tuya_ai_parse_conn_close(char *de_buf, uint32_t attr_len);
 OPERATE_RET tuya_ai_pong(char *data, uint32_t len);
 
 /**
- * @brief pkt data free
+ * @brief pkt data free, release the receive pool slot of the packet
  *
- * @param[in] data data buffer
+ * @param[in] data data buffer returned by tuya_ai_basic_pkt_read
  */
 void tuya_ai_basic_pkt_free(char *data);
 
@@ -25,6 +25,7 @@
 #include "tal_system.h"
 #include "tal_thread.h"
 #include "tal_mutex.h"
+#include "tal_semaphore.h"
 #include "uni_random.h"
 #include "tal_log.h"
 #include "tal_memory.h"
@@ -40,185 +41,341 @@
 #ifndef AI_BIZ_TASK_DELAY
 #define AI_BIZ_TASK_DELAY 10
 #endif
+#ifndef AI_BIZ_SEND_QUEUE_DEPTH
+#define AI_BIZ_SEND_QUEUE_DEPTH 8
+#endif
+#define AI_BIZ_SEND_BATCH_NUM 4
+
+typedef struct {
+    uint16_t id;
+    AI_PACKET_PT type;
+    AI_BIZ_SEND_FREE_CB free_cb;
+    AI_BIZ_ATTR_INFO_T attr;
+    AI_BIZ_HEAD_INFO_T head;
+    char *payload;
+} AI_BIZ_SEND_ITEM_T;
+
+typedef struct {
+    AI_BIZ_SEND_ITEM_T *item; // ring, malloc on first enqueue
+    uint16_t head;
+    uint16_t count;
+    uint32_t dropped;
+    uint32_t sent;
+} AI_BIZ_SEND_QUEUE_T;
 
 typedef struct {
     char id[AI_UUID_V4_LEN];
     AI_SESSION_CFG_T cfg;
+    AI_BIZ_SEND_QUEUE_T queue[AI_MAX_SESSION_ID_NUM];
 } AI_SESSION_T;
 
 typedef struct {
     THREAD_HANDLE thread;
     MUTEX_HANDLE mutex;
+    SEM_HANDLE send_sem;
+    SEM_HANDLE exit_sem; // posted by the biz thread as its last act
     AI_SESSION_T session[AI_SESSION_MAX_NUM];
     AI_BIZ_RECV_CB cb;
 } AI_BASIC_BIZ_T;
 AI_BASIC_BIZ_T *ai_basic_biz;
 
+static OPERATE_RET __ai_biz_create_task(void);
+
 OPERATE_RET tuya_ai_send_biz_pkt(uint16_t id, AI_BIZ_ATTR_INFO_T *attr, AI_PACKET_PT type, AI_BIZ_HEAD_INFO_T *head,
                                  char *payload)
 {
     OPERATE_RET rt = OPRT_OK;
-    uint32_t payload_len = 0;
+    void *type_attr = NULL;
+    union {
+        AI_VIDEO_HEAD_T video;
+        AI_IMAGE_HEAD_T image;
+        AI_FILE_HEAD_T file;
+    } biz_head;
+    AI_SEND_VEC_T vec[2];
+    uint32_t vec_num = 0;
+
     if (ai_basic_biz == NULL) {
         PR_ERR("ai biz is null");
         return OPRT_COM_ERROR;
     }
     AI_PROTO_D("biz len:%d", head->len);
-    if (type == AI_PT_VIDEO) {
-        payload_len = sizeof(AI_VIDEO_HEAD_T) + head->len;
-        char *video = Malloc(payload_len);
-        TUYA_CHECK_NULL_RETURN(video, OPRT_MALLOC_FAILED);
-        memset(video, 0, payload_len);
-        AI_VIDEO_HEAD_T *video_head = (AI_VIDEO_HEAD_T *)video;
-        video_head->id = UNI_HTONS(id);
-        video_head->stream_flag = head->stream_flag;
-        video_head->timestamp = head->value.video.timestamp;
-        video_head->pts = head->value.video.pts;
-        UNI_HTONLL(video_head->timestamp);
-        UNI_HTONLL(video_head->pts);
-        video_head->length = UNI_HTONL(head->len);
-        if (payload && head->len) {
-            memcpy(video + sizeof(AI_VIDEO_HEAD_T), payload, head->len);
-        }
-        if (attr && (attr->flag == AI_HAS_ATTR)) {
-            rt = tuya_ai_basic_video(&(attr->value.video), video, payload_len);
+    memset(&biz_head, 0, sizeof(biz_head));
+    vec[vec_num].data = (char *)&biz_head;
+    if ((type == AI_PT_VIDEO) || (type == AI_PT_AUDIO)) {
+        AI_VIDEO_HEAD_T *av_head = &biz_head.video;
+        av_head->id = UNI_HTONS(id);
+        av_head->stream_flag = head->stream_flag;
+        if (type == AI_PT_VIDEO) {
+            av_head->timestamp = head->value.video.timestamp;
+            av_head->pts = head->value.video.pts;
         } else {
-            rt = tuya_ai_basic_video(NULL, video, payload_len);
+            av_head->timestamp = head->value.audio.timestamp;
+            av_head->pts = head->value.audio.pts;
         }
-        Free(video);
-    } else if (type == AI_PT_AUDIO) {
-        payload_len = sizeof(AI_AUDIO_HEAD_T) + head->len;
-        char *audio = Malloc(payload_len);
-        TUYA_CHECK_NULL_RETURN(audio, OPRT_MALLOC_FAILED);
-        memset(audio, 0, payload_len);
-        AI_AUDIO_HEAD_T *audio_head = (AI_AUDIO_HEAD_T *)audio;
-        audio_head->id = UNI_HTONS(id);
-        audio_head->stream_flag = head->stream_flag;
-        audio_head->timestamp = head->value.audio.timestamp;
-        audio_head->pts = head->value.audio.pts;
-        UNI_HTONLL(audio_head->timestamp);
-        UNI_HTONLL(audio_head->pts);
-        audio_head->length = UNI_HTONL(head->len);
-        if (payload && head->len) {
-            memcpy(audio + sizeof(AI_AUDIO_HEAD_T), payload, head->len);
-        }
-        if (attr && (attr->flag == AI_HAS_ATTR)) {
-            rt = tuya_ai_basic_audio(&(attr->value.audio), audio, payload_len);
-        } else {
-            rt = tuya_ai_basic_audio(NULL, audio, payload_len);
-        }
-        Free(audio);
+        UNI_HTONLL(av_head->timestamp);
+        UNI_HTONLL(av_head->pts);
+        av_head->length = UNI_HTONL(head->len);
+        vec[vec_num++].len = sizeof(AI_VIDEO_HEAD_T);
     } else if (type == AI_PT_IMAGE) {
-        payload_len = sizeof(AI_IMAGE_HEAD_T) + head->len;
-        char *image = Malloc(payload_len);
-        TUYA_CHECK_NULL_RETURN(image, OPRT_MALLOC_FAILED);
-        memset(image, 0, payload_len);
-        AI_IMAGE_HEAD_T *image_head = (AI_IMAGE_HEAD_T *)image;
+        AI_IMAGE_HEAD_T *image_head = &biz_head.image;
         image_head->id = UNI_HTONS(id);
         image_head->stream_flag = head->stream_flag;
         image_head->timestamp = head->value.image.timestamp;
         UNI_HTONLL(image_head->timestamp);
         image_head->length = UNI_HTONL(head->len);
-        if (payload && head->len) {
-            memcpy(image + sizeof(AI_IMAGE_HEAD_T), payload, head->len);
-        }
-        rt = tuya_ai_basic_image(&(attr->value.image), image, payload_len);
-        Free(image);
-    } else if (type == AI_PT_FILE) {
-        payload_len = sizeof(AI_FILE_HEAD_T) + head->len;
-        char *file = Malloc(payload_len);
-        TUYA_CHECK_NULL_RETURN(file, OPRT_MALLOC_FAILED);
-        memset(file, 0, payload_len);
-        AI_FILE_HEAD_T *file_head = (AI_FILE_HEAD_T *)file;
+        vec[vec_num++].len = sizeof(AI_IMAGE_HEAD_T);
+    } else if ((type == AI_PT_FILE) || (type == AI_PT_TEXT)) {
+        AI_FILE_HEAD_T *file_head = &biz_head.file;
         file_head->id = UNI_HTONS(id);
         file_head->stream_flag = head->stream_flag;
         file_head->length = UNI_HTONL(head->len);
-        if (payload && head->len) {
-            memcpy(file + sizeof(AI_FILE_HEAD_T), payload, head->len);
-        }
-        rt = tuya_ai_basic_file(&(attr->value.file), file, payload_len);
-        Free(file);
-    } else if (type == AI_PT_TEXT) {
-        payload_len = sizeof(AI_TEXT_HEAD_T) + head->len;
-        char *text = Malloc(payload_len);
-        TUYA_CHECK_NULL_RETURN(text, OPRT_MALLOC_FAILED);
-        memset(text, 0, payload_len);
-        AI_TEXT_HEAD_T *text_head = (AI_TEXT_HEAD_T *)text;
-        text_head->id = UNI_HTONS(id);
-        text_head->stream_flag = head->stream_flag;
-        text_head->length = UNI_HTONL(head->len);
-        if (payload && head->len) {
-            memcpy(text + sizeof(AI_TEXT_HEAD_T), payload, head->len);
-        }
-        if (attr && (attr->flag == AI_HAS_ATTR)) {
-            rt = tuya_ai_basic_text(&(attr->value.text), text, payload_len);
-        } else {
-            rt = tuya_ai_basic_text(NULL, text, payload_len);
-        }
-        Free(text);
+        vec[vec_num++].len = sizeof(AI_FILE_HEAD_T);
     } else {
         PR_ERR("unknow type:%d", type);
-        rt = OPRT_COM_ERROR;
+        return OPRT_COM_ERROR;
+    }
+
+    if (payload && head->len) {
+        vec[vec_num].data = payload;
+        vec[vec_num++].len = head->len;
     }
 
+    if ((type == AI_PT_IMAGE) || (type == AI_PT_FILE)) {
+        type_attr = attr ? &(attr->value) : NULL;
+    } else if (attr && (attr->flag == AI_HAS_ATTR)) {
+        type_attr = &(attr->value);
+    }
+
+    rt = tuya_ai_basic_biz_sendv(type, type_attr, vec, vec_num);
     if (rt != OPRT_OK) {
         PR_ERR("send biz data failed, rt:%d", rt);
     }
     return rt;
 }
 
-static void __ai_biz_thread_cb(void *args)
+static void __ai_biz_send_item_free(AI_BIZ_SEND_ITEM_T *item)
+{
+    if (item->free_cb && item->payload) {
+        item->free_cb(item->payload);
+    }
+    item->payload = NULL;
+}
+
+static void __ai_biz_session_clear(AI_SESSION_T *session)
+{
+    uint32_t sidx = 0;
+    for (sidx = 0; sidx < AI_MAX_SESSION_ID_NUM; sidx++) {
+        AI_BIZ_SEND_QUEUE_T *queue = &session->queue[sidx];
+        if (queue->item == NULL) {
+            continue;
+        }
+        while (queue->count) {
+            __ai_biz_send_item_free(&queue->item[queue->head]);
+            queue->head = (queue->head + 1) % AI_BIZ_SEND_QUEUE_DEPTH;
+            queue->count--;
+        }
+        OS_FREE(queue->item);
+    }
+    memset(session, 0, sizeof(AI_SESSION_T));
+}
+
+static uint8_t __ai_biz_is_pulled(AI_BIZ_SEND_ITEM_T *batch, uint32_t num, uint16_t id)
+{
+    uint32_t idx = 0;
+    for (idx = 0; idx < num; idx++) {
+        if (batch[idx].id == id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* take at most one item per channel and pass until batch is full, called with mutex locked */
+static uint32_t __ai_biz_collect_send(AI_BIZ_SEND_ITEM_T *batch, uint8_t *need_poll)
 {
     OPERATE_RET rt = OPRT_OK;
-    uint32_t idx = 0, sidx = 0, kdx = 0;
+    uint32_t idx = 0, sidx = 0, num = 0;
+    uint8_t pulled = true, popped = true;
+
+    *need_poll = false;
+    while (popped && (num < AI_BIZ_SEND_BATCH_NUM)) {
+        popped = false;
+        for (idx = 0; (idx < AI_SESSION_MAX_NUM) && (num < AI_BIZ_SEND_BATCH_NUM); idx++) {
+            AI_SESSION_T *session = &ai_basic_biz->session[idx];
+            if (session->id[0] == 0) {
+                continue;
+            }
+            for (sidx = 0; (sidx < session->cfg.send_num) && (num < AI_BIZ_SEND_BATCH_NUM); sidx++) {
+                AI_BIZ_SEND_DATA_T *send = &session->cfg.send[sidx];
+                AI_BIZ_SEND_QUEUE_T *queue = &session->queue[sidx];
+                if (queue->count) {
+                    memcpy(&batch[num++], &queue->item[queue->head], sizeof(AI_BIZ_SEND_ITEM_T));
+                    queue->head = (queue->head + 1) % AI_BIZ_SEND_QUEUE_DEPTH;
+                    queue->count--;
+                    queue->sent++;
+                    popped = true;
+                    continue;
+                }
+                if (send->get_cb == NULL) {
+                    continue;
+                }
+                *need_poll = true;
+                // get cb channels are polled once per round, shared ids only once
+                if (!pulled || __ai_biz_is_pulled(batch, num, send->id)) {
+                    continue;
+                }
+                AI_BIZ_SEND_ITEM_T *item = &batch[num];
+                memset(item, 0, sizeof(AI_BIZ_SEND_ITEM_T));
+                rt = send->get_cb(&item->attr, &item->head, &item->payload);
+                if (rt != OPRT_OK) {
+                    continue;
+                }
+                item->id = send->id;
+                item->type = send->type;
+                item->free_cb = send->free_cb;
+                num++;
+            }
+        }
+        pulled = false;
+    }
+    return num;
+}
+
+static void __ai_biz_thread_cb(void *args)
+{
+    uint32_t idx = 0, num = 0;
+    uint8_t need_poll = false;
+    AI_BIZ_SEND_ITEM_T batch[AI_BIZ_SEND_BATCH_NUM];
+
     while (tal_thread_get_state(ai_basic_biz->thread) == THREAD_STATE_RUNNING) {
         if (!tuya_ai_client_is_ready()) {
-            tal_system_sleep(200);
+            tal_semaphore_wait(ai_basic_biz->send_sem, 200);
             continue;
         }
+
         tal_mutex_lock(ai_basic_biz->mutex);
-        uint16_t sent_ids[AI_MAX_SESSION_ID_NUM * AI_SESSION_MAX_NUM] = {0};
-        uint32_t sent_ids_count = 0;
-        for (idx = 0; idx < AI_SESSION_MAX_NUM; idx++) {
-            if (ai_basic_biz->session[idx].id[0] != 0) {
-                AI_SESSION_T *session = &ai_basic_biz->session[idx];
-                for (sidx = 0; sidx < session->cfg.send_num; sidx++) {
-                    uint16_t send_id = session->cfg.send[sidx].id;
-                    uint8_t already_sent = false;
-                    for (kdx = 0; kdx < sent_ids_count; kdx++) {
-                        if (sent_ids[kdx] == send_id) {
-                            already_sent = true;
-                            break;
-                        }
-                    }
-                    if (!already_sent) {
-                        sent_ids[sent_ids_count++] = send_id;
-                        AI_BIZ_SEND_DATA_T *send = &session->cfg.send[sidx];
-                        if (send->get_cb) {
-                            AI_BIZ_ATTR_INFO_T attr = {0};
-                            AI_BIZ_HEAD_INFO_T head = {0};
-                            char *payload = NULL;
-                            rt = send->get_cb(&attr, &head, &payload);
-                            if (rt != OPRT_OK) {
-                                continue;
-                            }
-                            tuya_ai_send_biz_pkt(send->id, &attr, send->type, &head, payload);
-                            if (send->free_cb) {
-                                send->free_cb(payload);
-                            }
-                        }
-                    }
-                }
-            }
-        }
+        num = __ai_biz_collect_send(batch, &need_poll);
         tal_mutex_unlock(ai_basic_biz->mutex);
-        tal_system_sleep(AI_BIZ_TASK_DELAY);
+
+        for (idx = 0; idx < num; idx++) {
+            AI_BIZ_SEND_ITEM_T *item = &batch[idx];
+            tuya_ai_send_biz_pkt(item->id, &item->attr, item->type, &item->head, item->payload);
+            __ai_biz_send_item_free(item);
+        }
+        if (num == AI_BIZ_SEND_BATCH_NUM) {
+            continue;
+        }
+
+        // only legacy get cb channels need to be polled, queued data posts the semaphore
+        tal_semaphore_wait(ai_basic_biz->send_sem, need_poll ? AI_BIZ_TASK_DELAY : SEM_WAIT_FOREVER);
     }
 
     PR_NOTICE("ai biz thread exit");
+    tal_semaphore_post(ai_basic_biz->exit_sem);
     return;
 }
 
+static AI_BIZ_SEND_QUEUE_T *__ai_biz_find_send_queue(uint16_t id, AI_BIZ_SEND_DATA_T **send)
+{
+    uint32_t idx = 0, sidx = 0;
+    for (idx = 0; idx < AI_SESSION_MAX_NUM; idx++) {
+        AI_SESSION_T *session = &ai_basic_biz->session[idx];
+        if (session->id[0] == 0) {
+            continue;
+        }
+        for (sidx = 0; sidx < session->cfg.send_num; sidx++) {
+            if (session->cfg.send[sidx].id == id) {
+                if (send) {
+                    *send = &session->cfg.send[sidx];
+                }
+                return &session->queue[sidx];
+            }
+        }
+    }
+    return NULL;
+}
+
+OPERATE_RET tuya_ai_biz_send_enqueue(uint16_t id, AI_BIZ_ATTR_INFO_T *attr, AI_BIZ_HEAD_INFO_T *head, char *payload)
+{
+    OPERATE_RET rt = OPRT_OK;
+    AI_BIZ_SEND_DATA_T *send = NULL;
+    AI_BIZ_SEND_ITEM_T *item = NULL;
+
+    if ((ai_basic_biz == NULL) || (head == NULL)) {
+        PR_ERR("ai biz or head is null");
+        return OPRT_INVALID_PARM;
+    }
+
+    tal_mutex_lock(ai_basic_biz->mutex);
+    AI_BIZ_SEND_QUEUE_T *queue = __ai_biz_find_send_queue(id, &send);
+    if (queue == NULL) {
+        PR_ERR("send id:%d not found", id);
+        rt = OPRT_NOT_FOUND;
+        goto EXIT;
+    }
+    if (queue->item == NULL) {
+        queue->item = OS_MALLOC(AI_BIZ_SEND_QUEUE_DEPTH * sizeof(AI_BIZ_SEND_ITEM_T));
+        if (queue->item == NULL) {
+            rt = OPRT_MALLOC_FAILED;
+            goto EXIT;
+        }
+        queue->head = 0;
+        queue->count = 0;
+    }
+    if (queue->count >= AI_BIZ_SEND_QUEUE_DEPTH) {
+        queue->dropped++;
+        if (send->drop_policy != AI_BIZ_DROP_OLDEST) {
+            AI_PROTO_D("send id:%d queue full, drop newest", id);
+            rt = OPRT_EXCEED_UPPER_LIMIT;
+            goto EXIT;
+        }
+        AI_PROTO_D("send id:%d queue full, drop oldest", id);
+        __ai_biz_send_item_free(&queue->item[queue->head]);
+        queue->head = (queue->head + 1) % AI_BIZ_SEND_QUEUE_DEPTH;
+        queue->count--;
+    }
+
+    item = &queue->item[(queue->head + queue->count) % AI_BIZ_SEND_QUEUE_DEPTH];
+    memset(item, 0, sizeof(AI_BIZ_SEND_ITEM_T));
+    item->id = id;
+    item->type = send->type;
+    item->free_cb = send->free_cb;
+    if (attr) {
+        memcpy(&item->attr, attr, sizeof(AI_BIZ_ATTR_INFO_T));
+    }
+    memcpy(&item->head, head, sizeof(AI_BIZ_HEAD_INFO_T));
+    item->payload = payload;
+    queue->count++;
+
+    if (ai_basic_biz->thread == NULL) {
+        __ai_biz_create_task();
+    }
+
+EXIT:
+    tal_mutex_unlock(ai_basic_biz->mutex);
+    if (OPRT_OK == rt) {
+        tal_semaphore_post(ai_basic_biz->send_sem);
+    }
+    return rt;
+}
+
+OPERATE_RET tuya_ai_biz_get_send_stat(uint16_t id, AI_BIZ_SEND_STAT_T *stat)
+{
+    if ((ai_basic_biz == NULL) || (stat == NULL)) {
+        return OPRT_INVALID_PARM;
+    }
+
+    tal_mutex_lock(ai_basic_biz->mutex);
+    AI_BIZ_SEND_QUEUE_T *queue = __ai_biz_find_send_queue(id, NULL);
+    if (queue) {
+        stat->depth = queue->count;
+        stat->dropped = queue->dropped;
+        stat->sent = queue->sent;
+    }
+    tal_mutex_unlock(ai_basic_biz->mutex);
+    return queue ? OPRT_OK : OPRT_NOT_FOUND;
+}
+
 static uint8_t __ai_biz_need_send_task(void)
 {
     uint32_t idx = 0, sidx = 0;
@@ -261,13 +418,27 @@ static void __ai_biz_deinit(void)
 {
     if (ai_basic_biz) {
         if (ai_basic_biz->thread) {
-            tal_thread_delete(ai_basic_biz->thread);
+            // a thread not marked running yet cannot be deleted
+            while (OPRT_COM_ERROR == tal_thread_delete(ai_basic_biz->thread)) {
+                tal_system_sleep(10);
+            }
+            // wake the thread from its wait and let it leave before the struct is freed
+            tal_semaphore_post(ai_basic_biz->send_sem);
+            tal_semaphore_wait_forever(ai_basic_biz->exit_sem);
             ai_basic_biz->thread = NULL;
         }
         if (ai_basic_biz->mutex) {
             tal_mutex_release(ai_basic_biz->mutex);
             ai_basic_biz->mutex = NULL;
         }
+        if (ai_basic_biz->send_sem) {
+            tal_semaphore_release(ai_basic_biz->send_sem);
+            ai_basic_biz->send_sem = NULL;
+        }
+        if (ai_basic_biz->exit_sem) {
+            tal_semaphore_release(ai_basic_biz->exit_sem);
+            ai_basic_biz->exit_sem = NULL;
+        }
         Free(ai_basic_biz);
         ai_basic_biz = NULL;
     }
@@ -655,7 +826,7 @@ static OPERATE_RET __ai_biz_session_destory(AI_SESSION_ID id, AI_STATUS_CODE cod
     tal_mutex_lock(ai_basic_biz->mutex);
     for (idx = 0; idx < AI_SESSION_MAX_NUM; idx++) {
         if (ai_basic_biz->session[idx].id[0] != 0 && !strcmp(ai_basic_biz->session[idx].id, id)) {
-            memset(&ai_basic_biz->session[idx], 0, sizeof(AI_SESSION_T));
+            __ai_biz_session_clear(&ai_basic_biz->session[idx]);
             AI_PROTO_D("del session idx:%d", idx);
             break;
         }
@@ -796,7 +967,7 @@ static OPERATE_RET __ai_clt_close_evt(void *data)
         if (ai_basic_biz->session[idx].id[0] != 0) {
             PR_NOTICE("close session id:%s", ai_basic_biz->session[idx].id);
             tal_event_publish(EVENT_AI_SESSION_CLOSE, ai_basic_biz->session[idx].id);
-            memset(&ai_basic_biz->session[idx], 0, sizeof(AI_SESSION_T));
+            __ai_biz_session_clear(&ai_basic_biz->session[idx]);
         }
     }
     tal_mutex_unlock(ai_basic_biz->mutex);
@@ -812,6 +983,8 @@ static OPERATE_RET __ai_clt_run_evt(void *data)
         TUYA_CHECK_NULL_RETURN(ai_basic_biz, OPRT_MALLOC_FAILED);
         memset(ai_basic_biz, 0, sizeof(AI_BASIC_BIZ_T));
         TUYA_CALL_ERR_GOTO(tal_mutex_create_init(&ai_basic_biz->mutex), EXIT);
+        TUYA_CALL_ERR_GOTO(tal_semaphore_create_init(&ai_basic_biz->send_sem, 0, 1), EXIT);
+        TUYA_CALL_ERR_GOTO(tal_semaphore_create_init(&ai_basic_biz->exit_sem, 0, 1), EXIT);
         tuya_ai_client_reg_cb(__ai_biz_recv_handle);
         PR_NOTICE("ai biz init success");
     }
@@ -906,6 +1079,7 @@ OPERATE_RET tuya_ai_biz_crt_session(uint32_t bizCode, AI_SESSION_CFG_T *cfg, uin
         __ai_biz_create_task();
     }
     tal_mutex_unlock(ai_basic_biz->mutex);
+    tal_semaphore_post(ai_basic_biz->send_sem);
 
     if (idx == AI_SESSION_MAX_NUM) {
         PR_ERR("session num is full");
@@ -41,11 +41,19 @@
 #define AI_CLIENT_STACK_SIZE 4096
 #endif
 
+#define AI_RECV_QUEUE_NUM 8
+
 typedef struct {
     uint32_t min;
     uint32_t max;
 } AI_RECONN_TIME_T;
 
+typedef struct {
+    char *data; // NULL to stop the dispatch task
+    uint32_t len;
+    AI_FRAG_FLAG frag;
+} AI_RECV_ITEM_T;
+
 typedef enum {
     AI_STATE_IDLE,
     AI_STATE_SETUP,
@@ -69,6 +77,9 @@ typedef struct {
     TIMER_ID alive_timeout_timer;
     uint8_t heartbeat_lost_cnt;
     AI_BASIC_DATA_HANDLE cb;
+    THREAD_HANDLE recv_thread;
+    SEM_HANDLE recv_exit_sem; // posted by the recv thread as its last act
+    QUEUE_HANDLE recv_queue;
 } AI_BASIC_CLIENT_T;
 
 static AI_BASIC_CLIENT_T *ai_basic_client = NULL;
@@ -246,6 +257,44 @@ static void __ai_handle_pong(char *data, uint32_t len)
     PR_NOTICE("ai pong");
 }
 
+static void __ai_dispatch(char *data, uint32_t len, AI_FRAG_FLAG frag)
+{
+    if (ai_basic_client->recv_queue) {
+        AI_RECV_ITEM_T item = {data, len, frag};
+        // hand the pooled packet over, the reader goes on while it is decoded
+        if (OPRT_OK == tal_queue_post(ai_basic_client->recv_queue, &item, SEM_WAIT_FOREVER)) {
+            return;
+        }
+    }
+    if (ai_basic_client->cb) {
+        ai_basic_client->cb(data, len, frag);
+    }
+    tuya_ai_basic_pkt_free(data);
+}
+
+static void __ai_recv_thread_cb(void *args)
+{
+    QUEUE_HANDLE queue = (QUEUE_HANDLE)args;
+    AI_RECV_ITEM_T item;
+
+    while (1) {
+        if (OPRT_OK != tal_queue_fetch(queue, &item, SEM_WAIT_FOREVER)) {
+            continue;
+        }
+        if (!item.data) {
+            break;
+        }
+        if (ai_basic_client->cb) {
+            ai_basic_client->cb(item.data, item.len, item.frag);
+        }
+        tuya_ai_basic_pkt_free(item.data);
+    }
+
+    tal_queue_free(queue);
+    PR_NOTICE("ai recv thread exit");
+    tal_semaphore_post(ai_basic_client->recv_exit_sem);
+}
+
 static OPERATE_RET __ai_running(void)
 {
     OPERATE_RET rt = OPRT_OK;
@@ -271,14 +320,12 @@ static OPERATE_RET __ai_running(void)
         } else if (pkt_type == AI_PT_CONN_CLOSE) {
             __ai_handle_conn_close(de_buf, de_len);
         } else {
-            if (ai_basic_client->cb) {
-                ai_basic_client->cb(de_buf, de_len, frag);
-            }
+            __ai_dispatch(de_buf, de_len, frag);
+            return rt;
         }
     } else {
-        if (ai_basic_client->cb) {
-            ai_basic_client->cb(de_buf, de_len, frag);
-        }
+        __ai_dispatch(de_buf, de_len, frag);
+        return rt;
     }
 
     tuya_ai_basic_pkt_free(de_buf);
@@ -314,6 +361,25 @@ static OPERATE_RET __ai_setup()
 
 static void __ai_basic_client_deinit(void)
 {
+    if (ai_basic_client->recv_queue) {
+        AI_RECV_ITEM_T item = {0};
+        if (ai_basic_client->recv_thread) {
+            // the queued packets are dispatched before the stop item, wait until the last one is freed
+            tal_queue_post(ai_basic_client->recv_queue, &item, SEM_WAIT_FOREVER);
+            tal_semaphore_wait_forever(ai_basic_client->recv_exit_sem);
+            while (OPRT_COM_ERROR == tal_thread_delete(ai_basic_client->recv_thread)) {
+                tal_system_sleep(10);
+            }
+            ai_basic_client->recv_thread = NULL;
+        } else {
+            tal_queue_free(ai_basic_client->recv_queue);
+        }
+        ai_basic_client->recv_queue = NULL;
+    }
+    if (ai_basic_client->recv_exit_sem) {
+        tal_semaphore_release(ai_basic_client->recv_exit_sem);
+        ai_basic_client->recv_exit_sem = NULL;
+    }
     if (ai_basic_client->thread) {
         tal_thread_delete(ai_basic_client->thread);
         ai_basic_client->thread = NULL;
@@ -383,6 +449,26 @@ static OPERATE_RET __ai_client_create_task(void)
     thrd_param.psram_mode = 1;
 #endif
 
+    // packets are decoded by the recv thread, the client thread keeps reading
+    rt = tal_queue_create_init(&ai_basic_client->recv_queue, sizeof(AI_RECV_ITEM_T), AI_RECV_QUEUE_NUM);
+    if (OPRT_OK != rt) {
+        PR_ERR("ai recv queue create err, rt:%d", rt);
+        return rt;
+    }
+    rt = tal_semaphore_create_init(&ai_basic_client->recv_exit_sem, 0, 1);
+    if (OPRT_OK != rt) {
+        PR_ERR("ai recv exit sem create err, rt:%d", rt);
+        return rt;
+    }
+    thrd_param.thrdname = "ai_recv_thread";
+    rt = tal_thread_create_and_start(&ai_basic_client->recv_thread, NULL, NULL, __ai_recv_thread_cb,
+                                     ai_basic_client->recv_queue, &thrd_param);
+    if (OPRT_OK != rt) {
+        PR_ERR("ai recv thread create err, rt:%d", rt);
+        return rt;
+    }
+
+    thrd_param.thrdname = "ai_client_thread";
     rt = tal_thread_create_and_start(&ai_basic_client->thread, NULL, NULL, __ai_client_thread_cb, NULL, &thrd_param);
     if (OPRT_OK != rt) {
         PR_ERR("ai client thread create err, rt:%d", rt);
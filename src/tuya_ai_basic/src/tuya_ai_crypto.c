@@ -0,0 +1,228 @@
+/**
+ * @file tuya_ai_crypto.c
+ * @brief Persistent crypto engine of the Tuya AI protocol.
+ *
+ * The engine keeps the expanded cipher context and the hmac pads of one
+ * connection direction, so a packet is encrypted, decrypted and signed
+ * without setting up any cipher or allocating any temporary buffer.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "tuya_cloud_types.h"
+#include "tal_log.h"
+#include "tal_hash.h"
+#include "tal_symmetry.h"
+#include "tuya_ai_crypto.h"
+
+static uint32_t __ai_crypto_add_pkcs(uint8_t *p, uint32_t len)
+{
+    uint32_t cz = 16 - len % 16;
+
+    memset(p + len, cz, cz);
+    return len + cz;
+}
+
+OPERATE_RET tuya_ai_crypto_init(AI_CRYPTO_T *crypto, AI_PACKET_SL sl, uint8_t is_encrypt, uint8_t *crypt_key,
+                                uint8_t *sign_key)
+{
+    OPERATE_RET rt = OPRT_OK;
+
+    TUYA_CHECK_NULL_RETURN(crypto, OPRT_INVALID_PARM);
+    TUYA_CHECK_NULL_RETURN(crypt_key, OPRT_INVALID_PARM);
+    TUYA_CHECK_NULL_RETURN(sign_key, OPRT_INVALID_PARM);
+
+    memset(crypto, 0, sizeof(AI_CRYPTO_T));
+    crypto->sl = sl;
+    crypto->is_encrypt = is_encrypt;
+
+    TUYA_CALL_ERR_GOTO(tal_sha256_mac_create_init(&crypto->hmac), EXIT);
+    crypto->inited = TRUE;
+    TUYA_CALL_ERR_GOTO(tal_sha256_mac_starts(&crypto->hmac, sign_key, AI_KEY_LEN), EXIT);
+
+    if (sl == AI_PACKET_SL2) {
+#if defined(MBEDTLS_CHACHA20_C)
+        mbedtls_chacha20_init(&crypto->chacha);
+        TUYA_CALL_ERR_GOTO(mbedtls_chacha20_setkey(&crypto->chacha, crypt_key), EXIT);
+#else
+        PR_ERR("chacha20 not support");
+        rt = OPRT_NOT_SUPPORTED;
+        goto EXIT;
+#endif
+    } else if (sl == AI_PACKET_SL3) {
+        TUYA_CALL_ERR_GOTO(tal_aes_create_init(&crypto->aes), EXIT);
+        if (is_encrypt) {
+            TUYA_CALL_ERR_GOTO(tal_aes_setkey_enc(crypto->aes, crypt_key, AI_KEY_LEN * 8), EXIT);
+        } else {
+            TUYA_CALL_ERR_GOTO(tal_aes_setkey_dec(crypto->aes, crypt_key, AI_KEY_LEN * 8), EXIT);
+        }
+    } else if (sl == AI_PACKET_SL4) {
+#if defined(MBEDTLS_GCM_C)
+        mbedtls_gcm_init(&crypto->gcm);
+        TUYA_CALL_ERR_GOTO(mbedtls_gcm_setkey(&crypto->gcm, MBEDTLS_CIPHER_ID_AES, crypt_key, AI_KEY_LEN * 8), EXIT);
+#else
+        PR_ERR("gcm not support");
+        rt = OPRT_NOT_SUPPORTED;
+        goto EXIT;
+#endif
+    } else if (sl != AI_PACKET_SL0) {
+        PR_ERR("sl:%d err", sl);
+        rt = OPRT_INVALID_PARM;
+        goto EXIT;
+    }
+    return OPRT_OK;
+
+EXIT:
+    PR_ERR("ai crypto init failed, sl:%d, rt:%d", sl, rt);
+    tuya_ai_crypto_deinit(crypto);
+    return rt;
+}
+
+void tuya_ai_crypto_deinit(AI_CRYPTO_T *crypto)
+{
+    if (!crypto || !crypto->inited) {
+        return;
+    }
+
+    if (crypto->sl == AI_PACKET_SL2) {
+#if defined(MBEDTLS_CHACHA20_C)
+        mbedtls_chacha20_free(&crypto->chacha);
+#endif
+    } else if (crypto->sl == AI_PACKET_SL3) {
+        if (crypto->aes) {
+            tal_aes_free(crypto->aes);
+        }
+    } else if (crypto->sl == AI_PACKET_SL4) {
+#if defined(MBEDTLS_GCM_C)
+        mbedtls_gcm_free(&crypto->gcm);
+#endif
+    }
+    tal_sha256_mac_free(&crypto->hmac);
+    memset(crypto, 0, sizeof(AI_CRYPTO_T));
+}
+
+OPERATE_RET tuya_ai_crypto_encrypt(AI_CRYPTO_T *crypto, uint8_t *iv, uint8_t *buf, uint32_t len, uint32_t *out_len)
+{
+    OPERATE_RET rt = OPRT_OK;
+    uint32_t pad_len = 0;
+
+    if (crypto->sl == AI_PACKET_SL2) {
+#if defined(MBEDTLS_CHACHA20_C)
+        /* the padding is not part of the keystream, keep it as the peer expects */
+        pad_len = __ai_crypto_add_pkcs(buf, len);
+        rt = mbedtls_chacha20_starts(&crypto->chacha, iv, 0);
+        if (OPRT_OK == rt) {
+            rt = mbedtls_chacha20_update(&crypto->chacha, len, buf, buf);
+        }
+        if (OPRT_OK != rt) {
+            PR_ERR("chacha20_crypt error:%d", rt);
+            return rt;
+        }
+        *out_len = pad_len;
+#endif
+    } else if (crypto->sl == AI_PACKET_SL3) {
+        pad_len = tal_pkcs7padding_buffer(buf, len);
+        rt = tal_aes_crypt_cbc(crypto->aes, SYMMETRY_ENCRYPT, pad_len, iv, buf, buf);
+        if (OPRT_OK != rt) {
+            PR_ERR("aes256_cbc_encode error:%d", rt);
+            return rt;
+        }
+        *out_len = pad_len;
+    } else if (crypto->sl == AI_PACKET_SL4) {
+#if defined(MBEDTLS_GCM_C)
+        pad_len = __ai_crypto_add_pkcs(buf, len);
+        rt = mbedtls_gcm_crypt_and_tag(&crypto->gcm, MBEDTLS_GCM_ENCRYPT, pad_len, iv, AI_IV_LEN, NULL, 0, buf, buf,
+                                       AI_GCM_TAG_LEN, buf + pad_len);
+        if (OPRT_OK != rt) {
+            PR_ERR("aes256_gcm_encode error:%x", rt);
+            return rt;
+        }
+        *out_len = pad_len + AI_GCM_TAG_LEN;
+#endif
+    } else {
+        *out_len = len;
+    }
+
+    return rt;
+}
+
+OPERATE_RET tuya_ai_crypto_decrypt(AI_CRYPTO_T *crypto, uint8_t *iv, uint8_t *in, uint32_t len, uint8_t *out,
+                                   uint32_t *out_len)
+{
+    OPERATE_RET rt = OPRT_OK;
+    uint32_t plain_len = len;
+
+    if (crypto->sl == AI_PACKET_SL2) {
+#if defined(MBEDTLS_CHACHA20_C)
+        rt = mbedtls_chacha20_starts(&crypto->chacha, iv, 0);
+        if (OPRT_OK == rt) {
+            rt = mbedtls_chacha20_update(&crypto->chacha, len, in, out);
+        }
+        if (OPRT_OK != rt) {
+            PR_ERR("chacha20_crypt error:%d", rt);
+            return rt;
+        }
+#endif
+    } else if (crypto->sl == AI_PACKET_SL3) {
+        rt = tal_aes_crypt_cbc(crypto->aes, SYMMETRY_DECRYPT, len, iv, in, out);
+        if (OPRT_OK != rt) {
+            PR_ERR("aes256_cbc_decode error:%d", rt);
+            return rt;
+        }
+    } else if (crypto->sl == AI_PACKET_SL4) {
+#if defined(MBEDTLS_GCM_C)
+        if (len < AI_GCM_TAG_LEN) {
+            return OPRT_INVALID_PARM;
+        }
+        plain_len = len - AI_GCM_TAG_LEN;
+        rt = mbedtls_gcm_auth_decrypt(&crypto->gcm, plain_len, iv, AI_IV_LEN, NULL, 0, in + plain_len, AI_GCM_TAG_LEN,
+                                      in, out);
+        if (OPRT_OK != rt) {
+            PR_ERR("aes256_gcm_decode error:%x", rt);
+            return rt;
+        }
+#endif
+    } else {
+        if (in != out) {
+            memmove(out, in, len);
+        }
+        *out_len = len;
+        return rt;
+    }
+
+    if (plain_len == 0 || out[plain_len - 1] > plain_len) {
+        PR_ERR("decrypt padding error, len:%d", plain_len);
+        return OPRT_COM_ERROR;
+    }
+    *out_len = plain_len - out[plain_len - 1];
+    return rt;
+}
+
+OPERATE_RET tuya_ai_crypto_sign_starts(AI_CRYPTO_T *crypto)
+{
+    OPERATE_RET rt = OPRT_OK;
+
+    /* restart from the cached inner pad instead of rehashing the key */
+    rt = tal_sha256_starts_ret(crypto->hmac.ctx, 0);
+    if (OPRT_OK == rt) {
+        rt = tal_sha256_update_ret(crypto->hmac.ctx, crypto->hmac.ipad, sizeof(crypto->hmac.ipad));
+    }
+    return rt;
+}
+
+OPERATE_RET tuya_ai_crypto_sign_update(AI_CRYPTO_T *crypto, const uint8_t *data, uint32_t len)
+{
+    if (len == 0) {
+        return OPRT_OK;
+    }
+    return tal_sha256_update_ret(crypto->hmac.ctx, data, len);
+}
+
+OPERATE_RET tuya_ai_crypto_sign_finish(AI_CRYPTO_T *crypto, uint8_t *signature)
+{
+    return tal_sha256_mac_finish(&crypto->hmac, signature);
+}
@@ -27,7 +27,6 @@
 #include "tal_api.h"
 #include "tuya_transporter.h"
 #include "mbedtls/hkdf.h"
-#include "mbedtls/chacha20.h"
 #include "mix_method.h"
 #include "tuya_iot.h"
 #include "cJSON.h"
@@ -35,10 +34,10 @@
 #include "uni_random.h"
 #include "tal_system.h"
 #include "tal_hash.h"
-#include "cipher_wrapper.h"
 #include "tal_security.h"
 #include "tal_memory.h"
 #include "tuya_ai_protocol.h"
+#include "tuya_ai_crypto.h"
 #include "tuya_ai_private.h"
 
 #define AI_DEFAULT_TIMEOUT_MS     5000
@@ -52,6 +51,14 @@
 #ifndef AI_WRITE_SOCKET_BUF_SIZE
 #define AI_WRITE_SOCKET_BUF_SIZE 0
 #endif
+#ifndef AI_RECV_POOL_FRAG_NUM
+#define AI_RECV_POOL_FRAG_NUM 2
+#endif
+
+#define AI_RECV_POOL_SIZE (AI_RECV_POOL_FRAG_NUM * (AI_MAX_FRAGMENT_LENGTH + AI_ADD_PKT_LEN))
+#define AI_RECV_SLOT_NUM  8
+#define AI_RECV_SLOT_HEAP 0xFFFFFFFF
+#define AI_RECV_HEAD_LEN  (sizeof(AI_PACKET_HEAD_T) + AI_IV_LEN + sizeof(uint32_t))
 
 /**
  *
@@ -64,9 +71,35 @@
 typedef struct {
     AI_FRAG_FLAG frag_flag;
     uint32_t offset;
-    char *data;
+    int slot; // slot being reassembled, -1 if none
 } AI_RECV_FRAG_MNG_T;
 
+/**
+ *
+ * recv pool: packets are read, verified and decrypted in place in slots,
+ * slots are carved from one ring buffer and released in any order by the
+ * consumer, space is reclaimed from the oldest slot. The payload of each
+ * fragment is read right behind the plain data of the previous one, so a
+ * fragmented packet is reassembled without any copy.
+ *
+ **/
+typedef struct {
+    char *data;
+    uint32_t off; // offset in pool, AI_RECV_SLOT_HEAP if the slot is on heap
+    uint32_t size;
+    uint8_t busy;
+} AI_RECV_SLOT_T;
+
+typedef struct {
+    MUTEX_HANDLE mutex;
+    SEM_HANDLE sem; // posted when a slot is released
+    char *buf;
+    uint32_t wr;
+    uint8_t head;
+    uint8_t count;
+    AI_RECV_SLOT_T slot[AI_RECV_SLOT_NUM];
+} AI_RECV_POOL_T;
+
 typedef struct {
     uint32_t offset;
 } AI_SEND_FRAG_MNG_T;
@@ -86,10 +119,14 @@ typedef struct {
     char *connection_id;
     char encrypt_iv[AI_IV_LEN + 1];
     char decrypt_iv[AI_IV_LEN + 1];
+    AI_CRYPTO_T tx_crypto; // send direction, protected by mutex
+    AI_CRYPTO_T rx_crypto; // recv direction, only used by the read task
     AI_RECV_FRAG_MNG_T recv_frag_mng;
     AI_SEND_FRAG_MNG_T send_frag_mng[2]; // 0:image,1:file
     bool frag_flag;
-    char recv_buf[AI_MAX_FRAGMENT_LENGTH + AI_ADD_PKT_LEN];
+    char recv_head[AI_RECV_HEAD_LEN];
+    AI_RECV_POOL_T recv_pool;
+    char send_buf[AI_MAX_FRAGMENT_LENGTH]; // packet arena, protected by mutex
 } AI_BASIC_PROTO_T;
 
 static AI_BASIC_PROTO_T *ai_basic_proto = NULL;
@@ -147,11 +184,6 @@ static OPERATE_RET __ai_generate_crypt_key()
     return rt;
 }
 
-static char *__ai_get_crypt_key(void)
-{
-    return ai_basic_proto->crypt_key;
-}
-
 static OPERATE_RET __ai_generate_sign_key()
 {
     OPERATE_RET rt = OPRT_OK;
@@ -173,9 +205,23 @@ static OPERATE_RET __ai_generate_sign_key()
     return rt;
 }
 
-static char *__ai_get_sign_key(void)
+static OPERATE_RET __ai_crypto_setup(void)
 {
-    return ai_basic_proto->sign_key;
+    OPERATE_RET rt = OPRT_OK;
+
+    tuya_ai_crypto_deinit(&ai_basic_proto->tx_crypto);
+    tuya_ai_crypto_deinit(&ai_basic_proto->rx_crypto);
+    rt = tuya_ai_crypto_init(&ai_basic_proto->tx_crypto, ai_basic_proto->sl, TRUE,
+                             (uint8_t *)ai_basic_proto->crypt_key, (uint8_t *)ai_basic_proto->sign_key);
+    if (OPRT_OK != rt) {
+        return rt;
+    }
+    rt = tuya_ai_crypto_init(&ai_basic_proto->rx_crypto, ai_basic_proto->sl, FALSE,
+                             (uint8_t *)ai_basic_proto->crypt_key, (uint8_t *)ai_basic_proto->sign_key);
+    if (OPRT_OK != rt) {
+        tuya_ai_crypto_deinit(&ai_basic_proto->tx_crypto);
+    }
+    return rt;
 }
 
 static AI_PACKET_SL __ai_get_sl(AI_PACKET_PT type, uint8_t is_decrypt)
@@ -190,6 +236,223 @@ static AI_PACKET_SL __ai_get_sl(AI_PACKET_PT type, uint8_t is_decrypt)
     }
 }
 
+static OPERATE_RET __ai_recv_pool_init(AI_RECV_POOL_T *pool)
+{
+    OPERATE_RET rt = OPRT_OK;
+
+    pool->buf = OS_MALLOC(AI_RECV_POOL_SIZE);
+    TUYA_CHECK_NULL_RETURN(pool->buf, OPRT_MALLOC_FAILED);
+    TUYA_CALL_ERR_RETURN(tal_mutex_create_init(&pool->mutex));
+    TUYA_CALL_ERR_RETURN(tal_semaphore_create_init(&pool->sem, 0, AI_RECV_SLOT_NUM));
+    return rt;
+}
+
+static void __ai_recv_pool_deinit(AI_RECV_POOL_T *pool)
+{
+    uint32_t idx = 0;
+    for (idx = 0; idx < AI_RECV_SLOT_NUM; idx++) {
+        if (pool->slot[idx].busy && (pool->slot[idx].off == AI_RECV_SLOT_HEAP)) {
+            OS_FREE(pool->slot[idx].data);
+        }
+    }
+    if (pool->buf) {
+        OS_FREE(pool->buf);
+    }
+    if (pool->mutex) {
+        tal_mutex_release(pool->mutex);
+    }
+    if (pool->sem) {
+        tal_semaphore_release(pool->sem);
+    }
+    memset(pool, 0, sizeof(AI_RECV_POOL_T));
+}
+
+/* offset of the oldest live slot in the ring buffer, AI_RECV_SLOT_HEAP if none */
+static uint32_t __ai_recv_pool_oldest(AI_RECV_POOL_T *pool, uint8_t skip_newest)
+{
+    uint32_t idx = 0, num = pool->count;
+    if (skip_newest && num) {
+        num--;
+    }
+    for (idx = 0; idx < num; idx++) {
+        AI_RECV_SLOT_T *slot = &pool->slot[(pool->head + idx) % AI_RECV_SLOT_NUM];
+        if (slot->off != AI_RECV_SLOT_HEAP) {
+            return slot->off;
+        }
+    }
+    return AI_RECV_SLOT_HEAP;
+}
+
+static int __ai_recv_slot_alloc(uint32_t size, uint8_t use_heap)
+{
+    AI_RECV_POOL_T *pool = &ai_basic_proto->recv_pool;
+    uint32_t off = AI_RECV_SLOT_HEAP;
+    int idx = -1;
+
+    tal_mutex_lock(pool->mutex);
+    if (pool->count >= AI_RECV_SLOT_NUM) {
+        goto EXIT;
+    }
+
+    uint32_t oldest = __ai_recv_pool_oldest(pool, FALSE);
+    if (oldest == AI_RECV_SLOT_HEAP) {
+        pool->wr = 0;
+        if (size <= AI_RECV_POOL_SIZE) {
+            off = 0;
+        }
+    } else if (pool->wr > oldest) {
+        if (AI_RECV_POOL_SIZE - pool->wr >= size) {
+            off = pool->wr;
+        } else if (oldest >= size) {
+            off = 0;
+        }
+    } else if (oldest - pool->wr >= size) {
+        off = pool->wr;
+    }
+
+    char *data = NULL;
+    if (off != AI_RECV_SLOT_HEAP) {
+        data = pool->buf + off;
+        pool->wr = off + size;
+    } else if (use_heap) {
+        AI_PROTO_D("recv pool full, use heap, size:%d", size);
+        data = OS_MALLOC(size);
+    }
+    if (data) {
+        idx = (pool->head + pool->count) % AI_RECV_SLOT_NUM;
+        pool->slot[idx].data = data;
+        pool->slot[idx].off = off;
+        pool->slot[idx].size = size;
+        pool->slot[idx].busy = TRUE;
+        pool->count++;
+    }
+
+EXIT:
+    tal_mutex_unlock(pool->mutex);
+    return idx;
+}
+
+static int __ai_recv_slot_get(uint32_t size)
+{
+    int idx = -1;
+    // wait for the consumer to release a slot before falling back to heap
+    while ((idx = __ai_recv_slot_alloc(size, FALSE)) < 0) {
+        if (OPRT_OK != tal_semaphore_wait(ai_basic_proto->recv_pool.sem, AI_DEFAULT_TIMEOUT_MS)) {
+            idx = __ai_recv_slot_alloc(size, TRUE);
+            break;
+        }
+    }
+    return idx;
+}
+
+/* grow the newest slot in place, or move its first used bytes to heap */
+static OPERATE_RET __ai_recv_slot_resize(int idx, uint32_t size, uint32_t used)
+{
+    OPERATE_RET rt = OPRT_OK;
+    AI_RECV_POOL_T *pool = &ai_basic_proto->recv_pool;
+    AI_RECV_SLOT_T *slot = &pool->slot[idx];
+
+    tal_mutex_lock(pool->mutex);
+    if (size <= slot->size) {
+        goto EXIT;
+    }
+    if (slot->off != AI_RECV_SLOT_HEAP) {
+        uint32_t limit = AI_RECV_POOL_SIZE;
+        uint32_t oldest = __ai_recv_pool_oldest(pool, TRUE);
+        if ((oldest != AI_RECV_SLOT_HEAP) && (oldest > slot->off)) {
+            limit = oldest;
+        }
+        if (slot->off + size <= limit) {
+            slot->size = size;
+            pool->wr = slot->off + size;
+            goto EXIT;
+        }
+    }
+
+    AI_PROTO_D("recv slot move to heap, size:%d", size);
+    char *data = OS_MALLOC(size);
+    if (!data) {
+        rt = OPRT_MALLOC_FAILED;
+        goto EXIT;
+    }
+    memcpy(data, slot->data, used);
+    if (slot->off == AI_RECV_SLOT_HEAP) {
+        OS_FREE(slot->data);
+    } else {
+        pool->wr = slot->off;
+    }
+    slot->data = data;
+    slot->off = AI_RECV_SLOT_HEAP;
+    slot->size = size;
+
+EXIT:
+    tal_mutex_unlock(pool->mutex);
+    return rt;
+}
+
+static void __ai_recv_slot_release(int idx)
+{
+    AI_RECV_POOL_T *pool = &ai_basic_proto->recv_pool;
+
+    tal_mutex_lock(pool->mutex);
+    if (pool->slot[idx].off == AI_RECV_SLOT_HEAP) {
+        OS_FREE(pool->slot[idx].data);
+    }
+    pool->slot[idx].data = NULL;
+    pool->slot[idx].busy = FALSE;
+    while (pool->count && !pool->slot[pool->head].busy) {
+        pool->head = (pool->head + 1) % AI_RECV_SLOT_NUM;
+        pool->count--;
+    }
+    if (pool->count == 0) {
+        pool->wr = 0;
+    }
+    tal_mutex_unlock(pool->mutex);
+    tal_semaphore_post(pool->sem);
+}
+
+static int __ai_recv_slot_find(char *data)
+{
+    AI_RECV_POOL_T *pool = &ai_basic_proto->recv_pool;
+    int idx = 0;
+
+    tal_mutex_lock(pool->mutex);
+    for (idx = 0; idx < AI_RECV_SLOT_NUM; idx++) {
+        if (pool->slot[idx].busy && (pool->slot[idx].data == data)) {
+            break;
+        }
+    }
+    tal_mutex_unlock(pool->mutex);
+    return (idx < AI_RECV_SLOT_NUM) ? idx : -1;
+}
+
+/* wait for the packets handed to the recv thread to come back before the pool is freed */
+static void __ai_recv_pool_drain(AI_RECV_POOL_T *pool)
+{
+    uint32_t count = 0;
+
+    while (1) {
+        tal_mutex_lock(pool->mutex);
+        count = pool->count;
+        tal_mutex_unlock(pool->mutex);
+        if (0 == count) {
+            break;
+        }
+        if (OPRT_OK != tal_semaphore_wait(pool->sem, AI_DEFAULT_TIMEOUT_MS)) {
+            PR_WARN("wait for %d recv packets", count);
+        }
+    }
+}
+
+static void __ai_recv_frag_reset(void)
+{
+    if (ai_basic_proto->recv_frag_mng.slot >= 0) {
+        __ai_recv_slot_release(ai_basic_proto->recv_frag_mng.slot);
+    }
+    memset(&ai_basic_proto->recv_frag_mng, 0, sizeof(AI_RECV_FRAG_MNG_T));
+    ai_basic_proto->recv_frag_mng.slot = -1;
+}
+
 static void __ai_basic_proto_deinit(void)
 {
     if (ai_basic_proto) {
@@ -206,6 +469,13 @@ static void __ai_basic_proto_deinit(void)
             Free(ai_basic_proto->connection_id);
             ai_basic_proto->connection_id = NULL;
         }
+        tuya_ai_crypto_deinit(&ai_basic_proto->tx_crypto);
+        tuya_ai_crypto_deinit(&ai_basic_proto->rx_crypto);
+        if (ai_basic_proto->recv_pool.sem) {
+            __ai_recv_frag_reset();
+            __ai_recv_pool_drain(&ai_basic_proto->recv_pool);
+        }
+        __ai_recv_pool_deinit(&ai_basic_proto->recv_pool);
         Free(ai_basic_proto);
         ai_basic_proto = NULL;
     }
@@ -227,15 +497,17 @@ static void __ai_basic_proto_reinit(void)
     }
     __ai_generate_crypt_key();
     __ai_generate_sign_key();
+    ai_basic_proto->sl = AI_PACKET_SECURITY_LEVEL;
+    if (OPRT_OK != __ai_crypto_setup()) {
+        PR_ERR("ai crypto setup failed");
+    }
     ai_basic_proto->connected = FALSE;
     ai_basic_proto->sequence_in = 0;
     ai_basic_proto->sequence_out = 1;
-    memset(ai_basic_proto->recv_buf, 0, sizeof(ai_basic_proto->recv_buf));
     memset(ai_basic_proto->encrypt_iv, 0, AI_IV_LEN);
     uni_random_string(ai_basic_proto->encrypt_iv, AI_IV_LEN);
-    ai_basic_proto->sl = AI_PACKET_SECURITY_LEVEL;
     memset(ai_basic_proto->decrypt_iv, 0, AI_IV_LEN);
-    memset(&ai_basic_proto->recv_frag_mng, 0, sizeof(ai_basic_proto->recv_frag_mng));
+    __ai_recv_frag_reset();
     tal_mutex_unlock(ai_basic_proto->mutex);
     PR_NOTICE("ai proto reinit success");
     return;
@@ -253,9 +525,12 @@ static OPERATE_RET __ai_basic_proto_init(void)
         TUYA_CALL_ERR_GOTO(__ai_generate_crypt_key(), EXIT);
         TUYA_CALL_ERR_GOTO(__ai_generate_sign_key(), EXIT);
         TUYA_CALL_ERR_GOTO(tal_mutex_create_init(&ai_basic_proto->mutex), EXIT);
+        TUYA_CALL_ERR_GOTO(__ai_recv_pool_init(&ai_basic_proto->recv_pool), EXIT);
+        ai_basic_proto->recv_frag_mng.slot = -1;
         ai_basic_proto->sequence_out = 1;
         uni_random_string(ai_basic_proto->encrypt_iv, AI_IV_LEN);
         ai_basic_proto->sl = AI_PACKET_SECURITY_LEVEL;
+        TUYA_CALL_ERR_GOTO(__ai_crypto_setup(), EXIT);
         PR_NOTICE("ai proto init success, sl:%d", ai_basic_proto->sl);
     }
     return rt;
@@ -408,41 +683,34 @@ static uint32_t __ai_get_packet_len(char *buf)
     return packet_len;
 }
 
-static uint32_t __ai_get_payload_len(char *buf)
-{
-    return __ai_get_packet_len(buf) - AI_SIGN_LEN;
-}
-
-static OPERATE_RET __ai_packet_sign(char *buf, uint8_t *signature)
+/* the packet head and the payload may live in different buffers */
+static OPERATE_RET __ai_packet_sign(AI_CRYPTO_T *crypto, char *head, uint32_t head_len, char *payload,
+                                    uint32_t payload_len, uint8_t *signature)
 {
     OPERATE_RET rt = OPRT_OK;
-    char *sign_key = __ai_get_sign_key();
-    TUYA_CHECK_NULL_RETURN(sign_key, OPRT_COM_ERROR);
-
-    uint32_t head_len = __ai_get_head_len(buf);
-    uint32_t payload_len = __ai_get_payload_len(buf);
+    static const uint8_t zero_pad[32] = {0};
 
     // transport first 32 byte and packet last 32 byte, if less than 64 byte,use all packet
-    uint8_t sign_data[64] = {0};
-    uint32_t sign_len = 0;
-
+    // feed both slices straight from the packet, no staging copy
     AI_PROTO_D("start sign head_len:%d, payload_len:%d", head_len, payload_len);
-    if (head_len + payload_len <= sizeof(sign_data)) {
-        memcpy(sign_data, buf, head_len + payload_len);
-        sign_len = head_len + payload_len;
+    TUYA_CALL_ERR_GOTO(tuya_ai_crypto_sign_starts(crypto), EXIT);
+    if (head_len + payload_len <= 64) {
+        TUYA_CALL_ERR_GOTO(tuya_ai_crypto_sign_update(crypto, (uint8_t *)head, head_len), EXIT);
+        TUYA_CALL_ERR_GOTO(tuya_ai_crypto_sign_update(crypto, (uint8_t *)payload, payload_len), EXIT);
     } else {
-        memcpy(sign_data, buf, 32);
-        char *payload = buf + head_len;
+        uint32_t first = (head_len > 32) ? 32 : head_len;
         uint32_t offset = (payload_len > 32) ? payload_len - 32 : 0;
         uint32_t copy_len = (payload_len > 32) ? 32 : payload_len;
-        memcpy(sign_data + 32, payload + offset, copy_len);
-        sign_len = sizeof(sign_data);
+        TUYA_CALL_ERR_GOTO(tuya_ai_crypto_sign_update(crypto, (uint8_t *)head, first), EXIT);
+        TUYA_CALL_ERR_GOTO(tuya_ai_crypto_sign_update(crypto, (uint8_t *)payload, 32 - first), EXIT);
+        TUYA_CALL_ERR_GOTO(tuya_ai_crypto_sign_update(crypto, (uint8_t *)payload + offset, copy_len), EXIT);
+        TUYA_CALL_ERR_GOTO(tuya_ai_crypto_sign_update(crypto, zero_pad, 32 - copy_len), EXIT);
     }
+    TUYA_CALL_ERR_GOTO(tuya_ai_crypto_sign_finish(crypto, signature), EXIT);
+    return rt;
 
-    rt = tal_sha256_mac((uint8_t *)sign_key, AI_KEY_LEN, (uint8_t *)sign_data, sign_len, signature);
-    if (OPRT_OK != rt) {
-        PR_ERR("sign packet failed, rt:%d", rt);
-    }
+EXIT:
+    PR_ERR("sign packet failed, rt:%d", rt);
     return rt;
 }
 
@@ -467,7 +735,7 @@ bool tuya_ai_is_need_attr(AI_FRAG_FLAG frag_flag)
     return false;
 }
 
-uint32_t __ai_get_send_payload_len(AI_SEND_PACKET_T *info, AI_FRAG_FLAG frag_flag)
+uint32_t __ai_get_send_payload_len(AI_SEND_PACKET_T *info, AI_FRAG_FLAG frag_flag, uint32_t data_len)
 {
     uint32_t len = 0;
     if (tuya_ai_is_need_attr(frag_flag)) {
@@ -475,7 +743,7 @@ uint32_t __ai_get_send_payload_len(AI_SEND_PACKET_T *info, AI_FRAG_FLAG frag_fla
         len += __ai_get_send_attr_len(info);
         len += sizeof(len);
     }
-    len += info->len;
+    len += data_len;
     // AI_PROTO_D("packet len:%d", len);
     return len;
 }
@@ -488,7 +756,7 @@ static uint8_t __ai_is_need_iv(AI_PACKET_PT type, AI_FRAG_FLAG frag_flag)
     return true;
 }
 
-static uint32_t __ai_get_send_pkt_len(AI_SEND_PACKET_T *info, AI_FRAG_FLAG frag_flag)
+static uint32_t __ai_get_send_pkt_len(AI_SEND_PACKET_T *info, AI_FRAG_FLAG frag_flag, uint32_t data_len)
 {
     uint32_t len = 0;
     AI_PACKET_PT type = __ai_get_sl(info->type, false);
@@ -497,7 +765,7 @@ static uint32_t __ai_get_send_pkt_len(AI_SEND_PACKET_T *info, AI_FRAG_FLAG frag_
         len += AI_IV_LEN;
     }
     len += sizeof(len);
-    len += __ai_get_send_payload_len(info, frag_flag);
+    len += __ai_get_send_payload_len(info, frag_flag, data_len);
     len += AI_SIGN_LEN;
     if (type != AI_PACKET_SL0) {
         len += AI_ADD_PKT_LEN; // for tag and padding
@@ -511,169 +779,68 @@ static uint32_t __ai_get_send_pkt_len(AI_SEND_PACKET_T *info, AI_FRAG_FLAG frag_
     return len;
 }
 
-static int __ai_encrypt_add_pkcs(char *p, uint32_t len)
+/* encrypt in place, buf must have AI_ADD_PKT_LEN room after len for padding and tag */
+static OPERATE_RET __ai_encrypt_packet(AI_PACKET_PT type, char *buf, uint32_t len, uint32_t *en_len)
 {
-    char pkcs[16];
-    int cz = 0;
-    int i = 0;
-
-    cz = len < 16 ? (16 - len) : (16 - len % 16);
-    memset(pkcs, 0, sizeof(pkcs));
-    for (i = 0; i < cz; i++) {
-        pkcs[i] = cz;
-    }
-    memcpy(p + len, pkcs, cz);
-    return (len + cz);
-}
-
-static OPERATE_RET __ai_encrypt_packet(AI_PACKET_PT type, char *data, uint32_t len, char *output, uint32_t *en_len)
-{
-    OPERATE_RET rt = OPRT_OK;
-    int data_out_len = 0;
-    char *key = __ai_get_crypt_key();
-    TUYA_CHECK_NULL_RETURN(key, OPRT_COM_ERROR);
-
     AI_PACKET_SL sl = __ai_get_sl(type, false);
-    if (sl == AI_PACKET_SL2) {
-#if (AI_PACKET_SECURITY_LEVEL == AI_PACKET_SL2)
-        memcpy(output, data, len);
-        data_out_len = __ai_encrypt_add_pkcs(output, len);
-        char nonce[12] = {0};
-        memcpy(nonce, ai_basic_proto->encrypt_iv, sizeof(nonce));
-        rt = mbedtls_chacha20_crypt((uint8_t *)key, (uint8_t *)nonce, 0, len, (uint8_t *)data, (uint8_t *)output);
-        if (OPRT_OK != rt) {
-            PR_ERR("chacha20_crypt error:%d", rt);
-            return rt;
-        }
-        *en_len = data_out_len;
-#endif
-    } else if (sl == AI_PACKET_SL3) {
-#if (AI_PACKET_SECURITY_LEVEL == AI_PACKET_SL3)
-        memcpy(output, data, len);
-        data_out_len = tal_pkcs7padding_buffer((uint8_t *)output, len);
-        rt = tal_aes256_cbc_encode_raw((uint8_t *)output, data_out_len, (uint8_t *)key,
-                                       (uint8_t *)ai_basic_proto->encrypt_iv, (uint8_t *)output);
-        if (OPRT_OK != rt) {
-            PR_ERR("aes128_cbc_encode error:%d", rt);
-            return rt;
-        }
-        *en_len = data_out_len;
-#endif
-    } else if (sl == AI_PACKET_SL4) {
-#if (AI_PACKET_SECURITY_LEVEL == AI_PACKET_SL4)
-        uint8_t tag[AI_GCM_TAG_LEN] = {0};
-        memcpy(output, data, len);
-        data_out_len = __ai_encrypt_add_pkcs(output, len);
-
-        const cipher_params_t en_input = {
-            .cipher_type = MBEDTLS_CIPHER_AES_256_GCM,
-            .key = (unsigned char *)key,
-            .key_len = AI_KEY_LEN,
-            .nonce = (uint8_t *)ai_basic_proto->encrypt_iv,
-            .nonce_len = AI_IV_LEN,
-            .ad = NULL,
-            .ad_len = 0,
-            .data = (uint8_t *)output,
-            .data_len = data_out_len,
-        };
-        rt = mbedtls_cipher_auth_encrypt_wrapper(&en_input, (uint8_t *)output, (size_t *)en_len, tag, sizeof(tag));
-        if (rt != OPRT_OK) {
-            PR_ERR("aes128_gcm_encode error:%x", rt);
-        }
-        memcpy(output + *en_len, tag, sizeof(tag));
-        *en_len += sizeof(tag);
-        // tuya_debug_hex_dump("encrypt_data", 64, (uint8_t *)output, *en_len);
-#endif
-    } else if (sl == AI_PACKET_SL0) {
+    if (sl == AI_PACKET_SL0) {
         AI_PROTO_D("sl:%d do not need crypt", sl);
-        memcpy(output, data, len);
         *en_len = len;
-    } else {
+        return OPRT_OK;
+    }
+    if (sl != ai_basic_proto->tx_crypto.sl) {
         PR_ERR("sl:%d err", sl);
-        rt = OPRT_COM_ERROR;
+        return OPRT_COM_ERROR;
     }
-
-    return rt;
+    return tuya_ai_crypto_encrypt(&ai_basic_proto->tx_crypto, (uint8_t *)ai_basic_proto->encrypt_iv, (uint8_t *)buf,
+                                  len, en_len);
 }
 
 static OPERATE_RET __ai_decrypt_packet(char *data, uint32_t len, char *output, uint32_t *de_len)
 {
-    OPERATE_RET rt = OPRT_OK;
-    char *key = __ai_get_crypt_key();
-    TUYA_CHECK_NULL_RETURN(key, OPRT_COM_ERROR);
-
     AI_PACKET_SL sl = __ai_get_sl(0, true);
-    if (sl == AI_PACKET_SL2) {
-#if (AI_PACKET_SECURITY_LEVEL == AI_PACKET_SL2)
-        char nonce[12] = {0};
-        memcpy(nonce, ai_basic_proto->decrypt_iv, sizeof(nonce));
-        rt = mbedtls_chacha20_crypt((uint8_t *)key, (uint8_t *)nonce, 0, len, (uint8_t *)data, (uint8_t *)output);
-        if (OPRT_OK != rt) {
-            PR_ERR("chacha20_crypt error:%d", rt);
-            return rt;
-        }
-        *de_len = len - output[len - 1];
-#endif
-    } else if (sl == AI_PACKET_SL3) {
-#if (AI_PACKET_SECURITY_LEVEL == AI_PACKET_SL3)
-        rt = tal_aes256_cbc_decode_raw((uint8_t *)data, len, (uint8_t *)key, (uint8_t *)ai_basic_proto->decrypt_iv,
-                                       (uint8_t *)output);
-        if (OPRT_OK != rt) {
-            PR_ERR("aes128_cbc_decode error:%d", rt);
-            return rt;
-        }
-        *de_len = len - output[len - 1];
-#endif
-    } else if (sl == AI_PACKET_SL4) {
-#if (AI_PACKET_SECURITY_LEVEL == AI_PACKET_SL4)
-        // tuya_debug_hex_dump("decrypt_data", 64, (uint8_t *)data, len - AI_GCM_TAG_LEN);
-        // tuya_debug_hex_dump("decrypt_key", 64, (uint8_t *)key, AI_KEY_LEN);
-        // tuya_debug_hex_dump("decrypt_iv", 64, (uint8_t *)ai_basic_proto->decrypt_iv, AI_IV_LEN);
-        // tuya_debug_hex_dump("decrypt_tag", 64, (uint8_t *)(data + len - AI_GCM_TAG_LEN), AI_GCM_TAG_LEN);
-        const cipher_params_t de_input = {
-            .cipher_type = MBEDTLS_CIPHER_AES_256_GCM,
-            .key = (unsigned char *)key,
-            .key_len = AI_KEY_LEN,
-            .nonce = (uint8_t *)ai_basic_proto->decrypt_iv,
-            .nonce_len = AI_IV_LEN,
-            .ad = NULL,
-            .ad_len = 0,
-            .data = (uint8_t *)data,
-            .data_len = len - AI_GCM_TAG_LEN,
-        };
-
-        rt = mbedtls_cipher_auth_decrypt_wrapper(&de_input, (uint8_t *)output, (size_t *)de_len,
-                                                 (uint8_t *)(data + len - AI_GCM_TAG_LEN), AI_GCM_TAG_LEN);
-        if (rt != OPRT_OK) {
-            PR_ERR("aes128_gcm_decode error:%x", rt);
-            return rt;
-        }
-        *de_len = *de_len - output[*de_len - 1];
-#endif
-    } else if (sl == AI_PACKET_SL0) {
-        AI_PROTO_D("sl:%d do not need crypt ", sl);
-        memcpy(output, data, len);
-        *de_len = len;
-    } else {
+    if (sl != ai_basic_proto->rx_crypto.sl) {
         AI_PROTO_D("sl:%d err", sl);
-        rt = OPRT_COM_ERROR;
+        return OPRT_COM_ERROR;
     }
+    return tuya_ai_crypto_decrypt(&ai_basic_proto->rx_crypto, (uint8_t *)ai_basic_proto->decrypt_iv, (uint8_t *)data,
+                                  len, (uint8_t *)output, de_len);
+}
 
-    return rt;
+static void __ai_copy_send_data(AI_SEND_PACKET_T *info, char *dst, uint32_t data_off, uint32_t data_len)
+{
+    uint32_t idx = 0, copy_len = 0;
+
+    if (info->vec_num == 0) {
+        memcpy(dst, info->data + data_off, data_len);
+        return;
+    }
+
+    for (idx = 0; (idx < info->vec_num) && (data_len > 0); idx++) {
+        AI_SEND_VEC_T *vec = &info->vec[idx];
+        if (data_off >= vec->len) {
+            data_off -= vec->len;
+            continue;
+        }
+        copy_len = vec->len - data_off;
+        if (copy_len > data_len) {
+            copy_len = data_len;
+        }
+        memcpy(dst, vec->data + data_off, copy_len);
+        dst += copy_len;
+        data_len -= copy_len;
+        data_off = 0;
+    }
 }
 
-static OPERATE_RET __ai_pack_payload(AI_SEND_PACKET_T *info, char *payload_buf, uint32_t *payload_len,
-                                     AI_FRAG_FLAG frag, uint32_t origin_len)
+static OPERATE_RET __ai_pack_payload(AI_SEND_PACKET_T *info, char *buf, uint32_t *payload_len, AI_FRAG_FLAG frag,
+                                     uint32_t origin_len, uint32_t data_off, uint32_t data_len)
 {
     OPERATE_RET rt = OPRT_OK;
     uint32_t idx = 0, attr_len = 0, packet_len = 0;
     uint32_t offset = 0;
     TUYA_CHECK_NULL_RETURN(info, OPRT_INVALID_PARM);
-    packet_len = __ai_get_send_payload_len(info, frag);
-
-    char *buf = Malloc(packet_len);
-    TUYA_CHECK_NULL_RETURN(buf, OPRT_MALLOC_FAILED);
-    memset(buf, 0, packet_len);
+    packet_len = __ai_get_send_payload_len(info, frag, data_len);
 
     if (tuya_ai_is_need_attr(frag)) {
         AI_PAYLOAD_HEAD_T payload_head = {0};
@@ -714,7 +881,6 @@ static OPERATE_RET __ai_pack_payload(AI_SEND_PACKET_T *info, char *payload_buf,
                     memcpy(buf + offset, info->attrs[idx]->value.str, attr_idx_len);
                 } else {
                     PR_ERR("unknow payload type:%d", payload_type);
-                    Free(buf);
                     return OPRT_COM_ERROR;
                 }
                 offset += attr_idx_len;
@@ -728,17 +894,15 @@ static OPERATE_RET __ai_pack_payload(AI_SEND_PACKET_T *info, char *payload_buf,
         offset += sizeof(info->len);
     }
 
-    memcpy(buf + offset, info->data, info->len);
-    offset += info->len;
+    __ai_copy_send_data(info, buf + offset, data_off, data_len);
+    offset += data_len;
     AI_PROTO_D("payload len:%d, offset:%d", packet_len, offset);
 
     // tuya_debug_hex_dump("payload_uncrypt", 64, (uint8_t *)buf, packet_len);
-    rt = __ai_encrypt_packet(info->type, buf, packet_len, payload_buf, payload_len);
+    rt = __ai_encrypt_packet(info->type, buf, packet_len, payload_len);
     if (OPRT_OK != rt) {
         PR_ERR("encrypt packet failed, rt:%d", rt);
     }
-
-    Free(buf);
     return rt;
 }
 
@@ -847,7 +1011,8 @@ OPERATE_RET tuya_ai_get_attr_value(char *de_buf, uint32_t *offset, AI_ATTRIBUTE_
     return rt;
 }
 
-static OPERATE_RET __ai_packet_write(AI_SEND_PACKET_T *info, AI_FRAG_FLAG frag, uint32_t origin_len)
+static OPERATE_RET __ai_packet_write(AI_SEND_PACKET_T *info, AI_FRAG_FLAG frag, uint32_t origin_len,
+                                     uint32_t data_off, uint32_t data_len)
 {
     OPERATE_RET rt = OPRT_OK;
     uint32_t payload_len = 0, offset = 0;
@@ -859,14 +1024,12 @@ static OPERATE_RET __ai_packet_write(AI_SEND_PACKET_T *info, AI_FRAG_FLAG frag,
     uint16_t sequence = ai_basic_proto->sequence_out++;
     AI_PROTO_D("send packet sequence:%d, frag:%d", sequence, frag);
 
-    uint32_t uncrypt_len = __ai_get_send_pkt_len(info, frag);
-    if (uncrypt_len > AI_MAX_FRAGMENT_LENGTH) {
+    uint32_t uncrypt_len = __ai_get_send_pkt_len(info, frag, data_len);
+    if (uncrypt_len > sizeof(ai_basic_proto->send_buf)) {
         PR_ERR("send packet too long, len: %d", uncrypt_len);
         return OPRT_COM_ERROR;
     }
-    char *send_pkt_buf = Malloc(uncrypt_len);
-    TUYA_CHECK_NULL_RETURN(send_pkt_buf, OPRT_MALLOC_FAILED);
-    memset(send_pkt_buf, 0, uncrypt_len);
+    char *send_pkt_buf = ai_basic_proto->send_buf;
 
     uint32_t head_len = sizeof(AI_PACKET_HEAD_T);
     // AI_PROTO_D("head len:%d", head_len);
@@ -889,9 +1052,9 @@ static OPERATE_RET __ai_packet_write(AI_SEND_PACKET_T *info, AI_FRAG_FLAG frag,
     uint32_t length = 0;
     offset += sizeof(length);
 
-    rt = __ai_pack_payload(info, send_pkt_buf + offset, &payload_len, frag, origin_len);
+    rt = __ai_pack_payload(info, send_pkt_buf + offset, &payload_len, frag, origin_len, data_off, data_len);
     if (OPRT_OK != rt) {
-        goto EXIT;
+        return rt;
     }
     length = UNI_HTONL(payload_len + AI_SIGN_LEN);
 
@@ -901,9 +1064,11 @@ static OPERATE_RET __ai_packet_write(AI_SEND_PACKET_T *info, AI_FRAG_FLAG frag,
         memcpy(send_pkt_buf + head_len, &length, sizeof(length));
     }
 
-    rt = __ai_packet_sign(send_pkt_buf, signature);
+    uint32_t sign_head_len = __ai_get_head_len(send_pkt_buf);
+    rt = __ai_packet_sign(&ai_basic_proto->tx_crypto, send_pkt_buf, sign_head_len, send_pkt_buf + sign_head_len,
+                          payload_len, signature);
     if (OPRT_OK != rt) {
-        goto EXIT;
+        return rt;
     }
     offset += payload_len;
     memcpy(send_pkt_buf + offset, signature, AI_SIGN_LEN);
@@ -922,9 +1087,6 @@ static OPERATE_RET __ai_packet_write(AI_SEND_PACKET_T *info, AI_FRAG_FLAG frag,
     } else {
         rt = OPRT_OK;
     }
-
-EXIT:
-    Free(send_pkt_buf);
     return rt;
 }
 
@@ -1027,7 +1189,7 @@ OPERATE_RET tuya_ai_basic_pkt_frag_send(AI_SEND_PACKET_T *info)
     }
 
     __ai_basic_get_send_frag(info->type, info->len, info->total_len, &frag_flag);
-    rt = __ai_packet_write(info, frag_flag, info->total_len);
+    rt = __ai_packet_write(info, frag_flag, info->total_len, 0, info->len);
 
     tuya_ai_free_attrs(info);
     tal_mutex_unlock(ai_basic_proto->mutex);
@@ -1041,7 +1203,6 @@ OPERATE_RET tuya_ai_basic_pkt_send(AI_SEND_PACKET_T *info)
     uint32_t one_packet_len = 0;
     uint32_t min_pkt_len = sizeof(AI_PACKET_HEAD_T) + (2 * AI_ADD_PKT_LEN); // AI_SIGN_LEN + AI_IV_LEN + AI_ADD_PKT_LEN
     uint32_t origin_len = info->len;
-    char *origin_data = info->data;
     // AI_PROTO_D("send payload len:%d", payload_len);
 
     if (!ai_basic_proto) {
@@ -1058,9 +1219,9 @@ OPERATE_RET tuya_ai_basic_pkt_send(AI_SEND_PACKET_T *info)
         return OPRT_COM_ERROR;
     }
 
-    uint32_t send_pkt_len = __ai_get_send_pkt_len(info, AI_PACKET_NO_FRAG);
+    uint32_t send_pkt_len = __ai_get_send_pkt_len(info, AI_PACKET_NO_FRAG, origin_len);
     if (send_pkt_len <= AI_MAX_FRAGMENT_LENGTH) {
-        rt = __ai_packet_write(info, AI_PACKET_NO_FRAG, origin_len);
+        rt = __ai_packet_write(info, AI_PACKET_NO_FRAG, origin_len, 0, origin_len);
     } else {
         while (offset < origin_len) {
             if (offset == 0) {
@@ -1070,15 +1231,13 @@ OPERATE_RET tuya_ai_basic_pkt_send(AI_SEND_PACKET_T *info)
                 one_packet_len = AI_MAX_FRAGMENT_LENGTH - min_pkt_len;
             }
             frag_len = (origin_len - offset) > one_packet_len ? one_packet_len : (origin_len - offset);
-            info->data = origin_data + offset;
-            info->len = frag_len;
             AI_PROTO_D("offset:%d, frag_len:%d, %d", offset, frag_len, origin_len);
             if (offset == 0) {
-                rt = __ai_packet_write(info, AI_PACKET_FRAG_START, origin_len);
+                rt = __ai_packet_write(info, AI_PACKET_FRAG_START, origin_len, offset, frag_len);
             } else if ((offset + frag_len) == origin_len) {
-                rt = __ai_packet_write(info, AI_PACKET_FRAG_END, origin_len);
+                rt = __ai_packet_write(info, AI_PACKET_FRAG_END, origin_len, offset, frag_len);
             } else {
-                rt = __ai_packet_write(info, AI_PACKET_FRAG_ING, origin_len);
+                rt = __ai_packet_write(info, AI_PACKET_FRAG_ING, origin_len, offset, frag_len);
             }
             if (OPRT_OK != rt) {
                 AI_PROTO_D("send fragment failed, rt:%d", rt);
@@ -1086,8 +1245,6 @@ OPERATE_RET tuya_ai_basic_pkt_send(AI_SEND_PACKET_T *info)
             }
             offset += frag_len;
         }
-        info->data = origin_data;
-        info->len = origin_len;
     }
     tuya_ai_free_attrs(info);
 
@@ -1428,13 +1585,12 @@ static int __ai_baisc_read_pkt_head(char *recv_buf)
 
 void tuya_ai_basic_pkt_free(char *data)
 {
-    if (data == ai_basic_proto->recv_frag_mng.data) {
-        Free(data);
-        ai_basic_proto->recv_frag_mng.data = NULL;
-        memset(&ai_basic_proto->recv_frag_mng, 0, sizeof(AI_RECV_FRAG_MNG_T));
-    } else {
-        Free(data);
+    int idx = __ai_recv_slot_find(data);
+    if (idx < 0) {
+        PR_ERR("pkt %p not in recv pool", data);
+        return;
     }
+    __ai_recv_slot_release(idx);
 }
 
 void tuya_ai_basic_set_frag_flag(bool flag)
@@ -1450,195 +1606,194 @@ static bool __ai_basic_get_frag_flag(void)
 {
     return ai_basic_proto->frag_flag;
 }
-OPERATE_RET tuya_ai_basic_pkt_read(char **out, uint32_t *out_len, AI_FRAG_FLAG *out_frag)
-{
-    OPERATE_RET rt = OPRT_OK;
-    uint8_t calc_sign[AI_SIGN_LEN] = {0};
-    uint8_t packet_sign[AI_SIGN_LEN] = {0};
-    char *decrypt_buf = NULL;
-    char *recv_buf = ai_basic_proto->recv_buf;
-    TUYA_CHECK_NULL_RETURN(recv_buf, OPRT_COM_ERROR);
-
-    memset(recv_buf, 0, sizeof(ai_basic_proto->recv_buf));
-    AI_PROTO_D("recv packet ing");
-    int recv_len = __ai_baisc_read_pkt_head(recv_buf);
-    if (recv_len <= 0) {
-        goto EXIT;
-    }
 
-    AI_PACKET_HEAD_T *head = (AI_PACKET_HEAD_T *)recv_buf;
-    AI_PROTO_D("recv packet ver:%d", head->version);
-    AI_PROTO_D("recv packet seq:%d", UNI_NTOHS(head->sequence));
-    AI_PROTO_D("recv packet frag:%d", head->frag_flag);
-    AI_PROTO_D("recv packet sl:%d", head->security_level);
-    AI_PROTO_D("recv packet iv flag:%d", head->iv_flag);
-
-    uint32_t head_len = __ai_get_head_len(recv_buf);
-    uint32_t packet_len = __ai_get_packet_len(recv_buf);
-
-    AI_PROTO_D("recv head len:%d", head_len);
-    AI_PROTO_D("recv packet len:%d", packet_len);
-
-    if (packet_len + head_len > sizeof(ai_basic_proto->recv_buf)) {
-        PR_ERR("recv packet too long, pkt len:%u, head len:%u", packet_len, head_len);
-        recv_len = OPRT_RESOURCE_NOT_READY;
-        goto EXIT;
-    }
-
-    uint16_t sequence = UNI_NTOHS(head->sequence);
-    if (sequence <= ai_basic_proto->sequence_in) {
-        PR_ERR("sequence error, in:%d, pre:%d", sequence, ai_basic_proto->sequence_in);
-        goto EXIT;
-    }
-
-    ai_basic_proto->sequence_in = sequence;
-    if (sequence >= 0xFFFF) {
-        ai_basic_proto->sequence_in = 0;
-    }
-
-    uint32_t continue_recv_len = 0;
-    int offset = recv_len;
-    while (packet_len + head_len > offset) {
-        continue_recv_len = packet_len + head_len - offset;
-        recv_len = tuya_transporter_read(ai_basic_proto->transporter, (uint8_t *)(recv_buf + offset), continue_recv_len,
+static int __ai_basic_read_pkt_body(char *buf, uint32_t len)
+{
+    uint32_t offset = 0;
+    int recv_len = 0;
+    while (offset < len) {
+        recv_len = tuya_transporter_read(ai_basic_proto->transporter, (uint8_t *)(buf + offset), len - offset,
                                          AI_DEFAULT_TIMEOUT_MS);
         if (recv_len <= 0) {
             if (recv_len == OPRT_RESOURCE_NOT_READY) {
                 continue;
             }
-            PR_ERR("continue read failed, rt:%d, %d", recv_len, continue_recv_len);
-            goto EXIT;
+            PR_ERR("continue read failed, rt:%d, %d", recv_len, len - offset);
+            return OPRT_COM_ERROR;
         }
         offset += recv_len;
     }
+    return OPRT_OK;
+}
 
-    rt = __ai_packet_sign(recv_buf, calc_sign);
-    if (OPRT_OK != rt) {
-        PR_ERR("packet sign failed, rt:%d", rt);
-        goto EXIT;
+static OPERATE_RET __ai_basic_frag_start(char *data, uint32_t decrypt_len, uint32_t *total_len)
+{
+    uint32_t origin_len = 0, frag_offset = 0, attr_len = 0;
+    AI_PAYLOAD_HEAD_T *pkt_head = (AI_PAYLOAD_HEAD_T *)data;
+    if (pkt_head->attribute_flag == AI_HAS_ATTR) {
+        frag_offset = sizeof(AI_PAYLOAD_HEAD_T);
+        memcpy(&attr_len, data + frag_offset, sizeof(attr_len));
+        frag_offset += sizeof(attr_len);
+        attr_len = UNI_NTOHL(attr_len);
+        frag_offset += attr_len;
+        memcpy(&origin_len, data + frag_offset, sizeof(origin_len));
+        origin_len = UNI_NTOHL(origin_len);
+        AI_PROTO_D("recv start frag packet with attr, origin len:%d", origin_len);
+    } else {
+        memcpy(&origin_len, data + sizeof(AI_PAYLOAD_HEAD_T), sizeof(origin_len));
+        origin_len = UNI_NTOHL(origin_len);
+        AI_PROTO_D("recv start frag packet, origin len:%d", origin_len);
     }
-
-    AI_PROTO_D("sign ok");
-    uint32_t payload_len = __ai_get_payload_len(recv_buf);
-    char *payload = recv_buf + head_len;
-    memcpy(packet_sign, payload + payload_len, AI_SIGN_LEN);
-    if (memcmp(calc_sign, packet_sign, sizeof(calc_sign))) {
-        PR_ERR("packet sign error");
-        // tuya_debug_hex_dump("calc_sign", AI_SIGN_LEN, calc_sign, AI_SIGN_LEN);
-        // tuya_debug_hex_dump("packet_sign", AI_SIGN_LEN, packet_sign, AI_SIGN_LEN);
-        recv_len = OPRT_RESOURCE_NOT_READY;
-        goto EXIT;
+    if (origin_len <= decrypt_len) {
+        PR_ERR("origin len error, origin len:%d, decrypt len:%d", origin_len, decrypt_len);
+        return OPRT_COM_ERROR;
     }
+    *total_len = origin_len + frag_offset + AI_ADD_PKT_LEN;
+    AI_PROTO_D("frag_total_len %d", *total_len);
+    return OPRT_OK;
+}
 
-    uint32_t decrypt_len = 0;
-    decrypt_buf = Malloc(packet_len + head_len + AI_ADD_PKT_LEN);
-    TUYA_CHECK_NULL_RETURN(decrypt_buf, OPRT_MALLOC_FAILED);
-    memset(decrypt_buf, 0, packet_len + head_len + AI_ADD_PKT_LEN);
-    rt = __ai_decrypt_packet(payload, payload_len, decrypt_buf, &decrypt_len);
-    if (OPRT_OK != rt) {
-        PR_ERR("decrypt packet failed, rt:%d", rt);
-        goto EXIT;
-    }
-    AI_PROTO_D("decrypt len:%d", decrypt_len);
-    AI_PROTO_D("frag flag:%d, sdk frag flag:%d", head->frag_flag, __ai_basic_get_frag_flag());
+OPERATE_RET tuya_ai_basic_pkt_read(char **out, uint32_t *out_len, AI_FRAG_FLAG *out_frag)
+{
+    OPERATE_RET rt = OPRT_OK;
+    uint8_t calc_sign[AI_SIGN_LEN] = {0};
+    char *recv_head = ai_basic_proto->recv_head;
+    AI_PACKET_HEAD_T *head = (AI_PACKET_HEAD_T *)recv_head;
+    AI_RECV_FRAG_MNG_T *frag_mng = &ai_basic_proto->recv_frag_mng;
+    AI_RECV_POOL_T *pool = &ai_basic_proto->recv_pool;
+    int slot = -1;
+
+    while (1) {
+        AI_PROTO_D("recv packet ing");
+        int recv_len = __ai_baisc_read_pkt_head(recv_head);
+        if (recv_len <= 0) {
+            rt = recv_len;
+            goto EXIT;
+        }
+
+        AI_PROTO_D("recv packet ver:%d", head->version);
+        AI_PROTO_D("recv packet seq:%d", UNI_NTOHS(head->sequence));
+        AI_PROTO_D("recv packet frag:%d", head->frag_flag);
+        AI_PROTO_D("recv packet sl:%d", head->security_level);
+        AI_PROTO_D("recv packet iv flag:%d", head->iv_flag);
+
+        uint32_t head_len = __ai_get_head_len(recv_head);
+        uint32_t packet_len = __ai_get_packet_len(recv_head);
+
+        AI_PROTO_D("recv head len:%d", head_len);
+        AI_PROTO_D("recv packet len:%d", packet_len);
+
+        if ((packet_len <= AI_SIGN_LEN) || (packet_len + head_len > AI_MAX_FRAGMENT_LENGTH + AI_ADD_PKT_LEN)) {
+            PR_ERR("recv packet len invalid, pkt len:%u, head len:%u", packet_len, head_len);
+            rt = OPRT_RESOURCE_NOT_READY;
+            goto EXIT;
+        }
+
+        uint16_t sequence = UNI_NTOHS(head->sequence);
+        if (sequence <= ai_basic_proto->sequence_in) {
+            PR_ERR("sequence error, in:%d, pre:%d", sequence, ai_basic_proto->sequence_in);
+            rt = OPRT_COM_ERROR;
+            goto EXIT;
+        }
+
+        ai_basic_proto->sequence_in = sequence;
+        if (sequence >= 0xFFFF) {
+            ai_basic_proto->sequence_in = 0;
+        }
 
-    if (!__ai_basic_get_frag_flag()) {
         AI_FRAG_FLAG current_frag_flag = head->frag_flag;
-        AI_FRAG_FLAG last_frag_flag = ai_basic_proto->recv_frag_mng.frag_flag;
-        if ((last_frag_flag == AI_PACKET_FRAG_START) || (last_frag_flag == AI_PACKET_FRAG_ING)) {
-            if ((current_frag_flag != AI_PACKET_FRAG_ING) && (current_frag_flag != AI_PACKET_FRAG_END)) {
-                PR_ERR("recv start frag packet, but not continue %d, %d", current_frag_flag, last_frag_flag);
-                goto EXIT;
-            }
+        bool reassemble = !__ai_basic_get_frag_flag();
+        bool frag_continue =
+            reassemble && ((current_frag_flag == AI_PACKET_FRAG_ING) || (current_frag_flag == AI_PACKET_FRAG_END));
+        AI_PROTO_D("frag flag:%d, sdk frag flag:%d", current_frag_flag, !reassemble);
+        if (reassemble && (frag_mng->slot >= 0) && !frag_continue) {
+            PR_ERR("recv start frag packet, but not continue %d, %d", current_frag_flag, frag_mng->frag_flag);
+            rt = OPRT_COM_ERROR;
+            goto EXIT;
         }
 
-        AI_PROTO_D("frag flag:%d", head->frag_flag);
-        AI_PROTO_D("frag mng info, flag:%d, offset:%d", ai_basic_proto->recv_frag_mng.frag_flag,
-                   ai_basic_proto->recv_frag_mng.offset);
-        if (current_frag_flag == AI_PACKET_FRAG_START) {
-            uint32_t origin_len = 0, frag_offset = 0, attr_len = 0, frag_total_len = 0;
-            AI_PAYLOAD_HEAD_T *pkt_head = (AI_PAYLOAD_HEAD_T *)decrypt_buf;
-            if (pkt_head->attribute_flag == AI_HAS_ATTR) {
-                frag_offset = sizeof(AI_PAYLOAD_HEAD_T);
-                memcpy(&attr_len, decrypt_buf + frag_offset, sizeof(attr_len));
-                frag_offset += sizeof(attr_len);
-                attr_len = UNI_NTOHL(attr_len);
-                frag_offset += attr_len;
-                memcpy(&origin_len, decrypt_buf + frag_offset, sizeof(origin_len));
-                origin_len = UNI_NTOHL(origin_len);
-                AI_PROTO_D("recv start frag packet with attr, origin len:%d", origin_len);
-            } else {
-                memcpy(&origin_len, decrypt_buf + sizeof(AI_PAYLOAD_HEAD_T), sizeof(origin_len));
-                origin_len = UNI_NTOHL(origin_len);
-                AI_PROTO_D("recv start frag packet, origin len:%d", origin_len);
-            }
-            if (origin_len <= decrypt_len) {
-                PR_ERR("origin len error, origin len:%d, decrypt len:%d", origin_len, decrypt_len);
-                goto EXIT;
-            }
-            memset(&ai_basic_proto->recv_frag_mng, 0, sizeof(AI_RECV_FRAG_MNG_T));
-            ai_basic_proto->recv_frag_mng.frag_flag = current_frag_flag;
-            frag_total_len = origin_len + frag_offset + AI_ADD_PKT_LEN;
-            AI_PROTO_D("frag_total_len %d", frag_total_len);
-            ai_basic_proto->recv_frag_mng.data = Malloc(frag_total_len);
-            if (!ai_basic_proto->recv_frag_mng.data) {
-                PR_ERR("malloc origin data failed len:%d", decrypt_len);
-                goto EXIT;
-            }
-            AI_PROTO_D("malloc recv_frag_mng data addr %p", ai_basic_proto->recv_frag_mng.data);
-            memset(ai_basic_proto->recv_frag_mng.data, 0, frag_total_len);
-            memcpy(ai_basic_proto->recv_frag_mng.data, decrypt_buf, decrypt_len);
-            ai_basic_proto->recv_frag_mng.offset = decrypt_len;
-            Free(decrypt_buf);
-            decrypt_buf = NULL;
-            rt = tuya_ai_basic_pkt_read(out, out_len, out_frag);
-            if (rt != OPRT_OK) {
-                PR_ERR("read continue frag packet failed, rt:%d", rt);
+        char *payload = NULL;
+        if (frag_continue) {
+            AI_PROTO_D("frag mng info, flag:%d, offset:%d", frag_mng->frag_flag, frag_mng->offset);
+            if ((frag_mng->slot < 0) || (frag_mng->offset + packet_len > pool->slot[frag_mng->slot].size)) {
+                PR_ERR("recv frag packet out of range, offset:%d, len:%d", frag_mng->offset, packet_len);
+                rt = OPRT_COM_ERROR;
                 goto EXIT;
             }
-        } else if (current_frag_flag == AI_PACKET_FRAG_ING) {
-            memcpy(ai_basic_proto->recv_frag_mng.data + ai_basic_proto->recv_frag_mng.offset, decrypt_buf, decrypt_len);
-            ai_basic_proto->recv_frag_mng.frag_flag = current_frag_flag;
-            ai_basic_proto->recv_frag_mng.offset += decrypt_len;
-            Free(decrypt_buf);
-            decrypt_buf = NULL;
-            rt = tuya_ai_basic_pkt_read(out, out_len, out_frag);
-            if (rt != OPRT_OK) {
-                PR_ERR("read continue ing frag packet failed, rt:%d", rt);
+            payload = pool->slot[frag_mng->slot].data + frag_mng->offset;
+        } else {
+            slot = __ai_recv_slot_get(packet_len);
+            if (slot < 0) {
+                PR_ERR("recv pool exhausted, len:%d", packet_len);
+                rt = OPRT_MALLOC_FAILED;
                 goto EXIT;
             }
-        } else if (current_frag_flag == AI_PACKET_FRAG_END) {
-            memcpy(ai_basic_proto->recv_frag_mng.data + ai_basic_proto->recv_frag_mng.offset, decrypt_buf, decrypt_len);
-            ai_basic_proto->recv_frag_mng.frag_flag = current_frag_flag;
-            ai_basic_proto->recv_frag_mng.offset += decrypt_len;
-            Free(decrypt_buf);
-            decrypt_buf = NULL;
-            *out = ai_basic_proto->recv_frag_mng.data;
-            *out_len = ai_basic_proto->recv_frag_mng.offset;
-            *out_frag = AI_PACKET_NO_FRAG;
-        } else {
-            *out = decrypt_buf;
+            payload = pool->slot[slot].data;
+        }
+
+        // read payload and sign straight into the slot, behind the previous fragment
+        TUYA_CALL_ERR_GOTO(__ai_basic_read_pkt_body(payload, packet_len), EXIT);
+
+        uint32_t payload_len = packet_len - AI_SIGN_LEN;
+        TUYA_CALL_ERR_GOTO(
+            __ai_packet_sign(&ai_basic_proto->rx_crypto, recv_head, head_len, payload, payload_len, calc_sign), EXIT);
+        AI_PROTO_D("sign ok");
+        if (memcmp(calc_sign, payload + payload_len, sizeof(calc_sign))) {
+            PR_ERR("packet sign error");
+            // tuya_debug_hex_dump("calc_sign", AI_SIGN_LEN, calc_sign, AI_SIGN_LEN);
+            // tuya_debug_hex_dump("packet_sign", AI_SIGN_LEN, packet_sign, AI_SIGN_LEN);
+            rt = OPRT_RESOURCE_NOT_READY;
+            goto EXIT;
+        }
+
+        uint32_t decrypt_len = 0;
+        rt = __ai_decrypt_packet(payload, payload_len, payload, &decrypt_len);
+        if (OPRT_OK != rt) {
+            PR_ERR("decrypt packet failed, rt:%d", rt);
+            goto EXIT;
+        }
+        // keep the plain data NUL terminated, the sign room behind it is free now
+        payload[decrypt_len] = 0;
+        AI_PROTO_D("decrypt len:%d", decrypt_len);
+
+        if (!reassemble || (current_frag_flag == AI_PACKET_NO_FRAG)) {
+            *out = payload;
             *out_len = decrypt_len;
+            *out_frag = reassemble ? AI_PACKET_NO_FRAG : current_frag_flag;
+            break;
+        }
+
+        if (current_frag_flag == AI_PACKET_FRAG_START) {
+            uint32_t total_len = 0;
+            TUYA_CALL_ERR_GOTO(__ai_basic_frag_start(payload, decrypt_len, &total_len), EXIT);
+            TUYA_CALL_ERR_GOTO(__ai_recv_slot_resize(slot, total_len, decrypt_len + 1), EXIT);
+            frag_mng->slot = slot;
+            frag_mng->offset = decrypt_len;
+            frag_mng->frag_flag = current_frag_flag;
+            slot = -1;
+            continue;
+        }
+
+        frag_mng->offset += decrypt_len;
+        frag_mng->frag_flag = current_frag_flag;
+        if (current_frag_flag == AI_PACKET_FRAG_END) {
+            *out = pool->slot[frag_mng->slot].data;
+            *out_len = frag_mng->offset;
             *out_frag = AI_PACKET_NO_FRAG;
+            memset(frag_mng, 0, sizeof(AI_RECV_FRAG_MNG_T));
+            frag_mng->slot = -1;
+            break;
         }
-    } else {
-        *out = decrypt_buf;
-        *out_len = decrypt_len;
-        *out_frag = head->frag_flag;
     }
     AI_PROTO_D("recv packet len:%d", *out_len);
-    return rt;
+    return OPRT_OK;
 
 EXIT:
-    if (decrypt_buf) {
-        Free(decrypt_buf);
-        decrypt_buf = NULL;
-    }
-    if (ai_basic_proto->recv_frag_mng.data) {
-        Free(ai_basic_proto->recv_frag_mng.data);
+    if (slot >= 0) {
+        __ai_recv_slot_release(slot);
     }
-    memset(&ai_basic_proto->recv_frag_mng, 0, SIZEOF(AI_RECV_FRAG_MNG_T));
-    return recv_len;
+    __ai_recv_frag_reset();
+    return rt;
 }
 
 OPERATE_RET tuya_parse_user_attrs(char *in, uint32_t attr_len, AI_ATTRIBUTE_T **attr_out, uint32_t *attr_num)
@@ -1760,7 +1915,7 @@ OPERATE_RET tuya_ai_auth_resp(void)
     AI_PAYLOAD_HEAD_T *packet = (AI_PAYLOAD_HEAD_T *)de_buf;
     if (packet->attribute_flag != AI_HAS_ATTR) {
         PR_ERR("auth resp packet has no attribute");
-        Free(de_buf);
+        tuya_ai_basic_pkt_free(de_buf);
         return OPRT_COM_ERROR;
     }
 
@@ -1776,7 +1931,7 @@ OPERATE_RET tuya_ai_auth_resp(void)
         PR_ERR("auth resp packet type error %d", packet->type);
         rt = OPRT_COM_ERROR;
     }
-    Free(de_buf);
+    tuya_ai_basic_pkt_free(de_buf);
     return rt;
 }
 
@@ -2092,99 +2247,84 @@ OPERATE_RET tuya_ai_basic_session_close(char *session_id, AI_STATUS_CODE code)
     return tuya_ai_basic_pkt_send(&pkt);
 }
 
-OPERATE_RET tuya_ai_basic_video(AI_VIDEO_ATTR_T *video, char *data, uint32_t len)
+OPERATE_RET tuya_ai_basic_biz_sendv(AI_PACKET_PT type, void *attr, AI_SEND_VEC_T *vec, uint32_t vec_num)
 {
     OPERATE_RET rt = OPRT_OK;
+    uint32_t idx = 0;
     AI_SEND_PACKET_T pkt = {0};
-    pkt.type = AI_PT_VIDEO;
-    if (video) {
-        rt = __create_video_attrs(&pkt, video);
-        if (OPRT_OK != rt) {
-            return rt;
+    pkt.type = type;
+    pkt.vec = vec;
+    pkt.vec_num = vec_num;
+    for (idx = 0; idx < vec_num; idx++) {
+        pkt.len += vec[idx].len;
+    }
+
+    if (type == AI_PT_VIDEO) {
+        if (attr) {
+            rt = __create_video_attrs(&pkt, (AI_VIDEO_ATTR_T *)attr);
+        }
+    } else if (type == AI_PT_AUDIO) {
+        if (attr) {
+            rt = __create_audio_attrs(&pkt, (AI_AUDIO_ATTR_T *)attr);
+        }
+    } else if (type == AI_PT_IMAGE) {
+        TUYA_CHECK_NULL_RETURN(attr, OPRT_INVALID_PARM);
+        rt = __create_image_attrs(&pkt, (AI_IMAGE_ATTR_T *)attr);
+        pkt.total_len = ((AI_IMAGE_ATTR_T *)attr)->base.len;
+    } else if (type == AI_PT_FILE) {
+        TUYA_CHECK_NULL_RETURN(attr, OPRT_INVALID_PARM);
+        rt = __create_file_attrs(&pkt, (AI_FILE_ATTR_T *)attr);
+        pkt.total_len = ((AI_FILE_ATTR_T *)attr)->base.len;
+    } else if (type == AI_PT_TEXT) {
+        if (attr) {
+            rt = __create_text_attrs(&pkt, (AI_TEXT_ATTR_T *)attr);
         }
+    } else {
+        PR_ERR("unknow biz type:%d", type);
+        return OPRT_INVALID_PARM;
+    }
+    if (OPRT_OK != rt) {
+        return rt;
+    }
+
+    if (((type == AI_PT_IMAGE) || (type == AI_PT_FILE)) && (pkt.len != pkt.total_len)) {
+        return tuya_ai_basic_pkt_frag_send(&pkt);
     }
-    pkt.len = len;
-    pkt.data = data;
-    AI_PROTO_D("send video");
     return tuya_ai_basic_pkt_send(&pkt);
 }
 
+OPERATE_RET tuya_ai_basic_video(AI_VIDEO_ATTR_T *video, char *data, uint32_t len)
+{
+    AI_SEND_VEC_T vec = {.data = data, .len = len};
+    AI_PROTO_D("send video");
+    return tuya_ai_basic_biz_sendv(AI_PT_VIDEO, video, &vec, 1);
+}
+
 OPERATE_RET tuya_ai_basic_audio(AI_AUDIO_ATTR_T *audio, char *data, uint32_t len)
 {
-    OPERATE_RET rt = OPRT_OK;
-    AI_SEND_PACKET_T pkt = {0};
-    pkt.type = AI_PT_AUDIO;
-    if (audio) {
-        rt = __create_audio_attrs(&pkt, audio);
-        if (OPRT_OK != rt) {
-            return rt;
-        }
-    }
-    pkt.len = len;
-    pkt.data = data;
-    rt = tuya_ai_basic_pkt_send(&pkt);
-    return rt;
+    AI_SEND_VEC_T vec = {.data = data, .len = len};
+    return tuya_ai_basic_biz_sendv(AI_PT_AUDIO, audio, &vec, 1);
 }
 
 OPERATE_RET tuya_ai_basic_image(AI_IMAGE_ATTR_T *image, char *data, uint32_t len)
 {
-    OPERATE_RET rt = OPRT_OK;
-    AI_SEND_PACKET_T pkt = {0};
-    pkt.type = AI_PT_IMAGE;
-    if (image) {
-        rt = __create_image_attrs(&pkt, image);
-        if (OPRT_OK != rt) {
-            return rt;
-        }
-    }
-    pkt.total_len = image->base.len;
-    pkt.len = len;
-    pkt.data = data;
+    AI_SEND_VEC_T vec = {.data = data, .len = len};
     AI_PROTO_D("send image");
-    if (pkt.len == pkt.total_len) {
-        return tuya_ai_basic_pkt_send(&pkt);
-    } else {
-        return tuya_ai_basic_pkt_frag_send(&pkt);
-    }
+    return tuya_ai_basic_biz_sendv(AI_PT_IMAGE, image, &vec, 1);
 }
 
 OPERATE_RET tuya_ai_basic_file(AI_FILE_ATTR_T *file, char *data, uint32_t len)
 {
-    OPERATE_RET rt = OPRT_OK;
-    AI_SEND_PACKET_T pkt = {0};
-    pkt.type = AI_PT_FILE;
-    if (file) {
-        rt = __create_file_attrs(&pkt, file);
-        if (OPRT_OK != rt) {
-            return rt;
-        }
-    }
-    pkt.total_len = file->base.len;
-    pkt.len = len;
-    pkt.data = data;
+    AI_SEND_VEC_T vec = {.data = data, .len = len};
     AI_PROTO_D("send file");
-    if (pkt.len == pkt.total_len) {
-        return tuya_ai_basic_pkt_send(&pkt);
-    } else {
-        return tuya_ai_basic_pkt_frag_send(&pkt);
-    }
+    return tuya_ai_basic_biz_sendv(AI_PT_FILE, file, &vec, 1);
 }
 
 OPERATE_RET tuya_ai_basic_text(AI_TEXT_ATTR_T *text, char *data, uint32_t len)
 {
-    OPERATE_RET rt = OPRT_OK;
-    AI_SEND_PACKET_T pkt = {0};
-    pkt.type = AI_PT_TEXT;
-    if (text) {
-        rt = __create_text_attrs(&pkt, text);
-        if (OPRT_OK != rt) {
-            return rt;
-        }
-    }
-    pkt.len = len;
-    pkt.data = data;
+    AI_SEND_VEC_T vec = {.data = data, .len = len};
     AI_PROTO_D("send text");
-    return tuya_ai_basic_pkt_send(&pkt);
+    return tuya_ai_basic_biz_sendv(AI_PT_TEXT, text, &vec, 1);
 }
 
 OPERATE_RET tuya_ai_basic_event(AI_EVENT_ATTR_T *event, char *data, uint32_t len)
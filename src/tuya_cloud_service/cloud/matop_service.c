@@ -247,6 +247,32 @@ int matop_serice_yield(matop_context_t *context)
     return OPRT_OK;
 }
 
+/**
+ * @brief Gets the time before matop_serice_yield has a timeout to report.
+ *
+ * @param context The MATOP context.
+ * @return The time in milliseconds, UINT32_MAX if no request is pending.
+ */
+uint32_t matop_service_next_timeout(matop_context_t *context)
+{
+    uint32_t next = UINT32_MAX;
+    uint32_t now = tal_system_get_millisecond();
+
+    if (context == NULL) {
+        return next;
+    }
+
+    mqtt_atop_message_t *entry;
+    for (entry = context->message_list; entry; entry = entry->next) {
+        // matop_serice_yield reports a timeout once the time is past it
+        uint32_t remain = (entry->timeout >= now) ? (entry->timeout - now + 1) : 0;
+        if (remain < next) {
+            next = remain;
+        }
+    }
+    return next;
+}
+
 /**
  * @brief Destroys the matop service context.
  *
@@ -80,6 +80,14 @@ int matop_serice_init(matop_context_t *context, const matop_config_t *config);
  */
 int matop_serice_yield(matop_context_t *context);
 
+/**
+ * @brief Gets the time before matop_serice_yield has a timeout to report.
+ *
+ * @param context Pointer to the matop context.
+ * @return The time in milliseconds, UINT32_MAX if no request is pending.
+ */
+uint32_t matop_service_next_timeout(matop_context_t *context);
+
 /**
  * @brief Destroys the matop service context.
  *
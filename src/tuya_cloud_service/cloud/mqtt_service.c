@@ -33,6 +33,7 @@
 #include "tal_security.h"
 #include "crc32i.h"
 #include "tal_api.h"
+#include "tal_network.h"
 #include "tuya_protocol.h"
 
 static void on_subscribe_message_default(uint16_t msgid, const mqtt_client_message_t *msg, void *userdata);
@@ -331,26 +332,282 @@ static void mqtt_client_subscribed_cb(void *client, uint16_t msgid, void *userda
     PR_DEBUG("Subscribe successed ID:%d", msgid);
 }
 
+/*
+ * QoS1 publishes waiting for their PUBACK live in a fixed table. Sent ones are
+ * found by msgid through an open addressing index, all of them sit in a
+ * binary heap ordered by deadline so the loop only looks at the earliest one.
+ * The table functions are called with publish.mutex locked.
+ */
+#define MQTT_PUBLISH_SLOT_NONE 0xFF
+
+static int mqtt_publish_index_find(mqtt_publish_table_t *table, uint16_t msgid)
+{
+    uint16_t i = msgid % MQTT_PUBLISH_INDEX_SIZE;
+
+    for (; table->index[i] != MQTT_PUBLISH_SLOT_NONE; i = (i + 1) % MQTT_PUBLISH_INDEX_SIZE) {
+        if (table->slot[table->index[i]].msgid == msgid) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void mqtt_publish_index_add(mqtt_publish_table_t *table, uint8_t slot)
+{
+    uint16_t i = table->slot[slot].msgid % MQTT_PUBLISH_INDEX_SIZE;
+
+    while (table->index[i] != MQTT_PUBLISH_SLOT_NONE) {
+        i = (i + 1) % MQTT_PUBLISH_INDEX_SIZE;
+    }
+    table->index[i] = slot;
+}
+
+// backward shift, so lookups never need tombstones
+static void mqtt_publish_index_del(mqtt_publish_table_t *table, uint16_t i)
+{
+    uint16_t j = i, home;
+
+    for (;;) {
+        table->index[i] = MQTT_PUBLISH_SLOT_NONE;
+        for (;;) {
+            j = (j + 1) % MQTT_PUBLISH_INDEX_SIZE;
+            if (table->index[j] == MQTT_PUBLISH_SLOT_NONE) {
+                return;
+            }
+            home = table->slot[table->index[j]].msgid % MQTT_PUBLISH_INDEX_SIZE;
+            // entries whose home lies in (i, j] stay where they are
+            if ((i <= j) ? (i < home && home <= j) : (i < home || home <= j)) {
+                continue;
+            }
+            break;
+        }
+        table->index[i] = table->index[j];
+        i = j;
+    }
+}
+
+static void mqtt_publish_heap_swap(mqtt_publish_table_t *table, uint16_t a, uint16_t b)
+{
+    uint8_t slot = table->heap[a];
+
+    table->heap[a] = table->heap[b];
+    table->heap[b] = slot;
+    table->slot[table->heap[a]].heap_pos = a;
+    table->slot[table->heap[b]].heap_pos = b;
+}
+
+static bool mqtt_publish_heap_less(mqtt_publish_table_t *table, uint16_t a, uint16_t b)
+{
+    return table->slot[table->heap[a]].deadline < table->slot[table->heap[b]].deadline;
+}
+
+static void mqtt_publish_heap_fix(mqtt_publish_table_t *table, uint16_t pos)
+{
+    uint16_t child;
+
+    while (pos > 0 && mqtt_publish_heap_less(table, pos, (pos - 1) / 2)) {
+        mqtt_publish_heap_swap(table, pos, (pos - 1) / 2);
+        pos = (pos - 1) / 2;
+    }
+    while ((child = pos * 2 + 1) < table->num) {
+        if (child + 1 < table->num && mqtt_publish_heap_less(table, child + 1, child)) {
+            child++;
+        }
+        if (!mqtt_publish_heap_less(table, child, pos)) {
+            break;
+        }
+        mqtt_publish_heap_swap(table, pos, child);
+        pos = child;
+    }
+}
+
+static mqtt_publish_handle_t *mqtt_publish_add(mqtt_publish_table_t *table)
+{
+    uint8_t slot;
+
+    for (slot = 0; slot < MQTT_PUBLISH_INFLIGHT_MAX; slot++) {
+        if (!table->slot[slot].used) {
+            break;
+        }
+    }
+    if (table->num >= MQTT_PUBLISH_INFLIGHT_MAX || slot >= MQTT_PUBLISH_INFLIGHT_MAX) {
+        return NULL;
+    }
+
+    mqtt_publish_handle_t *entry = &table->slot[slot];
+    memset(entry, 0, sizeof(mqtt_publish_handle_t));
+    entry->used = true;
+    entry->seq = table->seq++;
+    entry->heap_pos = table->num;
+    table->heap[table->num++] = slot;
+    table->unsent++;
+
+    table->stat.inflight = table->num;
+    if (table->stat.inflight > table->stat.inflight_peak) {
+        table->stat.inflight_peak = table->stat.inflight;
+    }
+    return entry;
+}
+
+// the deadline must be set before, the heap is fixed here
+static void mqtt_publish_sent(mqtt_publish_table_t *table, mqtt_publish_handle_t *entry, uint16_t msgid)
+{
+    entry->msgid = msgid;
+    entry->sent_ms = tal_system_get_millisecond();
+    mqtt_publish_index_add(table, entry - table->slot);
+    table->unsent--;
+}
+
+// the entry is copied to out, its payload belongs to the caller
+static void mqtt_publish_remove(mqtt_publish_table_t *table, mqtt_publish_handle_t *entry, mqtt_publish_handle_t *out)
+{
+    uint16_t pos = entry->heap_pos;
+
+    if (entry->msgid) {
+        int i = mqtt_publish_index_find(table, entry->msgid);
+        if (i >= 0) {
+            mqtt_publish_index_del(table, i);
+        }
+    } else {
+        table->unsent--;
+    }
+
+    table->num--;
+    if (pos != table->num) {
+        table->heap[pos] = table->heap[table->num];
+        table->slot[table->heap[pos]].heap_pos = pos;
+        mqtt_publish_heap_fix(table, pos);
+    }
+    table->stat.inflight = table->num;
+
+    *out = *entry;
+    entry->used = false;
+}
+
 static void mqtt_client_puback_cb(void *client, uint16_t msgid, void *userdata)
 {
     client = client;
     tuya_mqtt_context_t *context = (tuya_mqtt_context_t *)userdata;
+    mqtt_publish_table_t *table = &context->publish;
+    mqtt_publish_handle_t entry;
     PR_DEBUG("PUBACK ID:%d", msgid);
 
-    /* LOCK */
-    /* publish async process */
-    mqtt_publish_handle_t **next_handle = &context->publish_list;
-    for (; *next_handle; next_handle = &(*next_handle)->next) {
-        mqtt_publish_handle_t *entry = *next_handle;
-        if (msgid == entry->msgid) {
-            entry->cb(OPRT_OK, entry->user_data);
-            *next_handle = entry->next;
-            tal_free(entry->payload);
-            tal_free(entry);
-            break;
-        }
+    tal_mutex_lock(table->mutex);
+    int i = mqtt_publish_index_find(table, msgid);
+    if (i < 0) {
+        tal_mutex_unlock(table->mutex);
+        return;
     }
-    /* UNLOCK */
+    mqtt_publish_remove(table, &table->slot[table->index[i]], &entry);
+
+    uint32_t rtt = (uint32_t)(tal_system_get_millisecond() - entry.sent_ms);
+    mqtt_publish_stat_t *stat = &table->stat;
+    stat->acked++;
+    stat->rtt_last_ms = rtt;
+    if (1 == stat->acked || rtt < stat->rtt_min_ms) {
+        stat->rtt_min_ms = rtt;
+    }
+    if (rtt > stat->rtt_max_ms) {
+        stat->rtt_max_ms = rtt;
+    }
+    stat->rtt_avg_ms = (1 == stat->acked) ? rtt : (stat->rtt_avg_ms * 7 + rtt) / 8;
+    tal_mutex_unlock(table->mutex);
+
+    entry.cb(OPRT_OK, entry.user_data);
+    tal_free(entry.payload);
+}
+
+/* time a datagram sent to the wakeup socket has to arrive when it is opened */
+#define MQTT_WAKEUP_PROBE_MS 100
+
+/*
+ * The loop sleeps in a select on the connection. Other threads end the sleep
+ * by sending a datagram to a loopback socket that is part of the select.
+ * Stacks built without loopback delivery (lwIP without LWIP_NETIF_LOOPBACK)
+ * drop the datagram, the socket is only kept if a first one arrives. Without
+ * the socket the loop wakes up every MQTT_RECV_BLOCK_TIME_MS at least.
+ */
+static void mqtt_wakeup_open(tuya_mqtt_context_t *context)
+{
+    TUYA_IP_ADDR_T addr = 0;
+    TUYA_FD_SET_T readfds;
+    uint8_t buf[8];
+    int fd = tal_net_socket_create(PROTOCOL_UDP);
+
+    context->wakeup_fd = -1;
+    if (fd < 0) {
+        PR_WARN("mqtt wakeup socket create fail");
+        return;
+    }
+    if (tal_net_bind(fd, TY_IPADDR_LOOPBACK, 0) < 0 ||
+        OPRT_OK != tal_net_getsockname(fd, &addr, &context->wakeup_port)) {
+        PR_WARN("mqtt wakeup socket bind fail");
+        tal_net_close(fd);
+        return;
+    }
+    tal_net_set_block(fd, FALSE);
+
+    tal_net_send_to(fd, "w", 1, TY_IPADDR_LOOPBACK, context->wakeup_port);
+    tal_net_fd_zero(&readfds);
+    tal_net_fd_set(fd, &readfds);
+    if (tal_net_select(fd + 1, &readfds, NULL, NULL, MQTT_WAKEUP_PROBE_MS) <= 0 ||
+        tal_net_recv(fd, buf, sizeof(buf)) <= 0) {
+        PR_WARN("mqtt wakeup datagram lost, poll every %d ms", MQTT_RECV_BLOCK_TIME_MS);
+        tal_net_close(fd);
+        return;
+    }
+    context->wakeup_fd = fd;
+}
+
+static void mqtt_wakeup_close(tuya_mqtt_context_t *context)
+{
+    if (context->wakeup_fd >= 0) {
+        tal_net_close(context->wakeup_fd);
+        context->wakeup_fd = -1;
+    }
+}
+
+/**
+ * @brief Ends the current wait of tuya_mqtt_loop_wait, from any thread.
+ *
+ * @param context Pointer to the Tuya MQTT context structure.
+ */
+void tuya_mqtt_wakeup(tuya_mqtt_context_t *context)
+{
+    if (context == NULL || context->is_inited == false || context->wakeup_fd < 0) {
+        return;
+    }
+    tal_net_send_to(context->wakeup_fd, "w", 1, TY_IPADDR_LOOPBACK, context->wakeup_port);
+}
+
+/* a packet that starts a write batch wakes the loop, it owns the batch deadline */
+static uint16_t mqtt_publish_send(tuya_mqtt_context_t *context, const char *topic, const uint8_t *payload,
+                                  size_t length, uint8_t qos)
+{
+    bool idle = (UINT32_MAX == mqtt_client_flush_remain(context->mqtt_client));
+    uint16_t msgid = mqtt_client_publish(context->mqtt_client, topic, payload, length, qos);
+
+    if (idle && UINT32_MAX != mqtt_client_flush_remain(context->mqtt_client)) {
+        tuya_mqtt_wakeup(context);
+    }
+    return msgid;
+}
+
+/**
+ * @brief Sends the MQTT packets waiting in the write batch at once.
+ *
+ * @param context Pointer to the Tuya MQTT context structure.
+ * @return Returns 0 on success, or a negative error code on failure.
+ */
+int tuya_mqtt_flush(tuya_mqtt_context_t *context)
+{
+    if (context == NULL || context->mqtt_client == NULL) {
+        return OPRT_INVALID_PARM;
+    }
+    if (MQTT_STATUS_SUCCESS != mqtt_client_flush(context->mqtt_client)) {
+        return OPRT_COM_ERROR;
+    }
+    return OPRT_OK;
 }
 
 /**
@@ -370,6 +627,8 @@ int tuya_mqtt_init(tuya_mqtt_context_t *context, const tuya_mqtt_config_t *confi
 
     /* Clean to zero */
     memset(context, 0, sizeof(tuya_mqtt_context_t));
+    memset(context->publish.index, MQTT_PUBLISH_SLOT_NONE, sizeof(context->publish.index));
+    context->wakeup_fd = -1;
 
     /* configuration */
     context->user_data = config->user_data;
@@ -428,6 +687,13 @@ int tuya_mqtt_init(tuya_mqtt_context_t *context, const tuya_mqtt_config_t *confi
     context->sequence_out = rand() & 0xffff;
     context->sequence_in = -1;
 
+    rt = tal_mutex_create_init(&context->publish.mutex);
+    if (OPRT_OK != rt) {
+        PR_ERR("mqtt publish mutex create error:%d", rt);
+        return rt;
+    }
+    mqtt_wakeup_open(context);
+
     /* Wait start task */
     context->is_inited = true;
     context->manual_disconnect = true;
@@ -647,43 +913,50 @@ int tuya_mqtt_client_publish_common(tuya_mqtt_context_t *context, const char *to
     }
 
     if (cb == NULL) {
-        uint16_t msgid = mqtt_client_publish(context->mqtt_client, topic, payload, payload_length, MQTT_QOS_0);
+        uint16_t msgid = mqtt_publish_send(context, topic, payload, payload_length, MQTT_QOS_0);
         if (msgid <= 0) {
             return OPRT_COM_ERROR;
         }
         return OPRT_OK;
     }
 
-    mqtt_publish_handle_t *handle = tal_malloc(sizeof(mqtt_publish_handle_t));
-    TUYA_CHECK_NULL_RETURN(handle, OPRT_MALLOC_FAILED);
-    handle->next = NULL;
-    handle->msgid = 0;
+    mqtt_publish_table_t *table = &context->publish;
+    uint8_t *copy = tal_malloc(payload_length);
+    TUYA_CHECK_NULL_RETURN(copy, OPRT_MALLOC_FAILED);
+    memcpy(copy, payload, payload_length);
+
+    /* the lock is held while sending, so the PUBACK can not come before the msgid is indexed */
+    tal_mutex_lock(table->mutex);
+    mqtt_publish_handle_t *handle = mqtt_publish_add(table);
+    if (handle == NULL) {
+        table->stat.rejected++;
+        tal_mutex_unlock(table->mutex);
+        tal_free(copy);
+        PR_WARN("mqtt publish refused, %d in flight", MQTT_PUBLISH_INFLIGHT_MAX);
+        return OPRT_EXCEED_UPPER_LIMIT;
+    }
     handle->topic = (char *)topic;
-    handle->timeout = tal_time_get_posix() + timeout_ms;
+    handle->deadline = tal_system_get_millisecond() + timeout_ms;
     handle->cb = cb;
     handle->user_data = user_data;
     handle->payload_length = payload_length;
-    handle->payload = tal_malloc(payload_length);
-    if (handle->payload == NULL) {
-        return OPRT_MALLOC_FAILED;
-    }
-    memcpy(handle->payload, payload, payload_length);
+    handle->payload = copy;
+    mqtt_publish_heap_fix(table, handle->heap_pos);
 
     if (async == false) {
-        handle->msgid = mqtt_client_publish(context->mqtt_client, handle->topic, handle->payload,
-                                            handle->payload_length, MQTT_QOS_1);
-    }
-
-    if (context->publish_list == NULL) {
-        context->publish_list = handle;
-        return OPRT_OK;
+        uint16_t msgid =
+            mqtt_publish_send(context, handle->topic, handle->payload, handle->payload_length, MQTT_QOS_1);
+        if (msgid) {
+            mqtt_publish_sent(table, handle, msgid);
+        }
     }
+    bool queued = (0 == handle->msgid);
+    tal_mutex_unlock(table->mutex);
 
-    mqtt_publish_handle_t *last = context->publish_list;
-    while (last->next != NULL) {
-        last = last->next;
+    if (queued) {
+        // the loop sends it
+        tuya_mqtt_wakeup(context);
     }
-    last->next = handle;
 
     return OPRT_OK;
 }
@@ -737,6 +1010,58 @@ int tuya_mqtt_protocol_data_publish_with_topic_common(tuya_mqtt_context_t *conte
     return ret;
 }
 
+/**
+ * @brief Publishes MQTT protocol data produced by a writer.
+ *
+ * The writer fills the data directly in the packet buffer, so no JSON string
+ * of the data is needed before packing.
+ *
+ * @param context The MQTT context.
+ * @param protocol_id The protocol ID.
+ * @param writer Writes exactly length bytes of JSON data.
+ * @param arg The writer argument.
+ * @param length The length of the data the writer produces.
+ * @param cb The callback function to be called after the publish operation is
+ * complete.
+ * @param user_data User data to be passed to the callback function.
+ * @param timeout_ms The timeout value for the publish operation in
+ * milliseconds.
+ * @param async Specifies whether the publish operation should be performed
+ * asynchronously.
+ * @return Returns 0 on success, or a negative error code on failure.
+ */
+int tuya_mqtt_protocol_data_publish_with_writer(tuya_mqtt_context_t *context, uint16_t protocol_id,
+                                                tuya_pack_writer_t writer, void *arg, uint32_t length,
+                                                mqtt_publish_notify_cb_t cb, void *user_data, int timeout_ms,
+                                                bool async)
+{
+    if (context == NULL || context->is_inited == false) {
+        return OPRT_INVALID_PARM;
+    }
+
+    if (context->is_connected == false) {
+        return OPRT_COM_ERROR;
+    }
+
+    int ret = OPRT_OK;
+
+    char *buffer = NULL;
+    uint32_t buffer_len = 0;
+
+    ret = tuya_pack_protocol_data_with_writer(DP_CMD_MQ, writer, arg, length, protocol_id,
+                                              (uint8_t *)context->signature.cipherkey, &buffer, &buffer_len);
+    if (ret != OPRT_OK) {
+        PR_ERR("tuya_pack_protocol_data_with_writer error:%d", ret);
+        return ret;
+    }
+
+    /* mqtt client publish */
+    ret = tuya_mqtt_client_publish_common(context, (const char *)context->signature.topic_out, (const uint8_t *)buffer,
+                                          buffer_len, cb, user_data, timeout_ms, async);
+    tal_free(buffer);
+    return ret;
+}
+
 /**
  * Publishes common MQTT protocol data.
  *
@@ -805,6 +1130,69 @@ int tuya_mqtt_protocol_data_publish(tuya_mqtt_context_t *context, uint16_t proto
     return tuya_mqtt_protocol_data_publish_with_topic(context, context->signature.topic_out, protocol_id, data, length);
 }
 
+static void mqtt_publish_expire(tuya_mqtt_context_t *context)
+{
+    mqtt_publish_table_t *table = &context->publish;
+    mqtt_publish_handle_t expired;
+    SYS_TIME_T now = tal_system_get_millisecond();
+
+    tal_mutex_lock(table->mutex);
+    while (table->num && table->slot[table->heap[0]].deadline <= now) {
+        mqtt_publish_remove(table, &table->slot[table->heap[0]], &expired);
+        table->stat.timeout++;
+        tal_mutex_unlock(table->mutex);
+        PR_WARN("mqtt publish ID:%d timeout", expired.msgid);
+        expired.cb(OPRT_TIMEOUT, expired.user_data);
+        tal_free(expired.payload);
+        tal_mutex_lock(table->mutex);
+    }
+    tal_mutex_unlock(table->mutex);
+}
+
+// time before the publish table needs the loop
+static uint32_t mqtt_publish_next_timeout(tuya_mqtt_context_t *context)
+{
+    mqtt_publish_table_t *table = &context->publish;
+    uint32_t next = UINT32_MAX;
+    SYS_TIME_T now = tal_system_get_millisecond();
+
+    tal_mutex_lock(table->mutex);
+    if (table->unsent) {
+        next = 0;
+    } else if (table->num) {
+        SYS_TIME_T deadline = table->slot[table->heap[0]].deadline;
+        next = (deadline > now) ? (uint32_t)(deadline - now) : 0;
+    }
+    tal_mutex_unlock(table->mutex);
+
+    return next;
+}
+
+static void mqtt_loop_sleep(tuya_mqtt_context_t *context, uint32_t wait_ms)
+{
+    TUYA_FD_SET_T readfds;
+    int fd = mqtt_client_socket(context->mqtt_client);
+    int maxfd = fd;
+    uint8_t buf[8];
+
+    if (fd < 0 || 0 == wait_ms || mqtt_client_read_pending(context->mqtt_client)) {
+        return;
+    }
+
+    tal_net_fd_zero(&readfds);
+    tal_net_fd_set(fd, &readfds);
+    if (context->wakeup_fd >= 0) {
+        tal_net_fd_set(context->wakeup_fd, &readfds);
+        maxfd = (context->wakeup_fd > fd) ? context->wakeup_fd : fd;
+    }
+
+    if (tal_net_select(maxfd + 1, &readfds, NULL, NULL, wait_ms) > 0 && context->wakeup_fd >= 0 &&
+        tal_net_fd_isset(context->wakeup_fd, &readfds)) {
+        while (tal_net_recv(context->wakeup_fd, buf, sizeof(buf)) > 0) {
+        }
+    }
+}
+
 /**
  * @brief Executes the MQTT event loop for the Tuya MQTT service.
  *
@@ -816,6 +1204,22 @@ int tuya_mqtt_protocol_data_publish(tuya_mqtt_context_t *context, uint16_t proto
  * @return Returns 0 on success, or a negative error code on failure.
  */
 int tuya_mqtt_loop(tuya_mqtt_context_t *context)
+{
+    return tuya_mqtt_loop_wait(context, MQTT_RECV_BLOCK_TIME_MS);
+}
+
+/**
+ * @brief Runs the MQTT event loop, sleeping until there is work.
+ *
+ * The loop waits for the connection to become readable, the next publish
+ * timeout or keep alive, a call to tuya_mqtt_wakeup, or wait_ms, whichever
+ * comes first, then processes what arrived.
+ *
+ * @param context Pointer to the Tuya MQTT context structure.
+ * @param wait_ms The longest time to wait, for the deadlines of the caller.
+ * @return Returns 0 on success, or a negative error code on failure.
+ */
+int tuya_mqtt_loop_wait(tuya_mqtt_context_t *context, uint32_t wait_ms)
 {
     if (context == NULL) {
         return OPRT_COM_ERROR;
@@ -828,6 +1232,9 @@ int tuya_mqtt_loop(tuya_mqtt_context_t *context)
         return rt;
     }
 
+    /* publishes time out while disconnected too */
+    mqtt_publish_expire(context);
+
     /* reconnect */
     if (context->is_connected == false) {
         mqtt_status = mqtt_client_connect(context->mqtt_client);
@@ -851,29 +1258,47 @@ int tuya_mqtt_loop(tuya_mqtt_context_t *context)
         return rt;
     }
 
-    /* LOCK */
     /* publish async process */
-    mqtt_publish_handle_t **next_handle = &context->publish_list;
-    for (; *next_handle; next_handle = &(*next_handle)->next) {
-        mqtt_publish_handle_t *entry = *next_handle;
-
-        if (entry->timeout <= tal_time_get_posix()) {
-            entry->cb(OPRT_TIMEOUT, entry->user_data);
-            *next_handle = entry->next;
-            tal_free(entry->payload);
-            tal_free(entry);
-            continue;
+    mqtt_publish_table_t *table = &context->publish;
+
+    tal_mutex_lock(table->mutex);
+    while (table->unsent) {
+        mqtt_publish_handle_t *entry = NULL;
+        for (uint8_t i = 0; i < MQTT_PUBLISH_INFLIGHT_MAX; i++) {
+            mqtt_publish_handle_t *slot = &table->slot[i];
+            if (slot->used && 0 == slot->msgid && (NULL == entry || (int32_t)(slot->seq - entry->seq) < 0)) {
+                entry = slot;
+            }
         }
-
-        if (entry->msgid <= 0) {
-            entry->msgid =
-                mqtt_client_publish(context->mqtt_client, entry->topic, entry->payload, entry->payload_length, 1);
+        uint16_t msgid =
+            mqtt_client_publish(context->mqtt_client, entry->topic, entry->payload, entry->payload_length, MQTT_QOS_1);
+        if (0 == msgid) {
+            break;
         }
+        mqtt_publish_sent(table, entry, msgid);
     }
-    /* UNLOCK */
+    tal_mutex_unlock(table->mutex);
 
-    /* yield */
-    mqtt_client_yield(context->mqtt_client);
+    /* sleep until the next deadline or event */
+    uint32_t next = mqtt_publish_next_timeout(context);
+    if (next < wait_ms) {
+        wait_ms = next;
+    }
+    next = mqtt_client_keepalive_remain(context->mqtt_client);
+    if (next < wait_ms) {
+        wait_ms = next;
+    }
+    next = mqtt_client_flush_remain(context->mqtt_client);
+    if (next < wait_ms) {
+        wait_ms = next;
+    }
+    /* without the wakeup socket the requests of other threads wait for the next poll */
+    if (context->wakeup_fd < 0 && wait_ms > MQTT_RECV_BLOCK_TIME_MS) {
+        wait_ms = MQTT_RECV_BLOCK_TIME_MS;
+    }
+    mqtt_loop_sleep(context, wait_ms);
+
+    mqtt_client_process(context->mqtt_client);
 
     return rt;
 }
@@ -894,6 +1319,24 @@ int tuya_mqtt_destory(tuya_mqtt_context_t *context)
     }
 
     tuya_mqtt_protocol_unregister_all(context);
+
+    /* fail the publishes still in flight */
+    mqtt_publish_table_t *table = &context->publish;
+    mqtt_publish_handle_t entry;
+    tal_mutex_lock(table->mutex);
+    while (table->num) {
+        mqtt_publish_remove(table, &table->slot[table->heap[0]], &entry);
+        tal_mutex_unlock(table->mutex);
+        entry.cb(OPRT_COM_ERROR, entry.user_data);
+        tal_free(entry.payload);
+        tal_mutex_lock(table->mutex);
+    }
+    tal_mutex_unlock(table->mutex);
+    tal_mutex_release(table->mutex);
+    table->mutex = NULL;
+    mqtt_wakeup_close(context);
+    context->is_inited = false;
+
     if (context->mqtt_client) {
         mqtt_client_status_t mqtt_status = mqtt_client_deinit(context->mqtt_client);
         mqtt_client_free(context->mqtt_client);
@@ -923,6 +1366,32 @@ bool tuya_mqtt_connected(tuya_mqtt_context_t *context)
     return context->is_connected;
 }
 
+/**
+ * @brief Reads the statistics of the QoS1 publishes.
+ *
+ * @param context Pointer to the MQTT context.
+ * @param stat The in-flight depth, acknowledgement and round trip statistics.
+ * @param reset Clear the counters and round trip times after reading them.
+ * @return Returns 0 on success, or a negative error code on failure.
+ */
+int tuya_mqtt_publish_stat_get(tuya_mqtt_context_t *context, mqtt_publish_stat_t *stat, bool reset)
+{
+    if (context == NULL || context->is_inited == false || stat == NULL) {
+        return OPRT_INVALID_PARM;
+    }
+
+    tal_mutex_lock(context->publish.mutex);
+    *stat = context->publish.stat;
+    if (reset) {
+        memset(&context->publish.stat, 0, sizeof(mqtt_publish_stat_t));
+        context->publish.stat.inflight = context->publish.num;
+        context->publish.stat.inflight_peak = context->publish.num;
+    }
+    tal_mutex_unlock(context->publish.mutex);
+
+    return OPRT_OK;
+}
+
 /**
  * @brief Reports the progress of an upgrade operation over MQTT.
  *
@@ -30,6 +30,10 @@ extern "C" {
 #include "cJSON.h"
 #include "mqtt_client_interface.h"
 #include "backoff_algorithm.h"
+#include "tuya_protocol.h"
+#include "tuya_config_defaults.h"
+#include "tuya_cloud_types.h"
+#include "tal_mutex.h"
 
 // data max len
 #define TUYA_MQTT_CLIENTID_MAXLEN   (32U)
@@ -153,10 +157,15 @@ typedef struct mqtt_subscribe_handle {
 
 typedef void (*mqtt_publish_notify_cb_t)(int result, void *user_data);
 
+#define MQTT_PUBLISH_INDEX_SIZE (MQTT_PUBLISH_INFLIGHT_MAX * 2)
+
 typedef struct mqtt_publish_handle {
-    struct mqtt_publish_handle *next;
-    uint16_t msgid;
-    int timeout;
+    uint16_t msgid; // 0 until the publish is sent
+    bool used;
+    uint8_t heap_pos;    // position in the deadline heap
+    uint32_t seq;        // unsent publishes go out in this order
+    SYS_TIME_T deadline; // tal_system_get_millisecond time
+    SYS_TIME_T sent_ms;
     char *topic;
     uint8_t *payload;
     size_t payload_length;
@@ -164,12 +173,37 @@ typedef struct mqtt_publish_handle {
     void *user_data;
 } mqtt_publish_handle_t;
 
+typedef struct {
+    uint16_t inflight; // publishes waiting for their PUBACK
+    uint16_t inflight_peak;
+    uint32_t acked;
+    uint32_t timeout;
+    uint32_t rejected; // refused because MQTT_PUBLISH_INFLIGHT_MAX were in flight
+    uint32_t rtt_last_ms;
+    uint32_t rtt_min_ms;
+    uint32_t rtt_max_ms;
+    uint32_t rtt_avg_ms; // moving average, 1/8 weight for the newest
+} mqtt_publish_stat_t;
+
+typedef struct {
+    MUTEX_HANDLE mutex;
+    mqtt_publish_handle_t slot[MQTT_PUBLISH_INFLIGHT_MAX];
+    uint8_t index[MQTT_PUBLISH_INDEX_SIZE];  // slot of each sent msgid, linear probing
+    uint8_t heap[MQTT_PUBLISH_INFLIGHT_MAX]; // slots, earliest deadline first
+    uint16_t num;
+    uint16_t unsent;
+    uint32_t seq;
+    mqtt_publish_stat_t stat;
+} mqtt_publish_table_t;
+
 typedef struct {
     void *mqtt_client;
     tuya_mqtt_access_t signature;
     tuya_protocol_handle_t *protocol_list;
     mqtt_subscribe_handle_t *subscribe_list;
-    mqtt_publish_handle_t *publish_list;
+    mqtt_publish_table_t publish;
+    int wakeup_fd; // loopback udp socket that ends the wait of the loop, -1 if none
+    uint16_t wakeup_port;
     BackoffAlgorithmContext_t backoff_algorithm;
     uint32_t sequence_in;
     uint32_t sequence_out;
@@ -247,6 +281,48 @@ int tuya_mqtt_destory(tuya_mqtt_context_t *context);
  */
 bool tuya_mqtt_connected(tuya_mqtt_context_t *context);
 
+/**
+ * @brief Reads the statistics of the QoS1 publishes.
+ *
+ * @param context Pointer to the MQTT context.
+ * @param stat The in-flight depth, acknowledgement and round trip statistics.
+ * @param reset Clear the counters and round trip times after reading them.
+ * @return Returns 0 on success, or a negative error code on failure.
+ */
+int tuya_mqtt_publish_stat_get(tuya_mqtt_context_t *context, mqtt_publish_stat_t *stat, bool reset);
+
+/**
+ * @brief Runs the MQTT event loop, sleeping until there is work.
+ *
+ * The loop waits for the connection to become readable, the next publish
+ * timeout or keep alive, a call to tuya_mqtt_wakeup, or wait_ms, whichever
+ * comes first, then processes what arrived.
+ *
+ * @param context Pointer to the Tuya MQTT context structure.
+ * @param wait_ms The longest time to wait, for the deadlines of the caller.
+ * @return Returns 0 on success, or a negative error code on failure.
+ */
+int tuya_mqtt_loop_wait(tuya_mqtt_context_t *context, uint32_t wait_ms);
+
+/**
+ * @brief Ends the current wait of tuya_mqtt_loop_wait, from any thread.
+ *
+ * @param context Pointer to the Tuya MQTT context structure.
+ */
+void tuya_mqtt_wakeup(tuya_mqtt_context_t *context);
+
+/**
+ * @brief Sends the MQTT packets waiting in the write batch at once.
+ *
+ * With ENABLE_MQTT_WRITE_COALESCE the packets wait up to
+ * MQTT_WRITE_COALESCE_MS for more to share their TLS record, call this after
+ * a publish that must not wait.
+ *
+ * @param context Pointer to the Tuya MQTT context structure.
+ * @return Returns 0 on success, or a negative error code on failure.
+ */
+int tuya_mqtt_flush(tuya_mqtt_context_t *context);
+
 /**
  * @brief Registers a MQTT protocol with the given context.
  *
@@ -312,6 +388,32 @@ int tuya_mqtt_protocol_data_publish(tuya_mqtt_context_t *context, uint16_t proto
 int tuya_mqtt_protocol_data_publish_with_topic(tuya_mqtt_context_t *context, const char *topic, uint16_t protocol_id,
                                                const uint8_t *data, uint16_t length);
 
+/**
+ * @brief Publishes MQTT protocol data produced by a writer.
+ *
+ * The writer fills the data directly in the packet buffer, so no JSON string
+ * of the data is needed before packing.
+ *
+ * @param context The MQTT context.
+ * @param protocol_id The protocol ID.
+ * @param writer Writes exactly length bytes of JSON data.
+ * @param arg The writer argument.
+ * @param length The length of the data the writer produces.
+ * @param cb The callback function to be called when the publish operation is
+ * complete.
+ * @param user_data User data to be passed to the callback function.
+ * @param timeout_ms The timeout value for the publish operation in
+ * milliseconds.
+ * @param async Specifies whether the publish operation should be performed
+ * asynchronously.
+ *
+ * @return Returns 0 on success, or a negative error code on failure.
+ */
+int tuya_mqtt_protocol_data_publish_with_writer(tuya_mqtt_context_t *context, uint16_t protocol_id,
+                                                tuya_pack_writer_t writer, void *arg, uint32_t length,
+                                                mqtt_publish_notify_cb_t cb, void *user_data, int timeout_ms,
+                                                bool async);
+
 /**
  * @brief Publishes common MQTT protocol data.
  *
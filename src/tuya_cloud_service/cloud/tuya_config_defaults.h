@@ -45,6 +45,16 @@
 #define MQTT_KEEPALIVE_INTERVALIN (120)
 #endif
 
+/**
+ * @brief Maximum number of QoS1 publishes waiting for their PUBACK, further
+ * publishes are refused. The MQTT core tracks MQTT_STATE_ARRAY_MAX_COUNT of
+ * them, at most 127.
+ *
+ */
+#ifndef MQTT_PUBLISH_INFLIGHT_MAX
+#define MQTT_PUBLISH_INFLIGHT_MAX (10U)
+#endif
+
 /**
  * @brief Defaults auto check upgrade interval.
  *
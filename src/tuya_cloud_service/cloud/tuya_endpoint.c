@@ -41,17 +41,26 @@ static int tuya_region_regist_key_write(const char *region, const char *regist_k
         return OPRT_INVALID_PARM;
     }
 
-    /* Write kv storage */
+    /* Write kv storage, both keys in one flash pass */
     int ret = 0;
+    tal_kv_batch_begin();
     ret = tal_kv_set("region", (const uint8_t *)region, strlen(region));
     if (ret != OPRT_OK) {
         PR_ERR("tal_kv_set region, error:0x%02x", ret);
+        tal_kv_batch_commit();
         return OPRT_KVS_WR_FAIL;
     }
 
     ret = tal_kv_set("regist_key", (const uint8_t *)regist_key, strlen(regist_key));
     if (ret != OPRT_OK) {
         PR_ERR("tal_kv_set regist_key, error:0x%02x", ret);
+        tal_kv_batch_commit();
+        return OPRT_KVS_WR_FAIL;
+    }
+
+    ret = tal_kv_batch_commit();
+    if (ret != OPRT_OK) {
+        PR_ERR("tal_kv_batch_commit, error:0x%02x", ret);
         return OPRT_KVS_WR_FAIL;
     }
 
@@ -245,10 +254,12 @@ int tuya_endpoint_region_regist_set(const char *region, const char *regist_key)
  */
 int tuya_endpoint_remove(void)
 {
+    tal_kv_batch_begin();
     tal_kv_del("region");
     tal_kv_del("regist_key");
     tal_kv_del("endpoint.cert");
     tal_kv_del("endpoint.domain");
+    tal_kv_batch_commit();
 
     return OPRT_OK;
 }
@@ -29,6 +29,7 @@
 #include "tuya_tls.h"
 #include "netmgr.h"
 #include "tuya_health.h"
+#include "http_client_interface.h"
 typedef enum {
     STATE_IDLE,
     STATE_START,
@@ -180,10 +181,12 @@ static int activate_response_parse(atop_base_response_t *response)
     // cJSON object to string save
     char *schemaId = cJSON_GetObjectItem(result_root, "schemaId")->valuestring;
     cJSON *schema_obj = cJSON_DetachItemFromObject(result_root, "schema");
+    tal_kv_batch_begin();
     ret = tal_kv_set(schemaId, (const uint8_t *)schema_obj->valuestring, strlen(schema_obj->valuestring));
     cJSON_Delete(schema_obj);
     if (ret != OPRT_OK) {
         PR_ERR("activate data save error:%d", ret);
+        tal_kv_batch_commit();
         return OPRT_KVS_WR_FAIL;
     }
 
@@ -193,6 +196,13 @@ static int activate_response_parse(atop_base_response_t *response)
     PR_DEBUG("result len %d :%s", (int)strlen(result_string), result_string);
     ret = tal_kv_set(activate_data_key, (const uint8_t *)result_string, strlen(result_string));
     tal_free(result_string);
+    if (ret != OPRT_OK) {
+        PR_ERR("activate data save error:%d", ret);
+        tal_kv_batch_commit();
+        return OPRT_KVS_WR_FAIL;
+    }
+
+    ret = tal_kv_batch_commit();
     if (ret != OPRT_OK) {
         PR_ERR("activate data save error:%d", ret);
         return OPRT_KVS_WR_FAIL;
@@ -558,6 +568,7 @@ int tuya_iot_init(tuya_iot_client_t *client, const tuya_iot_config_t *config)
     PR_DEBUG("authkey:%s", client->config.authkey);
 
     tal_semaphore_create_init(&client->token_get.sem, 0, 1);
+    tal_semaphore_create_init(&client->wakeup, 0, 1);
 
     /* Default storage namespace */
     if (client->config.storage_namespace == NULL) {
@@ -586,6 +597,13 @@ int tuya_iot_init(tuya_iot_client_t *client, const tuya_iot_config_t *config)
 
     tuya_health_monitor_init();
 
+#if defined(ENABLE_DP_REPORT_COALESCE) && (ENABLE_DP_REPORT_COALESCE == 1)
+    ret = tuya_iot_dp_coalesce_init();
+    if (OPRT_OK != ret) {
+        return ret;
+    }
+#endif
+
     /* Auto check upgrade timer init */
     ret = tal_sw_timer_create(check_auto_upgrade_timeout_on, client, &client->check_upgrade_timer);
     if (OPRT_OK != ret) {
@@ -598,6 +616,25 @@ int tuya_iot_init(tuya_iot_client_t *client, const tuya_iot_config_t *config)
     return ret;
 }
 
+/* end the current wait of tuya_iot_yield so that it sees the new state */
+static void tuya_iot_wakeup(tuya_iot_client_t *client)
+{
+    if (client->wakeup) {
+        tal_semaphore_post(client->wakeup);
+    }
+    tuya_mqtt_wakeup(&client->mqctx);
+}
+
+/* sleep of the states that poll, ended early by tuya_iot_wakeup */
+static void tuya_iot_wait(tuya_iot_client_t *client, uint32_t ms)
+{
+    if (client->wakeup) {
+        tal_semaphore_wait(client->wakeup, ms);
+    } else {
+        tal_system_sleep(ms);
+    }
+}
+
 /**
  * @brief Starts the Tuya IoT client.
  *
@@ -615,6 +652,7 @@ int tuya_iot_start(tuya_iot_client_t *client)
         return OPRT_COM_ERROR;
     }
     client->nextstate = STATE_START;
+    tuya_iot_wakeup(client);
     return OPRT_OK;
 }
 
@@ -629,6 +667,7 @@ int tuya_iot_start(tuya_iot_client_t *client)
 int tuya_iot_stop(tuya_iot_client_t *client)
 {
     client->nextstate = STATE_STOP;
+    tuya_iot_wakeup(client);
     return OPRT_OK;
 }
 
@@ -649,6 +688,7 @@ int tuya_iot_reconnect(tuya_iot_client_t *client)
         return OPRT_COM_ERROR;
     }
     client->nextstate = STATE_MQTT_RECONNECT;
+    tuya_iot_wakeup(client);
     return OPRT_OK;
 }
 
@@ -688,6 +728,7 @@ int tuya_iot_reset(tuya_iot_client_t *client)
         client->token_get.result = OPRT_COM_ERROR;
         tal_semaphore_post(client->token_get.sem);
     }
+    tuya_iot_wakeup(client);
 
     return ret;
 }
@@ -758,6 +799,18 @@ static OPERATE_RET __tuya_iot_link_type_change_cb(void *data)
     return rt;
 }
 
+static OPERATE_RET __tuya_iot_link_status_change_cb(void *data)
+{
+    tuya_iot_client_t *p_client = tuya_iot_client_get();
+
+    /* the states waiting for the network check it again */
+    if (p_client) {
+        tuya_iot_wakeup(p_client);
+    }
+
+    return OPRT_OK;
+}
+
 /**
  * @brief Yields control to the Tuya IoT client for processing incoming messages
  * and events.
@@ -781,12 +834,12 @@ int tuya_iot_yield(tuya_iot_client_t *client)
     switch (client->state) {
 
     case STATE_MQTT_YIELD:
-        tuya_mqtt_loop(&client->mqctx);
+        tuya_mqtt_loop_wait(&client->mqctx, matop_service_next_timeout(&client->matop));
         matop_serice_yield(&client->matop);
         break;
 
     case STATE_IDLE:
-        tal_system_sleep(500);
+        tuya_iot_wait(client, 500);
         break;
 
     case STATE_START:
@@ -800,6 +853,8 @@ int tuya_iot_yield(tuya_iot_client_t *client)
         }
         TUYA_CALL_ERR_LOG(
             tal_event_subscribe(EVENT_LINK_TYPE_CHG, "iot", __tuya_iot_link_type_change_cb, SUBSCRIBE_TYPE_NORMAL));
+        TUYA_CALL_ERR_LOG(tal_event_subscribe(EVENT_LINK_STATUS_CHG, "iot", __tuya_iot_link_status_change_cb,
+                                              SUBSCRIBE_TYPE_NORMAL));
         break;
 
     case STATE_DATA_LOAD:
@@ -855,7 +910,7 @@ int tuya_iot_yield(tuya_iot_client_t *client)
             client->status = TUYA_STATUS_WIFI_CONNECTED;
             client->nextstate = client->is_activated ? STATE_ENDPOINT_GET : STATE_ENDPOINT_UPDATE;
         } else {
-            tal_system_sleep(1000);
+            tuya_iot_wait(client, 1000);
         }
         break;
 
@@ -873,7 +928,7 @@ int tuya_iot_yield(tuya_iot_client_t *client)
     case STATE_ENDPOINT_UPDATE:
         rt = tuya_endpoint_update();
         if (rt != OPRT_OK) {
-            tal_system_sleep(1000);
+            tuya_iot_wait(client, 1000);
             break;
         }
         if (client->is_activated) {
@@ -891,7 +946,7 @@ int tuya_iot_yield(tuya_iot_client_t *client)
     case STATE_ACTIVATING:
         rt = client_activate_process(client, client->binding->token);
         if (rt != OPRT_OK) {
-            tal_system_sleep(1000);
+            tuya_iot_wait(client, 1000);
             break;
         }
 
@@ -963,7 +1018,7 @@ int tuya_iot_yield(tuya_iot_client_t *client)
             client->status = TUYA_STATUS_WIFI_CONNECTED;
             client->nextstate = STATE_MQTT_CONNECT_START;
         } else {
-            tal_system_sleep(1000);
+            tuya_iot_wait(client, 1000);
         }
         break;
 
@@ -980,6 +1035,7 @@ int tuya_iot_yield(tuya_iot_client_t *client)
     case STATE_STOP:
         tuya_mqtt_stop(&client->mqctx);
         tuya_mqtt_destory(&client->mqctx);
+        http_client_pool_flush();
         client->nextstate = STATE_IDLE;
         break;
 
@@ -1025,9 +1081,11 @@ int tuya_iot_activated_data_remove(tuya_iot_client_t *client)
 
     /* Clean client local data */
     dp_schema_delete(client->activate.devid);
+    tal_kv_batch_begin();
     tal_kv_del((const char *)(client->activate.schemaId));
     tal_kv_del((const char *)(client->config.storage_namespace));
     tuya_endpoint_remove();
+    tal_kv_batch_commit();
     client->is_activated = false;
     PR_INFO("Activated data remove successed");
 
@@ -225,6 +225,7 @@ struct tuya_iot_client_handle {
     tuya_token_get_t token_get;
     tuya_binding_info_t *binding;
     TIMER_ID check_upgrade_timer;
+    SEM_HANDLE wakeup; // ends the waits of tuya_iot_yield
     uint8_t status;
     uint8_t state;
     uint8_t nextstate;
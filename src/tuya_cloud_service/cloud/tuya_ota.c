@@ -21,6 +21,30 @@
 #include "iotdns.h"
 #include "mix_method.h"
 
+#if defined(ENABLE_OTA_RESUME) && (ENABLE_OTA_RESUME == 1)
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "tuya_tls_config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+#include "mbedtls/sha256.h"
+
+#if defined(MBEDTLS_SHA256_ALT)
+#error "ENABLE_OTA_RESUME saves the sha256 state, it needs the software sha256"
+#endif
+
+#define OTA_RESUME_KEY "ota_resume"
+
+/* saved in kv, the sha256 state covers the image up to offset */
+typedef struct {
+    char fw_md5[SW_MD5_LEN + 1];
+    uint8_t channel;
+    uint32_t file_size;
+    uint32_t offset;
+    mbedtls_sha256_context sha256;
+} tuya_ota_resume_t;
+#endif
+
 typedef struct {
     tuya_ota_config_t config;
     tuya_ota_msg_t msg;
@@ -28,7 +52,12 @@ typedef struct {
     uint8_t channel;
     uint8_t progress_percent;
     THREAD_HANDLE upgrade_thrd;
+#if defined(ENABLE_OTA_RESUME) && (ENABLE_OTA_RESUME == 1)
+    tuya_ota_resume_t resume;
+    uint32_t resume_saved; // offset of the last save
+#else
     TKL_HASH_HANDLE sha256;
+#endif
 } tuya_ota_t;
 
 int tuya_ota_upgrade_status_report(tuya_ota_t *handle, int status);
@@ -36,6 +65,97 @@ int tuya_ota_upgrade_progress_report(tuya_ota_t *handle, int percent);
 
 static tuya_ota_t *s_ota_ctx;
 
+#if defined(ENABLE_OTA_RESUME) && (ENABLE_OTA_RESUME == 1)
+/*
+ * Only the channels written by the ota event callback resume. The tkl ota
+ * port has no resume: tal_ota_start_notify must come before the data, and the
+ * data handed to tal_ota_data_process may still be buffered in the port, so
+ * the main firmware always starts from the beginning.
+ */
+static void __ota_resume_load(tuya_ota_t *ota)
+{
+    uint8_t *value = NULL;
+    size_t length = 0;
+
+    memset(&ota->resume, 0, sizeof(tuya_ota_resume_t));
+    if (OPRT_OK == tal_kv_get(OTA_RESUME_KEY, &value, &length)) {
+        if (length == sizeof(tuya_ota_resume_t)) {
+            memcpy(&ota->resume, value, sizeof(tuya_ota_resume_t));
+        }
+        tal_kv_free(value);
+    }
+    if (ota->resume.offset && (0 == ota->channel || 0 != strcmp(ota->resume.fw_md5, ota->msg.fw_md5) ||
+                               ota->resume.channel != ota->channel || ota->resume.file_size != ota->msg.file_size ||
+                               ota->resume.offset >= ota->resume.file_size)) {
+        PR_DEBUG("ota resume record of another firmware dropped");
+        memset(&ota->resume, 0, sizeof(tuya_ota_resume_t));
+        tal_kv_del(OTA_RESUME_KEY);
+    }
+    if (ota->resume.offset) {
+        PR_INFO("ota resume at %d of %d", ota->resume.offset, ota->resume.file_size);
+    }
+    ota->resume_saved = ota->resume.offset;
+}
+
+/* the event callback has written the data of an event when it returns */
+static void __ota_resume_save(tuya_ota_t *ota)
+{
+    if (0 == ota->channel || 0 == ota->resume.offset || ota->resume.offset == ota->resume_saved) {
+        return;
+    }
+    strcpy(ota->resume.fw_md5, ota->msg.fw_md5);
+    ota->resume.channel = ota->channel;
+    ota->resume.file_size = ota->msg.file_size;
+    if (OPRT_OK == tal_kv_set(OTA_RESUME_KEY, (const uint8_t *)&ota->resume, sizeof(tuya_ota_resume_t))) {
+        ota->resume_saved = ota->resume.offset;
+    }
+}
+
+static void __ota_hash_start(tuya_ota_t *ota)
+{
+    /* a resumed download goes on with the loaded state */
+    if (0 == ota->resume.offset) {
+        mbedtls_sha256_init(&ota->resume.sha256);
+        mbedtls_sha256_starts(&ota->resume.sha256, 0);
+    }
+}
+
+static void __ota_hash_update(tuya_ota_t *ota, const uint8_t *data, size_t len, size_t offset)
+{
+    mbedtls_sha256_update(&ota->resume.sha256, data, len);
+    ota->resume.offset = offset + len;
+    if (ota->resume.offset - ota->resume_saved >= OTA_RESUME_SAVE_SIZE) {
+        __ota_resume_save(ota);
+    }
+}
+
+static void __ota_hash_finish(tuya_ota_t *ota, uint8_t output[32])
+{
+    mbedtls_sha256_finish(&ota->resume.sha256, output);
+    mbedtls_sha256_free(&ota->resume.sha256);
+    memset(&ota->resume, 0, sizeof(tuya_ota_resume_t));
+    ota->resume_saved = 0;
+    tal_kv_del(OTA_RESUME_KEY);
+}
+#else
+static void __ota_hash_start(tuya_ota_t *ota)
+{
+    tal_sha256_create_init(&ota->sha256);
+    tal_sha256_starts_ret(ota->sha256, 0);
+}
+
+static void __ota_hash_update(tuya_ota_t *ota, const uint8_t *data, size_t len, size_t offset)
+{
+    tal_sha256_update_ret(ota->sha256, data, len);
+}
+
+static void __ota_hash_finish(tuya_ota_t *ota, uint8_t output[32])
+{
+    tal_sha256_finish_ret(ota->sha256, output);
+    tal_sha256_free(ota->sha256);
+}
+#endif
+
 static void file_download_event_cb(http_download_event_id_t id, http_download_event_t *event)
 {
     tuya_ota_t *ota = (tuya_ota_t *)event->user_data;
@@ -49,8 +169,7 @@ static void file_download_event_cb(http_download_event_id_t id, http_download_ev
     case DL_EVENT_START:
         PR_DEBUG("DL_EVENT_START");
         tuya_ota_upgrade_status_report(ota, TUS_UPGRDING);
-        tal_sha256_create_init(&ota->sha256);
-        tal_sha256_starts_ret(ota->sha256, 0);
+        __ota_hash_start(ota);
         break;
 
     case DL_EVENT_ON_FILESIZE:
@@ -60,6 +179,9 @@ static void file_download_event_cb(http_download_event_id_t id, http_download_ev
         } else if (event_cb) {
             ota->event.id = TUYA_OTA_EVENT_START;
             ota->event.file_size = event->file_size;
+#if defined(ENABLE_OTA_RESUME) && (ENABLE_OTA_RESUME == 1)
+            ota->event.offset = ota->resume.offset; // not 0 for a resumed download, keep the data before it
+#endif
             ota->event.user_data = ota->config.user_data;
             event_cb(&ota->msg, &ota->event);
         }
@@ -77,11 +199,6 @@ static void file_download_event_cb(http_download_event_id_t id, http_download_ev
             ota_pack.len = event->data_len;
             ota_pack.pri_data = NULL;
             tal_ota_data_process(&ota_pack, (uint32_t *)&event->remain_len);
-            if (event->remain_len) {
-                tal_sha256_update_ret(ota->sha256, event->data, event->data_len - event->remain_len);
-            } else {
-                tal_sha256_update_ret(ota->sha256, event->data, event->data_len);
-            }
         } else if (event_cb) {
             ota->event.id = TUYA_OTA_EVENT_ON_DATA;
             ota->event.data = event->data;
@@ -89,6 +206,8 @@ static void file_download_event_cb(http_download_event_id_t id, http_download_ev
             ota->event.offset = event->offset;
             event_cb(&ota->msg, &ota->event);
         }
+        /* the image is hashed as it is written, no pass over the flash afterwards */
+        __ota_hash_update(ota, event->data, event->data_len - event->remain_len, event->offset);
         uint8_t percent = event->offset * 100 / event->file_size;
         if (percent - ota->progress_percent > 5) {
             PR_DEBUG("File Download Percent: %d%%", percent);
@@ -101,8 +220,7 @@ static void file_download_event_cb(http_download_event_id_t id, http_download_ev
     case DL_EVENT_FINISH:
         PR_DEBUG("DL_EVENT_FINISH");
         PR_DEBUG("File Download Percent: %d%%", 100);
-        tal_sha256_finish_ret(ota->sha256, file_hmac);
-        tal_sha256_free(ota->sha256);
+        __ota_hash_finish(ota, file_hmac);
         hex2str((uint8_t *)file_sha256, file_hmac, 32);
         tal_sha256_mac((const uint8_t *)client->activate.seckey, strlen(client->activate.seckey), file_sha256, 32 * 2,
                        file_hmac);
@@ -122,6 +240,9 @@ static void file_download_event_cb(http_download_event_id_t id, http_download_ev
 
     case DL_EVENT_FAULT:
         PR_DEBUG("DL_EVENT_FAULT");
+#if defined(ENABLE_OTA_RESUME) && (ENABLE_OTA_RESUME == 1)
+        __ota_resume_save(ota);
+#endif
         tuya_ota_upgrade_status_report(ota, TUS_UPGRD_EXEC);
         if (event_cb) {
             ota->event.id = TUYA_OTA_EVENT_FAULT;
@@ -170,6 +291,14 @@ static void ota_process_thread_func(void *arg)
     tuya_iotdns_query_domain_certs(ota->msg.fw_url, &cert, &cert_len);
 
     http_download_config_t download_cfg;
+    memset(&download_cfg, 0, sizeof(download_cfg));
+#if defined(ENABLE_OTA_RESUME) && (ENABLE_OTA_RESUME == 1)
+    __ota_resume_load(ota);
+    download_cfg.offset = ota->resume.offset;
+#endif
+#if defined(OTA_DOWNLOAD_WORKERS)
+    download_cfg.workers = OTA_DOWNLOAD_WORKERS;
+#endif
     download_cfg.file_size = ota->msg.file_size;
     download_cfg.range_length = ota->config.range_size;
     download_cfg.timeout_ms = ota->config.timeout_ms;
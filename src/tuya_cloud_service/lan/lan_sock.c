@@ -6,11 +6,12 @@
  * The mechanism is designed to manage multiple socket readers, handle socket
  * events efficiently, and provide a clean shutdown process.
  *
- * The implementation utilizes a select-based approach to monitor and react to
- * socket events across multiple sockets. It supports operations such as adding
- * a new socket reader, updating existing readers, and removing readers. Error
- * handling and socket event detection are integral parts of the loop to ensure
- * robust operation.
+ * The implementation keeps the registered sockets packed in an array of poll
+ * entries that lives as long as the loop, so each wait hands tal_net_poll the
+ * sockets in use without rebuilding fd sets, and only the ready entries are
+ * dispatched. It supports operations such as adding a new socket reader,
+ * updating existing readers, and removing readers. Error handling and socket
+ * event detection are integral parts of the loop to ensure robust operation.
  *
  * Additionally, the file includes utility functions for setting up the
  * environment for socket event handling, including initializing and
@@ -34,10 +35,12 @@
 
 #define LAN_UDP_READER_CNT 5
 typedef struct LAN_SLOOP_S {
-    int max_sock;
     THREAD_HANDLE thread;
-    int cnt;
-    sloop_sock_t *readers;
+    int cnt;                // readers in use, they are packed at the head
+    sloop_sock_t *readers;  // registered sockets
+    TAL_NET_POLL_T *polls;  // poll entry of each reader, same index
+    SYS_TIME_T pre_select_ms;
+    BOOL_T pre_select_now; // run the pre select handlers before the next wait
     BOOL_T terminate;
     QUEUE_HANDLE queue;
 } LAN_SLOOP_S, *P_LAN_SLOOP_S;
@@ -46,6 +49,9 @@ typedef struct LAN_SLOOP_S {
 static P_LAN_SLOOP_S g_sloop = NULL;
 #define LAN_QUEUE_NUM 6
 
+/* how long the loop waits for sockets, the pre select handlers run at this pace */
+#define LAN_SLOOP_TIMEOUT_MS 1000
+
 #ifndef STACK_SIZE_LAN
 #define STACK_SIZE_LAN (4 * 1024)
 #endif
@@ -55,28 +61,33 @@ static uint32_t __ty_sock_get_reader_num(void)
     return (LAN_UDP_READER_CNT + tuya_lan_get_client_num());
 }
 
-static void __sock_table_set_fds(TUYA_FD_SET_T *rfds, TUYA_FD_SET_T *efds)
+static void __sock_select_err_handle()
 {
     int idx;
-    for (idx = 0; idx < __ty_sock_get_reader_num(); idx++) {
-        if (g_sloop->readers[idx].sock >= 0) {
-            tal_net_fd_set(g_sloop->readers[idx].sock, rfds);
-            tal_net_fd_set(g_sloop->readers[idx].sock, efds);
+    for (idx = 0; idx < g_sloop->cnt; idx++) {
+        if (g_sloop->readers[idx].err) {
+            g_sloop->readers[idx].err(g_sloop->readers[idx].sock);
         }
     }
+    return;
 }
 
-static void __sock_select_err_handle()
+static void __sock_pre_select_handle(void)
 {
     int idx;
-    for (idx = 0; idx < __ty_sock_get_reader_num(); idx++) {
-        if (g_sloop->readers[idx].sock >= 0) {
-            if (g_sloop->readers[idx].err) {
-                g_sloop->readers[idx].err(g_sloop->readers[idx].sock);
-            }
+    SYS_TIME_T now = tal_system_get_millisecond();
+
+    if (!g_sloop->pre_select_now && now - g_sloop->pre_select_ms < LAN_SLOOP_TIMEOUT_MS) {
+        return;
+    }
+    g_sloop->pre_select_ms = now;
+    g_sloop->pre_select_now = FALSE;
+
+    for (idx = 0; idx < g_sloop->cnt; idx++) {
+        if (g_sloop->readers[idx].pre_select) {
+            g_sloop->readers[idx].pre_select();
         }
     }
-    return;
 }
 
 void __ty_sock_loop_deinit(void)
@@ -87,21 +98,18 @@ void __ty_sock_loop_deinit(void)
 
     uint8_t idx = 0;
     if (g_sloop->readers) {
-        for (idx = 0; idx < __ty_sock_get_reader_num(); idx++) {
-            if (g_sloop->readers[idx].sock != -1) {
-                PR_DEBUG("deinit lan sock %d and close it", g_sloop->readers[idx].sock);
-                tal_net_close(g_sloop->readers[idx].sock);
-                g_sloop->readers[idx].sock = -1;
-                g_sloop->readers[idx].pre_select = NULL;
-                g_sloop->readers[idx].read = NULL;
-                g_sloop->readers[idx].err = NULL;
-                g_sloop->readers[idx].quit = NULL;
-                g_sloop->cnt--;
-            }
+        for (idx = 0; idx < g_sloop->cnt; idx++) {
+            PR_DEBUG("deinit lan sock %d and close it", g_sloop->readers[idx].sock);
+            tal_net_close(g_sloop->readers[idx].sock);
         }
+        g_sloop->cnt = 0;
         tal_free(g_sloop->readers);
         g_sloop->readers = NULL;
     }
+    if (g_sloop->polls) {
+        tal_free(g_sloop->polls);
+        g_sloop->polls = NULL;
+    }
     if (g_sloop->queue) {
         tal_queue_free(g_sloop->queue);
     }
@@ -116,164 +124,128 @@ void __ty_sock_loop_deinit(void)
 
 void __ty_add_sock_reader(sloop_sock_t sock_info)
 {
-    if (sock_info.sock > g_sloop->max_sock) {
-        g_sloop->max_sock = sock_info.sock;
-    }
-
-    uint8_t idx = 0;
-    for (idx = 0; idx < __ty_sock_get_reader_num(); idx++) {
+    int idx = 0;
+    for (idx = 0; idx < g_sloop->cnt; idx++) {
         if ((sock_info.sock == g_sloop->readers[idx].sock) && (g_sloop->readers[idx].read == sock_info.read)) {
             PR_DEBUG("update lan sock %d,read:%p", sock_info.sock, sock_info.read);
-            memset(&g_sloop->readers[idx], 0, sizeof(sloop_sock_t));
             memcpy(&g_sloop->readers[idx], &sock_info, sizeof(sloop_sock_t));
-            break;
-        }
-    }
-
-    if (idx == __ty_sock_get_reader_num()) {
-        for (idx = 0; idx < __ty_sock_get_reader_num(); idx++) {
-            if (-1 == g_sloop->readers[idx].sock) {
-                PR_DEBUG("reg lan sock %d,read:%p", sock_info.sock, sock_info.read);
-                memset(&g_sloop->readers[idx], 0, sizeof(sloop_sock_t));
-                memcpy(&g_sloop->readers[idx], &sock_info, sizeof(sloop_sock_t));
-                g_sloop->cnt++;
-                break;
-            }
+            return;
         }
     }
 
-    if (idx == __ty_sock_get_reader_num()) {
+    if (g_sloop->cnt >= __ty_sock_get_reader_num()) {
         PR_ERR("out of range");
         return;
     }
 
+    PR_DEBUG("reg lan sock %d,read:%p", sock_info.sock, sock_info.read);
+    memcpy(&g_sloop->readers[g_sloop->cnt], &sock_info, sizeof(sloop_sock_t));
+    g_sloop->polls[g_sloop->cnt].fd = sock_info.sock;
+    g_sloop->polls[g_sloop->cnt].events = TAL_NET_POLLIN;
+    g_sloop->polls[g_sloop->cnt].revents = 0;
+    g_sloop->cnt++;
+
     return;
 }
 
 void __ty_del_sock_reader(int sock)
 {
-    uint8_t idx = 0;
-    for (idx = 0; idx < __ty_sock_get_reader_num(); idx++) {
+    int idx = 0;
+    for (idx = 0; idx < g_sloop->cnt; idx++) {
         if (g_sloop->readers[idx].sock == sock) {
-            PR_DEBUG("unreg lan sock %d and close it", sock);
-            tal_net_close(g_sloop->readers[idx].sock);
-            g_sloop->readers[idx].sock = -1;
-            // g_sloop->readers[idx].pre_select = NULL;
-            g_sloop->readers[idx].read = NULL;
-            g_sloop->readers[idx].err = NULL;
-            g_sloop->readers[idx].quit = NULL;
-            g_sloop->cnt--;
             break;
         }
     }
 
-    if (idx == __ty_sock_get_reader_num()) {
+    if (idx == g_sloop->cnt) {
         PR_ERR("unreg not found");
         return;
     }
 
+    PR_DEBUG("unreg lan sock %d and close it", sock);
+    tal_net_close(sock);
+    // keep the readers packed, the last one takes the free place
+    g_sloop->cnt--;
+    if (idx != g_sloop->cnt) {
+        memcpy(&g_sloop->readers[idx], &g_sloop->readers[g_sloop->cnt], sizeof(sloop_sock_t));
+        memcpy(&g_sloop->polls[idx], &g_sloop->polls[g_sloop->cnt], sizeof(TAL_NET_POLL_T));
+    }
+    memset(&g_sloop->readers[g_sloop->cnt], 0, sizeof(sloop_sock_t));
+    g_sloop->readers[g_sloop->cnt].sock = -1;
+    g_sloop->polls[g_sloop->cnt].fd = -1;
+
     return;
 }
 
-void tuya_sock_loop_run(void *data)
+static void __sock_queue_handle(uint32_t timeout)
 {
-    int actv_cnt = 0;
-    int idx = 0;
-    TUYA_FD_SET_T *rfds, *efds;
     sloop_sock_t queue_data = {0};
 
-    rfds = tal_malloc(sizeof(TUYA_FD_SET_T));
-    efds = tal_malloc(sizeof(TUYA_FD_SET_T));
-    if (rfds == NULL || efds == NULL) {
-        PR_ERR("malloc err");
-        goto Err;
+    // take every pending request, the sockets of a burst of connections are
+    // all watched by the next poll
+    while (OPRT_OK == tal_queue_fetch(g_sloop->queue, &queue_data, timeout)) {
+        if (queue_data.read) {
+            __ty_add_sock_reader(queue_data);
+        } else {
+            __ty_del_sock_reader(queue_data.sock);
+        }
+        memset(&queue_data, 0, sizeof(sloop_sock_t));
+        timeout = 0;
     }
-    memset(rfds, 0, sizeof(TUYA_FD_SET_T));
-    memset(efds, 0, sizeof(TUYA_FD_SET_T));
+}
+
+void tuya_sock_loop_run(void *data)
+{
+    int actv_cnt = 0;
+    int idx = 0;
+    TAL_NET_POLL_T *entry = NULL;
 
     // while (tuya_get_sock_loop_terminate() &&
     // tal_thread_get_state(g_sloop->thread) == THREAD_STATE_RUNNING) {
     while (tuya_get_sock_loop_terminate()) {
-        memset(&queue_data, 0, sizeof(sloop_sock_t));
-        if (tal_queue_fetch(g_sloop->queue, &queue_data, 0) == 0) {
-            if (queue_data.read) {
-                __ty_add_sock_reader(queue_data);
-            } else {
-                __ty_del_sock_reader(queue_data.sock);
-            }
-        }
-        for (idx = 0; idx < __ty_sock_get_reader_num(); idx++) {
-            if (g_sloop->readers[idx].pre_select) {
-                g_sloop->readers[idx].pre_select();
-            }
-        }
+        // the sockets the handlers unregister are gone before the poll
+        __sock_pre_select_handle();
+        // with no socket to watch, wait for one to be registered
+        __sock_queue_handle((0 == g_sloop->cnt) ? LAN_SLOOP_TIMEOUT_MS : 0);
         if (g_sloop->cnt == 0) {
-            tal_system_sleep(2000);
             continue;
         }
 
-        tal_net_fd_zero(rfds);
-        tal_net_fd_zero(efds);
-        __sock_table_set_fds(rfds, efds);
-        actv_cnt = tal_net_select(g_sloop->max_sock + 1, rfds, NULL, efds, 1 * 1000);
+        actv_cnt = tal_net_poll(g_sloop->polls, g_sloop->cnt, LAN_SLOOP_TIMEOUT_MS);
         if (actv_cnt < 0) {
             PR_ERR("errno:%d", tal_net_get_errno());
             __sock_select_err_handle();
             tal_system_sleep(1000);
             continue;
-        } else if (actv_cnt == 0) {
-            continue;
-        } else {
-            for (idx = 0; idx < __ty_sock_get_reader_num(); idx++) {
-                if (g_sloop->readers[idx].sock >= 0) {
-                    if (0 == tal_net_fd_isset(g_sloop->readers[idx].sock, efds)) {
-                        continue;
-                    }
-                    if (g_sloop->readers[idx].err) {
-                        PR_ERR("socket err:%d, sock:%d, idx:%d", tal_net_get_errno(), g_sloop->readers[idx].sock, idx);
-                        g_sloop->readers[idx].err(g_sloop->readers[idx].sock);
-                    }
-                    actv_cnt--;
-                    if (0 == actv_cnt) {
-                        break;
-                    }
-                }
-            }
-        }
-
-        if (0 == actv_cnt) {
-            continue;
         }
 
-        for (idx = 0; idx < __ty_sock_get_reader_num(); idx++) {
-            if (g_sloop->readers[idx].sock >= 0) {
-                if (tal_net_fd_isset(g_sloop->readers[idx].sock, rfds)) {
-                    if (g_sloop->readers[idx].read) {
-                        g_sloop->readers[idx].read(g_sloop->readers[idx].sock);
-                        actv_cnt--;
-                        if (0 == actv_cnt) {
-                            break;
-                        }
-                    }
+        // the handlers only post unregister requests, the readers do not move
+        // until the next __sock_queue_handle
+        for (idx = 0; idx < g_sloop->cnt && actv_cnt > 0; idx++) {
+            entry = &g_sloop->polls[idx];
+            if (0 == entry->revents) {
+                continue;
+            }
+            actv_cnt--;
+            if (entry->revents & TAL_NET_POLLERR) {
+                if (g_sloop->readers[idx].err) {
+                    PR_ERR("socket err:%d, sock:%d, idx:%d", tal_net_get_errno(), entry->fd, idx);
+                    g_sloop->readers[idx].err(entry->fd);
                 }
+                continue;
+            }
+            if ((entry->revents & TAL_NET_POLLIN) && g_sloop->readers[idx].read) {
+                g_sloop->readers[idx].read(entry->fd);
             }
         }
     }
 
-    for (idx = 0; idx < __ty_sock_get_reader_num(); idx++) {
+    for (idx = 0; idx < g_sloop->cnt; idx++) {
         if (g_sloop->readers[idx].quit) {
             g_sloop->readers[idx].quit();
         }
     }
 
-Err:
-    if (rfds) {
-        tal_free(rfds);
-    }
-    if (efds) {
-        tal_free(efds);
-    }
-
     tuya_lan_exit();
     __ty_sock_loop_deinit();
 
@@ -315,13 +287,18 @@ OPERATE_RET tuya_sock_loop_init(void)
 
     uint32_t readers_len = __ty_sock_get_reader_num() * sizeof(sloop_sock_t);
     g_sloop->readers = tal_malloc(readers_len);
-    if (NULL == g_sloop->readers) {
+    g_sloop->polls = tal_malloc(__ty_sock_get_reader_num() * sizeof(TAL_NET_POLL_T));
+    if (NULL == g_sloop->readers || NULL == g_sloop->polls) {
         PR_ERR("tal_malloc err");
+        op_ret = OPRT_MALLOC_FAILED;
         goto Err;
     }
     memset(g_sloop->readers, 0, readers_len);
     for (idx = 0; idx < __ty_sock_get_reader_num(); idx++) {
         g_sloop->readers[idx].sock = -1;
+        g_sloop->polls[idx].fd = -1;
+        g_sloop->polls[idx].events = 0;
+        g_sloop->polls[idx].revents = 0;
     }
     THREAD_CFG_T thread_cfg = {.priority = THREAD_PRIO_2, .stackDepth = STACK_SIZE_LAN, .thrdname = "lan_sock_loop"};
 
@@ -389,6 +366,21 @@ OPERATE_RET tuya_unreg_lan_sock(int sock)
     return OPRT_OK;
 }
 
+/**
+ * @brief Runs the pre select handlers before the next wait of the loop.
+ *
+ * A faulted socket stays readable until its handler unregisters it, the loop
+ * would poll it again at once until the handlers run at their usual pace.
+ */
+void tuya_sock_loop_pre_select_now(void)
+{
+    if (NULL == g_sloop) {
+        return;
+    }
+
+    g_sloop->pre_select_now = TRUE;
+}
+
 /**
  * @brief Disables the socket loop for Tuya Cloud service.
  *
@@ -438,8 +430,7 @@ void tuya_dump_lan_sock_reader(void)
     PR_DEBUG("support readers:%d", __ty_sock_get_reader_num());
     PR_DEBUG("sock cnt:%d", g_sloop->cnt);
     PR_DEBUG("terminate:%d", g_sloop->terminate);
-    PR_DEBUG("max_sock:%d", g_sloop->max_sock);
-    for (idx = 0; idx < __ty_sock_get_reader_num(); idx++) {
+    for (idx = 0; idx < g_sloop->cnt; idx++) {
         if (g_sloop->readers[idx].read) {
             PR_DEBUG("***** sock:%d *****", g_sloop->readers[idx].sock);
             PR_DEBUG("read:%p", g_sloop->readers[idx].read);
@@ -91,6 +91,14 @@ OPERATE_RET tuya_reg_lan_sock(sloop_sock_t sock_info);
  */
 OPERATE_RET tuya_unreg_lan_sock(int sock);
 
+/**
+ * @brief run the pre select handlers before the next wait
+ *
+ * @note called when a socket faults, its handler closes it before it is
+ * polled again
+ */
+void tuya_sock_loop_pre_select_now(void);
+
 /**
  * @brief set sock loop disable
  *
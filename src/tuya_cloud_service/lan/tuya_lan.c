@@ -57,6 +57,11 @@ typedef struct {
     uint8_t randB[RAND_LEN];
     uint8_t hmac[HMAC_LEN];
     uint8_t secret_key[SESSIONKEY_LEN];
+    // receive buffer, kept from one session to the next, keep it last !!!
+    uint8_t *rx_buf;
+    uint32_t rx_size;
+    uint32_t rx_start; // first byte not handled
+    uint32_t rx_end;   // end of the received data
 } lan_session_t;
 
 typedef struct {
@@ -93,7 +98,6 @@ typedef struct {
     tuya_iot_client_t *iot_client;
     lan_cfg_t *cfg;
     // extension
-    uint32_t recv_offset;
     uint8_t recv_buf[0]; // keep it last !!!
 } lan_mgr_t;
 
@@ -113,8 +117,43 @@ static lan_mgr_t *lan_mgr_get(void)
 
 static void lan_session_free(lan_session_t *session)
 {
-    memset(session, 0, sizeof(lan_session_t));
+    memset(session, 0, offsetof(lan_session_t, rx_buf));
     session->fd = -1;
+    session->rx_start = 0;
+    session->rx_end = 0;
+}
+
+static OPERATE_RET lan_session_rx_reserve(lan_session_t *session, uint32_t size)
+{
+    uint8_t *rx_buf = NULL;
+    uint32_t pending = session->rx_end - session->rx_start;
+
+    // room for size bytes from the first byte not handled, and for a byte more
+    if (size <= pending) {
+        size = pending + 1;
+    }
+    if (session->rx_buf && session->rx_start + size <= session->rx_size) {
+        return OPRT_OK;
+    }
+
+    if (session->rx_buf && size <= session->rx_size) {
+        memmove(session->rx_buf, session->rx_buf + session->rx_start, pending);
+    } else {
+        rx_buf = tal_malloc(size);
+        if (NULL == rx_buf) {
+            return OPRT_MALLOC_FAILED;
+        }
+        if (pending) {
+            memcpy(rx_buf, session->rx_buf + session->rx_start, pending);
+        }
+        tal_free(session->rx_buf);
+        session->rx_buf = rx_buf;
+        session->rx_size = size;
+    }
+    session->rx_start = 0;
+    session->rx_end = pending;
+
+    return OPRT_OK;
 }
 
 static void lan_session_close(lan_session_t *session)
@@ -182,6 +221,8 @@ static void lan_session_fault_set(lan_session_t *session)
     }
     PR_DEBUG("set socket fault %d", session->fd);
     session->fault = true;
+    // lan_session_time_check closes it before the socket is polled again
+    tuya_sock_loop_pre_select_now();
 }
 
 static void lan_session_close_all(void)
@@ -845,11 +886,94 @@ static void lan_tcp_client_sock_err(int fd)
     return;
 }
 
-static void lan_tcp_client_sock_read(int32_t fd)
+static BOOL_T lan_tcp_client_frame_process(lan_mgr_t *lan, lan_session_t *session, const uint8_t *frame_buffer,
+                                           uint32_t frame_len)
 {
     int ret = 0;
+    int fd = session->fd;
+    lpv35_fixed_head_t *fixed_head = (lpv35_fixed_head_t *)(frame_buffer + LPV35_FRAME_HEAD_SIZE);
+
+    // verify sequence
+    uint32_t fr_sequence = UNI_NTOHL(fixed_head->sequence);
+    if (fr_sequence <= session->sequence_in) {
+        PR_ERR("fd:%d, sequence error in:%d, pre:%d", session->fd, fr_sequence, session->sequence_in);
+        PR_ERR("threshold:%d", lan->cfg->sequence_err_threshold);
+        if ((session->sequence_in - fr_sequence) >= lan->cfg->sequence_err_threshold) {
+            lan_session_close(session);
+            return FALSE;
+        }
+        return TRUE;
+    }
+    PR_TRACE("fr_num in:%u, pre:%u", fr_sequence, session->sequence_in);
+    session->sequence_in = fr_sequence;
+
+    uint32_t fr_type = UNI_NTOHL(fixed_head->type);
+    uint8_t *key = NULL;
+
+    //! TODO:
+    if (lan->iot_client->is_activated) {
+        if (fr_type == FRM_SECURITY_TYPE3 || fr_type == FRM_SECURITY_TYPE4 || fr_type == FRM_SECURITY_TYPE5) {
+            lan->cfg->allow_no_session_key_num = ALLOW_NO_KEY_NUM;
+            if (session->secret_key[0]) {
+                PR_WARN("already have the session_key, reset session..");
+                lan_session_close(session);
+                return FALSE;
+            }
+            key = (uint8_t *)lan->iot_client->activate.localkey;
+        } else {
+            if (0 == session->secret_key[0]) {
+                // fr_type come first than TYPE3,4,5, wait some packets
+                // before close(used in pressure test)
+                if (lan->cfg->allow_no_session_key_num > 0) {
+                    PR_ERR("allow no seesion key %d", lan->cfg->allow_no_session_key_num);
+                    lan->cfg->allow_no_session_key_num--;
+                    return TRUE;
+                }
+                PR_ERR("ERROR, no session_key");
+                lan_session_close(session);
+                lan->cfg->allow_no_session_key_num = ALLOW_NO_KEY_NUM;
+                return FALSE;
+            }
+            // PR_DEBUG("use session_key");
+            key = (uint8_t *)session->secret_key;
+        }
+    } else {
+        //! TODO:
+        lan_session_close(session);
+        return FALSE;
+    }
+
+    // Heartbeat packet has no data content and responds directly
+    if (FRM_TP_HB == fr_type) {
+        ret = lan_send(session, 0, FRM_TP_HB, 0, NULL, 0, false);
+        PR_TRACE("lan heart beat:%d", ret);
+        lan_session_time_update(session, tal_time_get_posix());
+        return TRUE;
+    }
+    //! TODO:
+    lpv35_frame_object_t frame_out = {0};
+    ret = lpv35_frame_parse(key, SESSIONKEY_LEN, frame_buffer, frame_len, &frame_out);
+    if (ret != OPRT_OK) {
+        PR_ERR("lpv35_frame_parse fail:%d", ret);
+        return TRUE;
+    }
+    // update time
+    lan_session_time_update(session, tal_time_get_posix());
+    lan_protocol_process(lan, session, &frame_out);
+    if (frame_out.data) {
+        tal_free(frame_out.data);
+    }
+
+    // the command handlers may have closed the connections
+    return (session->active && session->fd == fd);
+}
+
+static void lan_tcp_client_sock_read(int32_t fd)
+{
+    int recv_datalen = 0;
+    uint32_t skip = 0, frame_len = 0;
+    BOOL_T complete = FALSE;
     uint8_t *frame_buffer = NULL;
-    uint8_t *tmp_recv_buf = NULL;
 
     lan_mgr_t *lan = lan_mgr_get();
     lan_session_t *session = lan_session_get_by_fd(fd);
@@ -858,143 +982,54 @@ static void lan_tcp_client_sock_read(int32_t fd)
         return;
     }
 
-    uint32_t offset = 0;
-    int recv_datalen = 0;
-
-    lan->recv_offset = 0;
+    // the partial frame of the last read stays at the head of the buffer
+    if (OPRT_OK != lan_session_rx_reserve(session, lan->cfg->bufsize)) {
+        PR_ERR("malloc error");
+        lan_session_fault_set(session);
+        return;
+    }
 
-recv_again:
-    recv_datalen = tal_net_recv(fd, lan->recv_buf + lan->recv_offset, lan->cfg->bufsize - lan->recv_offset);
+    // one read per readiness, the socket loop calls again while data is left
+    recv_datalen = tal_net_recv(fd, session->rx_buf + session->rx_end, session->rx_size - session->rx_end);
     if (recv_datalen <= 0) {
+        if (recv_datalen < 0 && (UNW_EAGAIN == tal_net_get_errno() || UNW_EINTR == tal_net_get_errno())) {
+            return;
+        }
         PR_ERR("net recv err fd:%d,errno:%d", fd, tal_net_get_errno());
         lan_session_fault_set(session);
         return;
     }
-    // recv data process
-    recv_datalen += lan->recv_offset;
-    if (recv_datalen < LPV35_FRAME_MINI_SIZE) {
-        PR_ERR("not enough data len:%d", recv_datalen);
-        return;
-    }
-
-    offset = 0;
-    frame_buffer = NULL;
-    tmp_recv_buf = NULL;
-    while (recv_datalen >= LPV35_FRAME_MINI_SIZE + offset) {
-        if (tmp_recv_buf) {
-            break;
-        }
-        if (memcmp(lan->recv_buf + offset, LPV35_FRAME_HEAD, LPV35_FRAME_HEAD_SIZE) != 0) {
-            offset++;
+    session->rx_end += recv_datalen;
+
+    // frames are parsed where they were received
+    while (session->rx_end > session->rx_start) {
+        frame_buffer = session->rx_buf + session->rx_start;
+        complete = lpv35_frame_decode(frame_buffer, session->rx_end - session->rx_start, &skip, &frame_len,
+                                      LAN_FRAME_MAX_LEN);
+        session->rx_start += skip;
+        frame_buffer += skip;
+        if (frame_len > LAN_FRAME_MAX_LEN) {
+            PR_ERR("lan data len is out of limit");
+            session->rx_start += LPV35_FRAME_HEAD_SIZE;
             continue;
         }
-        frame_buffer = lan->recv_buf + offset;
-        lpv35_fixed_head_t *fixed_head = (lpv35_fixed_head_t *)(frame_buffer + LPV35_FRAME_HEAD_SIZE);
-        // verify sequence
-        uint32_t fr_sequence = UNI_NTOHL(fixed_head->sequence);
-        if (fr_sequence <= session->sequence_in) {
-            PR_ERR("fd:%d, sequence error in:%d, pre:%d", session->fd, fr_sequence, session->sequence_in);
-            PR_ERR("threshold:%d", lan->cfg->sequence_err_threshold);
-            if ((session->sequence_in - fr_sequence) >= lan->cfg->sequence_err_threshold) {
-                lan_session_close(session);
-            }
-            break;
-        }
-        PR_TRACE("fr_num in:%u, pre:%u", fr_sequence, session->sequence_in);
-        session->sequence_in = fr_sequence;
-        // frame_len verify
-        uint32_t frame_len =
-            LPV35_FRAME_HEAD_SIZE + sizeof(lpv35_fixed_head_t) + UNI_NTOHL(fixed_head->length) + LPV35_FRAME_TAIL_SIZE;
-        if (frame_len > (recv_datalen - offset)) { // recv data not enough buf
-            if (frame_len >= LAN_FRAME_MAX_LEN) {
-                PR_ERR("lan data len is out of limit");
-                break;
-            }
-            tmp_recv_buf = tal_malloc(frame_len + 1);
-            if (NULL == tmp_recv_buf) {
+        if (!complete) {
+            // make room for the whole frame, it is read by the next calls
+            if (frame_len && OPRT_OK != lan_session_rx_reserve(session, frame_len)) {
                 PR_ERR("malloc error");
-                break;
-            }
-            memset(tmp_recv_buf, 0, frame_len + 1);
-            memcpy(tmp_recv_buf, lan->recv_buf + offset, recv_datalen - offset);
-            recv_datalen = recv_datalen - offset;
-            offset = 0;
-            ret = tal_net_recv_nd_size(session->fd, tmp_recv_buf + recv_datalen, frame_len + 1 - recv_datalen,
-                                       frame_len - recv_datalen);
-            if (ret < 0) {
-                PR_ERR("tuya_hal_net_recv_nd_size error ret:%d", ret);
-                break;
-            }
-            frame_buffer = tmp_recv_buf;
-        }
-
-        uint32_t fr_type = UNI_NTOHL(fixed_head->type);
-        uint8_t *key = NULL;
-
-        //! TODO:
-        if (lan->iot_client->is_activated) {
-            if (fr_type == FRM_SECURITY_TYPE3 || fr_type == FRM_SECURITY_TYPE4 || fr_type == FRM_SECURITY_TYPE5) {
-                lan->cfg->allow_no_session_key_num = ALLOW_NO_KEY_NUM;
-                if (session->secret_key[0]) {
-                    PR_WARN("already have the session_key, reset session..");
-                    lan_session_close(session);
-                    break;
-                }
-                key = (uint8_t *)lan->iot_client->activate.localkey;
-            } else {
-                if (0 == session->secret_key[0]) {
-                    // fr_type come first than TYPE3,4,5, wait some packets
-                    // before close(used in pressure test)
-                    if (lan->cfg->allow_no_session_key_num > 0) {
-                        PR_ERR("allow no seesion key %d", lan->cfg->allow_no_session_key_num);
-                        lan->cfg->allow_no_session_key_num--;
-                    } else {
-                        PR_ERR("ERROR, no session_key");
-                        lan_session_close(session);
-                        lan->cfg->allow_no_session_key_num = ALLOW_NO_KEY_NUM;
-                    }
-                    break;
-                }
-                // PR_DEBUG("use session_key");
-                key = (uint8_t *)session->secret_key;
+                lan_session_fault_set(session);
             }
-        } else {
-            //! TODO:
-            lan_session_close(session);
             break;
         }
-
-        // Heartbeat packet has no data content and responds directly
-        if (FRM_TP_HB == fr_type) {
-            ret = lan_send(session, 0, FRM_TP_HB, 0, NULL, 0, false);
-            PR_TRACE("lan heart beat:%d", ret);
-            offset += frame_len;
-            lan_session_time_update(session, tal_time_get_posix());
-            continue;
-        }
-        //! TODO:
-        lpv35_frame_object_t frame_out = {0};
-        ret = lpv35_frame_parse(key, SESSIONKEY_LEN, frame_buffer, frame_len, &frame_out);
-        if (ret != OPRT_OK) {
-            PR_ERR("lpv35_frame_parse fail:%d", ret);
-            break;
-        }
-        offset += frame_len;
-        // update time
-        lan_session_time_update(session, tal_time_get_posix());
-        lan_protocol_process(lan, session, &frame_out);
-        if (frame_out.data) {
-            tal_free(frame_out.data);
+        session->rx_start += frame_len;
+        if (!lan_tcp_client_frame_process(lan, session, frame_buffer, frame_len)) {
+            return;
         }
     }
 
-    if (tmp_recv_buf) {
-        tal_free(tmp_recv_buf);
-    } else if (recv_datalen != offset) {
-        PR_DEBUG("recv_datalen:%d, offset:%d", recv_datalen, offset);
-        memmove(lan->recv_buf, lan->recv_buf + offset, recv_datalen - offset);
-        lan->recv_offset = recv_datalen - offset;
-        goto recv_again;
+    if (session->rx_start == session->rx_end) {
+        session->rx_start = 0;
+        session->rx_end = 0;
     }
 
     return;
@@ -1310,11 +1345,16 @@ __exit:
  */
 int tuya_lan_exit(void)
 {
+    int i;
+
     if (s_lan_mgr == NULL) {
         return OPRT_OK;
     }
     lan_session_close_all();
     if (s_lan_mgr->session) {
+        for (i = 0; i < s_lan_mgr->cfg->client_num; i++) {
+            tal_free(s_lan_mgr->session[i].rx_buf);
+        }
         tal_free(s_lan_mgr->session);
         s_lan_mgr->session = NULL;
     }
@@ -23,6 +23,7 @@
 #include "crc32i.h"
 #include "mix_method.h"
 #include "uni_random.h"
+#include "mbedtls/gcm.h"
 
 /***********************************************************
 *************************micro define***********************
@@ -51,6 +52,9 @@
 #define PV23_AD_DATA_LEN     (12)
 #define PV23_EXCEPT_DATA_LEN (PV23_AD_DATA_LEN + PV23_NONCE_LEN + PV23_TAG_LEN)
 
+// {"protocol":<uint32>,"t":<uint32>,"data":
+#define PACK_JSON_HEAD_MAX (12 + 10 + 5 + 10 + 8)
+
 /**
  * @brief Generates a serial number for the Tuya protocol packet.
  *
@@ -217,40 +221,58 @@ OPERATE_RET tuya_parse_protocol_data(const DP_CMD_TYPE_E cmd, uint8_t *data, con
     return op_ret;
 }
 
-static OPERATE_RET __pack_data_with_cmd_pv23(const DP_CMD_TYPE_E cmd, const char *pv, const char *src,
-                                             const uint32_t pro, const uint32_t num, const uint8_t *key,
-                                             uint8_t **pack_out, uint32_t *out_len)
+static uint32_t __pack_uint_put(char *buf, uint32_t value)
 {
-    OPERATE_RET op_ret = OPRT_OK;
-    char *out = NULL;
-    int offset = 0;
+    char digit[10];
+    uint32_t n = sizeof(digit);
+
+    do {
+        digit[--n] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    memcpy(buf, digit + n, sizeof(digit) - n);
+    return sizeof(digit) - n;
+}
 
-    PR_TRACE("To:%d src:%s pro:%d num:%d", cmd, src, pro, num);
-    // make json data
-    int len = strlen(src) + 60;
-    out = tal_malloc(len);
-    if (NULL == out) {
-        PR_ERR("tal_malloc Fails %d", len);
-        return OPRT_MALLOC_FAILED;
-    }
+// {"protocol":<pro>,"t":<time>,"data":
+static uint32_t __pack_json_head_put(char *buf, const uint32_t pro)
+{
+    uint32_t offset = 0;
+
+    memcpy(buf + offset, "{\"protocol\":", 12);
+    offset += 12;
+    offset += __pack_uint_put(buf + offset, pro);
+    memcpy(buf + offset, ",\"t\":", 5);
+    offset += 5;
+    offset += __pack_uint_put(buf + offset, (uint32_t)tal_time_get_posix());
+    memcpy(buf + offset, ",\"data\":", 8);
+    offset += 8;
+    return offset;
+}
 
-    // offset += sprintf(out + offset, "{\"protocol\":%d,\"t\":%d,\"data\":%s", pro, (uint32_t)tal_time_get_posix(),
-    // src);
-    offset += sprintf(out + offset, "{\"protocol\":%" PRIu32 ",\"t\":%" PRIu32 ",\"data\":%s", pro,
-                      (uint32_t)tal_time_get_posix(), src);
+static void __pack_src_write(char *buf, void *arg)
+{
+    memcpy(buf, arg, strlen((const char *)arg));
+}
 
-    out[offset++] = '}';
-    out[offset] = 0;
+static OPERATE_RET __pack_data_with_cmd_pv23(const DP_CMD_TYPE_E cmd, const char *pv, tuya_pack_writer_t writer,
+                                             void *arg, const uint32_t data_len, const uint32_t pro,
+                                             const uint32_t num, const uint8_t *key, uint8_t **pack_out,
+                                             uint32_t *out_len)
+{
+    OPERATE_RET op_ret = OPRT_OK;
+    char head[PACK_JSON_HEAD_MAX];
+    uint32_t head_len = __pack_json_head_put(head, pro);
+    uint32_t plain_len = head_len + data_len + 1;
 
-    PR_TRACE("After Pack:%s offset:%d", out, offset);
+    PR_TRACE("To:%d len:%d pro:%d num:%d", cmd, data_len, pro, num);
 
-    // make pack data
-    uint8_t *buf = tal_malloc(offset + PV23_EXCEPT_DATA_LEN);
+    // make pack data, the json is written and encrypted in place
+    uint8_t *buf = tal_malloc(plain_len + PV23_EXCEPT_DATA_LEN);
     if (buf == NULL) {
-        tal_free(out);
+        PR_ERR("tal_malloc Fails %d", plain_len + PV23_EXCEPT_DATA_LEN);
         return OPRT_MALLOC_FAILED;
     }
-    memset(buf, 0, offset + PV23_EXCEPT_DATA_LEN);
 
     // make head data
     // version
@@ -270,73 +292,65 @@ static OPERATE_RET __pack_data_with_cmd_pv23(const DP_CMD_TYPE_E cmd, const char
     // nonce
     uni_random_string((char *)(buf + PV23_NONCE_OFFSET), PV23_NONCE_LEN);
 
+    // make json data
+    char *plain = (char *)(buf + PV23_DATA_OFFSET);
+    memcpy(plain, head, head_len);
+    writer(plain + head_len, arg);
+    plain[plain_len - 1] = '}';
+
+    PR_TRACE("After Pack:%.*s len:%d", plain_len, plain, plain_len);
+
     // AES GCM encrypt
-    size_t encrypt_olen = 0;
-    op_ret = mbedtls_cipher_auth_encrypt_wrapper(&(const cipher_params_t){.cipher_type = MBEDTLS_CIPHER_AES_128_GCM,
-                                                                          .key = (unsigned char *)key,
-                                                                          .key_len = 16,
-                                                                          .nonce = buf + PV23_NONCE_OFFSET,
-                                                                          .nonce_len = PV23_NONCE_LEN,
-                                                                          .ad = buf,
-                                                                          .ad_len = PV23_AD_DATA_LEN,
-                                                                          .data = (unsigned char *)out,
-                                                                          .data_len = strlen(out)},
-                                                 buf + PV23_DATA_OFFSET, &encrypt_olen, buf + PV23_DATA_OFFSET + offset,
-                                                 PV23_TAG_LEN);
-    tal_free(out);
+    mbedtls_gcm_context gcm;
+    mbedtls_gcm_init(&gcm);
+    op_ret = mbedtls_gcm_setkey(&gcm, MBEDTLS_CIPHER_ID_AES, key, 128);
+    if (op_ret == OPRT_OK) {
+        op_ret = mbedtls_gcm_crypt_and_tag(&gcm, MBEDTLS_GCM_ENCRYPT, plain_len, buf + PV23_NONCE_OFFSET,
+                                           PV23_NONCE_LEN, buf, PV23_AD_DATA_LEN, (uint8_t *)plain, (uint8_t *)plain,
+                                           PV23_TAG_LEN, (uint8_t *)plain + plain_len);
+    }
+    mbedtls_gcm_free(&gcm);
     if (op_ret != OPRT_OK) {
-        PR_ERR("mbedtls_cipher_auth_encrypt_wrapper:0x%x", -op_ret);
+        PR_ERR("mbedtls_gcm_crypt_and_tag:0x%x", -op_ret);
         tal_free(buf);
         return op_ret;
     }
 
     *pack_out = buf;
-    *out_len = PV23_EXCEPT_DATA_LEN + encrypt_olen;
+    *out_len = PV23_EXCEPT_DATA_LEN + plain_len;
 
     return OPRT_OK;
 }
 
-static OPERATE_RET __pack_data_with_cmd_lpv35(const DP_CMD_TYPE_E cmd, const char *pv, const char *src,
-                                              const uint32_t pro, const uint32_t num, const uint8_t *key,
-                                              uint8_t **pack_out, uint32_t *out_len)
+static OPERATE_RET __pack_data_with_cmd_lpv35(const DP_CMD_TYPE_E cmd, const char *pv, tuya_pack_writer_t writer,
+                                              void *arg, const uint32_t data_len, const uint32_t pro,
+                                              const uint32_t num, const uint8_t *key, uint8_t **pack_out,
+                                              uint32_t *out_len)
 {
-    char *out = NULL;
-    int offset = 0;
-
-    PR_TRACE("To:%d src:%s pro:%d num:%d", cmd, src, pro, num);
-
-    // make json data
-    int len = strlen(src) + 60;
-    out = tal_malloc(len);
-    if (NULL == out) {
-        PR_ERR("tal_malloc Fails %d", len);
-        return OPRT_MALLOC_FAILED;
-    }
-
-    // offset += sprintf(out + offset, "{\"protocol\":%d,\"t\":%d,\"data\":%s", pro, (uint32_t)tal_time_get_posix(),
-    // src);
-    offset += sprintf(out + offset, "{\"protocol\":%" PRIu32 ",\"t\":%" PRIu32 ",\"data\":%s", pro,
-                      (uint32_t)tal_time_get_posix(), src);
-
-    out[offset++] = '}';
-    out[offset] = 0;
+    char head[PACK_JSON_HEAD_MAX];
+    uint32_t head_len = __pack_json_head_put(head, pro);
+    uint32_t plain_len = head_len + data_len + 1;
 
-    PR_TRACE("After Pack:%s offset:%d", out, offset);
+    PR_TRACE("To:%d len:%d pro:%d num:%d", cmd, data_len, pro, num);
 
     // make pack data
-    uint8_t *buf = tal_malloc(DATA_OFFSET_22_32 + offset + 16);
+    uint8_t *buf = tal_malloc(DATA_OFFSET_22_32 + plain_len + 16);
     if (buf == NULL) {
-        tal_free(out);
+        PR_ERR("tal_malloc Fails %d", DATA_OFFSET_22_32 + plain_len + 16);
         return OPRT_MALLOC_FAILED;
     }
-    memset(buf, 0, DATA_OFFSET_22_32 + offset + 16);
+    memset(buf, 0, DATA_OFFSET_22_32 + plain_len + 16);
 
     // not aes data
-    memcpy(buf + DATA_OFFSET_22_32, out, offset);
-    tal_free(out);
+    char *plain = (char *)(buf + DATA_OFFSET_22_32);
+    memcpy(plain, head, head_len);
+    writer(plain + head_len, arg);
+    plain[plain_len - 1] = '}';
+
+    PR_TRACE("After Pack:%.*s len:%d", plain_len, plain, plain_len);
 
     *pack_out = buf;
-    *out_len = (DATA_OFFSET_22_32 + offset);
+    *out_len = (DATA_OFFSET_22_32 + plain_len);
 
     // make head data
     memcpy(buf + PV_OFFSET_22_32, pv, PV_LEN_22_32);
@@ -354,13 +368,15 @@ static OPERATE_RET __pack_data_with_cmd_lpv35(const DP_CMD_TYPE_E cmd, const cha
 }
 
 /**
- * @brief Packs the protocol data for Tuya Cloud service.
+ * @brief Packs protocol data produced by a writer for Tuya Cloud service.
  *
- * This function takes the command type, source data, protocol version,
- * encryption key, and outputs the packed protocol data.
+ * The protocol envelope is sized from data_len and the writer fills the data
+ * in the packet buffer, so the packet is built with a single allocation.
  *
  * @param cmd The command type.
- * @param src The source data to be packed.
+ * @param writer Writes exactly data_len bytes of JSON data.
+ * @param arg The writer argument.
+ * @param data_len The length of the data the writer produces.
  * @param pro The protocol version.
  * @param key The encryption key.
  * @param out Pointer to the output packed data.
@@ -370,10 +386,11 @@ static OPERATE_RET __pack_data_with_cmd_lpv35(const DP_CMD_TYPE_E cmd, const cha
  *     - OPRT_OK: Operation successful.
  *     - Other error codes: Operation failed.
  */
-OPERATE_RET tuya_pack_protocol_data(const DP_CMD_TYPE_E cmd, const char *src, const uint32_t pro, uint8_t *key,
-                                    char **out, uint32_t *out_len)
+OPERATE_RET tuya_pack_protocol_data_with_writer(const DP_CMD_TYPE_E cmd, tuya_pack_writer_t writer, void *arg,
+                                                const uint32_t data_len, const uint32_t pro, uint8_t *key,
+                                                char **out, uint32_t *out_len)
 {
-    if ((NULL == src) || NULL == out) {
+    if ((NULL == writer) || NULL == out) {
         PR_ERR("Invalid Param");
         return OPRT_INVALID_PARM;
     }
@@ -392,7 +409,8 @@ OPERATE_RET tuya_pack_protocol_data(const DP_CMD_TYPE_E cmd, const char *src, co
     if (DP_CMD_LAN == cmd) {
         if (0 == strcmp(pv, "3.5")) {
             PR_TRACE("Data To LAN AND V=3.5");
-            op_ret = __pack_data_with_cmd_lpv35(cmd, pv, src, pro, num, (uint8_t *)key, (uint8_t **)out, out_len);
+            op_ret = __pack_data_with_cmd_lpv35(cmd, pv, writer, arg, data_len, pro, num, (uint8_t *)key,
+                                                (uint8_t **)out, out_len);
         } else {
             PR_ERR("Data To LAN But No Match Parse %s", pv);
             return OPRT_COM_ERROR;
@@ -400,7 +418,8 @@ OPERATE_RET tuya_pack_protocol_data(const DP_CMD_TYPE_E cmd, const char *src, co
     } else if (DP_CMD_MQ == cmd) {
         if (0 == strcmp(pv, "2.3")) {
             PR_TRACE("Data To MQTT AND V=2.3");
-            op_ret = __pack_data_with_cmd_pv23(cmd, pv, src, pro, num, key, (uint8_t **)out, out_len);
+            op_ret = __pack_data_with_cmd_pv23(cmd, pv, writer, arg, data_len, pro, num, key, (uint8_t **)out,
+                                               out_len);
         } else {
             PR_ERR("Data To MQTT But No Match Parse %s", pv);
             return OPRT_COM_ERROR;
@@ -413,6 +432,35 @@ OPERATE_RET tuya_pack_protocol_data(const DP_CMD_TYPE_E cmd, const char *src, co
     return op_ret;
 }
 
+/**
+ * @brief Packs the protocol data for Tuya Cloud service.
+ *
+ * This function takes the command type, source data, protocol version,
+ * encryption key, and outputs the packed protocol data.
+ *
+ * @param cmd The command type.
+ * @param src The source data to be packed.
+ * @param pro The protocol version.
+ * @param key The encryption key.
+ * @param out Pointer to the output packed data.
+ * @param out_len Pointer to the length of the output packed data.
+ *
+ * @return The operation result status.
+ *     - OPRT_OK: Operation successful.
+ *     - Other error codes: Operation failed.
+ */
+OPERATE_RET tuya_pack_protocol_data(const DP_CMD_TYPE_E cmd, const char *src, const uint32_t pro, uint8_t *key,
+                                    char **out, uint32_t *out_len)
+{
+    if ((NULL == src) || NULL == out) {
+        PR_ERR("Invalid Param");
+        return OPRT_INVALID_PARM;
+    }
+
+    return tuya_pack_protocol_data_with_writer(cmd, __pack_src_write, (void *)src, strlen(src), pro, key, out,
+                                               out_len);
+}
+
 /**
  * @brief Retrieves the size of the frame buffer for LPV35 frame objects.
  *
@@ -428,6 +476,58 @@ int lpv35_frame_buffer_size_get(lpv35_frame_object_t *frame_obj)
             LPV35_FRAME_TAG_SIZE + LPV35_FRAME_TAIL_SIZE);
 }
 
+/**
+ * @brief Finds the next LPV35 frame in a stream of received data.
+ *
+ * Bytes that cannot start a frame head are skipped by jumping from one 0x66
+ * byte to the next with memchr, the length of the frame is read from its head
+ * as soon as the head is received. The frame is not copied, it starts at
+ * data + *skip.
+ *
+ * @param data Received data.
+ * @param len Length of the data.
+ * @param skip Bytes before the frame, they do not belong to any frame.
+ * @param frame_len Length of the frame once its head is received, 0 before.
+ * A head announcing a frame longer than max_len gives max_len + 1.
+ * @param max_len Longest frame accepted.
+ * @return TRUE if the whole frame is in the data.
+ */
+BOOL_T lpv35_frame_decode(const uint8_t *data, uint32_t len, uint32_t *skip, uint32_t *frame_len, uint32_t max_len)
+{
+    uint32_t offset = 0, length = 0;
+    const uint8_t *mark = NULL;
+    const lpv35_fixed_head_t *fixed_head = NULL;
+
+    *frame_len = 0;
+    /* the head is 00 00 66 99, a head can only start 2 bytes before a 0x66 */
+    while (offset + LPV35_FRAME_HEAD_SIZE <= len) {
+        if (0 == memcmp(data + offset, LPV35_FRAME_HEAD, LPV35_FRAME_HEAD_SIZE)) {
+            break;
+        }
+        mark = memchr(data + offset + 3, 0x66, len - offset - 3);
+        if (NULL == mark) {
+            offset = len - 2;
+            break;
+        }
+        offset = mark - data - 2;
+    }
+    *skip = offset;
+
+    if (len - offset < LPV35_FRAME_HEAD_SIZE + sizeof(lpv35_fixed_head_t)) {
+        return FALSE;
+    }
+    fixed_head = (const lpv35_fixed_head_t *)(data + offset + LPV35_FRAME_HEAD_SIZE);
+    length = UNI_NTOHL(fixed_head->length);
+    // checked before the sum, a length near 4G would wrap it
+    if (length > max_len - LPV35_FRAME_HEAD_SIZE - sizeof(lpv35_fixed_head_t) - LPV35_FRAME_TAIL_SIZE) {
+        *frame_len = max_len + 1;
+        return FALSE;
+    }
+    *frame_len = LPV35_FRAME_HEAD_SIZE + sizeof(lpv35_fixed_head_t) + length + LPV35_FRAME_TAIL_SIZE;
+
+    return (len - offset >= *frame_len);
+}
+
 /**
  * @brief Serializes an LPV35 frame object into a byte array.
  *
@@ -577,7 +677,8 @@ OPERATE_RET lpv35_frame_parse(const uint8_t *key, int key_len, const uint8_t *in
     offset += LPV35_FRAME_DATALEN_SIZE;
 
     // length verify
-    if (length != ilen - offset - LPV35_FRAME_TAIL_SIZE) {
+    if (ilen < offset + LPV35_FRAME_TAIL_SIZE || length != ilen - offset - LPV35_FRAME_TAIL_SIZE ||
+        length < LPV35_FRAME_NONCE_SIZE + LPV35_FRAME_TAG_SIZE) {
         PR_ERR("length error, length:%d", length);
         return OPRT_COM_ERROR;
     }
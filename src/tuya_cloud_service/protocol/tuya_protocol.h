@@ -89,6 +89,14 @@ typedef struct {
 } lpv35_frame_object_t;
 
 typedef dp_cmd_type_t DP_CMD_TYPE_E;
+
+/**
+ * @brief writes the data of a packet in place
+ *
+ * @param[out] buf destination, the writer fills exactly the announced length
+ * @param[in] arg writer argument
+ */
+typedef void (*tuya_pack_writer_t)(char *buf, void *arg);
 /***********************************************************
  *  Function: parse_data_with_cmd
  *  Input: cmd data len
@@ -129,6 +137,28 @@ OPERATE_RET tuya_parse_protocol_data(const DP_CMD_TYPE_E cmd, uint8_t *data, con
  */
 OPERATE_RET tuya_pack_protocol_data(const DP_CMD_TYPE_E cmd, const char *src, const uint32_t pro, uint8_t *key,
                                     char **out, uint32_t *out_len);
+
+/**
+ * @brief pack protocol data written in place by a writer
+ *
+ * The packet is allocated once from data_len and the writer fills the data
+ * directly in it, the envelope and the encryption are done around it.
+ *
+ * @param[in] cmd refer to DP_CMD_TYPE_E
+ * @param[in] writer writes exactly data_len bytes of json data
+ * @param[in] arg writer argument
+ * @param[in] data_len length of the data written by the writer
+ * @param[in] pro pro
+ * @param[in] key pack key
+ * @param[out] out pack out
+ * @param[out] out_len pack out length
+ *
+ * @return OPRT_OK on success. Others on error, please refer to
+ * tuya_error_code.h
+ */
+OPERATE_RET tuya_pack_protocol_data_with_writer(const DP_CMD_TYPE_E cmd, tuya_pack_writer_t writer, void *arg,
+                                                const uint32_t data_len, const uint32_t pro, uint8_t *key,
+                                                char **out, uint32_t *out_len);
 /**
  * @brief add head and tail in lpv35 frame
  *
@@ -159,6 +189,21 @@ OPERATE_RET lpv35_frame_serialize(const uint8_t *key, int key_len, const lpv35_f
 OPERATE_RET lpv35_frame_parse(const uint8_t *key, int key_len, const uint8_t *input, int ilen,
                               lpv35_frame_object_t *output);
 
+/**
+ * @brief find the next lpv35 frame in received stream data
+ *
+ * @param[in] data received data
+ * @param[in] len data length
+ * @param[out] skip bytes before the frame, drop them
+ * @param[out] frame_len frame length read from its head, 0 if the head is not
+ * received yet, max_len + 1 if the head announces a longer frame, check it
+ * against the receive buffer before waiting for more
+ * @param[in] max_len longest frame accepted
+ *
+ * @return TRUE if the whole frame starts at data + skip
+ */
+BOOL_T lpv35_frame_decode(const uint8_t *data, uint32_t len, uint32_t *skip, uint32_t *frame_len, uint32_t max_len);
+
 /**
  * @brief get lpv35 frame buffer size
  *
@@ -35,6 +35,23 @@ typedef struct {
 
 static dp_schema_mgr_t s_dsmgr = {0};
 
+/**
+ * @brief FNV-1a hash of a device id.
+ *
+ * @param devid The device ID.
+ * @return The hash value.
+ */
+static uint32_t dp_devid_hash(const char *devid)
+{
+    uint32_t hash = 2166136261u;
+
+    while (*devid) {
+        hash ^= (uint8_t)*devid++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
 /**
  * @brief Appends a JSON string to the given data with the specified time, type,
  * and repetition sequence.
@@ -118,16 +135,10 @@ __err_exit:
  */
 dp_node_t *dp_node_find(dp_schema_t *schema, int id)
 {
-    int i;
-    dp_node_t *dpnode = NULL;
-
-    for (i = 0; i < schema->num; i++) {
-        if (schema->node[i].desc.id == id) {
-            dpnode = &schema->node[i];
-            break;
-        }
+    if (id < 0 || id > DP_NODE_NUM_MAX || DP_NODE_POS_NONE == schema->index[id]) {
+        return NULL;
     }
-    return dpnode;
+    return &schema->node[schema->index[id]];
 }
 
 /**
@@ -139,6 +150,7 @@ dp_node_t *dp_node_find(dp_schema_t *schema, int id)
 dp_schema_t *dp_schema_find(const char *devid)
 {
     int i = 0;
+    uint32_t hash = dp_devid_hash(devid);
 
     PR_TRACE("try to find schema devid %s", devid);
     dp_schema_mgr_t *dsmgr = &s_dsmgr;
@@ -146,7 +158,7 @@ dp_schema_t *dp_schema_find(const char *devid)
         if (NULL == dsmgr->schema_list[i]) {
             continue;
         }
-        if (0 == strcmp(devid, dsmgr->schema_list[i]->devid)) {
+        if (hash == dsmgr->schema_list[i]->devid_hash && 0 == strcmp(devid, dsmgr->schema_list[i]->devid)) {
             return dsmgr->schema_list[i];
         }
 
@@ -168,20 +180,11 @@ dp_schema_t *dp_schema_find(const char *devid)
  */
 dp_node_t *dp_node_find_by_devid(char *devid, int id)
 {
-    int i;
-    dp_node_t *dpnode = NULL;
-
     dp_schema_t *schema = dp_schema_find(devid);
     if (NULL == schema) {
         return NULL;
     }
-    for (i = 0; i < schema->num; i++) {
-        if (schema->node[i].desc.id == id) {
-            dpnode = &schema->node[i];
-            break;
-        }
-    }
-    return dpnode;
+    return dp_node_find(schema, id);
 }
 
 static __attribute__((unused)) OPERATE_RET dp_obj_equal_resp(dp_schema_t *schema, uint8_t *dpid, uint8_t num,
@@ -820,141 +823,247 @@ int dp_rept_valid_check(dp_schema_t *schema, dp_rept_in_t *dpin, dp_rept_valid_t
     return OPRT_OK;
 }
 
+typedef struct {
+    char *buf; // NULL to only count
+    int len;
+} dp_json_writer_t;
+
+static void dp_json_put(dp_json_writer_t *w, const char *data, int len)
+{
+    if (w->buf) {
+        memcpy(w->buf + w->len, data, len);
+    }
+    w->len += len;
+}
+
+static void dp_json_put_uint(dp_json_writer_t *w, uint32_t value)
+{
+    char digit[10];
+    int n = sizeof(digit);
+
+    do {
+        digit[--n] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    dp_json_put(w, digit + n, sizeof(digit) - n);
+}
+
+static void dp_json_put_int(dp_json_writer_t *w, int value)
+{
+    if (value < 0) {
+        dp_json_put(w, "-", 1);
+        dp_json_put_uint(w, 0 - (uint32_t)value);
+    } else {
+        dp_json_put_uint(w, value);
+    }
+}
+
+// quoted and escaped the way cJSON_PrintUnformatted does
+static void dp_json_put_str(dp_json_writer_t *w, const char *str)
+{
+    static const char hex[] = "0123456789abcdef";
+    const char *run = str;
+    char esc[6] = {'\\', 'u', '0', '0'};
+
+    dp_json_put(w, "\"", 1);
+    for (; *str; str++) {
+        uint8_t c = (uint8_t)*str;
+        int esc_len = 2;
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        dp_json_put(w, run, str - run);
+        run = str + 1;
+        switch (c) {
+        case '"':
+        case '\\':
+            esc[1] = c;
+            break;
+        case '\b':
+            esc[1] = 'b';
+            break;
+        case '\f':
+            esc[1] = 'f';
+            break;
+        case '\n':
+            esc[1] = 'n';
+            break;
+        case '\r':
+            esc[1] = 'r';
+            break;
+        case '\t':
+            esc[1] = 't';
+            break;
+        default:
+            esc[1] = 'u';
+            esc[4] = hex[c >> 4];
+            esc[5] = hex[c & 0x0F];
+            esc_len = 6;
+            break;
+        }
+        dp_json_put(w, esc, esc_len);
+    }
+    dp_json_put(w, run, str - run);
+    dp_json_put(w, "\"", 1);
+}
+
+// position of each dp id in dpin, the first one wins when an id is repeated
+static void dp_rept_pos_build(dp_rept_in_t *dpin, uint8_t dppos[DP_NODE_NUM_MAX + 1])
+{
+    uint16_t j;
+
+    memset(dppos, DP_NODE_POS_NONE, DP_NODE_NUM_MAX + 1);
+    for (j = dpin->dpscnt; j > 0; j--) {
+        dppos[dpin->dps[j - 1].id] = j - 1;
+    }
+}
+
 /**
- * @brief Outputs the JSON representation of a device property (DP) schema.
+ * @brief Serializes the valid DPs of a report as a JSON object.
  *
- * This function takes a DP schema, input data, validation information, and
- * output data as parameters. It generates the JSON representation of the DP
- * schema based on the provided input data and validation information, and
- * stores the result in the output data structure.
+ * Writes {"<id>":<value>,...} for the DPs listed in dpvalid without any
+ * allocation. Call it once with buf NULL to get the exact length, then again
+ * with a buffer of that length.
  *
  * @param schema Pointer to the DP schema structure.
  * @param dpin Pointer to the input data structure.
  * @param dpvalid Pointer to the validation information structure.
- * @param dpout Pointer to the output data structure.
- * @return Integer value indicating the success or failure of the operation.
+ * @param buf Output buffer, NULL to only compute the length.
+ * @return Length of the JSON text, the terminating 0 is not written, or a
+ * negative error code.
  */
-int dp_rept_json_output(dp_schema_t *schema, dp_rept_in_t *dpin, dp_rept_valid_t *dpvalid, dp_rept_out_t *dpout)
+int dp_rept_json_serialize(dp_schema_t *schema, dp_rept_in_t *dpin, dp_rept_valid_t *dpvalid, char *buf)
 {
-    uint16_t i, j;
-    uint16_t offset = 0;
-    uint16_t time_offset = 0;
-    OPERATE_RET op_ret = OPRT_OK;
-    char *dpstr = NULL;
-    char *dptimestr = NULL;
-    bool is_need_time = false;
+    uint16_t i;
+    uint8_t dppos[DP_NODE_NUM_MAX + 1];
+    dp_json_writer_t w = {.buf = buf, .len = 0};
 
-    dpstr = (char *)tal_malloc(dpvalid->len);
-    if (NULL == dpstr) {
-        PR_ERR("malloc err:%d", dpvalid->len);
-        return OPRT_MALLOC_FAILED;
-    }
-    // STAT type DP needs to assemble a timestamp
-    if ((T_STAT_REPT == dpin->rept_type) && dpvalid->timelen && dpout->timejson) {
-        dptimestr = (char *)tal_malloc(dpvalid->timelen);
-        if (NULL == dptimestr) {
-            PR_ERR("malloc err:%d", dpvalid->timelen);
-            op_ret = OPRT_MALLOC_FAILED;
-            goto __err_exit;
-        }
-        is_need_time = true;
-    }
-    dpstr[offset++] = '{';
-    if (is_need_time) {
-        dptimestr[time_offset++] = '{';
-    }
+    dp_rept_pos_build(dpin, dppos);
 
+    dp_json_put(&w, "{", 1);
     for (i = 0; i < dpvalid->num; i++) {
-        dp_obj_t *dp = NULL;
-        for (j = 0; j < dpin->dpscnt; j++) {
-            if (dpvalid->dpid[i] == dpin->dps[j].id) {
-                dp = &dpin->dps[j];
-                break;
-            }
-        }
-        if (NULL == dp) {
+        if (DP_NODE_POS_NONE == dppos[dpvalid->dpid[i]]) {
             PR_DEBUG("dp not found");
-            op_ret = OPRT_SVC_DP_ID_NOT_FOUND;
-            goto __err_exit;
+            return OPRT_SVC_DP_ID_NOT_FOUND;
         }
-        // dp_obj_t  *dp     = &dpin->dps[dpvalid->dpid[i]];
+        dp_obj_t *dp = &dpin->dps[dppos[dpvalid->dpid[i]]];
         dp_node_t *dpnode = dp_node_find(schema, dp->id);
         if (NULL == dpnode) {
             PR_DEBUG("dp->id = %d not found", dp->id);
-            op_ret = OPRT_SVC_DP_ID_NOT_FOUND;
-            goto __err_exit;
+            return OPRT_SVC_DP_ID_NOT_FOUND;
         }
 
         if (dp->type != dpnode->desc.prop_tp) {
-            op_ret = OPRT_SVC_DP_TP_NOT_MATCH;
-            goto __err_exit;
+            return OPRT_SVC_DP_TP_NOT_MATCH;
+        }
+
+        if (i > 0) {
+            dp_json_put(&w, ",", 1);
         }
+        dp_json_put(&w, "\"", 1);
+        dp_json_put_uint(&w, dp->id);
+        dp_json_put(&w, "\":", 2);
 
         switch (dp->type) {
         case PROP_BOOL: {
             if (TRUE == dp->value.dp_bool) {
-                offset += sprintf(dpstr + offset, "\"%d\":true,", dp->id);
+                dp_json_put(&w, "true", 4);
             } else {
-                offset += sprintf(dpstr + offset, "\"%d\":false,", dp->id);
+                dp_json_put(&w, "false", 5);
             }
             break;
         }
 
         case PROP_VALUE: {
-            offset += sprintf(dpstr + offset, "\"%d\":%d,", dp->id, dp->value.dp_value);
+            dp_json_put_int(&w, dp->value.dp_value);
             break;
         }
 
         case PROP_BITMAP: {
-            offset += sprintf(dpstr + offset, "\"%d\":%" PRIu32 ",", dp->id, dp->value.dp_bitmap);
+            dp_json_put_uint(&w, dp->value.dp_bitmap);
             break;
         }
 
         case PROP_STR: {
-            cJSON *temp_str = cJSON_CreateString(dp->value.dp_str);
-            char *tmp_data = cJSON_PrintUnformatted(temp_str);
-            if (tmp_data) {
-                offset += sprintf(dpstr + offset, "\"%d\":%s,", dp->id, tmp_data);
-            }
-            tal_free(tmp_data);
-            cJSON_Delete(temp_str);
+            dp_json_put_str(&w, dp->value.dp_str ? dp->value.dp_str : "");
             break;
         }
 
         case PROP_ENUM: {
-            offset +=
-                sprintf(dpstr + offset, "\"%d\":\"%s\",", dp->id, dpnode->prop.prop_enum.pp_enum[dp->value.dp_enum]);
+            const char *enum_str = dpnode->prop.prop_enum.pp_enum[dp->value.dp_enum];
+            dp_json_put(&w, "\"", 1);
+            dp_json_put(&w, enum_str, strlen(enum_str));
+            dp_json_put(&w, "\"", 1);
         } break;
         }
-
-        if (is_need_time && dp->time_stamp) {
-            time_offset += sprintf(dptimestr + time_offset, "\"%d\":%u,", dp->id, dp->time_stamp);
-        }
     }
+    dp_json_put(&w, "}", 1);
 
-    dpstr[offset - 1] = '}';
-    dpstr[offset] = 0;
+    return w.len;
+}
 
-    dpout->dpsjson = dpstr;
+/**
+ * @brief Outputs the JSON representation of a device property (DP) schema.
+ *
+ * This function takes a DP schema, input data, validation information, and
+ * output data as parameters. It generates the JSON representation of the DP
+ * schema based on the provided input data and validation information, and
+ * stores the result in the output data structure.
+ *
+ * @param schema Pointer to the DP schema structure.
+ * @param dpin Pointer to the input data structure.
+ * @param dpvalid Pointer to the validation information structure.
+ * @param dpout Pointer to the output data structure.
+ * @return Integer value indicating the success or failure of the operation.
+ */
+int dp_rept_json_output(dp_schema_t *schema, dp_rept_in_t *dpin, dp_rept_valid_t *dpvalid, dp_rept_out_t *dpout)
+{
+    uint16_t i;
+    uint16_t time_offset = 0;
+    int len = 0;
+    char *dpstr = NULL;
+    char *dptimestr = NULL;
+    uint8_t dppos[DP_NODE_NUM_MAX + 1];
 
-    PR_DEBUG("dp rept out: %s", dpstr);
+    len = dp_rept_json_serialize(schema, dpin, dpvalid, NULL);
+    if (len < 0) {
+        return len;
+    }
+    dpstr = (char *)tal_malloc(len + 1);
+    if (NULL == dpstr) {
+        PR_ERR("malloc err:%d", len + 1);
+        return OPRT_MALLOC_FAILED;
+    }
+    dp_rept_json_serialize(schema, dpin, dpvalid, dpstr);
+    dpstr[len] = 0;
 
-    if (is_need_time) {
+    // STAT type DP needs to assemble a timestamp
+    if ((T_STAT_REPT == dpin->rept_type) && dpvalid->timelen && dpout->timejson) {
+        dptimestr = (char *)tal_malloc(dpvalid->timelen);
+        if (NULL == dptimestr) {
+            PR_ERR("malloc err:%d", dpvalid->timelen);
+            tal_free(dpstr);
+            return OPRT_MALLOC_FAILED;
+        }
+        dp_rept_pos_build(dpin, dppos);
+        dptimestr[time_offset++] = '{';
+        for (i = 0; i < dpvalid->num; i++) {
+            dp_obj_t *dp = &dpin->dps[dppos[dpvalid->dpid[i]]];
+            if (dp->time_stamp) {
+                time_offset += sprintf(dptimestr + time_offset, "\"%d\":%u,", dp->id, dp->time_stamp);
+            }
+        }
         dptimestr[time_offset - 1] = '}';
         dptimestr[time_offset] = 0;
         PR_DEBUG("dptimestr:%s", dptimestr);
         dpout->timejson = dptimestr;
     }
 
-    return OPRT_OK;
+    dpout->dpsjson = dpstr;
 
-__err_exit:
-    tal_free(dpstr);
-    if (is_need_time) {
-        tal_free(dptimestr);
-    }
+    PR_DEBUG("dp rept out: %s", dpstr);
 
-    return op_ret;
+    return OPRT_OK;
 }
 
 // int dp_rept_json_output(dp_schema_t *schema, dp_rept_in_t *dpin,
@@ -1526,15 +1635,17 @@ int dp_schema_create(char *devid, char *schema_json, dp_schema_t **dp_schema_out
     dp_node_pos_t *nodepos = NULL;
     int nodenum;
 
-    nodepos = tal_malloc(sizeof(dp_node_pos_t) * 255);
+    int i;
+
+    nodepos = tal_malloc(sizeof(dp_node_pos_t) * (DP_NODE_NUM_MAX + 1));
     if (NULL == nodepos) {
         PR_ERR("malloc fail");
         return OPRT_MALLOC_FAILED;
     }
     PR_DEBUG("devid %s, schema_json %s", devid, schema_json);
 
-    nodenum = dp_node_pos_decode(schema_json, nodepos, 255);
-    if (0 == nodenum || nodenum >= 255) {
+    nodenum = dp_node_pos_decode(schema_json, nodepos, DP_NODE_NUM_MAX + 1);
+    if (0 == nodenum || nodenum > DP_NODE_NUM_MAX) {
         PR_ERR("dp num parse err:%d", nodenum);
         tal_free(nodepos);
         return OPRT_SVC_DEVOS_DEV_DP_CNT_INVALID;
@@ -1562,9 +1673,15 @@ int dp_schema_create(char *devid, char *schema_json, dp_schema_t **dp_schema_out
         PR_ERR("dp_node_parse fail:%d", op_ret);
         goto __exit;
     }
+    // direct-mapped id to node table, the first node wins when an id is repeated
+    memset(dp_schema->index, DP_NODE_POS_NONE, sizeof(dp_schema->index));
+    for (i = nodenum - 1; i >= 0; i--) {
+        dp_schema->index[dp_schema->node[i].desc.id] = i;
+    }
     dp_schema->actv.preprocess = other_attr.preprocess;
     dp_schema->actv.attach_dp_if = TRUE;
     strncpy(dp_schema->devid, devid, DEV_ID_LEN);
+    dp_schema->devid_hash = dp_devid_hash(dp_schema->devid);
     if (dp_schema_out) {
         *dp_schema_out = dp_schema;
     }
@@ -1597,6 +1714,7 @@ __exit:
 int dp_schema_delete(char *devid)
 {
     int i = 0;
+    uint32_t hash = dp_devid_hash(devid);
 
     PR_TRACE("try to delete schema devid %s", devid);
     dp_schema_mgr_t *dsmgr = &s_dsmgr;
@@ -1605,7 +1723,7 @@ int dp_schema_delete(char *devid)
             continue;
         }
 
-        if (0 == strcmp(devid, dsmgr->schema_list[i]->devid)) {
+        if (hash == dsmgr->schema_list[i]->devid_hash && 0 == strcmp(devid, dsmgr->schema_list[i]->devid)) {
             tal_mutex_release(dsmgr->schema_list[i]->mutex);
             tal_free(dsmgr->schema_list[i]);
             dsmgr->schema_list[i] = NULL;
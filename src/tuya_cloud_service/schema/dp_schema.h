@@ -322,15 +322,25 @@ typedef struct {
 
 // typedef struct dev_cntl_n_s {
 
+/**
+ * @brief Definition of dp schema limits
+ */
+#define DP_NODE_NUM_MAX  255  // dp ids are uint8_t, node[] holds at most one node per id
+#define DP_NODE_POS_NONE 0xFF // index[] value of an id without node
+
 typedef struct {
     /** virtual id */
     char devid[DEV_ID_LEN + 1];
+    /** hash of devid, compared before the string */
+    uint32_t devid_hash;
     /** device attribute, see DEV_ACTV_ATTR_S */
     dp_prop_actv_t actv;
     /** exclusive access to dp */
     MUTEX_HANDLE mutex;
     /** count of dp */
     uint8_t num;
+    /** position in node[] of each dp id, DP_NODE_POS_NONE if the id is absent */
+    uint8_t index[DP_NODE_NUM_MAX + 1];
     /** dp info */
     dp_node_t node[0];
 } dp_schema_t;
@@ -485,6 +495,22 @@ int dp_rept_valid_check(dp_schema_t *schema, dp_rept_in_t *dpin, dp_rept_valid_t
  */
 int dp_rept_json_output(dp_schema_t *schema, dp_rept_in_t *dpin, dp_rept_valid_t *dpvalid, dp_rept_out_t *dpout);
 
+/**
+ * @brief Serializes the valid DPs of a report as a JSON object.
+ *
+ * This function writes {"<id>":<value>,...} for the DPs listed in dpvalid
+ * without allocating. Calling it with buf NULL returns the exact length, so a
+ * caller can reserve room for the DPs in its own buffer and write them there.
+ *
+ * @param schema The DP schema of the report.
+ * @param dpin The input data for the DP report.
+ * @param dpvalid The validation information for the DP report.
+ * @param buf The output buffer, NULL to only compute the length.
+ * @return The length of the JSON text without terminating 0, or a negative
+ * error code.
+ */
+int dp_rept_json_serialize(dp_schema_t *schema, dp_rept_in_t *dpin, dp_rept_valid_t *dpvalid, char *buf);
+
 /**
  * Appends a JSON string to the given data point schema.
  *
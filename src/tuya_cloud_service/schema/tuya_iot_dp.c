@@ -154,6 +154,64 @@ static void tuya_iot_dp_parse_on_worq(void *args)
     tal_free(msg);
 }
 
+typedef struct {
+    const char *devid;
+    dp_schema_t *schema;
+    dp_rept_in_t *dpin;
+    dp_rept_valid_t *dpvalid;
+} dp_rept_writer_t;
+
+// {"devId":"<devid>","dps":<dps>}
+static uint32_t dp_rept_body_head_put(char *buf, const char *devid)
+{
+    uint32_t devid_len = strlen(devid);
+
+    if (buf) {
+        memcpy(buf, "{\"devId\":\"", 10);
+        memcpy(buf + 10, devid, devid_len);
+        memcpy(buf + 10 + devid_len, "\",\"dps\":", 8);
+    }
+    return 10 + devid_len + 8;
+}
+
+static void dp_rept_body_write(char *buf, void *arg)
+{
+    dp_rept_writer_t *writer = (dp_rept_writer_t *)arg;
+    uint32_t offset = dp_rept_body_head_put(buf, writer->devid);
+
+    offset += dp_rept_json_serialize(writer->schema, writer->dpin, writer->dpvalid, buf + offset);
+    buf[offset] = '}';
+}
+
+// the dps are serialized straight into the packet buffer, dp_sync_cb frees dpvalid
+static int dp_obj_report_mqtt(tuya_iot_client_t *client, dp_schema_t *schema, dp_rept_in_t *dpin,
+                              dp_rept_valid_t *dpvalid)
+{
+    dp_rept_writer_t writer = {
+        .devid = client->activate.devid,
+        .schema = schema,
+        .dpin = dpin,
+        .dpvalid = dpvalid,
+    };
+
+    int dps_len = dp_rept_json_serialize(schema, dpin, dpvalid, NULL);
+    if (dps_len < 0) {
+        PR_DEBUG("dp rept json serialize error %d", dps_len);
+        tal_free(dpvalid);
+        return dps_len;
+    }
+    uint32_t body_len = dp_rept_body_head_put(NULL, writer.devid) + dps_len + 1;
+
+    int rt = tuya_mqtt_protocol_data_publish_with_writer(&client->mqctx, PRO_DATA_PUSH, dp_rept_body_write, &writer,
+                                                         body_len, (mqtt_publish_notify_cb_t)dp_sync_cb, dpvalid, 5000,
+                                                         false);
+    if (OPRT_OK != rt) {
+        // not queued, dp_sync_cb will not run
+        tal_free(dpvalid);
+    }
+    return rt;
+}
+
 /**
  * @brief Parses the device data point command received from the Tuya IoT
  * platform.
@@ -234,7 +292,7 @@ int tuya_iot_dp_obj_report(tuya_iot_client_t *client, const char *devid, dp_obj_
     if (NULL == dpvalid) {
         return OPRT_MALLOC_FAILED;
     }
-    memset(dpvalid, 0, sizeof(sizeof(dp_rept_valid_t) + sizeof(uint8_t) * dpscnt));
+    memset(dpvalid, 0, sizeof(dp_rept_valid_t) + sizeof(uint8_t) * dpscnt);
 
     PR_DEBUG("dp report: devid %s, dps 0x%08x, dpscnt %d, flags %d", devid ? devid : "null", dps, dpscnt, flags);
 
@@ -285,36 +343,30 @@ int tuya_iot_dp_obj_report(tuya_iot_client_t *client, const char *devid, dp_obj_
     }
 #endif
 
-    dp_rept_out_t dpout;
-
-    memset(&dpout, 0, sizeof(dpout));
-
-    ret = dp_rept_json_output(schema, &dpin, dpvalid, &dpout);
-    if (OPRT_OK != ret) {
-        PR_DEBUG("dp rept json output error %d", ret);
-        return ret;
-    }
-
     if (tuya_lan_is_connected()) {
+        dp_rept_out_t dpout;
         char *out = NULL;
+
+        memset(&dpout, 0, sizeof(dpout));
+        ret = dp_rept_json_output(schema, &dpin, dpvalid, &dpout);
+        if (OPRT_OK != ret) {
+            PR_DEBUG("dp rept json output error %d", ret);
+            tal_free(dpvalid);
+            return ret;
+        }
         PR_DEBUG("lan channel report");
         dp_rept_json_append(schema, dpout.dpsjson, NULL, NULL, 0, &out);
         ret = tuya_lan_dp_report(out);
         tal_free(out);
+        tal_free(dpout.dpsjson);
         tal_free(dpvalid);
         tuya_iot_dp_sync_start(client, 5);
     } else if (tuya_iot_is_connected()) {
         PR_DEBUG("mqtt channel report");
-        ret = tuya_iot_dp_report_json_with_notify(client, dpout.dpsjson, NULL, dp_sync_cb, dpvalid, 5000);
+        ret = dp_obj_report_mqtt(client, schema, &dpin, dpvalid);
     } else {
         PR_ERR("no channel for connect");
-    }
-
-    if (dpout.dpsjson) {
-        tal_free(dpout.dpsjson);
-    }
-    if (dpout.timejson) {
-        tal_free(dpout.timejson);
+        tal_free(dpvalid);
     }
 
     return ret;
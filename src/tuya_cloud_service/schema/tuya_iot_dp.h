@@ -76,6 +76,78 @@ int tuya_iot_dp_raw_report(tuya_iot_client_t *client, const char *devid, dp_raw_
  */
 char *tuya_iot_dp_obj_dump(tuya_iot_client_t *client, char *devid, int flags);
 
+#if defined(ENABLE_DP_REPORT_COALESCE) && (ENABLE_DP_REPORT_COALESCE == 1)
+/**
+ * @brief Counters of the dp report aggregator
+ */
+typedef struct {
+    /** calls of tuya_iot_dp_obj_report_coalesce */
+    uint32_t requests;
+    /** dp values passed to tuya_iot_dp_obj_report_coalesce */
+    uint32_t dps;
+    /** dp values replaced by a newer one before being sent */
+    uint32_t coalesced;
+    /** reports sent, one cloud message each */
+    uint32_t reports;
+    /** dp values carried by these reports */
+    uint32_t sent_dps;
+} dp_report_stat_t;
+
+/**
+ * @brief Creates the locks and the work of the dp report aggregator, called by tuya_iot_init.
+ *
+ * @return int OPRT_OK on success
+ */
+int tuya_iot_dp_coalesce_init(void);
+
+/**
+ * @brief Queues object dps and reports them later, merged with other reports.
+ *
+ * The dps of a device wait DP_REPORT_WINDOW_MS, then all the pending dps of
+ * the device are sent with one tuya_iot_dp_obj_report. A newer value of a
+ * pending state dp replaces it. Statistic dps and dps with a direct trigger
+ * are never dropped, a new value of a pending one sends the pending dps first.
+ * The report is sent at once when DP_REPORT_MAX_DPS dps are pending.
+ *
+ * @param client
+ * @param devid
+ * @param dps dps to report, string values are copied
+ * @param dpscnt
+ * @param flags ored with the flags of the other pending reports of the device
+ * @return int OPRT_OK if the dps are queued
+ */
+int tuya_iot_dp_obj_report_coalesce(tuya_iot_client_t *client, const char *devid, dp_obj_t *dps, uint16_t dpscnt,
+                                    int flags);
+
+/**
+ * @brief Sets the minimum interval between two reports of a state dp.
+ *
+ * A value reported sooner stays pending, newer values replacing it, until the
+ * interval since the last report of the dp is over.
+ *
+ * @param devid
+ * @param dpid
+ * @param interval_ms 0 to remove the policy
+ * @return int
+ */
+int tuya_iot_dp_report_interval_set(const char *devid, uint8_t dpid, uint32_t interval_ms);
+
+/**
+ * @brief Sends the pending dps of every device now, minimum intervals still apply.
+ *
+ * @return int
+ */
+int tuya_iot_dp_report_flush(void);
+
+/**
+ * @brief Reads the counters of the dp report aggregator.
+ *
+ * @param stat
+ * @param reset clear the counters after reading them
+ */
+void tuya_iot_dp_report_stat_get(dp_report_stat_t *stat, bool reset);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
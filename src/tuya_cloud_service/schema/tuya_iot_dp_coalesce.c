@@ -0,0 +1,499 @@
+/**
+ * @file tuya_iot_dp_coalesce.c
+ * @brief Aggregator of frequent object dp reports.
+ *
+ * Applications such as dimmer sliders or power meters report the same dps
+ * many times per second. Each tuya_iot_dp_obj_report builds, encrypts and
+ * publishes one cloud message, so this aggregator holds the dps for a short
+ * window, keeps the last value of each state dp and sends all the pending dps
+ * of a device in a single report. Minimum intervals per dp hold back the dps
+ * that must not be reported more often than a given period.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include "dp_schema.h"
+#include "tuya_iot_dp.h"
+#include "tal_api.h"
+#include "mix_method.h"
+
+#if defined(ENABLE_DP_REPORT_COALESCE) && (ENABLE_DP_REPORT_COALESCE == 1)
+
+/***********************************************************
+*************************micro define***********************
+***********************************************************/
+#define DP_PENDING_NONE 0xFF
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+typedef struct {
+    uint8_t id;
+    uint32_t interval_ms;
+    SYS_TIME_T last_ms; // last report of the dp, 0 if never reported
+} dp_rate_t;
+
+typedef struct dp_coalesce_dev {
+    struct dp_coalesce_dev *next;
+    char devid[DEV_ID_LEN + 1];
+    tuya_iot_client_t *client;
+    int flags;             // ored flags of the pending reports
+    SYS_TIME_T window_end; // end of the window the next pending dp joins
+    uint16_t num;
+    uint8_t pos[DP_NODE_NUM_MAX + 1]; // position in dps of each pending id
+    dp_obj_t dps[DP_REPORT_MAX_DPS];
+    SYS_TIME_T due[DP_REPORT_MAX_DPS]; // time each pending dp can be sent at
+    bool merge[DP_REPORT_MAX_DPS];     // FALSE for dps whose values must all be sent
+    uint16_t rate_num;
+    dp_rate_t rate[DP_REPORT_MAX_DPS];
+} dp_coalesce_dev_t;
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+static MUTEX_HANDLE s_coalesce_mutex = NULL;
+static MUTEX_HANDLE s_coalesce_send_mutex = NULL; // keeps the reports of a dp in order
+static DELAYED_WORK_HANDLE s_coalesce_work = NULL;
+static dp_coalesce_dev_t *s_coalesce_dev = NULL;
+static dp_report_stat_t s_coalesce_stat = {0};
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+static void dp_coalesce_work_cb(void *data);
+
+/**
+ * @brief Creates the locks and the work of the dp report aggregator.
+ *
+ * Called once by tuya_iot_init, before any report can be queued.
+ *
+ * @return OPRT_OK on success, or a negative error code on failure.
+ */
+int tuya_iot_dp_coalesce_init(void)
+{
+    OPERATE_RET rt = OPRT_OK;
+
+    if (s_coalesce_work) {
+        return OPRT_OK;
+    }
+
+    TUYA_CALL_ERR_GOTO(tal_mutex_create_init(&s_coalesce_mutex), __ERR);
+    TUYA_CALL_ERR_GOTO(tal_mutex_create_init(&s_coalesce_send_mutex), __ERR);
+    TUYA_CALL_ERR_GOTO(tal_workq_init_delayed(WORKQ_HIGHTPRI, dp_coalesce_work_cb, NULL, &s_coalesce_work), __ERR);
+    return OPRT_OK;
+
+__ERR:
+    if (s_coalesce_mutex) {
+        tal_mutex_release(s_coalesce_mutex);
+        s_coalesce_mutex = NULL;
+    }
+    if (s_coalesce_send_mutex) {
+        tal_mutex_release(s_coalesce_send_mutex);
+        s_coalesce_send_mutex = NULL;
+    }
+    return rt;
+}
+
+static dp_coalesce_dev_t *dp_coalesce_dev_get(const char *devid, bool create)
+{
+    dp_coalesce_dev_t *dev = s_coalesce_dev;
+
+    for (; dev; dev = dev->next) {
+        if (0 == strcmp(dev->devid, devid)) {
+            return dev;
+        }
+    }
+    if (!create) {
+        return NULL;
+    }
+
+    dev = tal_malloc(sizeof(dp_coalesce_dev_t));
+    if (NULL == dev) {
+        return NULL;
+    }
+    memset(dev, 0, sizeof(dp_coalesce_dev_t));
+    memset(dev->pos, DP_PENDING_NONE, sizeof(dev->pos));
+    strncpy(dev->devid, devid, DEV_ID_LEN);
+    dev->next = s_coalesce_dev;
+    s_coalesce_dev = dev;
+    return dev;
+}
+
+static dp_rate_t *dp_coalesce_rate_get(dp_coalesce_dev_t *dev, uint8_t id)
+{
+    uint16_t i;
+
+    for (i = 0; i < dev->rate_num; i++) {
+        if (dev->rate[i].id == id) {
+            return &dev->rate[i];
+        }
+    }
+    return NULL;
+}
+
+// time the minimum interval of the dp allows the next report at
+static SYS_TIME_T dp_coalesce_hold(dp_coalesce_dev_t *dev, uint8_t id)
+{
+    dp_rate_t *rate = dp_coalesce_rate_get(dev, id);
+
+    if (NULL == rate || 0 == rate->last_ms) {
+        return 0;
+    }
+    return rate->last_ms + rate->interval_ms;
+}
+
+static void dp_coalesce_value_free(dp_obj_t *dp)
+{
+    if (PROP_STR == dp->type && dp->value.dp_str) {
+        tal_free(dp->value.dp_str);
+        dp->value.dp_str = NULL;
+    }
+}
+
+/**
+ * @brief Moves the dps of the device that can be sent into out.
+ *
+ * @param force ignore the window, the minimum intervals still apply
+ * @return number of dps moved, the caller owns their string values
+ */
+static uint16_t dp_coalesce_take(dp_coalesce_dev_t *dev, SYS_TIME_T now, bool force, dp_obj_t *out)
+{
+    uint16_t i, num = 0, keep = 0;
+
+    for (i = 0; i < dev->num; i++) {
+        SYS_TIME_T hold = dev->merge[i] ? dp_coalesce_hold(dev, dev->dps[i].id) : 0;
+        if (hold <= now && (force || dev->due[i] <= now)) {
+            dp_rate_t *rate = dp_coalesce_rate_get(dev, dev->dps[i].id);
+            if (rate) {
+                rate->last_ms = now;
+            }
+            dev->pos[dev->dps[i].id] = DP_PENDING_NONE;
+            out[num++] = dev->dps[i];
+            continue;
+        }
+        if (keep != i) {
+            dev->dps[keep] = dev->dps[i];
+            dev->due[keep] = dev->due[i];
+            dev->merge[keep] = dev->merge[i];
+        }
+        dev->pos[dev->dps[keep].id] = keep;
+        keep++;
+    }
+    dev->num = keep;
+
+    return num;
+}
+
+// earliest time a pending dp can be sent at, 0 if nothing is pending
+static SYS_TIME_T dp_coalesce_next(void)
+{
+    SYS_TIME_T next = 0, due, hold;
+    dp_coalesce_dev_t *dev;
+    uint16_t i;
+
+    for (dev = s_coalesce_dev; dev; dev = dev->next) {
+        for (i = 0; i < dev->num; i++) {
+            due = dev->due[i];
+            hold = dev->merge[i] ? dp_coalesce_hold(dev, dev->dps[i].id) : 0;
+            if (hold > due) {
+                due = hold;
+            }
+            if (0 == next || due < next) {
+                next = due;
+            }
+        }
+    }
+    return next;
+}
+
+// called with s_coalesce_mutex locked
+static void dp_coalesce_schedule(SYS_TIME_T now)
+{
+    SYS_TIME_T next = dp_coalesce_next();
+
+    if (0 == next) {
+        tal_workq_stop_delayed(s_coalesce_work);
+        return;
+    }
+    tal_workq_start_delayed(s_coalesce_work, next > now ? (TIME_MS)(next - now) : 1, LOOP_ONCE);
+}
+
+/**
+ * @brief Sends the dps of one device that can be sent.
+ *
+ * @param devid device to flush, NULL for all the devices
+ * @param force ignore the window, the minimum intervals still apply
+ */
+static void dp_coalesce_flush(const char *devid, bool force)
+{
+    dp_coalesce_dev_t *dev;
+    dp_obj_t *dps = NULL;
+    uint16_t num, i;
+    int flags;
+    tuya_iot_client_t *client;
+
+    dps = tal_malloc(sizeof(dp_obj_t) * DP_REPORT_MAX_DPS);
+    if (NULL == dps) {
+        PR_ERR("coalesce malloc fail");
+        return;
+    }
+
+    // the list is walked with s_coalesce_mutex locked, devices are never removed
+    tal_mutex_lock(s_coalesce_send_mutex);
+    tal_mutex_lock(s_coalesce_mutex);
+    for (dev = s_coalesce_dev; dev; dev = dev->next) {
+        if (devid && strcmp(dev->devid, devid)) {
+            continue;
+        }
+
+        num = dp_coalesce_take(dev, tal_system_get_millisecond(), force, dps);
+        flags = dev->flags;
+        client = dev->client;
+        if (0 == dev->num) {
+            dev->flags = 0;
+        }
+        if (0 == num) {
+            continue;
+        }
+        s_coalesce_stat.reports++;
+        s_coalesce_stat.sent_dps += num;
+
+        tal_mutex_unlock(s_coalesce_mutex);
+        int rt = tuya_iot_dp_obj_report(client, dev->devid, dps, num, flags);
+        if (OPRT_OK != rt) {
+            PR_ERR("coalesced report of %d dps fail:%d", num, rt);
+        }
+        for (i = 0; i < num; i++) {
+            dp_coalesce_value_free(&dps[i]);
+        }
+        tal_mutex_lock(s_coalesce_mutex);
+    }
+    dp_coalesce_schedule(tal_system_get_millisecond());
+    tal_mutex_unlock(s_coalesce_mutex);
+    tal_mutex_unlock(s_coalesce_send_mutex);
+    tal_free(dps);
+}
+
+static void dp_coalesce_work_cb(void *data)
+{
+    dp_coalesce_flush(NULL, FALSE);
+}
+
+/**
+ * @brief Adds a dp to the pending dps of the device, called with s_coalesce_mutex locked.
+ *
+ * @return OPRT_EXCEED_UPPER_LIMIT if the pending dps have to be sent first
+ */
+static OPERATE_RET dp_coalesce_put(dp_coalesce_dev_t *dev, dp_obj_t *dp, bool merge, SYS_TIME_T now)
+{
+    uint8_t pos = dev->pos[dp->id];
+    char *str = NULL;
+
+    if (DP_PENDING_NONE != pos && !dev->merge[pos]) {
+        return OPRT_EXCEED_UPPER_LIMIT;
+    }
+    if (DP_PENDING_NONE == pos && dev->num >= DP_REPORT_MAX_DPS) {
+        return OPRT_EXCEED_UPPER_LIMIT;
+    }
+
+    if (PROP_STR == dp->type) {
+        str = mm_strdup(dp->value.dp_str ? dp->value.dp_str : "");
+        if (NULL == str) {
+            return OPRT_MALLOC_FAILED;
+        }
+    }
+
+    if (DP_PENDING_NONE != pos) {
+        // last value wins, the dp keeps its place in the window
+        dp_coalesce_value_free(&dev->dps[pos]);
+        s_coalesce_stat.coalesced++;
+    } else {
+        if (dev->window_end <= now) {
+            dev->window_end = now + DP_REPORT_WINDOW_MS;
+        }
+        pos = dev->num++;
+        dev->pos[dp->id] = pos;
+        dev->due[pos] = dev->window_end;
+        dev->merge[pos] = merge;
+    }
+    dev->dps[pos] = *dp;
+    if (str) {
+        dev->dps[pos].value.dp_str = str;
+    }
+    return OPRT_OK;
+}
+
+/**
+ * @brief Queues object dps and reports them later, merged with other reports.
+ *
+ * @param client The Tuya IoT client instance.
+ * @param devid The device ID.
+ * @param dps An array of device object data.
+ * @param dpscnt The number of device object data elements in the array.
+ * @param flags Additional flags for the report.
+ *
+ * @return OPRT_OK if the dps are queued, or a negative error code on failure.
+ */
+int tuya_iot_dp_obj_report_coalesce(tuya_iot_client_t *client, const char *devid, dp_obj_t *dps, uint16_t dpscnt,
+                                    int flags)
+{
+    OPERATE_RET rt = OPRT_OK;
+    uint16_t i;
+
+    if (NULL == client || NULL == dps || 0 == dpscnt) {
+        return OPRT_INVALID_PARM;
+    }
+    if (NULL == devid) {
+        devid = client->activate.devid;
+    }
+
+    dp_schema_t *schema = dp_schema_find(devid);
+    if (NULL == schema) {
+        return OPRT_INVALID_PARM;
+    }
+    for (i = 0; i < dpscnt; i++) {
+        dp_node_t *dpnode = dp_node_find(schema, dps[i].id);
+        if (NULL == dpnode || T_OBJ != dpnode->desc.type) {
+            PR_ERR("dpid %d not an obj dp", dps[i].id);
+            return OPRT_SVC_DP_ID_NOT_FOUND;
+        }
+        if (dps[i].type != dpnode->desc.prop_tp) {
+            PR_ERR("dpid %d type not match:%d %d", dps[i].id, dps[i].type, dpnode->desc.prop_tp);
+            return OPRT_SVC_DP_TP_NOT_MATCH;
+        }
+    }
+
+    if (NULL == s_coalesce_work) {
+        return OPRT_RESOURCE_NOT_READY;
+    }
+
+    tal_mutex_lock(s_coalesce_mutex);
+    dp_coalesce_dev_t *dev = dp_coalesce_dev_get(devid, TRUE);
+    if (NULL == dev) {
+        tal_mutex_unlock(s_coalesce_mutex);
+        return OPRT_MALLOC_FAILED;
+    }
+    dev->client = client;
+    dev->flags |= flags;
+    s_coalesce_stat.requests++;
+
+    for (i = 0; i < dpscnt; i++) {
+        dp_node_t *dpnode = dp_node_find(schema, dps[i].id);
+        bool merge = (DST_NONE == dpnode->desc.stat) && (TRIG_DIRECT != dpnode->desc.trig);
+
+        s_coalesce_stat.dps++;
+        rt = dp_coalesce_put(dev, &dps[i], merge, tal_system_get_millisecond());
+        if (OPRT_EXCEED_UPPER_LIMIT == rt) {
+            // a value that must not be dropped is pending or the device is full
+            tal_mutex_unlock(s_coalesce_mutex);
+            dp_coalesce_flush(dev->devid, TRUE);
+            tal_mutex_lock(s_coalesce_mutex);
+            rt = dp_coalesce_put(dev, &dps[i], merge, tal_system_get_millisecond());
+        }
+        if (OPRT_OK != rt) {
+            // every pending dp is held back by its minimum interval
+            PR_ERR("dpid %d not queued:%d", dps[i].id, rt);
+            break;
+        }
+    }
+
+    bool full = (dev->num >= DP_REPORT_MAX_DPS);
+    dp_coalesce_schedule(tal_system_get_millisecond());
+    tal_mutex_unlock(s_coalesce_mutex);
+
+    if (full) {
+        dp_coalesce_flush(dev->devid, TRUE);
+    }
+
+    return rt;
+}
+
+/**
+ * @brief Sets the minimum interval between two reports of a state dp.
+ *
+ * @param devid The device ID.
+ * @param dpid The dp ID.
+ * @param interval_ms The minimum interval, 0 to remove the policy.
+ *
+ * @return OPRT_OK on success, or a negative error code on failure.
+ */
+int tuya_iot_dp_report_interval_set(const char *devid, uint8_t dpid, uint32_t interval_ms)
+{
+    OPERATE_RET rt = OPRT_OK;
+
+    if (NULL == devid) {
+        return OPRT_INVALID_PARM;
+    }
+    if (NULL == s_coalesce_work) {
+        return OPRT_RESOURCE_NOT_READY;
+    }
+
+    tal_mutex_lock(s_coalesce_mutex);
+    dp_coalesce_dev_t *dev = dp_coalesce_dev_get(devid, TRUE);
+    if (NULL == dev) {
+        tal_mutex_unlock(s_coalesce_mutex);
+        return OPRT_MALLOC_FAILED;
+    }
+
+    dp_rate_t *rate = dp_coalesce_rate_get(dev, dpid);
+    if (0 == interval_ms) {
+        if (rate) {
+            *rate = dev->rate[--dev->rate_num];
+        }
+    } else if (rate) {
+        rate->interval_ms = interval_ms;
+    } else if (dev->rate_num < DP_REPORT_MAX_DPS) {
+        rate = &dev->rate[dev->rate_num++];
+        rate->id = dpid;
+        rate->interval_ms = interval_ms;
+        rate->last_ms = 0;
+    } else {
+        rt = OPRT_EXCEED_UPPER_LIMIT;
+    }
+    dp_coalesce_schedule(tal_system_get_millisecond());
+    tal_mutex_unlock(s_coalesce_mutex);
+
+    return rt;
+}
+
+/**
+ * @brief Sends the pending dps of every device now.
+ *
+ * @return OPRT_OK on success, or a negative error code on failure.
+ */
+int tuya_iot_dp_report_flush(void)
+{
+    if (NULL == s_coalesce_work) {
+        return OPRT_OK;
+    }
+
+    dp_coalesce_flush(NULL, TRUE);
+    return OPRT_OK;
+}
+
+/**
+ * @brief Reads the counters of the dp report aggregator.
+ *
+ * @param stat The counters.
+ * @param reset Clear the counters after reading them.
+ */
+void tuya_iot_dp_report_stat_get(dp_report_stat_t *stat, bool reset)
+{
+    if (NULL == stat) {
+        return;
+    }
+
+    if (s_coalesce_mutex) {
+        tal_mutex_lock(s_coalesce_mutex);
+    }
+    *stat = s_coalesce_stat;
+    if (reset) {
+        memset(&s_coalesce_stat, 0, sizeof(s_coalesce_stat));
+    }
+    if (s_coalesce_mutex) {
+        tal_mutex_unlock(s_coalesce_mutex);
+    }
+}
+
+#endif
@@ -60,6 +60,11 @@ static tuya_tls_pre_conn_cb s_pre_conn_cb = NULL;
 static mbedtls_entropy_context ty_entropy;
 static mbedtls_ctr_drbg_context ty_ctr_drbg;
 
+/* upper bounds of the handshake time buckets, the last bucket takes the rest */
+static const uint32_t s_handshake_hist_ms[TUYA_TLS_HANDSHAKE_HIST_NUM - 1] = {50, 100, 250, 500, 1000, 2000, 4000};
+static tuya_tls_handshake_stat_t s_handshake_stat;
+static MUTEX_HANDLE s_tls_mutex = NULL; // handshake statistics and session cache
+
 /* -------------------------------------------------------------------------- */
 /*                                  TLS Mutex                                 */
 /* -------------------------------------------------------------------------- */
@@ -227,6 +232,325 @@ int __tuya_tls_nv_seed_write(unsigned char *buf, size_t buf_len)
     return buf_len;
 }
 
+/* -------------------------------------------------------------------------- */
+/*                             TLS session cache                              */
+/* -------------------------------------------------------------------------- */
+#if defined(ENABLE_TLS_SESSION_CACHE) && (ENABLE_TLS_SESSION_CACHE == 1)
+#define TY_TLS_SESSION_KV "tls_ss_%08x"
+
+typedef struct {
+    uint32_t key;  // hash of host, port and mode, 0 if the slot is empty
+    uint32_t used; // tick of the last use, the oldest slot is replaced
+    TIME_T saved;  // posix time of the full handshake
+    mbedtls_ssl_session session;
+} tls_session_slot_t;
+
+static tls_session_slot_t s_session_cache[TLS_SESSION_CACHE_NUM];
+static uint32_t s_session_tick = 0;
+
+static uint32_t __tls_session_key(const char *hostname, int port, tuya_tls_mode_t mode)
+{
+    uint32_t hash = 2166136261U;
+
+    while (hostname && *hostname) {
+        hash = (hash ^ (uint8_t)*hostname++) * 16777619U;
+    }
+    hash = (hash ^ (uint32_t)port) * 16777619U;
+    hash = (hash ^ (uint32_t)mode) * 16777619U;
+    return hash ? hash : 1;
+}
+
+/* caller holds s_tls_mutex */
+static tls_session_slot_t *__tls_session_slot(uint32_t key, bool alloc)
+{
+    tls_session_slot_t *oldest = &s_session_cache[0];
+    uint32_t i;
+
+    for (i = 0; i < TLS_SESSION_CACHE_NUM; i++) {
+        if (s_session_cache[i].key == key) {
+            return &s_session_cache[i];
+        }
+        if (s_session_cache[i].used < oldest->used) {
+            oldest = &s_session_cache[i];
+        }
+    }
+    if (!alloc) {
+        return NULL;
+    }
+    if (oldest->key) {
+        mbedtls_ssl_session_free(&oldest->session);
+    }
+    mbedtls_ssl_session_init(&oldest->session);
+    oldest->key = key;
+    oldest->used = 0;
+    oldest->saved = 0;
+    return oldest;
+}
+
+/* caller holds s_tls_mutex, the kv record is deleted by __tls_session_kv_del once it is released */
+static void __tls_session_drop(tls_session_slot_t *slot)
+{
+    mbedtls_ssl_session_free(&slot->session);
+    memset(slot, 0, sizeof(tls_session_slot_t));
+}
+
+#if defined(ENABLE_TLS_SESSION_PERSIST) && (ENABLE_TLS_SESSION_PERSIST == 1)
+/* the kv functions access the flash, they are called without s_tls_mutex */
+static void __tls_session_kv_del(uint32_t key)
+{
+    char name[16];
+
+    snprintf(name, sizeof(name), TY_TLS_SESSION_KV, key);
+    tal_kv_del(name);
+}
+
+/* kv record: the posix time of the handshake, then mbedtls_ssl_session_save */
+static bool __tls_session_kv_load(uint32_t key, TIME_T *saved, mbedtls_ssl_session *session)
+{
+    char name[16];
+    uint8_t *data = NULL;
+    size_t len = 0;
+    bool loaded = false;
+
+    snprintf(name, sizeof(name), TY_TLS_SESSION_KV, key);
+    if (OPRT_OK != tal_kv_get(name, &data, &len)) {
+        return false;
+    }
+    if (len > sizeof(TIME_T)) {
+        memcpy(saved, data, sizeof(TIME_T));
+        mbedtls_ssl_session_init(session);
+        if (0 == mbedtls_ssl_session_load(session, data + sizeof(TIME_T), len - sizeof(TIME_T))) {
+            loaded = true;
+        } else {
+            mbedtls_ssl_session_free(session);
+        }
+    }
+    tal_kv_free(data);
+    if (!loaded) {
+        tal_kv_del(name);
+    }
+    return loaded;
+}
+
+/* caller holds s_tls_mutex, the record is written by __tls_session_kv_save once it is released */
+static uint8_t *__tls_session_kv_encode(tls_session_slot_t *slot, size_t *size)
+{
+    size_t len = 0;
+    uint8_t *data = NULL;
+
+    mbedtls_ssl_session_save(&slot->session, NULL, 0, &len);
+    data = tal_malloc(sizeof(TIME_T) + len);
+    if (NULL == data) {
+        return NULL;
+    }
+    memcpy(data, &slot->saved, sizeof(TIME_T));
+    if (0 != mbedtls_ssl_session_save(&slot->session, data + sizeof(TIME_T), len, &len)) {
+        tal_free(data);
+        return NULL;
+    }
+    *size = sizeof(TIME_T) + len;
+    return data;
+}
+
+/* writes and frees a record of __tls_session_kv_encode */
+static void __tls_session_kv_save(uint32_t key, uint8_t *data, size_t size)
+{
+    char name[16];
+
+    snprintf(name, sizeof(name), TY_TLS_SESSION_KV, key);
+    tal_kv_set(name, data, size);
+    tal_free(data);
+}
+
+/* caller holds s_tls_mutex, it is released while the kv record is read */
+static tls_session_slot_t *__tls_session_load(uint32_t key)
+{
+    tls_session_slot_t *slot = NULL;
+    mbedtls_ssl_session session;
+    TIME_T saved = 0;
+    bool loaded = false;
+
+    tal_mutex_unlock(s_tls_mutex);
+    loaded = __tls_session_kv_load(key, &saved, &session);
+    tal_mutex_lock(s_tls_mutex);
+    if (!loaded) {
+        return __tls_session_slot(key, false);
+    }
+
+    /* another handshake may have kept a newer session meanwhile */
+    slot = __tls_session_slot(key, false);
+    if (slot) {
+        mbedtls_ssl_session_free(&session);
+        return slot;
+    }
+    slot = __tls_session_slot(key, true);
+    mbedtls_ssl_session_free(&slot->session);
+    slot->session = session;
+    slot->saved = saved;
+    return slot;
+}
+#endif
+
+/**
+ * @brief offer the cached session of a host to a handshake
+ *
+ * @param[in] key session key
+ * @param[in] ssl ssl context, set up and not yet started
+ * @param[out] master master secret of the offered session, it is kept on
+ * resumption
+ *
+ * @return true if a session was offered
+ */
+static bool __tls_session_offer(uint32_t key, mbedtls_ssl_context *ssl, uint8_t *master)
+{
+    bool offered = false;
+    bool expired = false;
+    TIME_T now = tal_time_get_posix();
+
+    tal_mutex_lock(s_tls_mutex);
+    tls_session_slot_t *slot = __tls_session_slot(key, false);
+#if defined(ENABLE_TLS_SESSION_PERSIST) && (ENABLE_TLS_SESSION_PERSIST == 1)
+    if (NULL == slot) {
+        slot = __tls_session_load(key);
+    }
+#endif
+    /* a clock set after the handshake only makes the session look younger */
+    if (slot && now >= slot->saved && now - slot->saved > TLS_SESSION_LIFETIME_S) {
+        __tls_session_drop(slot);
+        slot = NULL;
+        expired = true;
+    }
+    if (slot && 0 == mbedtls_ssl_set_session(ssl, &slot->session)) {
+        slot->used = ++s_session_tick;
+        memcpy(master, slot->session.MBEDTLS_PRIVATE(master), sizeof(slot->session.MBEDTLS_PRIVATE(master)));
+        offered = true;
+    }
+    tal_mutex_unlock(s_tls_mutex);
+
+#if defined(ENABLE_TLS_SESSION_PERSIST) && (ENABLE_TLS_SESSION_PERSIST == 1)
+    if (expired) {
+        __tls_session_kv_del(key);
+    }
+#else
+    (void)expired;
+#endif
+
+    return offered;
+}
+
+/**
+ * @brief keep the session of a finished handshake
+ *
+ * @param[in] key session key
+ * @param[in] ssl ssl context after the handshake
+ * @param[in] resumed the handshake resumed the offered session
+ */
+static void __tls_session_keep(uint32_t key, mbedtls_ssl_context *ssl, bool resumed)
+{
+#if defined(ENABLE_TLS_SESSION_PERSIST) && (ENABLE_TLS_SESSION_PERSIST == 1)
+    uint8_t *record = NULL;
+    size_t record_len = 0;
+#endif
+    bool dropped = false;
+
+    tal_mutex_lock(s_tls_mutex);
+    tls_session_slot_t *slot = __tls_session_slot(key, true);
+    TIME_T saved = resumed ? slot->saved : tal_time_get_posix();
+
+    /* a resumption may come with a new ticket, keep the session as it is now */
+    mbedtls_ssl_session_free(&slot->session);
+    mbedtls_ssl_session_init(&slot->session);
+    if (0 != mbedtls_ssl_get_session(ssl, &slot->session)) {
+        __tls_session_drop(slot);
+        dropped = true;
+    } else {
+        slot->saved = saved;
+        slot->used = ++s_session_tick;
+#if defined(ENABLE_TLS_SESSION_PERSIST) && (ENABLE_TLS_SESSION_PERSIST == 1)
+        record = __tls_session_kv_encode(slot, &record_len);
+#endif
+    }
+    tal_mutex_unlock(s_tls_mutex);
+
+#if defined(ENABLE_TLS_SESSION_PERSIST) && (ENABLE_TLS_SESSION_PERSIST == 1)
+    if (record) {
+        __tls_session_kv_save(key, record, record_len);
+    } else if (dropped) {
+        __tls_session_kv_del(key);
+    }
+#else
+    (void)dropped;
+#endif
+}
+
+/**
+ * @brief forget the session of a host after a failed handshake
+ *
+ * @param[in] key session key
+ */
+static void __tls_session_forget(uint32_t key)
+{
+    bool dropped = false;
+
+    tal_mutex_lock(s_tls_mutex);
+    tls_session_slot_t *slot = __tls_session_slot(key, false);
+    if (slot) {
+        __tls_session_drop(slot);
+        dropped = true;
+    }
+    tal_mutex_unlock(s_tls_mutex);
+
+#if defined(ENABLE_TLS_SESSION_PERSIST) && (ENABLE_TLS_SESSION_PERSIST == 1)
+    if (dropped) {
+        __tls_session_kv_del(key);
+    }
+#else
+    (void)dropped;
+#endif
+}
+#endif
+
+static void __tls_handshake_stat_add(OPERATE_RET result, bool resumed, uint32_t cost_ms)
+{
+    uint32_t i = 0;
+
+    while (i < TUYA_TLS_HANDSHAKE_HIST_NUM - 1 && cost_ms >= s_handshake_hist_ms[i]) {
+        i++;
+    }
+
+    tal_mutex_lock(s_tls_mutex);
+    if (OPRT_OK != result) {
+        s_handshake_stat.failed++;
+    } else if (resumed) {
+        s_handshake_stat.resumed++;
+        s_handshake_stat.resumed_hist[i]++;
+    } else {
+        s_handshake_stat.full++;
+        s_handshake_stat.full_hist[i]++;
+    }
+    tal_mutex_unlock(s_tls_mutex);
+}
+
+/**
+ * @brief Gets the handshake statistics.
+ *
+ * @param[out] stat The statistics since the start or the last reset.
+ * @param[in] reset Whether to clear the statistics after reading them.
+ */
+void tuya_tls_handshake_stat_get(tuya_tls_handshake_stat_t *stat, bool reset)
+{
+    if (NULL == stat) {
+        return;
+    }
+
+    tal_mutex_lock(s_tls_mutex);
+    *stat = s_handshake_stat;
+    if (reset) {
+        memset(&s_handshake_stat, 0, sizeof(s_handshake_stat));
+    }
+    tal_mutex_unlock(s_tls_mutex);
+}
+
 /**
  * @brief Registers an X.509 certificate in DER format.
  *
@@ -425,6 +749,14 @@ OPERATE_RET tuya_tls_init(void)
     }
     mbedtls_ctr_drbg_set_prediction_resistance(&ty_ctr_drbg, MBEDTLS_CTR_DRBG_PR_OFF);
 
+    if (NULL == s_tls_mutex) {
+        op_ret = tal_mutex_create_init(&s_tls_mutex);
+        if (op_ret) {
+            PR_ERR("tls mutex create fail. %d", op_ret);
+            goto exit;
+        }
+    }
+
     PR_NOTICE("tuya_tls_init ok!");
 
     return OPRT_OK;
@@ -639,6 +971,13 @@ OPERATE_RET tuya_tls_connect(tuya_tls_hander p_tls_handler, char *hostname, int
     mbedtls_ssl_set_bio(p_ssl_ctx, tls_context, __tuya_tls_socket_send_cb, __tuya_tls_socket_recv_cb, NULL);
     PR_DEBUG("socket fd is set. set to inner send/recv to handshake");
 
+    bool resumed = false;
+#if defined(ENABLE_TLS_SESSION_CACHE) && (ENABLE_TLS_SESSION_CACHE == 1)
+    uint8_t master[sizeof(p_ssl_ctx->MBEDTLS_PRIVATE(session_negotiate)->MBEDTLS_PRIVATE(master))];
+    uint32_t session_key = __tls_session_key(hostname, port_num, tls_context->config.mode);
+    bool offered = __tls_session_offer(session_key, p_ssl_ctx, master);
+#endif
+    SYS_TIME_T start_ms = tal_system_get_millisecond();
     TIME_T cur_time = tal_time_get_posix();
 
     while ((op_ret = mbedtls_ssl_handshake(p_ssl_ctx)) != 0) {
@@ -674,6 +1013,18 @@ OPERATE_RET tuya_tls_connect(tuya_tls_hander p_tls_handler, char *hostname, int
         }
     }
 
+#if defined(ENABLE_TLS_SESSION_CACHE) && (ENABLE_TLS_SESSION_CACHE == 1)
+    if (op_ret == OPRT_OK) {
+        /* a resumed session keeps its master secret, a full handshake makes a new one */
+        resumed = offered && 0 == memcmp(master, p_ssl_ctx->MBEDTLS_PRIVATE(session)->MBEDTLS_PRIVATE(master),
+                                          sizeof(master));
+        __tls_session_keep(session_key, p_ssl_ctx, resumed);
+    } else if (offered) {
+        __tls_session_forget(session_key);
+    }
+#endif
+    __tls_handshake_stat_add(op_ret, resumed, (uint32_t)(tal_system_get_millisecond() - start_ms));
+
     if (op_ret != OPRT_OK) {
         goto tuya_tls_connect_EXIT;
     }
@@ -684,8 +1035,9 @@ OPERATE_RET tuya_tls_connect(tuya_tls_hander p_tls_handler, char *hostname, int
                             tls_context->config.f_recv, NULL);
     }
 
-    PR_DEBUG("TUYA_TLS Success Connect %s:%d Suit:%s", (hostname ? hostname : ""), port_num,
-             mbedtls_ssl_get_ciphersuite(p_ssl_ctx));
+    PR_DEBUG("TUYA_TLS Success Connect %s:%d Suit:%s %s in %d ms", (hostname ? hostname : ""), port_num,
+             mbedtls_ssl_get_ciphersuite(p_ssl_ctx), resumed ? "resumed" : "full",
+             (int)(tal_system_get_millisecond() - start_ms));
 
     return OPRT_OK;
 
@@ -783,6 +1135,23 @@ int tuya_tls_read(tuya_tls_hander tls_handler, uint8_t *buf, uint32_t len)
     return value;
 }
 
+/**
+ * @brief Gets the number of decrypted bytes waiting in the TLS context.
+ *
+ * @param[in] tls_handler The TLS handler.
+ *
+ * @return The number of bytes tuya_tls_read returns without reading the socket.
+ */
+int tuya_tls_read_pending(tuya_tls_hander tls_handler)
+{
+    if (tls_handler == NULL) {
+        return 0;
+    }
+
+    tuya_mbedtls_context_t *tls_context = (tuya_mbedtls_context_t *)tls_handler;
+    return (int)mbedtls_ssl_get_bytes_avail(&(tls_context->ssl_ctx));
+}
+
 /**
  * @brief generated random
  *
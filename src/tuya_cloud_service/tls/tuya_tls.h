@@ -91,6 +91,17 @@ typedef struct {
     void *user_data;
 } tuya_tls_config_t;
 
+#define TUYA_TLS_HANDSHAKE_HIST_NUM 8
+
+/* handshake time buckets: < 50, 100, 250, 500, 1000, 2000, 4000 ms, the rest */
+typedef struct {
+    uint32_t full;    // handshakes with the key exchange and the certificate chain
+    uint32_t resumed; // handshakes that resumed a cached session
+    uint32_t failed;
+    uint32_t full_hist[TUYA_TLS_HANDSHAKE_HIST_NUM];
+    uint32_t resumed_hist[TUYA_TLS_HANDSHAKE_HIST_NUM];
+} tuya_tls_handshake_stat_t;
+
 /**
  * @brief Get mbedtls random data in the specified length
  *
@@ -198,6 +209,18 @@ int tuya_tls_write(tuya_tls_hander tls_handler, uint8_t *buf, uint32_t len);
  */
 int tuya_tls_read(tuya_tls_hander tls_handler, uint8_t *buf, uint32_t len);
 
+/**
+ * @brief number of decrypted bytes waiting in the tls context
+ *
+ * Those bytes are read without data on the socket, so a socket poll alone
+ * does not see them.
+ *
+ * @param[in] tls_handler refer to tuya_tls_hander
+ *
+ * @return number of bytes tuya_tls_read returns without reading the socket
+ */
+int tuya_tls_read_pending(tuya_tls_hander tls_handler);
+
 /**
  * @brief generated random
  *
@@ -208,6 +231,17 @@ int tuya_tls_read(tuya_tls_hander tls_handler, uint8_t *buf, uint32_t len);
  */
 OPERATE_RET tuya_tls_disconnect(tuya_tls_hander tls_handler);
 
+/**
+ * @brief get the handshake statistics
+ *
+ * The time histograms of full and resumed handshakes show what the session
+ * cache (ENABLE_TLS_SESSION_CACHE) saves.
+ *
+ * @param[out] stat statistics since the start or the last reset
+ * @param[in] reset clear the statistics after reading them
+ */
+void tuya_tls_handshake_stat_get(tuya_tls_handshake_stat_t *stat, bool reset);
+
 /**
  * @brief Retrieves the configuration for the Tuya TLS PSK mode.
  *
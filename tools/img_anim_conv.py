@@ -0,0 +1,646 @@
+#!/usr/bin/env python3
+"""
+Animation asset converter
+Turns GIF and PNG images into the tile animations played by lv_tile_anim
+
+The frames are mapped to one palette of RGB565 colors, at most 256, and cut
+into tiles. The first frame stores every tile, each later frame only the
+tiles that differ from the frame before it, and a last entry holds the tiles
+that take the last frame back to the first one for the next loop. A tile is
+stored as a fill of one palette index, as an LZ4 block of its indices, as an
+LZ4 block that uses the indices the tile had before as its dictionary, or raw
+when nothing is smaller. The same data is stored once.
+
+The input is an animated GIF, a sequence of PNG frames, or a C file holding
+the bytes of a GIF or PNG in its first array, like the images of LVGL.
+
+Usage:
+    img_anim_conv.py -o Sad128.c Sad128.gif
+    img_anim_conv.py -o Sad128.c --name Sad128 old/Sad128.c
+    img_anim_conv.py -o blink.c --delay 33 blink_0.png blink_1.png blink_2.png
+"""
+
+import os
+import re
+import sys
+import zlib
+import struct
+import argparse
+
+TILE_CODEC_FILL = 0
+TILE_CODEC_RAW = 1
+TILE_CODEC_LZ4 = 2
+TILE_CODEC_LZ4_DELTA = 3
+
+MAX_COLORS = 256
+MAX_TILES = 1 << 14
+
+
+class Frame:
+    """One RGBA8888 frame and how long it is shown"""
+
+    def __init__(self, width, height, pixels, delay_ms):
+        self.width = width
+        self.height = height
+        self.pixels = pixels
+        self.delay_ms = delay_ms
+
+
+# ---------------------------------------------------------------- GIF input
+
+def _lzw_decode(data, min_code_size, pixel_cnt):
+    clear = 1 << min_code_size
+    end = clear + 1
+    code_size = min_code_size + 1
+    table = [bytes([i]) for i in range(clear)] + [b"", b""]
+    out = bytearray()
+    prev = None
+    bit_pos = 0
+    bits = int.from_bytes(data, "little")
+    total_bits = len(data) * 8
+
+    while bit_pos + code_size <= total_bits and len(out) < pixel_cnt:
+        code = (bits >> bit_pos) & ((1 << code_size) - 1)
+        bit_pos += code_size
+
+        if code == clear:
+            code_size = min_code_size + 1
+            table = table[:end + 1]
+            prev = None
+            continue
+        if code == end:
+            break
+
+        if code < len(table):
+            entry = table[code]
+            if prev is not None and len(table) < 4096:
+                table.append(prev + entry[:1])
+        elif prev is not None:
+            entry = prev + prev[:1]
+            if len(table) < 4096:
+                table.append(entry)
+        else:
+            raise ValueError("corrupt LZW data")
+
+        out += entry
+        prev = entry
+        if len(table) == (1 << code_size) and code_size < 12:
+            code_size += 1
+
+    return bytes(out[:pixel_cnt]).ljust(pixel_cnt, b"\0")
+
+
+def _read_sub_blocks(data, pos):
+    out = bytearray()
+    while True:
+        size = data[pos]
+        pos += 1
+        if size == 0:
+            return bytes(out), pos
+        out += data[pos:pos + size]
+        pos += size
+
+
+def load_gif(data):
+    """Composes the frames of a GIF, the disposal methods are applied"""
+    if data[:6] not in (b"GIF87a", b"GIF89a"):
+        raise ValueError("not a GIF")
+
+    width, height, flags, bg_index, _ = struct.unpack_from("<HHBBB", data, 6)
+    pos = 13
+    global_table = None
+    if flags & 0x80:
+        size = 3 * (2 << (flags & 0x07))
+        global_table = data[pos:pos + size]
+        pos += size
+
+    canvas = [(0, 0, 0, 0)] * (width * height)
+    frames = []
+    loop_cnt = 0
+    delay_ms, disposal, transparent = 0, 0, None
+
+    while pos < len(data):
+        block = data[pos]
+        pos += 1
+
+        if block == 0x3B:
+            break
+
+        if block == 0x21:
+            label = data[pos]
+            pos += 1
+            body, pos = _read_sub_blocks(data, pos)
+            if label == 0xF9 and len(body) >= 4:
+                packed, delay, index = struct.unpack_from("<BHB", body, 0)
+                disposal = (packed >> 2) & 0x07
+                delay_ms = delay * 10
+                transparent = index if packed & 0x01 else None
+            elif label == 0xFF and body[:11] in (b"NETSCAPE2.0", b"ANIMEXTS1.0") and len(body) >= 14:
+                loop_cnt, = struct.unpack_from("<H", body, 12)
+            continue
+
+        if block != 0x2C:
+            raise ValueError("unknown GIF block 0x%02x" % block)
+
+        x, y, w, h, packed = struct.unpack_from("<HHHHB", data, pos)
+        pos += 9
+        table = global_table
+        if packed & 0x80:
+            size = 3 * (2 << (packed & 0x07))
+            table = data[pos:pos + size]
+            pos += size
+        min_code_size = data[pos]
+        pos += 1
+        lzw, pos = _read_sub_blocks(data, pos)
+        indices = _lzw_decode(lzw, min_code_size, w * h)
+
+        rows = list(range(h))
+        if packed & 0x40:
+            rows = list(range(0, h, 8)) + list(range(4, h, 8)) + list(range(2, h, 4)) + list(range(1, h, 2))
+
+        previous = list(canvas) if disposal == 3 else None
+        for src_row, dst_row in enumerate(rows):
+            cy = y + dst_row
+            if cy >= height:
+                continue
+            for col in range(w):
+                cx = x + col
+                index = indices[src_row * w + col]
+                if cx >= width or index == transparent:
+                    continue
+                canvas[cy * width + cx] = (table[index * 3], table[index * 3 + 1], table[index * 3 + 2], 255)
+
+        frames.append(Frame(width, height, list(canvas), delay_ms))
+
+        if disposal == 2:
+            for cy in range(y, min(y + h, height)):
+                for cx in range(x, min(x + w, width)):
+                    canvas[cy * width + cx] = (0, 0, 0, 0)
+        elif disposal == 3:
+            canvas = previous
+        delay_ms, disposal, transparent = 0, 0, None
+
+    return frames, loop_cnt
+
+
+# ---------------------------------------------------------------- PNG input
+
+def _unfilter(raw, width, height, bpp, stride):
+    out = bytearray(stride * height)
+    prev = bytearray(stride)
+    pos = 0
+    for row in range(height):
+        ftype = raw[pos]
+        line = bytearray(raw[pos + 1:pos + 1 + stride])
+        pos += 1 + stride
+        for i in range(stride):
+            a = line[i - bpp] if i >= bpp else 0
+            b = prev[i]
+            c = prev[i - bpp] if i >= bpp else 0
+            if ftype == 1:
+                line[i] = (line[i] + a) & 0xFF
+            elif ftype == 2:
+                line[i] = (line[i] + b) & 0xFF
+            elif ftype == 3:
+                line[i] = (line[i] + ((a + b) >> 1)) & 0xFF
+            elif ftype == 4:
+                p = a + b - c
+                pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+                pred = a if pa <= pb and pa <= pc else (b if pb <= pc else c)
+                line[i] = (line[i] + pred) & 0xFF
+        out[row * stride:(row + 1) * stride] = line
+        prev = line
+    return out
+
+
+def load_png(data, delay_ms):
+    """Decodes a non interlaced PNG of 8 bits per channel or a palette"""
+    if data[:8] != b"\x89PNG\r\n\x1a\n":
+        raise ValueError("not a PNG")
+
+    pos = 8
+    idat = bytearray()
+    palette, trns = b"", b""
+    while pos < len(data):
+        length, ctype = struct.unpack_from(">I4s", data, pos)
+        body = data[pos + 8:pos + 8 + length]
+        pos += 12 + length
+        if ctype == b"IHDR":
+            width, height, depth, color, _, _, interlace = struct.unpack(">IIBBBBB", body)
+        elif ctype == b"PLTE":
+            palette = body
+        elif ctype == b"tRNS":
+            trns = body
+        elif ctype == b"IDAT":
+            idat += body
+        elif ctype == b"IEND":
+            break
+
+    if interlace:
+        raise ValueError("interlaced PNG is not supported")
+    if color != 3 and depth != 8:
+        raise ValueError("only 8 bit PNG channels are supported")
+
+    channels = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}[color]
+    bits = channels * depth
+    stride = (width * bits + 7) // 8
+    rows = _unfilter(zlib.decompress(bytes(idat)), width, height, max(1, bits // 8), stride)
+
+    pixels = []
+    for y in range(height):
+        line = rows[y * stride:(y + 1) * stride]
+        for x in range(width):
+            if color == 3:
+                bit = x * depth
+                index = (line[bit // 8] >> (8 - depth - bit % 8)) & ((1 << depth) - 1)
+                alpha = trns[index] if index < len(trns) else 255
+                pixels.append((palette[index * 3], palette[index * 3 + 1], palette[index * 3 + 2], alpha))
+            elif color == 0:
+                v = line[x]
+                pixels.append((v, v, v, 255))
+            elif color == 4:
+                v = line[x * 2]
+                pixels.append((v, v, v, line[x * 2 + 1]))
+            elif color == 2:
+                pixels.append((line[x * 3], line[x * 3 + 1], line[x * 3 + 2], 255))
+            else:
+                pixels.append(tuple(line[x * 4:x * 4 + 4]))
+
+    return Frame(width, height, pixels, delay_ms)
+
+
+def load_c_array(path):
+    """Reads back the bytes of the first array of a C image file"""
+    with open(path, "r") as f:
+        text = f.read()
+    start = text.find("[] = {")
+    if start < 0:
+        raise ValueError("%s has no array" % path)
+    body = text[start:text.find("};", start)]
+    return bytes(int(v, 16) for v in re.findall(r"0x([0-9a-fA-F]{2})\b", body))
+
+
+def load_frames(paths, delay_ms):
+    if len(paths) == 1:
+        data = load_c_array(paths[0]) if paths[0].endswith(".c") else open(paths[0], "rb").read()
+        if data[:3] == b"GIF":
+            return load_gif(data)
+        return [load_png(data, delay_ms)], 0
+
+    frames = [load_png(open(p, "rb").read(), delay_ms) for p in paths]
+    if any((f.width, f.height) != (frames[0].width, frames[0].height) for f in frames):
+        raise ValueError("the PNG frames differ in size")
+    return frames, 0
+
+
+# ---------------------------------------------------------------- palette
+
+def _rgb565(r, g, b):
+    return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3)
+
+
+def _to_key(px):
+    r, g, b, a = px
+    if a == 0:
+        return (0, 0)
+    return (_rgb565(r, g, b), a)
+
+
+def _median_cut(colors, count):
+    """Reduces (rgb565, alpha) keys weighted by use to count colors"""
+    def channels(key):
+        c, a = key
+        return ((c >> 11) << 3, ((c >> 5) & 0x3F) << 2, (c & 0x1F) << 3, a)
+
+    boxes = [list(colors.items())]
+    while len(boxes) < count:
+        best, best_range, best_ch = None, -1, 0
+        for i, box in enumerate(boxes):
+            if len(box) < 2:
+                continue
+            for ch in range(4):
+                values = [channels(k)[ch] for k, _ in box]
+                spread = max(values) - min(values)
+                if spread > best_range:
+                    best, best_range, best_ch = i, spread, ch
+        if best is None:
+            break
+        box = sorted(boxes.pop(best), key=lambda kv: channels(kv[0])[best_ch])
+        total = sum(n for _, n in box)
+        acc, cut = 0, 1
+        for cut in range(1, len(box)):
+            acc += box[cut - 1][1]
+            if acc * 2 >= total:
+                break
+        boxes += [box[:cut], box[cut:]]
+
+    mapping, palette = {}, []
+    for box in boxes:
+        total = sum(n for _, n in box)
+        avg = [sum(channels(k)[ch] * n for k, n in box) // total for ch in range(4)]
+        entry = (0, 0) if avg[3] == 0 else (_rgb565(*avg[:3]), avg[3])
+        for k, _ in box:
+            mapping[k] = len(palette)
+        palette.append(entry)
+    return palette, mapping
+
+
+def build_palette(frames, max_colors):
+    colors = {}
+    for frame in frames:
+        for px in frame.pixels:
+            key = _to_key(px)
+            colors[key] = colors.get(key, 0) + 1
+
+    if len(colors) <= max_colors:
+        palette = sorted(colors, key=lambda k: -colors[k])
+        mapping = {k: i for i, k in enumerate(palette)}
+    else:
+        palette, mapping = _median_cut(colors, max_colors)
+
+    indexed = [bytes(mapping[_to_key(px)] for px in frame.pixels) for frame in frames]
+    return palette, indexed, len(colors)
+
+
+# ---------------------------------------------------------------- LZ4
+
+LZ4_MIN_MATCH = 4
+LZ4_LAST_LITERALS = 5
+LZ4_MF_LIMIT = 12
+
+
+def _lz4_length(n):
+    out = bytearray()
+    while n >= 255:
+        out.append(255)
+        n -= 255
+    out.append(n)
+    return out
+
+
+def lz4_compress(src, dictionary=b""):
+    """Greedy LZ4 block compression, decoded by LZ4_decompress_safe_usingDict"""
+    out = bytearray()
+    src = dictionary + src
+    n = len(src)
+    anchor = pos = len(dictionary)
+    table = {src[i:i + 4]: i for i in range(max(0, len(dictionary) - 3))}
+
+    while n >= LZ4_MF_LIMIT and pos <= n - LZ4_MF_LIMIT:
+        key = src[pos:pos + 4]
+        ref = table.get(key)
+        table[key] = pos
+        if ref is None or pos - ref > 0xFFFF:
+            pos += 1
+            continue
+
+        length = 4
+        limit = n - LZ4_LAST_LITERALS
+        while pos + length < limit and src[ref + length] == src[pos + length]:
+            length += 1
+
+        lit = pos - anchor
+        ml = length - LZ4_MIN_MATCH
+        out.append((min(lit, 15) << 4) | min(ml, 15))
+        if lit >= 15:
+            out += _lz4_length(lit - 15)
+        out += src[anchor:pos]
+        out += struct.pack("<H", pos - ref)
+        if ml >= 15:
+            out += _lz4_length(ml - 15)
+
+        for i in range(pos + 1, min(pos + length, n - 3)):
+            table[src[i:i + 4]] = i
+        pos += length
+        anchor = pos
+
+    lit = n - anchor
+    out.append(min(lit, 15) << 4)
+    if lit >= 15:
+        out += _lz4_length(lit - 15)
+    out += src[anchor:]
+    return bytes(out)
+
+
+def lz4_decompress(src, size, dictionary=b""):
+    """Reference decoder, used to check the blocks before they are written"""
+    out = bytearray(dictionary)
+    pos = 0
+    while pos < len(src):
+        token = src[pos]
+        pos += 1
+        lit = token >> 4
+        if lit == 15:
+            while True:
+                lit += src[pos]
+                pos += 1
+                if src[pos - 1] != 255:
+                    break
+        out += src[pos:pos + lit]
+        pos += lit
+        if pos >= len(src):
+            break
+        offset = src[pos] | (src[pos + 1] << 8)
+        pos += 2
+        ml = token & 0x0F
+        if ml == 15:
+            while True:
+                ml += src[pos]
+                pos += 1
+                if src[pos - 1] != 255:
+                    break
+        for _ in range(ml + LZ4_MIN_MATCH):
+            out.append(out[-offset])
+    if len(out) != len(dictionary) + size:
+        raise ValueError("LZ4 round trip failed")
+    return bytes(out[len(dictionary):])
+
+
+# ---------------------------------------------------------------- tiles
+
+class Animation:
+    """The tile stream of lv_tile_anim_dsc_t"""
+
+    def __init__(self, width, height, tile_w, tile_h):
+        self.width = width
+        self.height = height
+        self.tile_w = tile_w
+        self.tile_h = tile_h
+        self.cols = (width + tile_w - 1) // tile_w
+        self.rows = (height + tile_h - 1) // tile_h
+        self.tiles = []     # (index, codec, data offset, data size)
+        self.frames = []    # (delay_ms, first tile, tile count)
+        self.data = bytearray()
+        self.shared = {}
+        self.codec_cnt = [0, 0, 0, 0]
+
+    def tile_pixels(self, indexed, tile):
+        tx, ty = tile % self.cols, tile // self.cols
+        x0, y0 = tx * self.tile_w, ty * self.tile_h
+        w = min(self.tile_w, self.width - x0)
+        h = min(self.tile_h, self.height - y0)
+        return b"".join(indexed[(y0 + y) * self.width + x0:(y0 + y) * self.width + x0 + w] for y in range(h))
+
+    def add_tile(self, tile, pixels, before):
+        codec, payload = TILE_CODEC_RAW, pixels
+        if pixels.count(pixels[0]) == len(pixels):
+            codec, payload = TILE_CODEC_FILL, pixels[:1]
+        else:
+            candidates = [(TILE_CODEC_LZ4, lz4_compress(pixels), b"")]
+            if before is not None:
+                candidates.append((TILE_CODEC_LZ4_DELTA, lz4_compress(pixels, before), before))
+            for cand_codec, packed, dictionary in candidates:
+                if len(packed) < len(payload):
+                    if lz4_decompress(packed, len(pixels), dictionary) != pixels:
+                        raise ValueError("LZ4 round trip failed")
+                    codec, payload = cand_codec, packed
+
+        # a delta block decodes to the same tile only from the same dictionary
+        key = (codec, payload, before if codec == TILE_CODEC_LZ4_DELTA else None)
+        if key not in self.shared:
+            self.shared[key] = len(self.data)
+            self.data += payload
+        self.tiles.append((tile, codec, self.shared[key], len(payload)))
+        self.codec_cnt[codec] += 1
+
+    def add_frame(self, delay_ms, indexed, prev):
+        first = len(self.tiles)
+        for tile in range(self.cols * self.rows):
+            pixels = self.tile_pixels(indexed, tile)
+            before = None if prev is None else self.tile_pixels(prev, tile)
+            if pixels != before:
+                self.add_tile(tile, pixels, before)
+        self.frames.append((delay_ms, first, len(self.tiles) - first))
+
+
+def build_animation(frames, indexed, tile_w, tile_h, min_delay):
+    anim = Animation(frames[0].width, frames[0].height, tile_w, tile_h)
+    if anim.cols * anim.rows > MAX_TILES:
+        raise ValueError("more than %d tiles, use larger ones" % MAX_TILES)
+    prev = None
+    for frame, pixels in zip(frames, indexed):
+        anim.add_frame(max(frame.delay_ms, min_delay), pixels, prev)
+        prev = pixels
+    # back from the last frame to the first one, played when the animation loops
+    anim.add_frame(0, indexed[0], prev)
+    return anim
+
+
+# ---------------------------------------------------------------- C output
+
+def _c_bytes(data, indent="    ", per_line=16):
+    lines = []
+    for i in range(0, len(data), per_line):
+        lines.append(indent + ", ".join("0x%02x" % b for b in data[i:i + per_line]) + ",")
+    return "\n".join(lines)
+
+
+def write_c(path, name, source, anim, palette, loop_cnt):
+    has_alpha = any(a != 255 for _, a in palette)
+    attr = "LV_ATTRIBUTE_IMG_" + name.upper()
+    out = []
+    out.append("/**")
+    out.append(" * @file %s" % os.path.basename(path))
+    out.append(" * @brief Tile animation generated by tools/img_anim_conv.py from %s" % os.path.basename(source))
+    out.append(" */")
+    out.append("")
+    out.append('#include "lv_tile_anim.h"')
+    out.append("")
+    out.append("#if LV_USE_TILE_ANIM")
+    out.append("")
+    out.append("#ifndef LV_ATTRIBUTE_MEM_ALIGN")
+    out.append("#define LV_ATTRIBUTE_MEM_ALIGN")
+    out.append("#endif")
+    out.append("")
+    out.append("#ifndef %s" % attr)
+    out.append("#define %s" % attr)
+    out.append("#endif")
+    out.append("")
+    out.append("static const uint16_t %s_palette[] = {" % name)
+    for i in range(0, len(palette), 8):
+        out.append("    " + ", ".join("0x%04x" % c for c, _ in palette[i:i + 8]) + ",")
+    out.append("};")
+    out.append("")
+    if has_alpha:
+        out.append("static const uint8_t %s_alpha[] = {" % name)
+        out.append(_c_bytes(bytes(a for _, a in palette)))
+        out.append("};")
+        out.append("")
+    out.append("static const lv_tile_anim_tile_t %s_tiles[] = {" % name)
+    for tile, codec, ofs, size in anim.tiles:
+        out.append("    {%d, %d, %d, %d}," % (ofs, size, tile, codec))
+    out.append("};")
+    out.append("")
+    out.append("static const lv_tile_anim_frame_t %s_frames[] = {" % name)
+    for delay, first, count in anim.frames:
+        out.append("    {%d, %d, %d}," % (delay, count, first))
+    out.append("};")
+    out.append("")
+    out.append("static const LV_ATTRIBUTE_MEM_ALIGN LV_ATTRIBUTE_LARGE_CONST %s uint8_t %s_data[] = {" % (attr, name))
+    out.append(_c_bytes(anim.data))
+    out.append("};")
+    out.append("")
+    out.append("const lv_tile_anim_dsc_t %s = {" % name)
+    out.append("    .w = %d," % anim.width)
+    out.append("    .h = %d," % anim.height)
+    out.append("    .tile_w = %d," % anim.tile_w)
+    out.append("    .tile_h = %d," % anim.tile_h)
+    out.append("    .frame_cnt = %d," % (len(anim.frames) - 1))
+    out.append("    .loop_cnt = %d," % loop_cnt)
+    out.append("    .palette_cnt = %d," % len(palette))
+    out.append("    .palette = %s_palette," % name)
+    out.append("    .palette_alpha = %s," % ("%s_alpha" % name if has_alpha else "NULL"))
+    out.append("    .frames = %s_frames," % name)
+    out.append("    .tiles = %s_tiles," % name)
+    out.append("    .data = %s_data," % name)
+    out.append("};")
+    out.append("")
+    out.append("#endif /*LV_USE_TILE_ANIM*/")
+    out.append("")
+
+    if os.path.dirname(path):
+        os.makedirs(os.path.dirname(path), exist_ok=True)
+    with open(path, "w") as f:
+        f.write("\n".join(out))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert GIF and PNG images into tile animations")
+    parser.add_argument("inputs", nargs="+", help="a GIF, PNG frames in order, or a C file holding a GIF or PNG")
+    parser.add_argument("-o", "--output", required=True, help="C file to write")
+    parser.add_argument("--name", help="name of the descriptor, the output file name by default")
+    parser.add_argument("--tile", type=int, default=16, help="tile width and height in pixels (default 16)")
+    parser.add_argument("--colors", type=int, default=MAX_COLORS, help="palette size limit (default 256)")
+    parser.add_argument("--delay", type=int, default=33, help="frame time of PNG frames in ms (default 33)")
+    parser.add_argument("--min-delay", type=int, default=20,
+                        help="shortest frame time in ms, GIF frames without delay get it (default 20)")
+    parser.add_argument("--loop", type=int, help="loop count, 0 for endless, from the GIF by default")
+    args = parser.parse_args()
+
+    if not 1 <= args.colors <= MAX_COLORS or not 1 <= args.tile <= 255:
+        parser.error("--colors must be 1-256 and --tile 1-255")
+
+    name = args.name or os.path.splitext(os.path.basename(args.output))[0]
+    frames, loop_cnt = load_frames(args.inputs, args.delay)
+    if args.loop is not None:
+        loop_cnt = args.loop
+
+    palette, indexed, color_cnt = build_palette(frames, args.colors)
+    anim = build_animation(frames, indexed, args.tile, args.tile, args.min_delay)
+    write_c(args.output, name, args.inputs[0], anim, palette, loop_cnt)
+
+    tile_cnt = anim.cols * anim.rows
+    delta = [count for _, _, count in anim.frames[1:-1]]
+    source_size = sum(len(load_c_array(p)) if p.endswith(".c") else os.path.getsize(p) for p in args.inputs)
+    sys.stderr.write("%s: %dx%d, %d frames, %d colors%s\n" %
+                     (name, anim.width, anim.height, len(frames), len(palette),
+                      "" if color_cnt <= len(palette) else " (from %d)" % color_cnt))
+    sys.stderr.write("  tiles: %d per frame, %.1f changed on average, %d fill / %d raw / %d lz4 / %d lz4 delta\n" %
+                     (tile_cnt, sum(delta) / len(delta) if delta else 0, *anim.codec_cnt))
+    sys.stderr.write("  data: %d bytes, source %d bytes, frame buffer %d bytes\n" %
+                     (len(anim.data) + len(anim.tiles) * 8 + len(palette) * 2, source_size,
+                      anim.width * anim.height * (3 if any(a != 255 for _, a in palette) else 2)))
+
+
+if __name__ == "__main__":
+    main()
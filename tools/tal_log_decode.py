@@ -0,0 +1,300 @@
+#!/usr/bin/env python3
+"""
+Binary log decoder
+Expands the frames written by a tal_log binary output terminal back to text
+
+The frames only carry the addresses of the format strings and file names,
+the strings are read back from the ELF of the firmware that wrote the log.
+The ELF must be the exact image running on the device and keep its symbol
+table (tal_log_bin_anchor is used to find the load offset).
+
+Usage:
+    tal_log_decode.py --elf app.elf log.bin
+    cat /dev/ttyUSB0 | tal_log_decode.py --elf app.elf -
+"""
+
+import sys
+import struct
+import argparse
+import datetime
+import re
+
+LOG_BIN_TYPE_SYNC = 0x00
+LOG_BIN_TYPE_LOG = 0x10
+LOG_BIN_TYPE_RAW = 0x20
+LOG_BIN_VERSION = 1
+LOG_BIN_ENDIAN_MARK = 0x01020304
+
+LEVEL_STR = ["E", "W", "N", "I", "D", "T"]
+
+SPEC_RE = re.compile(
+    r"%(?P<flags>[-+ #0]*)(?P<width>\*|\d+)?(?:\.(?P<prec>\*|\d*))?"
+    r"(?P<length>hh|h|ll|l|z|j|t|L)?(?P<conv>[%diouxXcspaAeEfFgG])")
+
+
+class ElfImage:
+    """Loadable sections and symbols of an ELF file"""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF":
+            raise ValueError("%s is not an ELF file" % path)
+
+        is_64 = self.data[4] == 2
+        self.endian = "<" if self.data[5] == 1 else ">"
+        if is_64:
+            shoff, = struct.unpack_from(self.endian + "Q", self.data, 0x28)
+            shentsize, shnum, shstrndx = struct.unpack_from(self.endian + "HHH", self.data, 0x3A)
+            sh_fmt = self.endian + "IIQQQQIIQQ"
+            sym_fmt, sym_size = self.endian + "IBBHQQ", 24
+        else:
+            shoff, = struct.unpack_from(self.endian + "I", self.data, 0x20)
+            shentsize, shnum, shstrndx = struct.unpack_from(self.endian + "HHH", self.data, 0x2E)
+            sh_fmt = self.endian + "IIIIIIIIII"
+            sym_fmt, sym_size = self.endian + "IIIBBH", 16
+
+        sections = []
+        for idx in range(shnum):
+            sections.append(struct.unpack_from(sh_fmt, self.data, shoff + idx * shentsize))
+
+        # (addr, offset, size) of the allocated sections with file content
+        self.segments = []
+        self.symbols = {}
+        for sh in sections:
+            sh_type, sh_flags, sh_addr, sh_offset, sh_size, sh_link = sh[1:7]
+            if sh_type != 8 and (sh_flags & 0x2) and sh_addr:  # not NOBITS, SHF_ALLOC
+                self.segments.append((sh_addr, sh_offset, sh_size))
+            if sh_type in (2, 11):  # SYMTAB, DYNSYM
+                str_off = sections[sh_link][4]
+                for pos in range(sh_offset, sh_offset + sh_size, sym_size):
+                    sym = struct.unpack_from(sym_fmt, self.data, pos)
+                    value = sym[4] if is_64 else sym[1]
+                    name = self._cstr(str_off + sym[0])
+                    if name and value:
+                        self.symbols.setdefault(name, value)
+
+    def _cstr(self, offset):
+        end = self.data.find(b"\x00", offset)
+        return self.data[offset:end].decode("utf-8", "replace")
+
+    def read_cstr(self, addr):
+        for seg_addr, seg_offset, seg_size in self.segments:
+            if seg_addr <= addr < seg_addr + seg_size:
+                return self._cstr(seg_offset + addr - seg_addr)
+        return None
+
+
+class ArgReader:
+    """Reads the arguments encoded by tal_log_args"""
+
+    def __init__(self, data, endian, sizes):
+        self.data = data
+        self.pos = 0
+        self.endian = endian
+        self.sizes = sizes
+
+    def int(self, size, signed):
+        fmt = {1: "b", 2: "h", 4: "i", 8: "q"}[size]
+        if not signed:
+            fmt = fmt.upper()
+        val, = struct.unpack_from(self.endian + fmt, self.data, self.pos)
+        self.pos += size
+        return val
+
+    def double(self):
+        val, = struct.unpack_from(self.endian + "d", self.data, self.pos)
+        self.pos += 8
+        return val
+
+    def str(self):
+        end = self.data.find(b"\x00", self.pos)
+        if end < 0:
+            raise struct.error("string not terminated")
+        val = self.data[self.pos:end].decode("utf-8", "replace")
+        self.pos = end + 1
+        return val
+
+
+def cobs_decode(frame):
+    out = bytearray()
+    pos = 0
+    while pos < len(frame):
+        code = frame[pos]
+        if code == 0 or pos + code > len(frame):
+            return None
+        out += frame[pos + 1:pos + code]
+        pos += code
+        if code < 0xFF and pos < len(frame):
+            out.append(0)
+    return bytes(out)
+
+
+def format_args(fmt, args):
+    """Expands a C printf format string with the encoded arguments"""
+    sizes = args.sizes
+    out = []
+    last = 0
+    for m in SPEC_RE.finditer(fmt):
+        out.append(fmt[last:m.start()])
+        last = m.end()
+        flags, width, prec, length, conv = m.group("flags", "width", "prec", "length", "conv")
+        if conv == "%":
+            out.append("%")
+            continue
+
+        if width == "*":
+            width = args.int(sizes["int"], True)
+            if width < 0:
+                flags, width = flags + "-", -width
+            width = str(width)
+        if prec == "*":
+            prec = args.int(sizes["int"], True)
+            prec = None if prec < 0 else str(prec)
+        spec = "%" + flags.replace("#", "" if conv in "ocsp" else "#") + (width or "") + \
+            ("." + prec if prec is not None else "")
+
+        if conv in "diouxXc":
+            size = sizes.get({"l": "long", "ll": "llong", "z": "size_t", "j": "intmax_t",
+                              "t": "ptrdiff_t"}.get(length, "int"))
+            val = args.int(size, conv in "di")
+            bits = {"hh": 8, "h": 16}.get(length)
+            if bits:
+                val &= (1 << bits) - 1
+                if conv in "di" and val >= 1 << (bits - 1):
+                    val -= 1 << bits
+            if conv == "c":
+                out.append((spec + "s") % chr(val & 0xFF))
+            elif conv == "o":
+                text = (spec + "o") % val
+                out.append(text.replace(oct(val)[2:], "0" + oct(val)[2:], 1) if "#" in flags and val else text)
+            else:
+                # C prints no 0x prefix for a zero value
+                spec = spec.replace("#", "") if val == 0 else spec
+                out.append((spec + {"i": "d", "u": "d"}.get(conv, conv)) % val)
+        elif conv == "p":
+            out.append((spec + "s") % hex(args.int(sizes["ptr"], False)))
+        elif conv == "s":
+            out.append((spec + "s") % args.str())
+        elif conv in "aA":
+            text = float.hex(args.double())
+            out.append((spec + "s") % (text.upper() if conv == "A" else text))
+        else:
+            out.append((spec + conv) % args.double())
+    out.append(fmt[last:])
+    return "".join(out)
+
+
+class Decoder:
+    def __init__(self, elf):
+        self.elf = elf
+        self.anchor = elf.symbols.get("tal_log_bin_anchor")
+        if self.anchor is None:
+            raise ValueError("tal_log_bin_anchor not found, is ENABLE_LOG_BINARY set and the ELF not stripped?")
+        self.sync = None
+        self.skipped = 0
+
+    def _ptr(self, frame, pos):
+        size = self.sync["sizes"]["ptr"]
+        val, = struct.unpack_from(self.sync["endian"] + ("I" if size == 4 else "Q"), frame, pos)
+        return val - self.sync["offset"], pos + size
+
+    def _str(self, addr):
+        text = self.elf.read_cstr(addr)
+        return text if text is not None else "<0x%x>" % addr
+
+    def _on_sync(self, frame):
+        if frame[1] != LOG_BIN_VERSION:
+            raise ValueError("unsupported frame version %d" % frame[1])
+        endian = "<" if struct.unpack_from("<I", frame, 2)[0] == LOG_BIN_ENDIAN_MARK else ">"
+        names = ["int", "long", "llong", "size_t", "intmax_t", "ptrdiff_t", "ptr", "double"]
+        sizes = dict(zip(names, frame[6:14]))
+        anchor, = struct.unpack_from(endian + ("I" if sizes["ptr"] == 4 else "Q"), frame, 14)
+        time_ms, = struct.unpack_from(endian + "Q", frame, 14 + sizes["ptr"])
+        self.sync = {"endian": endian, "sizes": sizes, "offset": anchor - self.anchor, "time_ms": time_ms}
+
+    def _time(self, time32):
+        base = self.sync["time_ms"]
+        time_ms = (base & ~0xFFFFFFFF) | time32
+        if time_ms < base - 0x80000000:
+            time_ms += 0x100000000
+        elif time_ms > base + 0x80000000:
+            time_ms -= 0x100000000
+        tm = datetime.datetime.fromtimestamp(time_ms / 1000)
+        return "%02d-%02d %02d:%02d:%02d:%d" % (tm.month, tm.day, tm.hour, tm.minute, tm.second, time_ms % 1000)
+
+    def decode(self, frame):
+        """Returns the text of one frame, None if the frame carries no text"""
+        frame_type = frame[0] & 0xF0
+        if frame_type == LOG_BIN_TYPE_SYNC:
+            self._on_sync(frame)
+            return None
+        if self.sync is None:
+            self.skipped += 1
+            return None
+
+        endian = self.sync["endian"]
+        if frame_type == LOG_BIN_TYPE_LOG:
+            level = frame[0] & 0x0F
+            time32, = struct.unpack_from(endian + "I", frame, 1)
+            file_addr, pos = self._ptr(frame, 5)
+            line, = struct.unpack_from(endian + "H", frame, pos)
+            fmt_addr, pos = self._ptr(frame, pos + 2)
+            text = format_args(self._str(fmt_addr), ArgReader(frame[pos:], endian, self.sync["sizes"]))
+            return "[%s ty %s][%s:%d] %s\n" % (self._time(time32), LEVEL_STR[level] if level < len(LEVEL_STR) else
+                                               "?", self._str(file_addr), line, text)
+        if frame_type == LOG_BIN_TYPE_RAW:
+            fmt_addr, pos = self._ptr(frame, 1)
+            return format_args(self._str(fmt_addr), ArgReader(frame[pos:], endian, self.sync["sizes"]))
+
+        self.skipped += 1
+        return None
+
+
+def read_frames(stream):
+    pending = b""
+    while True:
+        chunk = stream.read(4096)
+        if not chunk:
+            break
+        pending += chunk
+        *frames, pending = pending.split(b"\x00")
+        for frame in frames:
+            yield frame
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode tal_log binary output")
+    parser.add_argument("--elf", required=True, help="ELF of the firmware that wrote the log")
+    parser.add_argument("input", help="binary log file, - for stdin")
+    args = parser.parse_args()
+
+    try:
+        decoder = Decoder(ElfImage(args.elf))
+    except (OSError, ValueError, struct.error) as e:
+        sys.exit("error: %s" % e)
+    stream = sys.stdin.buffer if args.input == "-" else open(args.input, "rb")
+    try:
+        for encoded in read_frames(stream):
+            frame = cobs_decode(encoded) if encoded else None
+            if not frame:
+                decoder.skipped += 1 if encoded else 0
+                continue
+            try:
+                text = decoder.decode(frame)
+            except (struct.error, IndexError, KeyError, ValueError, TypeError):
+                decoder.skipped += 1
+                continue
+            if text:
+                sys.stdout.write(text.replace("\r\n", "\n"))
+                sys.stdout.flush()
+    finally:
+        if stream is not sys.stdin.buffer:
+            stream.close()
+
+    if decoder.skipped:
+        sys.stderr.write("%d frames skipped\n" % decoder.skipped)
+
+
+if __name__ == "__main__":
+    main()